@@ -3,6 +3,7 @@
 #include "../DataUtil/CDataUtilInc.h"
 #include "../MaUtil/CMaUtilInc.h"
 #include "Correct/CCorrectFwd.h"
+#include "Recon/CReconFwd.h"
 #include <stdio.h>
 
 namespace McAreTomo::AreTomo
@@ -123,6 +124,11 @@ private:
 	( int iVolZ, int iSeries, 
 	  MD::CTiltSeries* pSeries
 	);
+	void mStreamRecon
+	( Recon::CStreamRecon* pStreamRecon,
+	  int iVolZ, int iSeries,
+	  MD::CTiltSeries* pSeries
+	);
 	void mSaveVol
 	( MD::CTiltSeries* pVolSeries,
 	  int iNthVol, bool bClean
@@ -137,8 +143,18 @@ private:
 	//-----------------
 	float mRotAxis180(float fAxis);
 	//-----------------
+	void mGenStageKeys(void);
+	void mFindCtfStage(void);
+	bool mLoadAlignStage(MD::CStageEntry* pEntry);
+	bool mRestoreAlignStage(MD::CStageEntry* pEntry);
+	void mSaveAlignStage(void);
+	//-----------------
 	MAC::CCorrTomoStack* m_pCorrTomoStack;
+	MD::CStageKey m_aCtfKey;
+	MD::CStageKey m_aAlignKey;
 	float m_fRotScore;
+	int m_iCtfHand;
+	bool m_bCtfTiles;
 	int m_iNthGpu;
 };
 
@@ -40,9 +40,21 @@ static MD::CTiltSeries* sGetTiltSeries(int iNthGpu, int iSeries)
 	return pSeries;
 }
 
+//--------------------------------------------------------------------
+// 1. -CpuRecon as resolved for the current tilt series when it was
+//    dispatched, see CProcessThread::mSelectRecon.
+//--------------------------------------------------------------------
+static int sGetCpuRecon(int iNthGpu)
+{
+	MD::CTsPackage* pPkg = MD::CTsPackage::GetInstance(iNthGpu);
+	return pPkg->m_iCpuRecon;
+}
+
 CAreTomoMain::CAreTomoMain(void)
 {
 	m_pCorrTomoStack = 0L;
+	m_iCtfHand = 1;
+	m_bCtfTiles = false;
 }
 
 CAreTomoMain::~CAreTomoMain(void)
@@ -59,6 +71,7 @@ CAreTomoMain::~CAreTomoMain(void)
 bool CAreTomoMain::DoIt(int iNthGpu)
 {
 	m_iNthGpu = iNthGpu;
+	MD::CTraceSpan aSpan("CAreTomoMain::DoIt", m_iNthGpu);
 	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	printf("Processing (GPU %d): %s\n\n", m_iNthGpu, 
 	   pTsPackage->m_acMrcMain);
@@ -67,7 +80,6 @@ bool CAreTomoMain::DoIt(int iNthGpu)
 	if(!bValidTS) return true;
 	//-----------------
 	CInput* pInput = CInput::GetInstance();
-	mGenCtfTiles();
 	if(pInput->m_iCmd == 0 || pInput->m_iCmd == 1) mDoFull();
 	else if(pInput->m_iCmd == 2) mSkipAlign();
 	else if(pInput->m_iCmd == 3) mEstimateCtf();
@@ -75,9 +87,11 @@ bool CAreTomoMain::DoIt(int iNthGpu)
 	//-----------------
 	FindCtf::CTsTiles::DeleteInstance(m_iNthGpu);
 	//-----------------
-	MD::CAsyncSaveVol* pSaveVol = 
-	   MD::CAsyncSaveVol::GetInstance(m_iNthGpu);
-	pSaveVol->WaitForExit(-1.0f);
+	MD::CAsyncWriter* pAsyncWriter = MD::CAsyncWriter::GetInstance();
+	bool bClear = true;
+	{	MD::CTraceSpan aWaitSpan("WaitOutput", m_iNthGpu);
+		pAsyncWriter->WaitGpu(m_iNthGpu, !bClear);
+	}
 	//----------------------------------------------------
 	// Save the metrics after tomograms are saved to help
 	// DenoisET to connect the metrics to the tomogram.
@@ -91,13 +105,22 @@ bool CAreTomoMain::DoIt(int iNthGpu)
 
 void CAreTomoMain::mDoFull(void)
 {
+	//-----------------------------------------------
+	// 1) -StageCache: a cached alignment includes
+	// the refined CTF and skips both CTF stages.
+	// 2) Otherwise CTF tiles are generated from the
+	// raw tilt series as before.
+	//-----------------------------------------------
+	mGenStageKeys();
+	MD::CStageEntry aAlignEntry;
+	bool bAlignCached = mLoadAlignStage(&aAlignEntry);
 	//-----------------------------------------------
 	// 1) This runs on the full tilt series. 2) In 
 	// the future, refinement will be performed on 
 	// dark removed tilt series to determine alpha 
 	// and beta tilt offset.
 	//-----------------------------------------------
-	mFindCtf(false);
+	if(!bAlignCached) mFindCtfStage();
 	//-----------------
 	mCreateAlnParams();
 	mRemoveSpikes();	
@@ -105,7 +128,14 @@ void CAreTomoMain::mDoFull(void)
 	//-----------------
 	mRemoveDarkFrames();
 	//-----------------
-	mAlign();
+	if(bAlignCached && !mRestoreAlignStage(&aAlignEntry))
+	{	mFindCtfStage();
+		bAlignCached = false;
+	}
+	if(!bAlignCached)
+	{	mAlign();
+		mSaveAlignStage();
+	}
 	mSaveAlignment();
 	//-----------------------------------------------
 	// 1) -OutImod 3 saves the aligned tilt series.
@@ -263,6 +293,7 @@ void CAreTomoMain::mEstimateCtf(void)
 
 void CAreTomoMain::mRemoveDarkFrames(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mRemoveDarkFrames", m_iNthGpu);
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	MAM::CRemoveDarkFrames remDarkFrames;
 	remDarkFrames.Setup(m_iNthGpu);
@@ -279,6 +310,7 @@ void CAreTomoMain::mRemoveDarkCtfs(void)
 
 void CAreTomoMain::mCreateAlnParams(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mCreateAlnParams", m_iNthGpu);
 	MD::CTsPackage* pPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	MD::CTiltSeries* pRawSeries = pPackage->GetSeries(0);
 	//-----------------
@@ -298,6 +330,7 @@ void CAreTomoMain::mCreateAlnParams(void)
 
 void CAreTomoMain::mRemoveSpikes(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mRemoveSpikes", m_iNthGpu);
 	MD::CTsPackage* pPkg = MD::CTsPackage::GetInstance(m_iNthGpu);
 	MD::CTiltSeries* pRawSeries = pPkg->GetSeries(0);
 	MAJ::CRemoveSpikes remSpikes;
@@ -306,6 +339,8 @@ void CAreTomoMain::mRemoveSpikes(void)
 
 void CAreTomoMain::mGenCtfTiles(void)
 {
+	if(m_bCtfTiles) return;
+	MD::CTraceSpan aSpan("CAreTomoMain::mGenCtfTiles", m_iNthGpu);
 	CInput* pInput = CInput::GetInstance();
 	if(pInput->m_iCmd == 2) return; // recon only
 	if(pInput->m_iCmd == 4) return; // rotate tilt axis only
@@ -315,15 +350,19 @@ void CAreTomoMain::mGenCtfTiles(void)
 	   FindCtf::CTsTiles::GetInstance(m_iNthGpu);
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	pTsTiles->Generate(pAtInput->m_iCtfTileSize);
+	m_bCtfTiles = true;
 }
 
 //--------------------------------------------------------------------
 // 1. CFindCtfMain estimates CTFs and saves them into the output
 //    directory, but does not save in the Imod directory.
+// 2. CTF tiles are generated on first use.
 //--------------------------------------------------------------------
 void CAreTomoMain::mFindCtf(bool bRefine)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mFindCtf", m_iNthGpu);
 	if(!FindCtf::CFindCtfMain::bCheckInput()) return;
+	mGenCtfTiles();
 	//---------------------------
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
 	if(!bRefine)
@@ -343,6 +382,7 @@ void CAreTomoMain::mFindCtf(bool bRefine)
 		MAM::CAlignParam* pAlnParam = sGetAlignParam(m_iNthGpu);
 		float fTiltAxis = pAlnParam->GetTiltAxis(0);
 		//--------------------------
+		m_iCtfHand = pCtfResults->m_iDfHand;
 		if(pCtfResults->m_iDfHand == -1)
 		{	fTiltAxis = mRotAxis180(fTiltAxis);
 		}
@@ -364,12 +404,14 @@ void CAreTomoMain::mFindCtf(bool bRefine)
 
 void CAreTomoMain::mMassNorm(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mMassNorm", m_iNthGpu);
 	MassNorm::CLinearNorm linearNorm;
 	linearNorm.DoIt(m_iNthGpu);
 }
 
 void CAreTomoMain::mAlign(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mAlign", m_iNthGpu);
 	m_fRotScore = 0.0f;
 	mCoarseAlign();
 	mFindCtf(true);
@@ -405,6 +447,7 @@ void CAreTomoMain::mAlign(void)
 
 void CAreTomoMain::mCoarseAlign(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mCoarseAlign", m_iNthGpu);
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
 	pTimeStamp->Record("TomoAlignCoarse:Start");
 	MAS::CStreAlignMain streAlignMain;
@@ -456,6 +499,7 @@ void CAreTomoMain::mCoarseAlign(void)
 
 void CAreTomoMain::mProjAlign(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mProjAlign", m_iNthGpu);
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
         pTimeStamp->Record("TomoAlignRefine:Start");
 	//---------------------------
@@ -508,6 +552,7 @@ void CAreTomoMain::mRotAlign(void)
 
 void CAreTomoMain::mPatchAlign(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mPatchAlign", m_iNthGpu);
 	CAtInput* pInput = CAtInput::GetInstance();
 	if(pInput->GetNumPatches() == 0) return;
 	//---------------------------
@@ -528,6 +573,7 @@ void CAreTomoMain::mPatchAlign(void)
 
 void CAreTomoMain::mCalcThickness(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mCalcThickness", m_iNthGpu);
 	MD::CCtfResults* pCtfResults =MD::CCtfResults::GetInstance(m_iNthGpu);
 	MAM::CAlignParam* pAlnParam = MAM::CAlignParam::GetInstance(m_iNthGpu);
 	float fAlpha0 = pCtfResults->m_fAlphaOffset;
@@ -572,6 +618,7 @@ void CAreTomoMain::mCorrAngOffset(void)
 
 void CAreTomoMain::mCorrectCTF(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mCorrectCTF", m_iNthGpu);
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	if(pAtInput->m_aiCorrCTF[0] == 0) return;
 	//---------------------------
@@ -592,6 +639,7 @@ void CAreTomoMain::mCorrectCTF(void)
 
 void CAreTomoMain::mSetupTsCorrection(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mSetupTsCorrection", m_iNthGpu);
 	//---------------------------------------------------------
 	// The aligned tilt series is buffered in m_pCorrTomoStack
 	// and can be retrieved by calling
@@ -621,6 +669,7 @@ void CAreTomoMain::mSetupTsCorrection(void)
 //--------------------------------------------------------------------
 void CAreTomoMain::mSaveForImod(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mSaveForImod", m_iNthGpu);
 	CInput* pInput = CInput::GetInstance();
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	ImodUtil::CImodUtil* pImodUtil = 0L;
@@ -682,6 +731,7 @@ void CAreTomoMain::mSaveForImod(void)
 
 void CAreTomoMain::mAlignCTF(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mAlignCTF", m_iNthGpu);
 	CInput* pInput = CInput::GetInstance();
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	if(pAtInput->m_iOutImod != 3) return;
@@ -721,6 +771,7 @@ MD::CTiltSeries* CAreTomoMain::mBinAlnSeries(float fBin)
 
 void CAreTomoMain::mRecon(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mRecon", m_iNthGpu);
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
 	pTimeStamp->Record("TomoRecon:Start");
 	//---------------------------
@@ -759,6 +810,7 @@ void CAreTomoMain::mRecon(void)
 
 void CAreTomoMain::mRecon2nd(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mRecon2nd", m_iNthGpu);
 	CAtInput* pAtInput = CAtInput::GetInstance();
 	float fBin1 = pAtInput->m_afAtBin[1];
 	float fBin2 = pAtInput->m_afAtBin[2];
@@ -807,7 +859,8 @@ void CAreTomoMain::mSartRecon
 (	int iVolZ, int iSeries, 
 	MD::CTiltSeries* pSeries
 )
-{	CAtInput* pInput = CAtInput::GetInstance();
+{	MD::CTraceSpan aSpan("CAreTomoMain::mSartRecon", m_iNthGpu);
+	CAtInput* pInput = CAtInput::GetInstance();
 	MAM::CAlignParam* pAlnParam = sGetAlignParam(m_iNthGpu);
 	//-----------------
 	int iStartTilt = pAlnParam->GetFrameIdxFromTilt(
@@ -825,7 +878,17 @@ void CAreTomoMain::mSartRecon
 	Util_Time aTimer;
 	aTimer.Measure();
 	//-----------------
+	if(pInput->m_fSlabMem > 0)
+	{	Recon::CStreamRecon streamRecon;
+		streamRecon.SetSart(iStartTilt, iNumTilts, iIters, iNumSubsets);
+		mStreamRecon(&streamRecon, iVolZ, iSeries, pSeries);
+		printf("GPU %d: SART Recon: %.2f sec\n\n", m_iNthGpu,
+		   aTimer.GetElapsedSeconds());
+		return;
+	}
+	//-----------------
 	Recon::CDoSartRecon doSartRecon;
+	doSartRecon.m_iCpuRecon = sGetCpuRecon(m_iNthGpu);
 	MD::CTiltSeries* pVolStack = doSartRecon.DoIt(pSeries, 
 	   pAlnParam, iStartTilt, iNumTilts, iVolZ, iIters, iNumSubsets);
 	pVolStack->m_fPixSize = pSeries->m_fPixSize;
@@ -849,17 +912,32 @@ void CAreTomoMain::mWbpRecon
 (	int iVolZ, int iSeries,
 	MD::CTiltSeries* pSeries
 )
-{	printf("GPU %d: start WBP reconstruction...\n", m_iNthGpu);
+{	MD::CTraceSpan aSpan("CAreTomoMain::mWbpRecon", m_iNthGpu);
+	printf("GPU %d: start WBP reconstruction...\n", m_iNthGpu);
 	CAtInput* pInput = CAtInput::GetInstance();
 	//-----------------
 	Util_Time aTimer;
 	aTimer.Measure();
 	//-----------------
+	if(pInput->m_fSlabMem > 0)
+	{	Recon::CStreamRecon streamRecon;
+		mStreamRecon(&streamRecon, iVolZ, iSeries, pSeries);
+		printf("GPU %d: WBP Recon: %.2f sec\n\n", m_iNthGpu,
+		   aTimer.GetElapsedSeconds());
+		return;
+	}
+	//-----------------
 	MAM::CAlignParam* pAlnParam = sGetAlignParam(m_iNthGpu);
 	//-----------------
-	Recon::CDoWbpRecon doWbpRecon;
-	MD::CTiltSeries* pVolStack = doWbpRecon.DoIt(pSeries, 
-	   pAlnParam, iVolZ);
+	MD::CTiltSeries* pVolStack = 0L;
+	if(sGetCpuRecon(m_iNthGpu) == 1)
+	{	Recon::CDoCpuWbpRecon doCpuWbpRecon;
+		pVolStack = doCpuWbpRecon.DoIt(pSeries, pAlnParam, iVolZ);
+	}
+	else
+	{	Recon::CDoWbpRecon doWbpRecon;
+		pVolStack = doWbpRecon.DoIt(pSeries, pAlnParam, iVolZ);
+	}
 	pVolStack->m_fPixSize = pSeries->m_fPixSize;
 	printf("GPU %d: WBP Recon: %.2f sec\n\n", m_iNthGpu,
 	   aTimer.GetElapsedSeconds());
@@ -875,6 +953,35 @@ void CAreTomoMain::mWbpRecon
 	if(!bClean && pVolStack != 0L) delete pVolStack;
 }
 
+//--------------------------------------------------------------------
+// 1. -SlabMem: the volume is reconstructed in y-slabs written
+//    straight into its MRC file, which replaces mFlipVol and
+//    mSaveVol. Volumes that mSaveVol would skip are not
+//    reconstructed.
+//--------------------------------------------------------------------
+void CAreTomoMain::mStreamRecon
+(	Recon::CStreamRecon* pStreamRecon,
+	int iVolZ, int iSeries,
+	MD::CTiltSeries* pSeries
+)
+{	MD::CTraceSpan aSpan("CAreTomoMain::mStreamRecon", m_iNthGpu);
+	MD::CAsyncSaveVol* pSaveVol = 
+	   MD::CAsyncSaveVol::GetInstance(m_iNthGpu);
+	char acMrcFile[256] = {'\0'};
+	if(!pSaveVol->GetVolFile(iSeries, acMrcFile)) return;
+	//-----------------
+	CAtInput* pInput = CAtInput::GetInstance();
+	pStreamRecon->m_iCpuRecon = sGetCpuRecon(m_iNthGpu);
+	pStreamRecon->m_iFlipVol = pInput->m_iFlipVol;
+	pStreamRecon->m_fSlabMem = pInput->m_fSlabMem;
+	//-----------------
+	MAM::CAlignParam* pAlnParam = sGetAlignParam(m_iNthGpu);
+	bool bSaved = pStreamRecon->DoIt(pSeries, pAlnParam,
+	   iVolZ, acMrcFile);
+	if(!bSaved) return;
+	printf("GPU %d: MRC file saved: %s\n\n", m_iNthGpu, acMrcFile);
+}
+
 void CAreTomoMain::mSaveVol
 (	MD::CTiltSeries* pVolSeries, 
 	int iNthVol,
@@ -883,12 +990,12 @@ void CAreTomoMain::mSaveVol
 {	bool bAsync = true;
 	MD::CAsyncSaveVol* pSaveVol = 
 	   MD::CAsyncSaveVol::GetInstance(m_iNthGpu);
-	pSaveVol->WaitForExit(-1.0f);
 	pSaveVol->DoIt(pVolSeries, iNthVol, bAsync, bClean);
 }
 
 MD::CTiltSeries* CAreTomoMain::mFlipVol(MD::CTiltSeries* pVolSeries)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mFlipVol", m_iNthGpu);
 	CAtInput* pInput = CAtInput::GetInstance();
 	if(pInput->m_iFlipVol == 0) return 0L;
 	//-----------------
@@ -902,6 +1009,7 @@ MD::CTiltSeries* CAreTomoMain::mFlipVol(MD::CTiltSeries* pVolSeries)
 
 void CAreTomoMain::mSaveAlignment(void)
 {
+	MD::CTraceSpan aSpan("CAreTomoMain::mSaveAlignment", m_iNthGpu);
 	MrcUtil::CSaveAlignFile saveAlignFile;
 	saveAlignFile.DoIt(m_iNthGpu); 
 }
@@ -990,3 +1098,156 @@ bool CAreTomoMain::mCheckTiltSeries(void)
 	   pTsPackage->m_acInFile);
 	return false;	
 }
+
+//--------------------------------------------------------------------
+// 1. -StageCache: the CTF key hashes the raw tilt series and the
+//    CTF parameters. The alignment key adds the parameters of
+//    dark frame removal and alignment.
+// 2. The raw tilt series is hashed before spikes are removed and
+//    mass is normalized, which depend on no parameters.
+//--------------------------------------------------------------------
+void CAreTomoMain::mGenStageKeys(void)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(1)) return;
+	MD::CTraceSpan aSpan("CAreTomoMain::mGenStageKeys", m_iNthGpu);
+	//-----------------
+	MD::CTiltSeries* pRawSeries = sGetTiltSeries(m_iNthGpu, 0);
+	int iNumTilts = pRawSeries->m_aiStkSize[2];
+	m_aCtfKey.Add(pRawSeries->m_aiStkSize, sizeof(int) * 3);
+	m_aCtfKey.AddInt(pRawSeries->m_iMode);
+	m_aCtfKey.AddFloat(pRawSeries->m_fPixSize);
+	m_aCtfKey.Add(pRawSeries->m_pfTilts, sizeof(float) * iNumTilts);
+	m_aCtfKey.Add(pRawSeries->m_piSecIndices, sizeof(int) * iNumTilts);
+	for(int i=0; i<iNumTilts; i++)
+	{	m_aCtfKey.Add(pRawSeries->GetFrame(i), pRawSeries->m_tFmBytes);
+	}
+	aSpan.AddBytes(pRawSeries->m_tFmBytes * iNumTilts);
+	//-----------------
+	CInput* pInput = CInput::GetInstance();
+	CAtInput* pAtInput = CAtInput::GetInstance();
+	m_aCtfKey.AddInt(pInput->m_iKv);
+	m_aCtfKey.AddFloat(pInput->m_fCs);
+	m_aCtfKey.AddFloat(pAtInput->m_fAmpContrast);
+	m_aCtfKey.Add(pAtInput->m_afExtPhase, sizeof(float) * 2);
+	m_aCtfKey.AddInt(pAtInput->m_iCtfTileSize);
+	//-----------------
+	m_aAlignKey.AddKey(&m_aCtfKey);
+	m_aAlignKey.AddFloat(pAtInput->m_fDarkTol);
+	m_aAlignKey.Add(pAtInput->m_afTiltAxis, sizeof(float) * 2);
+	m_aAlignKey.AddInt(pAtInput->m_iAlignZ);
+	m_aAlignKey.Add(pAtInput->m_afTiltCor, sizeof(float) * 2);
+	m_aAlignKey.Add(pAtInput->m_aiAtPatches, sizeof(int) * 2);
+	m_aAlignKey.AddInt(pAtInput->m_iAlign);
+}
+
+//--------------------------------------------------------------------
+// 1. Initial CTF estimation, loaded from -StageCache if possible.
+//--------------------------------------------------------------------
+void CAreTomoMain::mFindCtfStage(void)
+{
+	mGenCtfTiles();
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	MD::CCtfResults* pCtfResults = MD::CCtfResults::GetInstance(m_iNthGpu);
+	if(!pStageCache->bEnabled(1))
+	{	mFindCtf(false);
+		return;
+	}
+	//-----------------
+	MD::CStageEntry aEntry;
+	if(pStageCache->Load("Ctf", &m_aCtfKey, &aEntry) &&
+	   pCtfResults->ReadEntry(&aEntry))
+	{	printf("GPU %d: CTF estimation loaded from %s\n\n",
+		   m_iNthGpu, aEntry.m_acFile);
+		pCtfResults->DisplayAll();
+		return;
+	}
+	//-----------------
+	mFindCtf(false);
+	if(pCtfResults->m_iNumImgs <= 0) return;
+	MD::CStageEntry* pEntry = new MD::CStageEntry;
+	pCtfResults->WriteEntry(pEntry);
+	pStageCache->Save("Ctf", &m_aCtfKey, pEntry, m_iNthGpu);
+}
+
+//--------------------------------------------------------------------
+// 1. The refined CTF comes first in the alignment entry and is
+//    restored right away since the CTF stages are skipped.
+//--------------------------------------------------------------------
+bool CAreTomoMain::mLoadAlignStage(MD::CStageEntry* pEntry)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(1)) return false;
+	if(!pStageCache->Load("Align", &m_aAlignKey, pEntry)) return false;
+	//-----------------
+	MD::CCtfResults* pCtfResults = MD::CCtfResults::GetInstance(m_iNthGpu);
+	m_iCtfHand = pEntry->ReadInt();
+	if(!pCtfResults->ReadEntry(pEntry)) return false;
+	printf("GPU %d: alignment loaded from %s\n\n", 
+	   m_iNthGpu, pEntry->m_acFile);
+	return true;
+}
+
+//--------------------------------------------------------------------
+// 1. Restores the alignment after dark frames are removed and does
+//    what mAlign does besides aligning: the tilt offset of the dark
+//    frames, the CTF files, the metrics and the shift logs.
+// 2. Nothing is changed when the entry does not match the dark
+//    removed tilt series.
+//--------------------------------------------------------------------
+bool CAreTomoMain::mRestoreAlignStage(MD::CStageEntry* pEntry)
+{
+	MD::CTiltSeries* pSeries = sGetTiltSeries(m_iNthGpu, 0);
+	size_t tReadPos = pEntry->m_tReadPos;
+	MAM::CAlignParam aAlignParam;
+	bool bMatch = aAlignParam.ReadEntry(pEntry);
+	if(aAlignParam.m_iNumFrames != pSeries->m_aiStkSize[2]) bMatch = false;
+	if(!bMatch)
+	{	printf("GPU %d: Warning: cached alignment does not match "
+		   "the tilt series, align again.\n\n", m_iNthGpu);
+		return false;
+	}
+	pEntry->m_tReadPos = tReadPos;
+	sGetAlignParam(m_iNthGpu)->ReadEntry(pEntry);
+	sGetLocalParam(m_iNthGpu)->ReadEntry(pEntry);
+	//-----------------
+	MD::CCtfResults* pCtfResults = MD::CCtfResults::GetInstance(m_iNthGpu);
+	CAtInput* pAtInput = CAtInput::GetInstance();
+	if(pAtInput->m_afTiltCor[0] != 0)
+	{	MAM::CDarkFrames* pDarkFrames = 
+		   MAM::CDarkFrames::GetInstance(m_iNthGpu);
+		pDarkFrames->AddTiltOffset(pCtfResults->m_fAlphaOffset);
+	}
+	//-----------------------------------------------
+	// CRefineCtfMain saves the CTF files with the
+	// handedness it found, before mFindCtf resets it.
+	//-----------------------------------------------
+	if(pCtfResults->m_iNumImgs > 0)
+	{	int iDfHand = pCtfResults->m_iDfHand;
+		pCtfResults->m_iDfHand = m_iCtfHand;
+		FindCtf::CSaveCtfResults saveCtfResults;
+		saveCtfResults.DoIt(m_iNthGpu);
+		pCtfResults->m_iDfHand = iDfHand;
+		pCtfResults->DisplayAll();
+	}
+	//-----------------
+	CTsMetrics* pTsMetrics = CTsMetrics::GetInstance(m_iNthGpu);
+	pTsMetrics->BuildMetrics();
+	mLogGlobalShift();
+	mLogLocalShift();
+	return true;
+}
+
+void CAreTomoMain::mSaveAlignStage(void)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(1)) return;
+	//-----------------
+	MD::CCtfResults* pCtfResults = MD::CCtfResults::GetInstance(m_iNthGpu);
+	MD::CStageEntry* pEntry = new MD::CStageEntry;
+	pEntry->WriteInt(m_iCtfHand);
+	pCtfResults->WriteEntry(pEntry);
+	sGetAlignParam(m_iNthGpu)->WriteEntry(pEntry);
+	sGetLocalParam(m_iNthGpu)->WriteEntry(pEntry);
+	pStageCache->Save("Align", &m_aAlignKey, pEntry, m_iNthGpu);
+}
@@ -68,59 +68,6 @@ private:
 	cufftComplex* mGetLine(int iProj, int iLine);
 };
 
-class CLineSet
-{
-public:
-	CLineSet(void);
-	~CLineSet(void);
-	void Clean(void);
-	void Setup(int iNthGpu);
-	cufftComplex* GetLine(int iLine); // do not free
-	//-----------------
-	int m_iNumProjs;
-	int m_iCmpSize;
-	int m_iNthGpu;
-private:
-	cufftComplex* m_gCmpLines;
-};
-
-class CSumLines
-{
-public:
-	CSumLines(void);
-	virtual ~CSumLines(void);
-	void Clean(void);
-	void DoIt(CLineSet* pLineSet);
-	cufftComplex* GetSum(bool bClean);
-private:
-	int m_iCmpSize;
-	cufftComplex* m_gCmpSum;
-};
-
-class GInterpolateLineSet
-{
-public:
-	GInterpolateLineSet(void);
-	~GInterpolateLineSet(void);
-	void Clean(void);
-	void DoIt
-	( CPossibleLines* pPossibleLines,
-	  float* pfRotAngles,
-	  CLineSet* pLineSet
-	);
-private:
-	void mInterpolate(int iProj);
-	//-----------------
-	CPossibleLines* m_pPossibleLines;
-	float* m_pfRotAngles;
-	CLineSet* m_pLineSet;
-	//-----------------
-	cufftComplex* m_gCmpLine1;
-	cufftComplex* m_gCmpLine2;
-	int m_iCmpSize;
-	int m_iGpuID;
-};	
-
 class GCalcCommonRegion
 {
 public:
@@ -255,20 +202,85 @@ private:
 	float m_fCC;
 };
 
-class CCalcScore 
+class CLineScore;
+
+//--------------------------------------------------------------------
+// 1. One call of CLineScore::DoIt, run by MU::CHostThreads.
+//--------------------------------------------------------------------
+class CLineScoreJob : public MU::CHostJob
 {
 public:
-	CCalcScore(void);
-	~CCalcScore(void);
-	float DoIt(CLineSet* pLineSet, cufftComplex* gCmpSum);
+	void DoBlock(int iFirst, int iCount, int iThread);
+	CLineScore* m_pLineScore;
+	float* m_pfLinePos;
+	float* m_pfScores;
+};
+
+//--------------------------------------------------------------------
+// 1. CPU counterpart of GLineScore. It reads the host planes of
+//    CPossibleLines in place and uses MU::GetHostThreads() threads,
+//    each with a work line allocated in Setup.
+//--------------------------------------------------------------------
+class CLineScore
+{
+public:
+	CLineScore(void);
+	~CLineScore(void);
+	void Clean(void);
+	void Setup(CPossibleLines* pPossibleLines, float fBFactor);
+	void DoIt
+	( float* pfLinePos, int iNumCands,
+	  float* pfScores
+	);
+	void ScoreBlock
+	( float* pfLinePos, int iFirst, int iCount,
+	  float* pfScores, int iThread
+	);
 private:
-	float mCorrelate(int iLine);
-	cufftComplex* mCudaMallocLine(bool bZero);
-	//-----------------
-	CLineSet* m_pLineSet;
-	cufftComplex* m_gCmpSum;
-	cufftComplex* m_gCmpRef;
+	float mScore(float* pfLinePos, float* pfSum);
+	cufftComplex** m_ppCmpPlanes;
+	float* m_pfWeights;
+	float* m_pfWorkBufs;
+	float m_fWeightSum;
+	int m_iNumProjs;
+	int m_iNumLines;
 	int m_iCmpSize;
+	int m_iNumThreads;
+};
+
+//--------------------------------------------------------------------
+// 1. Scores many candidate line sets in one call. A candidate has
+//    one line position per projection in units of the lines of
+//    CPossibleLines. A fractional position is interpolated
+//    linearly between the two neighbouring lines.
+// 2. The score is the mean over projections of the weighted phase
+//    correlation of each line with the sum of all others.
+// 3. The lines are uploaded once in Setup. Unless MU::gpuBackend,
+//    Setup creates a CLineScore that DoIt runs instead.
+//--------------------------------------------------------------------
+class GLineScore
+{
+public:
+	GLineScore(void);
+	~GLineScore(void);
+	void Clean(void);
+	void Setup(CPossibleLines* pPossibleLines, float fBFactor);
+	void DoIt
+	( float* pfLinePos, int iNumCands,
+	  float* pfScores
+	);
+private:
+	void mAlloc(int iNumCands);
+	cufftComplex* m_gCmpPlanes;
+	float* m_gfBuf;
+	int m_iMaxCands;
+	int m_iNumProjs;
+	int m_iNumLines;
+	int m_iCmpSize;
+	float m_fBFactor;
+	float m_fWeightSum;
+	cudaStream_t m_stream;
+	CLineScore* m_pHostScore; // unless MU::gpuBackend
 };
 
 class CFindTiltAxis
@@ -277,17 +289,11 @@ public:
 	CFindTiltAxis(void);
 	~CFindTiltAxis(void);
 	void Clean(void);
-	float DoIt
-	( CPossibleLines* pPossibleLines,
-	  CLineSet* pLineSet
-	);
+	float DoIt(CPossibleLines* pPossibleLines);
 	float m_fScore;
 private:
 	int mDoIt(void);
-	void mFillLineSet(int iLine);
-	float mCalcScore(void);
 	CPossibleLines* m_pPossibleLines;
-	CLineSet* m_pLineSet;
 	int m_iNumImgs;
 	int m_iNumLines;
 };
@@ -303,22 +309,21 @@ public:
 	virtual ~CRefineTiltAxis(void);
 	void Clean(void);
 	void Setup(int iDim, int iIterations, float fTol);
-	float Refine	
-	( CPossibleLines* pPossibleLines,
-	  CLineSet* pLineSet
-	);
+	float Refine(CPossibleLines* pPossibleLines);
 	void GetRotAngles(float* pfRotAngles);
 	float Eval(float* pfCoeff);
 private:
 	void mCalcRotAngles(float* pfCoeff);
+	void mCalcLinePos(void);
 	//----------------------------------
 	CPossibleLines* m_pPossibleLines;
-	CLineSet* m_pLineSet;
+	GLineScore m_aLineScore;
 	//-------------------
 	float* m_pfCoeff;
 	float* m_pfTerms;
 	float* m_pfSearchRange;
 	float* m_pfRotAngles;
+	float* m_pfLinePos;
 	//-------------------
 	int m_iNumProjs;
 	int m_iNumLines;
@@ -42,14 +42,10 @@ float CCommonLineMain::DoInitial
 	CGenLines genLines;
 	CPossibleLines* pPossibleLines = genLines.DoIt(m_iNthGpu);
 	//-----------------
-	CLineSet* pLineSet = new CLineSet;
-	pLineSet->Setup(m_iNthGpu);
-	//-----------------
 	CFindTiltAxis findTiltAxis;
-	float fRotAngle = findTiltAxis.DoIt(pPossibleLines, pLineSet);
+	float fRotAngle = findTiltAxis.DoIt(pPossibleLines);
 	//-----------------
 	if(pPossibleLines != 0L) delete pPossibleLines;
-	if(pLineSet != 0L) delete pLineSet;
 	//-----------------
 	printf("Initial estimate of tilt axes:\n");
 	for(int i=0; i<pAlnParam->m_iNumFrames; i++)
@@ -76,19 +72,15 @@ float CCommonLineMain::DoRefine(int iNthGpu)
 	//-----------------
 	CGenLines genLines;
 	CPossibleLines* pPossibleLines = genLines.DoIt(m_iNthGpu);
-	//-----------------
-	CLineSet* pLineSet = new CLineSet;
-	pLineSet->Setup(m_iNthGpu);
 	//----------------
 	CRefineTiltAxis refineTiltAxis;
 	refineTiltAxis.Setup(3, 10, 0.0001f);
-	float fScore = refineTiltAxis.Refine(pPossibleLines, pLineSet);
+	float fScore = refineTiltAxis.Refine(pPossibleLines);
 	//-------------------------------------------------------------
 	float* pfRotAngles = new float[pPossibleLines->m_iNumProjs];
 	refineTiltAxis.GetRotAngles(pfRotAngles);
 	//--------------------------------------
 	if(pPossibleLines != 0L) delete pPossibleLines;
-	if(pLineSet != 0L) delete pLineSet;
 	//---------------------------------
 	for(int i=0; i<m_iNumImgs; i++)
 	{	pAlnParam->SetTiltAxis(i, pfRotAngles[i]);
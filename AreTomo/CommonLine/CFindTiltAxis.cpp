@@ -17,12 +17,9 @@ CFindTiltAxis::~CFindTiltAxis(void)
 {
 }
 
-float CFindTiltAxis::DoIt
-(	CPossibleLines* pPossibleLines,
-	CLineSet* pLineSet
-)
+float CFindTiltAxis::DoIt(CPossibleLines* pPossibleLines)
 {	m_pPossibleLines = pPossibleLines;
-	m_pLineSet = pLineSet;
+	m_iNumImgs = m_pPossibleLines->m_iNumProjs;
 	m_iNumLines = m_pPossibleLines->m_iNumLines;
 	//------------------------------------------
 	int iLine = mDoIt();
@@ -30,16 +27,27 @@ float CFindTiltAxis::DoIt
 	return fTiltAxis;
 }
 
+//--------------------------------------------------------------------
+// 1. Candidate i takes line i of every projection. All of them are
+//    scored in one call of GLineScore.
+//--------------------------------------------------------------------
 int CFindTiltAxis::mDoIt(void)
 {
-	int iLineMax = 0;
-	m_fScore = 0.0f;
+	float* pfLinePos = new float[m_iNumLines * m_iNumImgs];
+	for(int i=0; i<m_iNumLines; i++)
+	{	float* pfPos = pfLinePos + i * m_iNumImgs;
+		for(int j=0; j<m_iNumImgs; j++) pfPos[j] = (float)i;
+	}
 	float* pfScores = new float[m_iNumLines];
+	GLineScore aLineScore;
+	aLineScore.Setup(m_pPossibleLines, 10.0f);
+	aLineScore.DoIt(pfLinePos, m_iNumLines, pfScores);
+	delete[] pfLinePos;
 	//-----------------
+	int iLineMax = 0;
+	m_fScore = 0.0f;
 	for(int i=0; i<m_iNumLines; i++)
-	{	mFillLineSet(i);
-		pfScores[i] = mCalcScore();
-		if(m_fScore < pfScores[i]) 
+	{	if(m_fScore < pfScores[i]) 
 		{	m_fScore = pfScores[i];
 			iLineMax = i;
 		}
@@ -49,24 +57,3 @@ int CFindTiltAxis::mDoIt(void)
 	if(pfScores != 0L) delete[] pfScores;
 	return iLineMax;
 }
-
-void CFindTiltAxis::mFillLineSet(int iLine)
-{
-	for(int i=0; i<m_pPossibleLines->m_iNumProjs; i++)
-	{	cufftComplex* gCmpLine = m_pLineSet->GetLine(i);
-		m_pPossibleLines->GetLine(i, iLine, gCmpLine);
-	}
-}
-
-float CFindTiltAxis::mCalcScore(void)
-{
-	CSumLines sumLines;
-	bool bClean = true;
-	sumLines.DoIt(m_pLineSet);
-	cufftComplex* gCmpSum = sumLines.GetSum(bClean);
-	//-----------------
-	CCalcScore calcScore;
-	float fScore = calcScore.DoIt(m_pLineSet, gCmpSum);
-	if(gCmpSum != 0L) cudaFree(gCmpSum);
-	return fScore;
-}
@@ -0,0 +1,188 @@
+#include "CCommonLineInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo;
+using namespace McAreTomo::AreTomo::CommonLine;
+
+static const int s_iLanes = 8;
+
+//--------------------------------------------------------------------
+// 1. Returns the two lines around fLinePos and the weight of the
+//    second one. Positions beyond the last line use the last line.
+//--------------------------------------------------------------------
+static float sFindLines
+(	float fLinePos,
+	int iNumLines,
+	int* piLines
+)
+{	int iLine = (fLinePos > 0) ? (int)fLinePos : 0;
+	if(iLine >= iNumLines - 1)
+	{	piLines[0] = iNumLines - 1;
+		piLines[1] = iNumLines - 1;
+		return 0.0f;
+	}
+	piLines[0] = iLine;
+	piLines[1] = iLine + 1;
+	return (fLinePos > 0) ? fLinePos - iLine : 0.0f;
+}
+
+//--------------------------------------------------------------------
+// 1. Weighted phase correlation of one frequency as in MAU::GCC1D.
+//--------------------------------------------------------------------
+static inline float sCorrelate
+(	cufftComplex* pLine1,
+	cufftComplex* pLine2,
+	cufftComplex* pSum,
+	float fW1,
+	float fW2,
+	float fFilt
+)
+{	float fX = fW1 * pLine1->x + fW2 * pLine2->x;
+	float fY = fW1 * pLine1->y + fW2 * pLine2->y;
+	float fRefX = pSum->x - fX;
+	float fRefY = pSum->y - fY;
+	float fA1 = sqrtf(fX * fX + fY * fY);
+	float fA2 = sqrtf(fRefX * fRefX + fRefY * fRefY);
+	return (fRefX * fX + fRefY * fY) * fFilt / (fA1 * fA2 + (float)1e-20);
+}
+
+void CLineScoreJob::DoBlock(int iFirst, int iCount, int iThread)
+{
+	m_pLineScore->ScoreBlock(m_pfLinePos, iFirst, iCount,
+	   m_pfScores, iThread);
+}
+
+CLineScore::CLineScore(void)
+{
+	m_ppCmpPlanes = 0L;
+	m_pfWeights = 0L;
+	m_pfWorkBufs = 0L;
+	m_iNumThreads = 1;
+}
+
+CLineScore::~CLineScore(void)
+{
+	this->Clean();
+}
+
+void CLineScore::Clean(void)
+{
+	if(m_pfWeights != 0L) delete[] m_pfWeights;
+	if(m_pfWorkBufs != 0L) delete[] m_pfWorkBufs;
+	m_pfWeights = 0L;
+	m_pfWorkBufs = 0L;
+	m_ppCmpPlanes = 0L;
+}
+
+//--------------------------------------------------------------------
+// 1. The weights are the B-factor filter of MAU::GCC1D with the
+//    zero frequency excluded.
+//--------------------------------------------------------------------
+void CLineScore::Setup
+(	CPossibleLines* pPossibleLines,
+	float fBFactor
+)
+{	this->Clean();
+	m_ppCmpPlanes = pPossibleLines->m_ppCmpPlanes;
+	m_iNumProjs = pPossibleLines->m_iNumProjs;
+	m_iNumLines = pPossibleLines->m_iNumLines;
+	m_iCmpSize = pPossibleLines->m_iCmpSize;
+	m_iNumThreads = MU::GetHostThreads();
+	//-----------------
+	m_pfWeights = new float[m_iCmpSize];
+	m_pfWeights[0] = 0.0f;
+	m_fWeightSum = 0.0f;
+	for(int i=1; i<m_iCmpSize; i++)
+	{	float fFilt = i / (2.0f * (m_iCmpSize - 1));
+		m_pfWeights[i] = expf(-2.0f * fBFactor * fFilt * fFilt);
+		m_fWeightSum += m_pfWeights[i];
+	}
+	//-----------------
+	size_t tSize = (size_t)m_iNumThreads * m_iCmpSize * 2;
+	m_pfWorkBufs = new float[tSize];
+}
+
+//--------------------------------------------------------------------
+// 1. Candidates are spread over the host threads one by one. Each
+//    thread sums the lines of its candidates in its own work line.
+//--------------------------------------------------------------------
+void CLineScore::DoIt
+(	float* pfLinePos,
+	int iNumCands,
+	float* pfScores
+)
+{	CLineScoreJob aJob;
+	aJob.m_pLineScore = this;
+	aJob.m_pfLinePos = pfLinePos;
+	aJob.m_pfScores = pfScores;
+	MU::CHostThreads aHostThreads;
+	aHostThreads.DoIt(&aJob, iNumCands, 1, m_iNumThreads);
+}
+
+void CLineScore::ScoreBlock
+(	float* pfLinePos,
+	int iFirst,
+	int iCount,
+	float* pfScores,
+	int iThread
+)
+{	float* pfSum = m_pfWorkBufs + (size_t)iThread * m_iCmpSize * 2;
+	for(int c=iFirst; c<iFirst+iCount; c++)
+	{	pfScores[c] = mScore(pfLinePos + c * m_iNumProjs, pfSum);
+	}
+}
+
+//--------------------------------------------------------------------
+// 1. The first pass sums the interpolated lines. The second pass
+//    interpolates each line again and correlates it with the sum
+//    minus itself. The complex arithmetic runs on 8 lanes of
+//    partial sums so that it vectorizes.
+//--------------------------------------------------------------------
+float CLineScore::mScore(float* pfLinePos, float* pfSum)
+{
+	int iSize = m_iCmpSize * 2;
+	memset(pfSum, 0, sizeof(float) * iSize);
+	int aiLines[2] = {0};
+	for(int p=0; p<m_iNumProjs; p++)
+	{	float fW2 = sFindLines(pfLinePos[p], m_iNumLines, aiLines);
+		float fW1 = 1.0f - fW2;
+		float* pfLine1 = (float*)(m_ppCmpPlanes[p]
+		   + (size_t)aiLines[0] * m_iCmpSize);
+		float* pfLine2 = (float*)(m_ppCmpPlanes[p]
+		   + (size_t)aiLines[1] * m_iCmpSize);
+		for(int i=0; i<iSize; i++)
+		{	pfSum[i] += (fW1 * pfLine1[i] + fW2 * pfLine2[i]);
+		}
+	}
+	//-----------------
+	int iVecSize = m_iCmpSize / s_iLanes * s_iLanes;
+	float fCCSum = 0.0f;
+	for(int p=0; p<m_iNumProjs; p++)
+	{	float fW2 = sFindLines(pfLinePos[p], m_iNumLines, aiLines);
+		float fW1 = 1.0f - fW2;
+		cufftComplex* pLine1 = m_ppCmpPlanes[p]
+		   + (size_t)aiLines[0] * m_iCmpSize;
+		cufftComplex* pLine2 = m_ppCmpPlanes[p]
+		   + (size_t)aiLines[1] * m_iCmpSize;
+		cufftComplex* pSum = (cufftComplex*)pfSum;
+		//----------------
+		float afCC[s_iLanes] = {0.0f};
+		for(int i=0; i<iVecSize; i+=s_iLanes)
+		{	for(int k=0; k<s_iLanes; k++)
+			{	int j = i + k;
+				afCC[k] += sCorrelate(pLine1 + j, pLine2 + j,
+				   pSum + j, fW1, fW2, m_pfWeights[j]);
+			}
+		}
+		for(int j=iVecSize; j<m_iCmpSize; j++)
+		{	afCC[0] += sCorrelate(pLine1 + j, pLine2 + j,
+			   pSum + j, fW1, fW2, m_pfWeights[j]);
+		}
+		float fCC = 0.0f;
+		for(int k=0; k<s_iLanes; k++) fCC += afCC[k];
+		if(m_fWeightSum > 0) fCCSum += (fCC / m_fWeightSum);
+	}
+	return fCCSum / m_iNumProjs;
+}
@@ -14,6 +14,7 @@ CRefineTiltAxis::CRefineTiltAxis(void)
 	m_pfSearchRange = 0L;
 	m_pfTerms = 0L;
 	m_pfCoeff = 0L;
+	m_pfLinePos = 0L;
 }
 
 CRefineTiltAxis::~CRefineTiltAxis(void)
@@ -27,10 +28,13 @@ void CRefineTiltAxis::Clean(void)
 	if(m_pfSearchRange != 0L) delete[] m_pfSearchRange;
 	if(m_pfTerms != 0L) delete[] m_pfTerms;
 	if(m_pfCoeff != 0L) delete[] m_pfCoeff;
+	if(m_pfLinePos != 0L) delete[] m_pfLinePos;
 	m_pfRotAngles = 0L;
 	m_pfSearchRange = 0L;
 	m_pfTerms = 0L;
 	m_pfCoeff = 0L;
+	m_pfLinePos = 0L;
+	m_aLineScore.Clean();
 }
 
 void CRefineTiltAxis::GetRotAngles(float* pfRotAngles)
@@ -49,17 +53,16 @@ void CRefineTiltAxis::Setup(int iDim, int iIterations, float fTol)
 	m_pfCoeff = new float[m_iDim];
 }
 
-float CRefineTiltAxis::Refine
-(	CPossibleLines* pPossibleLines,
-	CLineSet* pLineSet
-)
+float CRefineTiltAxis::Refine(CPossibleLines* pPossibleLines)
 {	m_pPossibleLines = pPossibleLines;
-	m_pLineSet = pLineSet;
+	m_aLineScore.Setup(m_pPossibleLines, 10.0f);
 	//--------------------
 	m_iNumProjs = m_pPossibleLines->m_iNumProjs;
 	m_iNumLines = m_pPossibleLines->m_iNumLines;
 	if(m_pfRotAngles != 0L) delete[] m_pfRotAngles;
+	if(m_pfLinePos != 0L) delete[] m_pfLinePos;
 	m_pfRotAngles = new float[m_iNumProjs];
+	m_pfLinePos = new float[m_iNumProjs];
 	//-------------------------------------
 	float* pfRotAngles = m_pPossibleLines->m_pfRotAngles;
 	m_fRefRot = (pfRotAngles[0] + pfRotAngles[m_iNumLines-1]) / 2;
@@ -85,20 +88,17 @@ float CRefineTiltAxis::Refine
 	return 1.0f - m_fBestVal;	
 }
 
+//--------------------------------------------------------------------
+// 1. Each evaluation is a batch of one for GLineScore, which keeps
+//    the lines and its buffers across evaluations.
+//--------------------------------------------------------------------
 float CRefineTiltAxis::Eval(float* pfCoeff)
 {
 	mCalcRotAngles(pfCoeff);	
+	mCalcLinePos();
 	//-----------------
-	GInterpolateLineSet intLineSet;
-	intLineSet.DoIt(m_pPossibleLines, m_pfRotAngles, m_pLineSet);
-	//-----------------
-	CSumLines sumLines;
-	sumLines.DoIt(m_pLineSet);
-	cufftComplex* gCmpSum = sumLines.GetSum(true);
-	//-----------------
-	CCalcScore calcScore;
-	float fScore = calcScore.DoIt(m_pLineSet, gCmpSum);
-	if(gCmpSum != 0L) cudaFree(gCmpSum);
+	float fScore = 0.0f;
+	m_aLineScore.DoIt(m_pfLinePos, 1, &fScore);
 	return 1.0f - fScore;
 }
 
@@ -119,3 +119,26 @@ void CRefineTiltAxis::mCalcRotAngles(float* pfCoeff)
 	}
 }
 
+//--------------------------------------------------------------------
+// 1. Each rotation angle is converted to a fractional line position
+//    given as positions for GLineScore: the first line is used
+//    within its step and the last line from the step before it.
+//--------------------------------------------------------------------
+void CRefineTiltAxis::mCalcLinePos(void)
+{
+	for(int i=0; i<m_iNumProjs; i++)
+	{	float fLine = m_pPossibleLines->CalcLinePos(m_pfRotAngles[i]);
+		int iLine1 = (int)fLine;
+		if(iLine1 < 0) iLine1 = 0;
+		int iLine2 = iLine1 + 1;
+		if(iLine2 >= m_iNumLines)
+		{	iLine2 = m_iNumLines - 1;
+			iLine1 = iLine2 - 1;
+		}
+		//----------------
+		float fW = 1.0f - (fLine - iLine1);
+		if(iLine1 == 0) fW = 1.0f;
+		else if(iLine2 == (m_iNumLines - 1)) fW = 0.0f;
+		m_pfLinePos[i] = iLine1 + (1.0f - fW);
+	}
+}
@@ -0,0 +1,226 @@
+#include "CCommonLineInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo;
+using namespace McAreTomo::AreTomo::CommonLine;
+
+//--------------------------------------------------------------------
+// 1. Point i of the interpolated line of iProj at fLinePos, see
+//    sFindLines in CLineScore.cpp.
+//--------------------------------------------------------------------
+static __device__ cufftComplex mGGetPoint
+(	cufftComplex* gCmpPlanes,
+	float fLinePos,
+	int iProj,
+	int iNumLines,
+	int iCmpSize,
+	int i
+)
+{	int iLine = (fLinePos > 0) ? (int)fLinePos : 0;
+	float fW2 = (fLinePos > 0) ? fLinePos - iLine : 0.0f;
+	int iLine2 = iLine + 1;
+	if(iLine >= iNumLines - 1)
+	{	iLine = iNumLines - 1;
+		iLine2 = iLine;
+		fW2 = 0.0f;
+	}
+	cufftComplex* gPlane = gCmpPlanes + (size_t)iProj * iNumLines
+	   * iCmpSize + i;
+	cufftComplex aC1 = gPlane[iLine * iCmpSize];
+	cufftComplex aC2 = gPlane[iLine2 * iCmpSize];
+	aC1.x = (1.0f - fW2) * aC1.x + fW2 * aC2.x;
+	aC1.y = (1.0f - fW2) * aC1.y + fW2 * aC2.y;
+	return aC1;
+}
+
+//--------------------------------------------------------------------
+// 1. blockIdx.y is the candidate. Each thread takes frequencies
+//    with a stride, sums the lines of all projections there and
+//    then adds the weighted phase correlation of each line with
+//    the sum minus itself, as in mGConv of MAU::GCC1D.
+//--------------------------------------------------------------------
+static __global__ void mGScore
+(	cufftComplex* gCmpPlanes,
+	float* gfLinePos,
+	int iNumProjs,
+	int iNumLines,
+	int iCmpSize,
+	float fBFactor,
+	float* gfSums
+)
+{	extern __shared__ float s_afSums[];
+	float* gfPos = gfLinePos + blockIdx.y * iNumProjs;
+	float fCCSum = 0.0f;
+	int iStride = gridDim.x * blockDim.x;
+	for(int i=blockIdx.x*blockDim.x+threadIdx.x; i<iCmpSize; i+=iStride)
+	{	if(i == 0) continue;
+		float fFilt = i / (2.0f * (iCmpSize - 1));
+		fFilt = expf(-2.0f * fBFactor * fFilt * fFilt);
+		//----------------
+		cufftComplex aSum = {0.0f, 0.0f};
+		for(int p=0; p<iNumProjs; p++)
+		{	cufftComplex aC = mGGetPoint(gCmpPlanes, gfPos[p], p,
+			   iNumLines, iCmpSize, i);
+			aSum.x += aC.x;
+			aSum.y += aC.y;
+		}
+		for(int p=0; p<iNumProjs; p++)
+		{	cufftComplex aC = mGGetPoint(gCmpPlanes, gfPos[p], p,
+			   iNumLines, iCmpSize, i);
+			float fRefX = aSum.x - aC.x;
+			float fRefY = aSum.y - aC.y;
+			float fA1 = sqrtf(aC.x * aC.x + aC.y * aC.y);
+			float fA2 = sqrtf(fRefX * fRefX + fRefY * fRefY);
+			fCCSum += (fRefX * aC.x + fRefY * aC.y) * fFilt
+			   / (fA1 * fA2 + (float)1e-20);
+		}
+	}
+	s_afSums[threadIdx.x] = fCCSum;
+	__syncthreads();
+	//-----------------
+	int iOffset = blockDim.x / 2;
+	while(iOffset > 0)
+	{	if(threadIdx.x < iOffset)
+		{	s_afSums[threadIdx.x] += s_afSums[threadIdx.x + iOffset];
+		}
+		__syncthreads();
+		iOffset /= 2;
+	}
+	if(threadIdx.x != 0) return;
+	gfSums[blockIdx.y * gridDim.x + blockIdx.x] = s_afSums[0];
+}
+
+static __global__ void mGReduce
+(	float* gfSums,
+	int iNumParts,
+	int iNumCands,
+	float fNorm,
+	float* gfScores
+)
+{	int c = blockIdx.x * blockDim.x + threadIdx.x;
+	if(c >= iNumCands) return;
+	//-----------------
+	float fSum = 0.0f;
+	float* gfSum = gfSums + c * iNumParts;
+	for(int i=0; i<iNumParts; i++) fSum += gfSum[i];
+	gfScores[c] = fSum * fNorm;
+}
+
+GLineScore::GLineScore(void)
+{
+	m_gCmpPlanes = 0L;
+	m_gfBuf = 0L;
+	m_iMaxCands = 0;
+	m_pHostScore = 0L;
+	cudaStreamCreate(&m_stream);
+}
+
+GLineScore::~GLineScore(void)
+{
+	this->Clean();
+	cudaStreamDestroy(m_stream);
+}
+
+void GLineScore::Clean(void)
+{
+	if(m_gCmpPlanes != 0L) cudaFree(m_gCmpPlanes);
+	if(m_gfBuf != 0L) cudaFree(m_gfBuf);
+	if(m_pHostScore != 0L) delete m_pHostScore;
+	m_gCmpPlanes = 0L;
+	m_gfBuf = 0L;
+	m_pHostScore = 0L;
+	m_iMaxCands = 0;
+}
+
+void GLineScore::Setup
+(	CPossibleLines* pPossibleLines,
+	float fBFactor
+)
+{	this->Clean();
+	m_iNumProjs = pPossibleLines->m_iNumProjs;
+	m_iNumLines = pPossibleLines->m_iNumLines;
+	m_iCmpSize = pPossibleLines->m_iCmpSize;
+	m_fBFactor = fBFactor;
+	//-----------------
+	if(MU::GetBackend() != MU::gpuBackend)
+	{	m_pHostScore = new CLineScore;
+		m_pHostScore->Setup(pPossibleLines, fBFactor);
+		return;
+	}
+	//-----------------
+	m_fWeightSum = 0.0f;
+	for(int i=1; i<m_iCmpSize; i++)
+	{	float fFilt = i / (2.0f * (m_iCmpSize - 1));
+		m_fWeightSum += expf(-2.0f * m_fBFactor * fFilt * fFilt);
+	}
+	//-----------------
+	size_t tPlane = (size_t)m_iNumLines * m_iCmpSize;
+	cudaMalloc(&m_gCmpPlanes, sizeof(cufftComplex) * tPlane
+	   * m_iNumProjs);
+	for(int i=0; i<m_iNumProjs; i++)
+	{	cudaMemcpy(m_gCmpPlanes + i * tPlane,
+		   pPossibleLines->m_ppCmpPlanes[i],
+		   sizeof(cufftComplex) * tPlane, cudaMemcpyDefault);
+	}
+}
+
+//--------------------------------------------------------------------
+// 1. pfLinePos has m_iNumProjs positions per candidate. One launch
+//    scores all candidates, the number of blocks per candidate
+//    shrinking as the batch grows.
+//--------------------------------------------------------------------
+void GLineScore::DoIt
+(	float* pfLinePos,
+	int iNumCands,
+	float* pfScores
+)
+{	if(m_pHostScore != 0L)
+	{	m_pHostScore->DoIt(pfLinePos, iNumCands, pfScores);
+		return;
+	}
+	//-----------------
+	dim3 aBlockDim(256, 1);
+	int iNumParts = (m_iCmpSize + aBlockDim.x - 1) / aBlockDim.x;
+	int iMaxParts = 1024 / iNumCands;
+	if(iNumParts > iMaxParts) iNumParts = iMaxParts;
+	if(iNumParts < 1) iNumParts = 1;
+	mAlloc(iNumCands);
+	//-----------------
+	float* gfLinePos = m_gfBuf;
+	float* gfScores = gfLinePos + m_iMaxCands * m_iNumProjs;
+	float* gfSums = gfScores + m_iMaxCands;
+	cudaMemcpyAsync(gfLinePos, pfLinePos, sizeof(float) * iNumCands
+	   * m_iNumProjs, cudaMemcpyDefault, m_stream);
+	//-----------------
+	dim3 aGridDim(iNumParts, iNumCands);
+	size_t tSmBytes = sizeof(float) * aBlockDim.x;
+	mGScore<<<aGridDim, aBlockDim, tSmBytes, m_stream>>>(m_gCmpPlanes,
+	   gfLinePos, m_iNumProjs, m_iNumLines, m_iCmpSize, m_fBFactor,
+	   gfSums);
+	//-----------------
+	float fNorm = 0.0f;
+	if(m_fWeightSum > 0) fNorm = 1.0f / (m_fWeightSum * m_iNumProjs);
+	aBlockDim.x = 64;
+	aGridDim.x = (iNumCands + aBlockDim.x - 1) / aBlockDim.x;
+	aGridDim.y = 1;
+	mGReduce<<<aGridDim, aBlockDim, 0, m_stream>>>(gfSums, iNumParts,
+	   iNumCands, fNorm, gfScores);
+	cudaMemcpyAsync(pfScores, gfScores, sizeof(float) * iNumCands,
+	   cudaMemcpyDefault, m_stream);
+	cudaStreamSynchronize(m_stream);
+}
+
+//--------------------------------------------------------------------
+// 1. One buffer holds the line positions, the scores, and the
+//    partial sums. There are at most max(1024, candidates) blocks.
+//--------------------------------------------------------------------
+void GLineScore::mAlloc(int iNumCands)
+{
+	if(iNumCands <= m_iMaxCands) return;
+	if(m_gfBuf != 0L) cudaFree(m_gfBuf);
+	m_iMaxCands = iNumCands;
+	size_t tFloats = (size_t)m_iMaxCands * (m_iNumProjs + 2) + 1024;
+	cudaMalloc(&m_gfBuf, sizeof(float) * tFloats);
+}
@@ -26,6 +26,9 @@ static void sCalcCmpSize(int* piSize, int* piCmpSize)
 CCorrTomoStack::CCorrTomoStack(void)
 {
 	m_gfLocalParam = 0L;
+	m_gfOwnBuf = 0L;
+	m_tOwnBytes = 0;
+	m_bOwnBuffers = false;
 	m_pOutSeries = 0L;
 	m_pGRWeight = 0L;
 	m_iNthGpu = -1;
@@ -43,6 +46,10 @@ void CCorrTomoStack::Clean(void)
 	{	cudaFree(m_gfLocalParam);
 		m_gfLocalParam = 0L;
 	}
+	if(m_gfOwnBuf != 0L)
+	{	cudaFree(m_gfOwnBuf);
+		m_gfOwnBuf = 0L;
+	}
 	if(m_pOutSeries != 0L) 
 	{	delete m_pOutSeries;
 		m_pOutSeries = 0L;
@@ -77,15 +84,16 @@ void CCorrTomoStack::Set1(int iNumPatches, float fTiltAxis)
 	CCorrectUtil::CalcAlignedSize(m_aiStkSize, fTiltAxis, m_aiAlnSize);
 	m_aiAlnSize[2] = m_aiStkSize[2];
 	//-----------------
-	MD::CBufferPool* pBufPool = MD::CBufferPool::GetInstance(m_iNthGpu);
-	MD::CStackBuffer* pTmpBuf = pBufPool->GetBuffer(MD::EBuffer::tmp);
-	//-----------------
-	m_gfRawProj = (float*)pTmpBuf->GetFrame(0);
-	//-----------------
-	int* piCorrSize = m_aiAlnSize;
-	if(m_aiAlnSize[1] < m_aiStkSize[1]) piCorrSize = m_aiStkSize;
-	m_gfCorrProj = (float*)pTmpBuf->GetFrame(1);
-	m_gfBinProj = (float*)pTmpBuf->GetFrame(2);
+	if(m_bOwnBuffers) mCreateOwnBuffers();
+	else
+	{	MD::CBufferPool* pBufPool = 
+		   MD::CBufferPool::GetInstance(m_iNthGpu);
+		MD::CStackBuffer* pTmpBuf = 
+		   pBufPool->GetBuffer(MD::EBuffer::tmp);
+		m_gfRawProj = (float*)pTmpBuf->GetFrame(0);
+		m_gfCorrProj = (float*)pTmpBuf->GetFrame(1);
+		m_gfBinProj = (float*)pTmpBuf->GetFrame(2);
+	}
 	//-----------------
 	bool bPadded = true;
         int aiAlnPadSize[2] = {0};
@@ -154,6 +162,11 @@ void CCorrTomoStack::Set4(bool bForRecon)
 	m_bForRecon = bForRecon;
 }
 
+void CCorrTomoStack::UseOwnBuffers(bool bOwnBuffers)
+{
+	m_bOwnBuffers = bOwnBuffers;
+}
+
 MD::CTiltSeries* CCorrTomoStack::GetCorrectedStack(bool bClean)
 {
 	MD::CTiltSeries* pRetStack = m_pOutSeries;
@@ -182,6 +195,34 @@ void CCorrTomoStack::DoIt(int iNthSeries, MAM::CAlignParam* pAlignParam)
 	}
 }
 
+//-------------------------------------------------------------------
+// 1. Three padded frames large enough for both the raw and the
+//    aligned projection. The binned frame is never larger.
+// 2. The size does not depend on binning. The buffer is kept when
+//    Set1 is called again unless it becomes too small.
+//-------------------------------------------------------------------
+void CCorrTomoStack::mCreateOwnBuffers(void)
+{
+	int iSizeX = (m_aiAlnSize[0] > m_aiStkSize[0]) ?
+	   m_aiAlnSize[0] : m_aiStkSize[0];
+	int iSizeY = (m_aiAlnSize[1] > m_aiStkSize[1]) ?
+	   m_aiAlnSize[1] : m_aiStkSize[1];
+	size_t tFmFloats = (size_t)(iSizeX / 2 + 1) * 2 * iSizeY;
+	size_t tBytes = sizeof(float) * tFmFloats * 3;
+	//-----------------
+	if(m_gfOwnBuf != 0L && tBytes > m_tOwnBytes)
+	{	cudaFree(m_gfOwnBuf);
+		m_gfOwnBuf = 0L;
+	}
+	if(m_gfOwnBuf == 0L)
+	{	cudaMalloc(&m_gfOwnBuf, tBytes);
+		m_tOwnBytes = tBytes;
+	}
+	m_gfRawProj = m_gfOwnBuf;
+	m_gfCorrProj = m_gfOwnBuf + tFmFloats;
+	m_gfBinProj = m_gfOwnBuf + tFmFloats * 2;
+}
+
 void CCorrTomoStack::mCorrectProj(int iProj)
 {
 	MD::CTsPackage* pTsPkg = MD::CTsPackage::GetInstance(m_iNthGpu);
@@ -76,6 +76,8 @@ public:
 	);
 private:
 	float m_fD2R;
+	int m_aiInSize[3];
+	int m_aiOutSize[2];
 	int m_iInImgX;
 	int m_iOutImgX;
 	int m_iOutImgY;
@@ -129,16 +131,25 @@ public:
 	void Set2(float fOutBin, bool bFourierCrop, bool bRandFill);
 	void Set3(bool bShiftOnly, bool bCorrInt, bool bRWeight);
 	void Set4(bool bForRecon);
+	//-----------------------------------------------------------
+	// Must be called before Set1. Concurrent users on the same
+	// GPU cannot share the tmp buffer of CBufferPool.
+	//-----------------------------------------------------------
+	void UseOwnBuffers(bool bOwnBuffers);
 	void DoIt(int iNthSeries, MAM::CAlignParam* pAlignParam);
 	MD::CTiltSeries* GetCorrectedStack(bool bClean);
 	void GetBinning(float* pfBinning);
 	void Clean(void);
 private:
 	void mCorrectProj(int iProj);
+	void mCreateOwnBuffers(void);
 	float* m_gfRawProj;
 	float* m_gfCorrProj;
 	float* m_gfBinProj;
 	float* m_gfLocalParam;
+	float* m_gfOwnBuf;
+	size_t m_tOwnBytes;
+	bool m_bOwnBuffers;
 	//-----------------
 	MAM::CAlignParam* m_pAlignParam;
 	GCorrPatchShift m_aGCorrPatchShift;
@@ -11,27 +11,29 @@
 using namespace McAreTomo::AreTomo;
 using namespace McAreTomo::AreTomo::Correct;
 
-// giInSize: padded sizeX, sizeY, numPatches
-static __device__ __constant__ int giInSize[3];
-static __device__ __constant__ int giOutSize[2];
-
+//-----------------------------------------------------------------------------
+// aiInSize: padded sizeX, sizeY, numPatches. The sizes are kernel arguments
+//    so that CCorrProj and CCorrTomoStack of concurrent patch workers can
+//    use different sizes at the same time.
+//-----------------------------------------------------------------------------
 static __device__ void mGCalcLocalShift
 (	float* gfLocalAlnParams,
+	int3 aiInSize,
 	int iInImgX,
      	float afXY[2],
 	float afLS[2]
 )
-{	float* gfPatCentYs = gfLocalAlnParams + giInSize[2];
-	float* gfLocalShiftXs = gfLocalAlnParams + giInSize[2] * 2;
-	float* gfLocalShiftYs = gfLocalAlnParams + giInSize[2] * 3;
-	float* gfGood = gfLocalAlnParams + giInSize[2] * 4;
+{	float* gfPatCentYs = gfLocalAlnParams + aiInSize.z;
+	float* gfLocalShiftXs = gfLocalAlnParams + aiInSize.z * 2;
+	float* gfLocalShiftYs = gfLocalAlnParams + aiInSize.z * 3;
+	float* gfGood = gfLocalAlnParams + aiInSize.z * 4;
 	//-------------------------------------------------
 	int iCount = 0;
 	float fSx = 0.0f, fSy = 0.0f, fW = 0.0f, fSumW = 0.0f;
-	for(int p=0; p<giInSize[2]; p++)
+	for(int p=0; p<aiInSize.z; p++)
 	{	if(gfGood[p] < 0.9f) continue;
 		afLS[0] = (afXY[0] - gfLocalAlnParams[p]) / iInImgX;
-		afLS[1] = (afXY[1] - gfPatCentYs[p]) / giInSize[1];
+		afLS[1] = (afXY[1] - gfPatCentYs[p]) / aiInSize.y;
 		fW = expf(-100.0f * (afLS[0] * afLS[0] + afLS[1] * afLS[1]));
 		fSx += (gfLocalShiftXs[p] * fW);
 		fSy += (gfLocalShiftYs[p] * fW);
@@ -49,28 +51,29 @@ static __device__ void mGCalcLocalShift
 
 static __device__ float mGRandom
 (	int x, int y, 
+	int3 aiInSize,
 	int iInImgX,
 	float* gfInImg
 )
 {	if(x < 0) x = -x;
 	if(y < 0) y = -y;
 	if(x >= iInImgX) x = iInImgX - 1 - (x % iInImgX);
-	if(y >= giInSize[1]) y = giInSize[1] - 1 - (y % giInSize[1]);
+	if(y >= aiInSize.y) y = aiInSize.y - 1 - (y % aiInSize.y);
 	//-----------------------------------------------------------
 	int iWin = 51, ix = 0, iy = 0;
 	int iSize = iWin * iWin;
-	unsigned int next = y * giInSize[0] + x;
+	unsigned int next = y * aiInSize.x + x;
 	for(int i=0; i<20; i++)
 	{	next = (next * 509 + 283) % iSize;
 		ix = (next % iSize) - iWin / 2 + x;
 		if(ix < 0 || ix >= iInImgX) continue;
 		//-----------------------------------
 		iy = (next / iWin) - iWin / 2 + y;
-		if(iy < 0 || iy >= giInSize[1]) continue;
+		if(iy < 0 || iy >= aiInSize.y) continue;
 		//---------------------------------------
-		return gfInImg[iy * giInSize[0] + ix];
+		return gfInImg[iy * aiInSize.x + ix];
 	}
-	return gfInImg[y * giInSize[0] + x];
+	return gfInImg[y * aiInSize.x + x];
 }
 //-----------------------------------------------------------------------------
 // Imod coordinate system: [0, Nx] where 0 is the left edge of the image and
@@ -82,6 +85,8 @@ static __device__ float mGRandom
 //-----------------------------------------------------------------------------
 static __global__ void mGCorrect
 (	float* gfInImg,
+	int3 aiInSize,
+	int2 aiOutSize,
 	int iInImgX,
 	float fGlobalShiftX,
 	float fGlobalShiftY,
@@ -92,12 +97,12 @@ static __global__ void mGCorrect
 )
 {	int x = 0, y = 0;
 	y = blockIdx.y * blockDim.y + threadIdx.y;
-	if(y >= giOutSize[1]) return;
-	int i = y * giOutSize[0] + blockIdx.x;
+	if(y >= aiOutSize.y) return;
+	int i = y * aiOutSize.x + blockIdx.x;
 	//------------------------------------
 	float afXY[2] = {0.0f}, afTmp[2];
 	afXY[0] = blockIdx.x + 0.5f - gridDim.x * 0.5f;
-	afXY[1] = y + 0.5f - giOutSize[1] * 0.5f;
+	afXY[1] = y + 0.5f - aiOutSize.y * 0.5f;
 	//---------------------------------------
 	afTmp[0] = cosf(fRotAngle);
 	afTmp[1] = sinf(fRotAngle);
@@ -105,23 +110,25 @@ static __global__ void mGCorrect
 	afXY[1] = afXY[0] * afTmp[1] + afXY[1] * afTmp[0];
 	afXY[0] = fT;
 	//-----------
-	if(giInSize[2] > 0 && gfLocalAlnParams != 0L)
-	{	mGCalcLocalShift(gfLocalAlnParams, iInImgX, afXY, afTmp);
+	if(aiInSize.z > 0 && gfLocalAlnParams != 0L)
+	{	mGCalcLocalShift(gfLocalAlnParams, aiInSize, iInImgX,
+		   afXY, afTmp);
 		afXY[0] += afTmp[0];
 		afXY[1] += afTmp[1];
 	}
 	afXY[0] += (fGlobalShiftX + iInImgX * 0.5f);
-	afXY[1] += (fGlobalShiftY + giInSize[1] * 0.5f);
+	afXY[1] += (fGlobalShiftY + aiInSize.y * 0.5f);
 	//----------------------------------------------
 	x = (int)(afXY[0] + 0.5f);
 	y = (int)(afXY[1] + 0.5f);
 	//------------------------
-	if(x >= 0 && x < iInImgX && y >= 0 && y < giInSize[1]) 
-	{	gfOutImg[i] = gfInImg[y * giInSize[0] + x];
+	if(x >= 0 && x < iInImgX && y >= 0 && y < aiInSize.y) 
+	{	gfOutImg[i] = gfInImg[y * aiInSize.x + x];
 		return;
 	}
 	//-------------
-	if(bRandomFill) gfOutImg[i] = mGRandom(x, y, iInImgX, gfInImg);
+	if(bRandomFill) gfOutImg[i] = mGRandom(x, y, aiInSize,
+	   iInImgX, gfInImg);
 	else gfOutImg[i] = (float)(-1e30);
 }
 
@@ -141,9 +148,11 @@ void GCorrPatchShift::SetSizes
 	bool bOutPadded,
 	int iNumPatches
 )
-{	int aiInSize[] = {piInSize[0], piInSize[1], iNumPatches};
-	cudaMemcpyToSymbol(giInSize, aiInSize, sizeof(giInSize));
-	cudaMemcpyToSymbol(giOutSize, piOutSize, sizeof(giOutSize));
+{	m_aiInSize[0] = piInSize[0];
+	m_aiInSize[1] = piInSize[1];
+	m_aiInSize[2] = iNumPatches;
+	m_aiOutSize[0] = piOutSize[0];
+	m_aiOutSize[1] = piOutSize[1];
 	//----------------------------------------------------------
 	m_iInImgX = piInSize[0];
 	if(bInPadded) m_iInImgX = (piInSize[0] / 2 - 1) * 2;
@@ -166,7 +175,11 @@ void GCorrPatchShift::DoIt
 	dim3 aGridDim(m_iOutImgX, 1);
 	aGridDim.y = (m_iOutImgY + aBlockDim.y - 1) / aBlockDim.y;
 	//--------------------------------------------------------
-	mGCorrect<<<aGridDim, aBlockDim>>>(gfInImg, m_iInImgX,
+	int3 aiInSize = make_int3(m_aiInSize[0], m_aiInSize[1],
+	   m_aiInSize[2]);
+	int2 aiOutSize = make_int2(m_aiOutSize[0], m_aiOutSize[1]);
+	mGCorrect<<<aGridDim, aBlockDim>>>(gfInImg, aiInSize,
+	   aiOutSize, m_iInImgX,
 	   pfGlobalShift[0], pfGlobalShift[1], fRotAngle,
 	   gfLocalAlnParams, bRandomFill, gfOutImg);
 }
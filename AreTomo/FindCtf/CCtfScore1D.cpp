@@ -0,0 +1,192 @@
+#include "CFindCtfInc.h"
+#include <math.h>
+#include <stdio.h>
+#include <memory.h>
+
+using namespace McAreTomo::AreTomo::FindCtf;
+
+static const int s_iCandBlock = 64;
+static const int s_iBinBlock = 64;
+
+//--------------------------------------------------------------------
+// 1. Same polynomial sin^2 as in CCtfScore2D.cpp so that the loop
+//    over candidates vectorizes.
+//--------------------------------------------------------------------
+static inline float sSin2(float fPhase)
+{
+	float fK = fPhase * 0.318309886f;
+	fK = (float)(int)(fK + (fK >= 0.0f ? 0.5f : -0.5f));
+	float fR = fPhase - fK * 3.140625f;
+	fR = fR - fK * 9.67653589793e-4f;
+	float fR2 = fR * fR;
+	float fS = -2.50521084e-8f;
+	fS = fS * fR2 + 2.75573192e-6f;
+	fS = fS * fR2 - 1.98412698e-4f;
+	fS = fS * fR2 + 8.33333333e-3f;
+	fS = fS * fR2 - 1.66666667e-1f;
+	fS = fR + fR * fR2 * fS;
+	return fS * fS;
+}
+
+void CCtfScore1DJob::DoBlock(int iFirst, int iCount, int iThread)
+{
+	m_pCtfScore1D->ScoreBlock(m_pfVals, m_pfCands + iFirst * 2,
+	   iCount, m_dStd2, m_pfScores + iFirst);
+}
+
+CCtfScore1D::CCtfScore1D(void)
+{
+	m_pfTables = 0L;
+	m_iCmpSize = 0;
+	m_iFirst = 0;
+	m_iNumBins = 0;
+	m_iNumThreads = 1;
+}
+
+CCtfScore1D::~CCtfScore1D(void)
+{
+	this->Clean();
+}
+
+void CCtfScore1D::Clean(void)
+{
+	if(m_pfTables != 0L) delete[] m_pfTables;
+	m_pfTables = 0L;
+	m_iFirst = 0;
+	m_iNumBins = 0;
+}
+
+void CCtfScore1D::SetParam(MD::CCtfParam* pCtfParam)
+{
+	m_fWavelength = pCtfParam->m_fWavelength;
+	m_fCs = pCtfParam->m_fCs;
+	m_fAmpPhase = (float)atanf(pCtfParam->m_fAmpContrast /
+	   sqrtf(1.0f - pCtfParam->m_fAmpContrast *
+	   pCtfParam->m_fAmpContrast));
+}
+
+void CCtfScore1D::SetSize(int iCmpSize)
+{
+	m_iCmpSize = iCmpSize;
+}
+
+//--------------------------------------------------------------------
+// 1. Same band as GCC1D::DoIt, i.e. the bins x with fFreqLow <= x
+//    < fFreqHigh. For each bin the tables hold pi * lambda * s^2,
+//    the Cs term, and the B-factor.
+// 2. Must be called after SetParam and SetSize.
+//--------------------------------------------------------------------
+void CCtfScore1D::Setup
+(	float fFreqLow,
+	float fFreqHigh,
+	float fBFactor
+)
+{	this->Clean();
+	m_iNumThreads = MU::GetHostThreads();
+	//-----------------
+	int iLast = m_iCmpSize - 1;
+	m_iFirst = m_iCmpSize;
+	for(int x=0; x<m_iCmpSize; x++)
+	{	if(x < fFreqLow || x >= fFreqHigh) continue;
+		if(x < m_iFirst) m_iFirst = x;
+		iLast = x;
+	}
+	if(m_iFirst > iLast) return;
+	m_iNumBins = iLast - m_iFirst + 1;
+	//-----------------
+	m_pfTables = new float[m_iNumBins * 3];
+	float* pfA = m_pfTables;
+	float* pfB = m_pfTables + m_iNumBins;
+	float* pfWeight = m_pfTables + m_iNumBins * 2;
+	float fW2 = m_fWavelength * m_fWavelength;
+	for(int i=0; i<m_iNumBins; i++)
+	{	float fS = (m_iFirst + i) * 0.5f / (m_iCmpSize - 1.0f);
+		float fS2 = fS * fS;
+		pfA[i] = 3.141592654f * m_fWavelength * fS2;
+		pfB[i] = pfA[i] * 0.5f * fW2 * fS2 * m_fCs;
+		pfWeight[i] = expf(-fBFactor * fS2);
+	}
+}
+
+//--------------------------------------------------------------------
+// 1. pfRadialAvg is a host copy of the radial average. The tables
+//    are read only, so several threads may score on one instance
+//    at the same time, e.g. for different tilts of a series.
+// 2. Blocks of 64 candidates are shared by the host threads.
+//--------------------------------------------------------------------
+void CCtfScore1D::DoIt
+(	float* pfRadialAvg,
+	float* pfCands,
+	int iNumCands,
+	float* pfScores
+)
+{	float* pfVals = pfRadialAvg + m_iFirst;
+	double dStd2 = 0.0;
+	for(int i=0; i<m_iNumBins; i++)
+	{	dStd2 += pfVals[i] * (double)pfVals[i];
+	}
+	//-----------------
+	CCtfScore1DJob aJob;
+	aJob.m_pCtfScore1D = this;
+	aJob.m_pfVals = pfVals;
+	aJob.m_pfCands = pfCands;
+	aJob.m_pfScores = pfScores;
+	aJob.m_dStd2 = dStd2;
+	MU::CHostThreads aHostThreads;
+	aHostThreads.DoIt(&aJob, iNumCands, s_iCandBlock, m_iNumThreads);
+}
+
+//--------------------------------------------------------------------
+// 1. The loop over candidates is innermost so that it vectorizes
+//    without reordering sums. Blocks of 64 bins are summed in float
+//    and then added to double totals.
+// 2. As in GCC1D the correlated CTF is ctf^2 - 0.5, and the score
+//    is 0 when either side has no variance.
+//--------------------------------------------------------------------
+void CCtfScore1D::ScoreBlock
+(	float* pfVals,
+	float* pfCands,
+	int iNumCands,
+	double dStd2,
+	float* pfScores
+)
+{	float afDf[s_iCandBlock], afPhase[s_iCandBlock];
+	for(int c=0; c<iNumCands; c++)
+	{	afDf[c] = pfCands[2 * c];
+		afPhase[c] = pfCands[2 * c + 1] + m_fAmpPhase;
+	}
+	//-----------------
+	float* pfA = m_pfTables;
+	float* pfB = m_pfTables + m_iNumBins;
+	float* pfWeight = m_pfTables + m_iNumBins * 2;
+	double adCC[s_iCandBlock] = {0.0}, adStd1[s_iCandBlock] = {0.0};
+	float afCC[s_iCandBlock], afStd1[s_iCandBlock];
+	//-----------------
+	for(int b=0; b<m_iNumBins; b+=s_iBinBlock)
+	{	int iEnd = b + s_iBinBlock;
+		if(iEnd > m_iNumBins) iEnd = m_iNumBins;
+		memset(afCC, 0, sizeof(afCC));
+		memset(afStd1, 0, sizeof(afStd1));
+		for(int i=b; i<iEnd; i++)
+		{	float fA = pfA[i], fB = pfB[i];
+			float fW = pfWeight[i], fS = pfVals[i];
+			for(int c=0; c<iNumCands; c++)
+			{	float fC = sSin2(afPhase[c] + fA * afDf[c] - fB);
+				fC = (fC - 0.5f) * fW;
+				afCC[c] += fC * fS;
+				afStd1[c] += fC * fC;
+			}
+		}
+		for(int c=0; c<iNumCands; c++)
+		{	adCC[c] += afCC[c];
+			adStd1[c] += afStd1[c];
+		}
+	}
+	//-----------------
+	for(int c=0; c<iNumCands; c++)
+	{	if(adStd1[c] > 0 && dStd2 > 0)
+		{	pfScores[c] = (float)(adCC[c] / sqrt(adStd1[c] * dStd2));
+		}
+		else pfScores[c] = 0.0f;
+	}
+}
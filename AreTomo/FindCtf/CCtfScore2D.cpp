@@ -0,0 +1,233 @@
+#include "CFindCtfInc.h"
+#include <math.h>
+#include <stdio.h>
+#include <memory.h>
+
+using namespace McAreTomo::AreTomo::FindCtf;
+
+static const int s_iCandBlock = 64;
+
+//--------------------------------------------------------------------
+// 1. sin^2 has a period of pi. The phase is reduced to [-pi/2, pi/2]
+//    with pi split in two parts and sin is a polynomial there, so
+//    the loop over candidates vectorizes.
+//--------------------------------------------------------------------
+static inline float sSin2(float fPhase)
+{
+	float fK = fPhase * 0.318309886f;
+	fK = (float)(int)(fK + (fK >= 0.0f ? 0.5f : -0.5f));
+	float fR = fPhase - fK * 3.140625f;
+	fR = fR - fK * 9.67653589793e-4f;
+	float fR2 = fR * fR;
+	float fS = -2.50521084e-8f;
+	fS = fS * fR2 + 2.75573192e-6f;
+	fS = fS * fR2 - 1.98412698e-4f;
+	fS = fS * fR2 + 8.33333333e-3f;
+	fS = fS * fR2 - 1.66666667e-1f;
+	fS = fR + fR * fR2 * fS;
+	return fS * fS;
+}
+
+void CCtfScore2DJob::DoBlock(int iFirst, int iCount, int iThread)
+{
+	m_pCtfScore2D->ScoreBlock(m_pfVals, m_pfCands + iFirst * 4,
+	   iCount, m_dStd2, m_pfScores + iFirst);
+}
+
+CCtfScore2D::CCtfScore2D(void)
+{
+	m_pfTables = 0L;
+	m_piPixels = 0L;
+	m_piRowEnds = 0L;
+	m_iNumPixels = 0;
+	m_iNumRows = 0;
+	m_iNumThreads = 1;
+	m_fBFactor = 1.0f;
+}
+
+CCtfScore2D::~CCtfScore2D(void)
+{
+	this->Clean();
+}
+
+void CCtfScore2D::Clean(void)
+{
+	if(m_pfTables != 0L) delete[] m_pfTables;
+	if(m_piPixels != 0L) delete[] m_piPixels;
+	if(m_piRowEnds != 0L) delete[] m_piRowEnds;
+	m_pfTables = 0L;
+	m_piPixels = 0L;
+	m_piRowEnds = 0L;
+	m_iNumPixels = 0;
+	m_iNumRows = 0;
+}
+
+void CCtfScore2D::SetParam(MD::CCtfParam* pCtfParam)
+{
+	m_fWavelength = pCtfParam->m_fWavelength;
+	m_fCs = pCtfParam->m_fCs;
+	m_fAmpPhase = (float)atanf(pCtfParam->m_fAmpContrast /
+	   sqrtf(1.0f - pCtfParam->m_fAmpContrast *
+	   pCtfParam->m_fAmpContrast));
+}
+
+void CCtfScore2D::SetSize(int* piCmpSize)
+{
+	m_aiCmpSize[0] = piCmpSize[0];
+	m_aiCmpSize[1] = piCmpSize[1];
+}
+
+//--------------------------------------------------------------------
+// 1. Same band as GCC2D::DoIt. The in-band pixels are listed row by
+//    row with what the CTF needs of them: pi * lambda * s^2, the Cs
+//    term, cos and sin of twice the azimuth, and the B-factor.
+// 2. Must be called after SetParam and SetSize.
+//--------------------------------------------------------------------
+void CCtfScore2D::Setup
+(	float fFreqLow,
+	float fFreqHigh,
+	float fBFactor
+)
+{	this->Clean();
+	m_fBFactor = fBFactor;
+	m_iNumThreads = MU::GetHostThreads();
+	//-----------------
+	int iCmpX = m_aiCmpSize[0];
+	int iCmpY = m_aiCmpSize[1];
+	float fFreqLow2 = fFreqLow / iCmpY;
+	float fFreqHigh2 = fFreqHigh / iCmpY;
+	if(fFreqHigh2 > 0.75f) fFreqHigh2 = 0.75f;
+	fFreqLow2 *= fFreqLow2;
+	fFreqHigh2 *= fFreqHigh2;
+	//-----------------
+	int iMaxPixels = iCmpX * iCmpY;
+	m_piPixels = new int[iMaxPixels];
+	m_piRowEnds = new int[iCmpY];
+	m_pfTables = new float[iMaxPixels * 5];
+	float* pfA = m_pfTables;
+	float* pfB = m_pfTables + iMaxPixels;
+	float* pfCos2 = m_pfTables + iMaxPixels * 2;
+	float* pfSin2 = m_pfTables + iMaxPixels * 3;
+	float* pfWeight = m_pfTables + iMaxPixels * 4;
+	float fW2 = m_fWavelength * m_fWavelength;
+	//-----------------
+	for(int y=0; y<iCmpY; y++)
+	{	float fY = (y - iCmpY * 0.5f) / iCmpY;
+		for(int x=0; x<iCmpX; x++)
+		{	float fX = (0.5f * x) / (iCmpX - 1);
+			float fS2 = fX * fX + fY * fY;
+			if(fS2 < fFreqLow2 || fS2 > fFreqHigh2) continue;
+			if(fS2 <= 0.0f) continue;
+			//---------------
+			int i = m_iNumPixels;
+			m_piPixels[i] = y * iCmpX + x;
+			pfA[i] = 3.1415926f * m_fWavelength * fS2;
+			pfB[i] = pfA[i] * 0.5f * fW2 * fS2 * m_fCs;
+			pfCos2[i] = (fX * fX - fY * fY) / fS2;
+			pfSin2[i] = 2.0f * fX * fY / fS2;
+			pfWeight[i] = expf(-m_fBFactor * fS2);
+			m_iNumPixels += 1;
+		}
+		if(m_iNumRows > 0 && m_piRowEnds[m_iNumRows-1]
+		   == m_iNumPixels) continue;
+		m_piRowEnds[m_iNumRows] = m_iNumPixels;
+		m_iNumRows += 1;
+	}
+	//-----------------
+	for(int i=1; i<5; i++)
+	{	memmove(m_pfTables + i * m_iNumPixels, m_pfTables
+		   + i * iMaxPixels, sizeof(float) * m_iNumPixels);
+	}
+}
+
+//--------------------------------------------------------------------
+// 1. pfSpect is a host copy of the half spectrum. The tables are
+//    read only, so several threads may score on one instance at
+//    the same time, e.g. for different tilts of a series.
+// 2. The in-band pixels are gathered once per call. Blocks of 64
+//    candidates are then shared by the host threads.
+//--------------------------------------------------------------------
+void CCtfScore2D::DoIt
+(	float* pfSpect,
+	float* pfCands,
+	int iNumCands,
+	float* pfScores
+)
+{	float* pfVals = new float[m_iNumPixels];
+	double dStd2 = 0.0;
+	for(int i=0; i<m_iNumPixels; i++)
+	{	pfVals[i] = pfSpect[m_piPixels[i]];
+		dStd2 += pfVals[i] * (double)pfVals[i];
+	}
+	//-----------------
+	CCtfScore2DJob aJob;
+	aJob.m_pCtfScore2D = this;
+	aJob.m_pfVals = pfVals;
+	aJob.m_pfCands = pfCands;
+	aJob.m_pfScores = pfScores;
+	aJob.m_dStd2 = dStd2;
+	MU::CHostThreads aHostThreads;
+	aHostThreads.DoIt(&aJob, iNumCands, s_iCandBlock, m_iNumThreads);
+	delete[] pfVals;
+}
+
+//--------------------------------------------------------------------
+// 1. The loops over candidates are innermost so that they vectorize
+//    without reordering sums. Each row is summed in float and then
+//    added to double totals.
+//--------------------------------------------------------------------
+void CCtfScore2D::ScoreBlock
+(	float* pfVals,
+	float* pfCands,
+	int iNumCands,
+	double dStd2,
+	float* pfScores
+)
+{	float afMean[s_iCandBlock], afCos[s_iCandBlock];
+	float afSin[s_iCandBlock], afPhase[s_iCandBlock];
+	for(int c=0; c<iNumCands; c++)
+	{	float* pfCand = pfCands + c * 4;
+		float fSigma = 0.5f * (pfCand[1] - pfCand[0]);
+		afMean[c] = 0.5f * (pfCand[0] + pfCand[1]);
+		afCos[c] = fSigma * cosf(2.0f * pfCand[2]);
+		afSin[c] = fSigma * sinf(2.0f * pfCand[2]);
+		afPhase[c] = pfCand[3] + m_fAmpPhase;
+	}
+	//-----------------
+	float* pfA = m_pfTables;
+	float* pfB = m_pfTables + m_iNumPixels;
+	float* pfCos2 = m_pfTables + m_iNumPixels * 2;
+	float* pfSin2 = m_pfTables + m_iNumPixels * 3;
+	float* pfWeight = m_pfTables + m_iNumPixels * 4;
+	double adCC[s_iCandBlock] = {0.0}, adStd1[s_iCandBlock] = {0.0};
+	float afCC[s_iCandBlock], afStd1[s_iCandBlock];
+	//-----------------
+	int iStart = 0;
+	for(int r=0; r<m_iNumRows; r++)
+	{	memset(afCC, 0, sizeof(afCC));
+		memset(afStd1, 0, sizeof(afStd1));
+		for(int i=iStart; i<m_piRowEnds[r]; i++)
+		{	float fA = pfA[i], fB = pfB[i], fS = pfVals[i];
+			float fCos2 = pfCos2[i], fSin2 = pfSin2[i];
+			float fW = pfWeight[i];
+			for(int c=0; c<iNumCands; c++)
+			{	float fDf = afMean[c] + afCos[c] * fCos2
+				   + afSin[c] * fSin2;
+				float fC = sSin2(afPhase[c] + fA * fDf - fB) * fW;
+				afCC[c] += fC * fS;
+				afStd1[c] += fC * fC;
+			}
+		}
+		for(int c=0; c<iNumCands; c++)
+		{	adCC[c] += afCC[c];
+			adStd1[c] += afStd1[c];
+		}
+		iStart = m_piRowEnds[r];
+	}
+	//-----------------
+	for(int c=0; c<iNumCands; c++)
+	{	double dStd = sqrt(adStd1[c] * dStd2);
+		if(dStd == 0) pfScores[c] = 0.0f;
+		else pfScores[c] = (float)(adCC[c] / dStd);
+	}
+}
@@ -300,6 +300,149 @@ private:
 	float* m_gfRes;
 };
 
+//-------------------------------------------------------------------
+// 1. Scores a batch of CTF candidates against one half spectrum
+//    with the CTF of GCalcCTF2D and the correlation of GCC2D, in
+//    one launch on its own stream.
+// 2. pfCands has 4 floats per candidate: minimum and maximum
+//    defocus in pixel, azimuth and extra phase in radian.
+//-------------------------------------------------------------------
+class GCtfScore2D
+{
+public:
+	GCtfScore2D(void);
+	~GCtfScore2D(void);
+	void SetParam(MD::CCtfParam* pCtfParam);
+	void SetSize(int* piCmpSize); // half spectrum
+	void Setup
+	(  float fFreqLow,  // same as GCC2D::Setup
+	   float fFreqHigh,
+	   float fBFactor
+	);
+	void DoIt
+	( float* gfSpect, float* pfCands,
+	  int iNumCands, float* pfScores
+	);
+private:
+	void mAlloc(int iNumCands);
+	float m_fFreqLow;
+	float m_fFreqHigh;
+	float m_fBFactor;
+	float m_fAmpPhase;
+	int m_aiCmpSize[2];
+	float* m_gfBuf;
+	int m_iMaxCands;
+	cudaStream_t m_stream;
+};
+
+class CCtfScore2D;
+
+//-------------------------------------------------------------------
+// 1. One call of CCtfScore2D::DoIt, run by MU::CHostThreads.
+//-------------------------------------------------------------------
+class CCtfScore2DJob : public MU::CHostJob
+{
+public:
+	void DoBlock(int iFirst, int iCount, int iThread);
+	CCtfScore2D* m_pCtfScore2D;
+	float* m_pfVals;
+	float* m_pfCands;
+	float* m_pfScores;
+	double m_dStd2;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GCtfScore2D on a host spectrum, using
+//    MU::GetHostThreads() threads.
+// 2. DoIt may be called by several threads at once after Setup.
+//-------------------------------------------------------------------
+class CCtfScore2D
+{
+public:
+	CCtfScore2D(void);
+	~CCtfScore2D(void);
+	void Clean(void);
+	void SetParam(MD::CCtfParam* pCtfParam);
+	void SetSize(int* piCmpSize);
+	void Setup(float fFreqLow, float fFreqHigh, float fBFactor);
+	void DoIt
+	( float* pfSpect, float* pfCands,
+	  int iNumCands, float* pfScores
+	);
+	void ScoreBlock
+	( float* pfVals, float* pfCands,
+	  int iNumCands, double dStd2,
+	  float* pfScores
+	);
+private:
+	float m_fWavelength;
+	float m_fCs;
+	float m_fAmpPhase;
+	float m_fBFactor;
+	int m_aiCmpSize[2];
+	float* m_pfTables;
+	int* m_piPixels;
+	int* m_piRowEnds;
+	int m_iNumPixels;
+	int m_iNumRows;
+	int m_iNumThreads;
+};
+
+class CCtfScore1D;
+
+//-------------------------------------------------------------------
+// 1. One call of CCtfScore1D::DoIt, run by MU::CHostThreads.
+//-------------------------------------------------------------------
+class CCtfScore1DJob : public MU::CHostJob
+{
+public:
+	void DoBlock(int iFirst, int iCount, int iThread);
+	CCtfScore1D* m_pCtfScore1D;
+	float* m_pfVals;
+	float* m_pfCands;
+	float* m_pfScores;
+	double m_dStd2;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GCalcCTF1D followed by GCC1D on a host
+//    radial average. Each candidate is 2 floats, defocus in pixel
+//    and extra phase in radian.
+// 2. DoIt may be called by several threads at once after Setup.
+//-------------------------------------------------------------------
+class CCtfScore1D
+{
+public:
+	CCtfScore1D(void);
+	~CCtfScore1D(void);
+	void Clean(void);
+	void SetParam(MD::CCtfParam* pCtfParam);
+	void SetSize(int iCmpSize);
+	void Setup
+	( float fFreqLow,   // pixel in Fourier domain
+	  float fFreqHigh,  // pixel in Fourier domain
+	  float fBFactor
+	);
+	void DoIt
+	( float* pfRadialAvg, float* pfCands,
+	  int iNumCands, float* pfScores
+	);
+	void ScoreBlock
+	( float* pfVals, float* pfCands,
+	  int iNumCands, double dStd2,
+	  float* pfScores
+	);
+private:
+	float m_fWavelength;
+	float m_fCs;
+	float m_fAmpPhase;
+	int m_iCmpSize;
+	float* m_pfTables;
+	int m_iFirst;
+	int m_iNumBins;
+	int m_iNumThreads;
+};
+
 class GCC1D
 {
 public:
@@ -716,15 +859,18 @@ private:
 	void mBrutalForceSearch(float afResult[3]);
 	void mCalcCTF(float fDefocus, float fExtPhase);
 	float mCorrelate(void);
+	void mScoreHost(float* pfCands, int iNumCands, float* pfCCs);
 	//-----------------
 	MD::CCtfParam* m_pCtfParam;
 	GCC1D* m_pGCC1D;
 	GCalcCTF1D m_aGCalcCtf1D;
+	CCtfScore1D* m_pCScore; // unless MU::gpuBackend
 	//-----------------
 	float m_afResRange[2];
 	float m_afDfRange[2];    // f0, delta in angstrom
 	float m_afPhaseRange[2]; // p0, delta in degree
 	float* m_gfRadialAvg;
+	float* m_pfRadialAvg;
 	int m_iCmpSize;
 	float* m_gfCtf1D;
 };
@@ -775,6 +921,11 @@ private:
 	  float fExtPhase
 	);
 	void mCalcCtfRes(void);
+	void mAddCand
+	( float fDfMean, float fAstRatio,
+	  float fAstAngle, float fExtPhase
+	);
+	void mScore(void);
 	//-----------------
         void mGetRange
         ( float fCentVal, float fRange,
@@ -784,8 +935,14 @@ private:
         float* m_gfSpect;
         float* m_gfCtf2D;
         int m_aiCmpSize[2];
-        GCC2D* m_pGCC2D;
+        GCtfScore2D* m_pGScore;
+        CCtfScore2D* m_pCScore; // unless MU::gpuBackend
         GCalcCTF2D m_aGCalcCtf2D;
+	float* m_pfSpect;
+	float* m_pfCands;
+	float* m_pfScores;
+	int m_iNumCands;
+	int m_iMaxCands;
 	MD::CCtfParam* m_pCtfParam;
         //-----------------
         float m_fDfMean;
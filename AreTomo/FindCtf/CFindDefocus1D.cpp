@@ -14,6 +14,8 @@ CFindDefocus1D::CFindDefocus1D(void)
 {
 	m_gfCtf1D = 0L;
 	m_pGCC1D = 0L;
+	m_pCScore = 0L;
+	m_pfRadialAvg = 0L;
 }
 
 CFindDefocus1D::~CFindDefocus1D(void)
@@ -31,6 +33,14 @@ void CFindDefocus1D::Clean(void)
 	{	delete m_pGCC1D;
 		m_pGCC1D = 0L;
 	}
+	if(m_pCScore != 0L)
+	{	delete m_pCScore;
+		m_pCScore = 0L;
+	}
+	if(m_pfRadialAvg != 0L)
+	{	delete[] m_pfRadialAvg;
+		m_pfRadialAvg = 0L;
+	}
 }
 
 void CFindDefocus1D::Setup(MD::CCtfParam* pCtfParam, int iCmpSize)
@@ -45,12 +55,24 @@ void CFindDefocus1D::Setup(MD::CCtfParam* pCtfParam, int iCmpSize)
 	//-----------------
 	m_pGCC1D = new GCC1D;
 	m_pGCC1D->SetSize(m_iCmpSize);	
+	//-----------------
+	if(MU::GetBackend() == MU::gpuBackend) return;
+	m_pCScore = new CCtfScore1D;
+	m_pCScore->SetParam(m_pCtfParam);
+	m_pCScore->SetSize(m_iCmpSize);
+	m_pfRadialAvg = new float[m_iCmpSize];
 }
 
 void CFindDefocus1D::SetResRange(float afRange[2])
 {
 	m_afResRange[0] = afRange[0];
 	m_afResRange[1] = afRange[1];
+	if(m_pCScore == 0L) return;
+	//-----------------
+	float fRes1 = ((m_iCmpSize - 1) * 2) * m_pCtfParam->m_fPixelSize;
+	float fMinFreq = fRes1 / m_afResRange[0];
+	float fMaxFreq = fRes1 / m_afResRange[1];
+	m_pCScore->Setup(fMinFreq, fMaxFreq, 0.0f);
 }
 
 void CFindDefocus1D::DoIt
@@ -61,6 +83,8 @@ void CFindDefocus1D::DoIt
 {	memcpy(m_afDfRange, afDfRange, sizeof(float) * 2);
 	memcpy(m_afPhaseRange, afPhaseRange, sizeof(float) * 2);
 	m_gfRadialAvg = gfRadialAvg;
+	if(m_pfRadialAvg != 0L) cudaMemcpy(m_pfRadialAvg, gfRadialAvg,
+	   sizeof(float) * m_iCmpSize, cudaMemcpyDefault);
 	//--------------------------
 	m_fMaxCC = (float)-1e20;
 	float afResult[3] = {0.0f};
@@ -71,7 +95,10 @@ void CFindDefocus1D::DoIt
 }
 
 //--------------------------------------------------------------------
-// Search both defocus and phase shift.
+// 1. Search both defocus and phase shift. The grid is laid out
+//    first and then scored, point by point on GPU or in one batch
+//    with CCtfScore1D unless MU::gpuBackend.
+// 2. The first point of the highest CC wins in either case.
 //--------------------------------------------------------------------
 void CFindDefocus1D::mBrutalForceSearch(float afResult[3])
 {	
@@ -87,34 +114,37 @@ void CFindDefocus1D::mBrutalForceSearch(float afResult[3])
 	iPsSteps = (int)(m_afPhaseRange[1] / fPsStep) / 2 * 2 + 1;
 	//-----------------
 	int iPoints = iDfSteps * iPsSteps;
+	float* pfPoints = new float[iPoints * 2];
 	float* pfCCs = new float[iPoints];
 	//-----------------
-	float fDefocus, fPhase;
-	int iFocus = 0, iPhase = 0;
-	afResult[2] = (float)-1e20;
-	//-----------------
 	for(int i=0; i<iPoints; i++)
-	{	iFocus = i % iDfSteps;
-		iPhase = i / iDfSteps;
-		fDefocus = m_afDfRange[0] + iFocus * fDfStep;
-		fPhase = m_afPhaseRange[0] + (iPhase - iPsSteps / 2) * fPsStep;
+	{	int iFocus = i % iDfSteps;
+		int iPhase = i / iDfSteps;
+		float fPhase = m_afPhaseRange[0] + (iPhase - iPsSteps / 2)
+		   * fPsStep;
 		if(fPhase < 0) fPhase = 0.0f;
 		else if(fPhase > 150.0f) fPhase = 150.0f;
-		//----------------
-		mCalcCTF(fDefocus, fPhase);
-		pfCCs[i] = mCorrelate();
-		if(pfCCs[i] > afResult[2])
-		{	afResult[0] = fDefocus;
-			afResult[1] = fPhase;
-			afResult[2] = pfCCs[i];
+		pfPoints[2 * i] = m_afDfRange[0] + iFocus * fDfStep;
+		pfPoints[2 * i + 1] = fPhase;
+	}
+	//-----------------
+	if(m_pCScore != 0L) mScoreHost(pfPoints, iPoints, pfCCs);
+	else
+	{	for(int i=0; i<iPoints; i++)
+		{	mCalcCTF(pfPoints[2 * i], pfPoints[2 * i + 1]);
+			pfCCs[i] = mCorrelate();
 		}
-		/*		
-		printf("%3d  %8.2f  %8.2f  %8.4f  %8.2f %8.2f  %8.4f\n", i,
-		   fDefocus, fPhase, pfCCs[i],
-		   afResult[0], afResult[1], afResult[2]);
-		*/
 	}
-	if(pfCCs != 0L) delete[] pfCCs;
+	//-----------------
+	afResult[2] = (float)-1e20;
+	for(int i=0; i<iPoints; i++)
+	{	if(pfCCs[i] <= afResult[2]) continue;
+		afResult[0] = pfPoints[2 * i];
+		afResult[1] = pfPoints[2 * i + 1];
+		afResult[2] = pfCCs[i];
+	}
+	delete[] pfPoints;
+	delete[] pfCCs;
 }
 
 void CFindDefocus1D::mCalcCTF(float fDefocus, float fExtPhase)
@@ -134,3 +164,22 @@ float CFindDefocus1D::mCorrelate(void)
 	float fCC = m_pGCC1D->DoIt(m_gfCtf1D, m_gfRadialAvg);
 	return fCC;
 }
+
+//--------------------------------------------------------------------
+// 1. pfCands holds defocus in angstrom and phase in degree as in
+//    mCalcCTF. They are converted to pixel and radian for
+//    CCtfScore1D.
+//--------------------------------------------------------------------
+void CFindDefocus1D::mScoreHost
+(	float* pfCands,
+	int iNumCands,
+	float* pfCCs
+)
+{	float* pfBuf = new float[iNumCands * 2];
+	for(int i=0; i<iNumCands; i++)
+	{	pfBuf[2 * i] = pfCands[2 * i] / m_pCtfParam->m_fPixelSize;
+		pfBuf[2 * i + 1] = pfCands[2 * i + 1] * s_fD2R;
+	}
+	m_pCScore->DoIt(m_pfRadialAvg, pfBuf, iNumCands, pfCCs);
+	delete[] pfBuf;
+}
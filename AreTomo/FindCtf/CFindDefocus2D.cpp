@@ -13,7 +13,13 @@ static float s_fD2R = 0.01745329f;
 CFindDefocus2D::CFindDefocus2D(void)
 {
 	m_gfCtf2D = 0L;
-	m_pGCC2D = 0L;
+	m_pGScore = 0L;
+	m_pCScore = 0L;
+	m_pfSpect = 0L;
+	m_pfCands = 0L;
+	m_pfScores = 0L;
+	m_iNumCands = 0;
+	m_iMaxCands = 0;
 	m_fAstRatio = 0.0f; // (m_fDfMean - fMinDf) / m_fDfMean;
 	m_fAstAngle = 0.0f; // degree
 }
@@ -29,10 +35,17 @@ void CFindDefocus2D::Clean(void)
 	{	cudaFree(m_gfCtf2D);
 		m_gfCtf2D = 0L;
 	}
-	if(m_pGCC2D != 0L)
-	{	delete m_pGCC2D;
-		m_pGCC2D = 0L;
-	}
+	if(m_pGScore != 0L) delete m_pGScore;
+	if(m_pCScore != 0L) delete m_pCScore;
+	if(m_pfSpect != 0L) delete[] m_pfSpect;
+	if(m_pfCands != 0L) delete[] m_pfCands;
+	if(m_pfScores != 0L) delete[] m_pfScores;
+	m_pGScore = 0L;
+	m_pCScore = 0L;
+	m_pfSpect = 0L;
+	m_pfCands = 0L;
+	m_pfScores = 0L;
+	m_iMaxCands = 0;
 }
 
 float CFindDefocus2D::GetDfMin(void)
@@ -79,8 +92,17 @@ void CFindDefocus2D::Setup1(MD::CCtfParam* pCtfParam, int* piCmpSize)
 	cudaMalloc(&m_gfCtf2D, sizeof(float) 
 	   * m_aiCmpSize[0] * m_aiCmpSize[1]);
 	//------------------------------------
-	m_pGCC2D = new GCC2D;
-	m_pGCC2D->SetSize(m_aiCmpSize);	
+	if(MU::GetBackend() != MU::gpuBackend)
+	{	m_pCScore = new CCtfScore2D;
+		m_pCScore->SetParam(m_pCtfParam);
+		m_pCScore->SetSize(m_aiCmpSize);
+		m_pfSpect = new float[m_aiCmpSize[0] * m_aiCmpSize[1]];
+	}
+	else
+	{	m_pGScore = new GCtfScore2D;
+		m_pGScore->SetParam(m_pCtfParam);
+		m_pGScore->SetSize(m_aiCmpSize);
+	}
 }
 
 void CFindDefocus2D::Setup2(float afResRange[2])
@@ -88,7 +110,8 @@ void CFindDefocus2D::Setup2(float afResRange[2])
 	float fRes1 = m_aiCmpSize[1] * m_pCtfParam->m_fPixelSize;
 	float fMinFreq = fRes1 / afResRange[0];
 	float fMaxFreq = fRes1 / afResRange[1];
-	m_pGCC2D->Setup(fMinFreq, fMaxFreq, 100.0f);
+	if(m_pCScore != 0L) m_pCScore->Setup(fMinFreq, fMaxFreq, 100.0f);
+	else m_pGScore->Setup(fMinFreq, fMaxFreq, 100.0f);
 }
 
 //--------------------------------------------------------------------
@@ -110,6 +133,8 @@ void CFindDefocus2D::Setup3
 void CFindDefocus2D::DoIt(float* gfSpect, float fPhaseRange)
 {
 	m_gfSpect = gfSpect;
+	if(m_pfSpect != 0L) cudaMemcpy(m_pfSpect, gfSpect, sizeof(float)
+	   * m_aiCmpSize[0] * m_aiCmpSize[1], cudaMemcpyDefault);
 	m_afPhaseRange[1] = fPhaseRange;
         //-----------------
 	m_afDfRange[0] = m_fDfMean * 0.9f;
@@ -131,6 +156,8 @@ void CFindDefocus2D::Refine
 	float fPhaseRange
 )
 {	m_gfSpect = gfSpect;
+	if(m_pfSpect != 0L) cudaMemcpy(m_pfSpect, gfSpect, sizeof(float)
+	   * m_aiCmpSize[0] * m_aiCmpSize[1], cudaMemcpyDefault);
 	//-----------------
 	float fHalfR = 0.5f * fDfRange;
 	m_afDfRange[0] = fmaxf(m_fDfMean - fHalfR, 3000.0f);
@@ -197,12 +224,22 @@ float CFindDefocus2D::mFindAstig(float* pfAstRange, float* pfAngRange)
 	if(fAngStep < 1e-5) iAngSteps = 1;
 	if(iAstSteps == 1 && iAngSteps == 1) return 0.0f;
 	//-----------------
+	m_iNumCands = 0;
+	for(int j=0; j<iAngSteps; j++)
+	{	float fAng = pfAngRange[0] + j * fAngStep;
+		for(int i=0; i<iAstSteps; i++)
+		{	float fAst = pfAstRange[0] + i * fAstStep;
+			mAddCand(m_fDfMean, fAst, fAng, m_fExtPhase);
+		}
+	}
+	mScore();
+	//-----------------
 	float fAngMax, fAstMax, fCCMax = (float)-1e20;
 	for(int j=0; j<iAngSteps; j++)
 	{	float fAng = pfAngRange[0] + j * fAngStep;
    		for(int i=0; i<iAstSteps; i++)
 		{	float fAst = pfAstRange[0] + i * fAstStep;
-			float fCC = mCorrelate(fAst, fAng, m_fExtPhase);
+			float fCC = m_pfScores[j * iAstSteps + i];
 			if(fCC <= fCCMax) continue;
 			//---------------
 			fCCMax = fCC;
@@ -235,10 +272,16 @@ float CFindDefocus2D::mRefineAstMag(float fAstRange)
 	iSteps = (int)((fMax - fMin) / fStep) / 2 * 2 + 1;
 	if(iSteps == 1) return 0.0f;	
         //-----------------
+	m_iNumCands = 0;
+	for(int i=0; i<iSteps; i++)
+	{	mAddCand(m_fDfMean, fMin + i * fStep, m_fAstAngle, m_fExtPhase);
+	}
+	mScore();
+	//-----------------
         float fAstMax, fCCMax = (float)-1e20;
 	for(int i=0; i<iSteps; i++)
 	{	float fAst = fMin + i * fStep;
-		float fCC = mCorrelate(fAst, m_fAstAngle, m_fExtPhase);
+		float fCC = m_pfScores[i];
 		if(fCC <= fCCMax) continue;
 		//---------------
 		fCCMax = fCC;
@@ -267,10 +310,16 @@ float CFindDefocus2D::mRefineAstAng(float fAngRange)
         iSteps = (int)((fMax - fMin) / fStep) / 2 * 2 + 1;
         if(iSteps == 1) return 0.0f;
         //-----------------
+	m_iNumCands = 0;
+	for(int i=0; i<iSteps; i++)
+	{	mAddCand(m_fDfMean, m_fAstRatio, fMin + i * fStep, m_fExtPhase);
+	}
+	mScore();
+	//-----------------
         float fAngMax, fCCMax = (float)-1e20;
         for(int i=0; i<iSteps; i++)
         {       float fAng = fMin + i * fStep;
-                float fCC = mCorrelate(m_fAstRatio, fAng, m_fExtPhase);
+                float fCC = m_pfScores[i];
                 if(fCC <= fCCMax) continue;
                 //---------------
                 fCCMax = fCC;
@@ -300,10 +349,17 @@ float CFindDefocus2D::mRefineDfMean(float fDfRange)
 	iSteps = (int)((fMax - fMin) / fStep) / 2 * 2 + 1;
 	if(iSteps == 1) return 0.0f;
 	//-----------------
+	m_iNumCands = 0;
+	for(int i=0; i<iSteps; i++)
+	{	mAddCand(fMin + i * fStep, m_fAstRatio, m_fAstAngle,
+		   m_fExtPhase);
+	}
+	mScore();
+	//-----------------
 	float fDfMax = 0.0f, fCCMax = (float)-1e20;
 	for(int i=0; i<iSteps; i++)
 	{	m_fDfMean = fMin + i * fStep;
-		float fCC = mCorrelate(m_fAstRatio, m_fAstAngle, m_fExtPhase);
+		float fCC = m_pfScores[i];
 		if(fCC <= fCCMax) continue;
 		//----------------
 		fDfMax = m_fDfMean;
@@ -342,11 +398,22 @@ float CFindDefocus2D::mRefinePhase(float fPhaseRange)
 	if(fMaxPhase > 150) fMaxPhase = 180.0f;
 	//-----------------
 	float fCCMax = (float)-1e20, fPhaseMax = 0.0f, fPhase = 0.0f;
+	m_iNumCands = 0;
+	for(int i=0; i<iSteps; i++)
+	{	fPhase = m_fExtPhase + (i - iSteps / 2)  * fStep;
+		if(fPhase < fMinPhase || fPhase > fMaxPhase) continue;
+		mAddCand(m_fDfMean, m_fAstRatio, m_fAstAngle, fPhase);
+	}
+	if(m_iNumCands == 0) return 0.0f;
+	mScore();
+	//-----------------
+	int iCand = 0;
 	for(int i=0; i<iSteps; i++)
 	{	fPhase = m_fExtPhase + (i - iSteps / 2)  * fStep;
 		if(fPhase < fMinPhase || fPhase > fMaxPhase) continue;
 		//----------------
-		float fCC = mCorrelate(m_fAstRatio, m_fAstAngle, fPhase);
+		float fCC = m_pfScores[iCand];
+		iCand += 1;
 		if(fCC <= fCCMax) continue;
 		//----------------
 		fPhaseMax = fPhase;
@@ -365,18 +432,53 @@ float CFindDefocus2D::mCorrelate
 	float fAstAngle, 
 	float fExtPhase
 )
-{	float fExtPhaseRad = fExtPhase * s_fD2R;
-	float fAstRad = fAstAngle * s_fD2R;
-	//---------------------------------
-	float fDfMin = CFindCtfHelp::CalcDfMin(m_fDfMean, fAstRatio)
+{	m_iNumCands = 0;
+	mAddCand(m_fDfMean, fAstRatio, fAstAngle, fExtPhase);
+	mScore();
+	return m_pfScores[0];
+}
+
+void CFindDefocus2D::mAddCand
+(	float fDfMean,
+	float fAstRatio,
+	float fAstAngle,
+	float fExtPhase
+)
+{	if(m_iNumCands == m_iMaxCands)
+	{	int iMaxCands = m_iMaxCands * 2 + 64;
+		float* pfCands = new float[iMaxCands * 4];
+		if(m_pfCands != 0L)
+		{	memcpy(pfCands, m_pfCands, sizeof(float) * m_iNumCands * 4);
+			delete[] m_pfCands;
+		}
+		if(m_pfScores != 0L) delete[] m_pfScores;
+		m_pfCands = pfCands;
+		m_pfScores = new float[iMaxCands];
+		m_iMaxCands = iMaxCands;
+	}
+	//-----------------
+	float* pfCand = m_pfCands + m_iNumCands * 4;
+	pfCand[0] = CFindCtfHelp::CalcDfMin(fDfMean, fAstRatio)
 	   / m_pCtfParam->m_fPixelSize;
-	float fDfMax = CFindCtfHelp::CalcDfMax(m_fDfMean, fAstRatio)
+	pfCand[1] = CFindCtfHelp::CalcDfMax(fDfMean, fAstRatio)
 	   / m_pCtfParam->m_fPixelSize;
-	//-----------------------------
-	m_aGCalcCtf2D.DoIt(fDfMin, fDfMax, fAstRad, fExtPhaseRad, 
-	   m_gfCtf2D, m_aiCmpSize);
-	float fCC = m_pGCC2D->DoIt(m_gfCtf2D, m_gfSpect);
-	return fCC;
+	pfCand[2] = fAstAngle * s_fD2R;
+	pfCand[3] = fExtPhase * s_fD2R;
+	m_iNumCands += 1;
+}
+
+//--------------------------------------------------------------------
+// 1. Scores all candidates added since m_iNumCands was reset in one
+//    batch, on GPU or with CCtfScore2D unless MU::gpuBackend.
+//--------------------------------------------------------------------
+void CFindDefocus2D::mScore(void)
+{
+	if(m_pCScore != 0L)
+	{	m_pCScore->DoIt(m_pfSpect, m_pfCands, m_iNumCands, m_pfScores);
+	}
+	else
+	{	m_pGScore->DoIt(m_gfSpect, m_pfCands, m_iNumCands, m_pfScores);
+	}
 }
 
 void CFindDefocus2D::mCalcCtfRes(void)
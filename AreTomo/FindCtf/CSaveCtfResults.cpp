@@ -1,6 +1,7 @@
 #include "CFindCtfInc.h"
 #include <stdio.h>
 #include <memory.h>
+#include <string.h>
 
 using namespace McAreTomo::AreTomo::FindCtf;
 
@@ -44,26 +45,34 @@ void CSaveCtfResults::DoFittings(int iNthGpu)
 	mSaveFittings(acCtfFile);
 }
 
+//--------------------------------------------------------------------
+// 1. The spectra are copied into a stack owned by the write job so
+//    that CCtfResults can be changed while they are being saved.
+//--------------------------------------------------------------------
 void CSaveCtfResults::mSaveImages(const char* pcCtfFile)
 {
 	MD::CCtfResults* pCtfResults = MD::CCtfResults::GetInstance(m_iNthGpu);
-	Mrc::CSaveMrc aSaveMrc;
+	if(pCtfResults->m_iNumImgs <= 0) return;
 	bool bClean = true;
 	//-----------------
-	char acCtfImgFile[256] = {'\0'};
-	strcpy(acCtfImgFile, pcCtfFile);
-	strcat(acCtfImgFile, ".mrc");
-	//-----------------
-	aSaveMrc.OpenFile(acCtfImgFile);
-	aSaveMrc.SetMode(Mrc::eMrcFloat);
-	aSaveMrc.SetImgSize(pCtfResults->m_aiSpectSize,
-	   pCtfResults->m_iNumImgs, 1, 1.0f);
-	//-----------------
+	int aiStkSize[3] = {pCtfResults->m_aiSpectSize[0],
+	   pCtfResults->m_aiSpectSize[1], pCtfResults->m_iNumImgs};
+	MD::CMrcStack* pSpectStack = new MD::CMrcStack;
+	pSpectStack->Create(Mrc::eMrcFloat, aiStkSize);
 	for(int i=0; i<pCtfResults->m_iNumImgs; i++)
 	{	float* pfSpect = pCtfResults->GetSpect(i, !bClean);
-		aSaveMrc.DoIt(i, pfSpect);
+		memcpy(pSpectStack->GetFrame(i), pfSpect,
+		   pSpectStack->m_tFmBytes);
 	}
-	aSaveMrc.CloseFile();
+	//-----------------
+	MD::CWriteStack* pWriteStack = new MD::CWriteStack;
+	strcpy(pWriteStack->m_acFile, pcCtfFile);
+	strcat(pWriteStack->m_acFile, ".mrc");
+	pWriteStack->m_iNthGpu = m_iNthGpu;
+	bool bOwn = true;
+	pWriteStack->SetStack(pSpectStack, bOwn);
+	pWriteStack->SetPixSize(1.0f);
+	MD::CAsyncWriter::GetInstance()->Submit(pWriteStack);
 }
 
 void CSaveCtfResults::mSaveFittings(const char* pcCtfFile)
@@ -73,8 +82,12 @@ void CSaveCtfResults::mSaveFittings(const char* pcCtfFile)
 	strcpy(acCtfTxtFile, pcCtfFile);
         strcat(acCtfTxtFile, ".txt");
 	//---------------------
-	FILE* pFile = fopen(acCtfTxtFile, "w");
-	if(pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(acCtfTxtFile, m_iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//---------------------
 	fprintf(pFile, "# Columns: #1 micrograph number; "
 	   "#2 - defocus 1 [A]; #3 - defocus 2; "
@@ -95,7 +108,7 @@ void CSaveCtfResults::mSaveFittings(const char* pcCtfFile)
 		   pCtfResults->GetCtfRes(i),
 		   pCtfResults->m_iDfHand);
 	}
-	fclose(pFile);
+	pWriteText->Submit();
 }
 
 void CSaveCtfResults::mSaveImod(const char* pcCtfFile)
@@ -106,8 +119,12 @@ void CSaveCtfResults::mSaveImod(const char* pcCtfFile)
 	strcpy(acCtfTxtFile, pcCtfFile);
 	strcat(acCtfTxtFile, "_Imod.txt");
 	//-----------------
-	FILE* pFile = fopen(acCtfTxtFile, "w");
-	if(pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(acCtfTxtFile, m_iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//-----------------
 	float fExtPhase = pCtfResults->GetExtPhase(0);
 	if(fExtPhase == 0) fprintf(pFile, "1  0  0.0  0.0  0.0  3\n");
@@ -137,5 +154,5 @@ void CSaveCtfResults::mSaveImod(const char* pcCtfFile)
 			   pCtfResults->GetExtPhase(i));
 		}
 	}
-	fclose(pFile);
+	pWriteText->Submit();
 }
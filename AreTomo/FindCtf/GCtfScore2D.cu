@@ -0,0 +1,218 @@
+#include "CFindCtfInc.h"
+#include <math.h>
+#include <stdio.h>
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+using namespace McAreTomo::AreTomo::FindCtf;
+
+//--------------------------------------------------------------
+// 0: wavelength in pixel
+// 1: Cs in pixel
+//--------------------------------------------------------------
+static __device__ __constant__ float s_gfCtfParam[2];
+
+//-----------------------------------------------------------------------------
+// 1. blockIdx.y is the candidate. gfCands has 4 floats per candidate,
+//    mean and sigma of defocus in pixel, azimuth and total phase
+//    shift in radian.
+// 2. The CTF and the frequency band are those of mGCalculate in
+//    GCalcCTF2D.cu and mGCalc2D in GCC2D.cu. Each block of a
+//    candidate sums a strided part of the half spectrum.
+//-----------------------------------------------------------------------------
+static __global__ void mGScore2D
+(	float* gfSpect,
+	float* gfCands,
+	int iCmpX,
+	int iCmpY,
+	float fFreqLow2,
+	float fFreqHigh2,
+	float fBFactor,
+	float* gfSums
+)
+{	extern __shared__ float s_afShared[];
+	float* s_afSumStd1 = &s_afShared[blockDim.x];
+	float* s_afSumStd2 = &s_afSumStd1[blockDim.x];
+	//-----------------
+	float* gfCand = gfCands + blockIdx.y * 4;
+	float fDfMean = gfCand[0], fDfSigma = gfCand[1];
+	float fAzimuth = gfCand[2], fPhase = gfCand[3];
+	float fW2 = s_gfCtfParam[0] * s_gfCtfParam[0];
+	//-----------------
+	float fSumCC = 0.0f, fSumStd1 = 0.0f, fSumStd2 = 0.0f;
+	int iPixels = iCmpX * iCmpY;
+	int iStride = gridDim.x * blockDim.x;
+	for(int i=blockIdx.x*blockDim.x+threadIdx.x; i<iPixels; i+=iStride)
+	{	int y = i / iCmpX;
+		int x = i - y * iCmpX;
+		float fX = x * 0.5f / (iCmpX - 1);
+		float fY = (y - iCmpY / 2) / (float)iCmpY;
+		float fS2 = fX * fX + fY * fY;
+		if(fS2 < fFreqLow2 || fS2 > fFreqHigh2) continue;
+		//----------------
+		float fDf = atanf(fY / (fX + (float)1e-30));
+		fDf = fDfMean + fDfSigma * cosf(2.0f * (fDf - fAzimuth));
+		float fC = sinf(fPhase + 3.1415926f * s_gfCtfParam[0] * fS2
+		   * (fDf - 0.5f * fW2 * fS2 * s_gfCtfParam[1]));
+		fC = fC * fC * expf(-fBFactor * fS2);
+		float fS = gfSpect[i];
+		fSumCC += (fC * fS);
+		fSumStd1 += (fC * fC);
+		fSumStd2 += (fS * fS);
+	}
+	s_afShared[threadIdx.x] = fSumCC;
+	s_afSumStd1[threadIdx.x] = fSumStd1;
+	s_afSumStd2[threadIdx.x] = fSumStd2;
+	__syncthreads();
+	//-----------------
+	int iOffset = blockDim.x / 2;
+	while(iOffset > 0)
+	{	if(threadIdx.x < iOffset)
+		{	int j = iOffset + threadIdx.x;
+			s_afShared[threadIdx.x] += s_afShared[j];
+			s_afSumStd1[threadIdx.x] += s_afSumStd1[j];
+			s_afSumStd2[threadIdx.x] += s_afSumStd2[j];
+		}
+		__syncthreads();
+		iOffset /= 2;
+	}
+	if(threadIdx.x != 0) return;
+	//-----------------
+	int j = (blockIdx.y * gridDim.x + blockIdx.x) * 3;
+	gfSums[j] = s_afShared[0];
+	gfSums[j+1] = s_afSumStd1[0];
+	gfSums[j+2] = s_afSumStd2[0];
+}
+
+static __global__ void mGScore1D
+(	float* gfSums,
+	int iNumParts,
+	int iNumCands,
+	float* gfScores
+)
+{	int c = blockIdx.x * blockDim.x + threadIdx.x;
+	if(c >= iNumCands) return;
+	//-----------------
+	float* gfSum = gfSums + c * iNumParts * 3;
+	float fSumCC = 0.0f, fSumStd1 = 0.0f, fSumStd2 = 0.0f;
+	for(int i=0; i<iNumParts; i++)
+	{	fSumCC += gfSum[3 * i];
+		fSumStd1 += gfSum[3 * i + 1];
+		fSumStd2 += gfSum[3 * i + 2];
+	}
+	float fStd = sqrtf(fSumStd1 * fSumStd2);
+	if(fStd == 0) gfScores[c] = 0.0f;
+	else gfScores[c] = fSumCC / fStd;
+}
+
+GCtfScore2D::GCtfScore2D(void)
+{
+	m_gfBuf = 0L;
+	m_iMaxCands = 0;
+	m_fBFactor = 1.0f;
+	m_fAmpPhase = 0.0f;
+	cudaStreamCreate(&m_stream);
+}
+
+GCtfScore2D::~GCtfScore2D(void)
+{
+	if(m_gfBuf != 0L) cudaFree(m_gfBuf);
+	cudaStreamDestroy(m_stream);
+}
+
+void GCtfScore2D::SetParam(MD::CCtfParam* pCtfParam)
+{
+	float afCtfParam[2] = {0.0f};
+	afCtfParam[0] = pCtfParam->m_fWavelength;
+	afCtfParam[1] = pCtfParam->m_fCs;
+	cudaMemcpyToSymbol(s_gfCtfParam, afCtfParam, sizeof(float) * 2);
+	//-----------------
+	m_fAmpPhase = (float)atanf(pCtfParam->m_fAmpContrast /
+	   sqrtf(1.0f - pCtfParam->m_fAmpContrast *
+	   pCtfParam->m_fAmpContrast));
+}
+
+void GCtfScore2D::SetSize(int* piCmpSize)
+{
+	m_aiCmpSize[0] = piCmpSize[0];
+	m_aiCmpSize[1] = piCmpSize[1];
+}
+
+void GCtfScore2D::Setup
+(	float fFreqLow,
+	float fFreqHigh,
+	float fBFactor
+)
+{	m_fFreqLow = fFreqLow;
+	m_fFreqHigh = fFreqHigh;
+	m_fBFactor = fBFactor;
+}
+
+//-----------------------------------------------------------------------------
+// 1. One launch scores all candidates. The number of blocks per
+//    candidate shrinks as the batch grows so that the grid stays
+//    around 1024 blocks.
+//-----------------------------------------------------------------------------
+void GCtfScore2D::DoIt
+(	float* gfSpect,
+	float* pfCands,
+	int iNumCands,
+	float* pfScores
+)
+{	int iNumParts = 1024 / iNumCands;
+	if(iNumParts > 64) iNumParts = 64;
+	else if(iNumParts < 1) iNumParts = 1;
+	mAlloc(iNumCands);
+	//-----------------
+	float* gfCands = m_gfBuf;
+	float* gfScores = gfCands + m_iMaxCands * 4;
+	float* gfSums = gfScores + m_iMaxCands;
+	float* pfBuf = new float[iNumCands * 4];
+	for(int i=0; i<iNumCands; i++)
+	{	float* pfCand = pfCands + i * 4;
+		float* pfDst = pfBuf + i * 4;
+		pfDst[0] = 0.5f * (pfCand[0] + pfCand[1]);
+		pfDst[1] = 0.5f * (pfCand[1] - pfCand[0]);
+		pfDst[2] = pfCand[2];
+		pfDst[3] = pfCand[3] + m_fAmpPhase;
+	}
+	cudaMemcpyAsync(gfCands, pfBuf, sizeof(float) * iNumCands * 4,
+	   cudaMemcpyDefault, m_stream);
+	//-----------------
+	float fFreqLow2 = m_fFreqLow / m_aiCmpSize[1];
+	float fFreqHigh2 = m_fFreqHigh / m_aiCmpSize[1];
+	if(fFreqHigh2 > 0.75f) fFreqHigh2 = 0.75f;
+	fFreqLow2 *= fFreqLow2;
+	fFreqHigh2 *= fFreqHigh2;
+	//-----------------
+	dim3 aBlockDim(256, 1);
+	dim3 aGridDim(iNumParts, iNumCands);
+	size_t tSmBytes = sizeof(float) * aBlockDim.x * 3;
+	mGScore2D<<<aGridDim, aBlockDim, tSmBytes, m_stream>>>(gfSpect,
+	   gfCands, m_aiCmpSize[0], m_aiCmpSize[1], fFreqLow2,
+	   fFreqHigh2, m_fBFactor, gfSums);
+	//-----------------
+	aBlockDim.x = 64;
+	aGridDim.x = (iNumCands + aBlockDim.x - 1) / aBlockDim.x;
+	aGridDim.y = 1;
+	mGScore1D<<<aGridDim, aBlockDim, 0, m_stream>>>(gfSums,
+	   iNumParts, iNumCands, gfScores);
+	cudaMemcpyAsync(pfScores, gfScores, sizeof(float) * iNumCands,
+	   cudaMemcpyDefault, m_stream);
+	cudaStreamSynchronize(m_stream);
+	delete[] pfBuf;
+}
+
+//-----------------------------------------------------------------------------
+// 1. One buffer holds the candidates, the scores, and 3 partial sums
+//    per block. At most 1024 blocks are needed per batch beyond the
+//    one block per candidate.
+//-----------------------------------------------------------------------------
+void GCtfScore2D::mAlloc(int iNumCands)
+{
+	if(iNumCands <= m_iMaxCands) return;
+	if(m_gfBuf != 0L) cudaFree(m_gfBuf);
+	m_iMaxCands = iNumCands;
+	size_t tFloats = (size_t)m_iMaxCands * 5 + (m_iMaxCands + 1024) * 3;
+	cudaMalloc(&m_gfBuf, sizeof(float) * tFloats);
+}
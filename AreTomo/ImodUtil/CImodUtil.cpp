@@ -185,23 +185,26 @@ void CImodUtil::mSaveTiltSeries(void)
 	mCreateFileName(m_acInMrcFile, acFile);
 	//-----------------
 	MAM::CSaveStack aSaveStack;
+	aSaveStack.m_iNthGpu = m_iNthGpu;
 	bool bOpen = aSaveStack.OpenFile(acFile);
 	if(!bOpen) return;
 	//-----------------
-	printf("GPU %d: Save tilt series in Imod folder, please "
-	   "wait .....\n", m_iNthGpu);
 	bool bVolume = true;
 	aSaveStack.DoIt(m_pTiltSeries, m_pGlobalParam,
 	   m_fPixelSize, 0L, !bVolume);
-	printf("GPU %d: Aligned series saved in Imod folder.\n", m_iNthGpu);
+	printf("GPU %d: Aligned series queued for Imod folder.\n", m_iNthGpu);
 }
 
 void CImodUtil::mSaveNewstComFile(void)
 {
 	char acComFile[256];
 	mCreateFileName("newst.com", acComFile);
-	FILE* pFile = fopen(acComFile, "wt");
-	if(pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(acComFile, m_iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//---------------------
 	fprintf(pFile, "$newstack -StandardInput\n");
 	fprintf(pFile, "InputFile	%s\n", m_acInMrcFile);
@@ -216,15 +219,19 @@ void CImodUtil::mSaveNewstComFile(void)
 	fprintf(pFile, "#GradientFile   hc20211206_804.maggrad\n");
 	fprintf(pFile, "$if (-e ./savework) ./savework");
 	//-----------------------------------------------
-	fclose(pFile);	
+	pWriteText->Submit();
 }
 
 void CImodUtil::mSaveTiltComFile(void)
 {
 	char acComFile[256];
 	mCreateFileName("tilt.com", acComFile);
-	FILE* pFile = fopen(acComFile, "wt");
-	if(pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(acComFile, m_iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//---------------------
 	MAM::CDarkFrames* pDarkFrames =
 	   MAM::CDarkFrames::GetInstance(m_iNthGpu);
@@ -263,7 +270,7 @@ void CImodUtil::mSaveTiltComFile(void)
 	}
 	fprintf(pFile, "$if (-e ./savework) ./savework");
 	//-----------------------------------------------
-	fclose(pFile);	
+	pWriteText->Submit();
 }
 
 void CImodUtil::SaveCtfFile(void)
@@ -274,8 +281,12 @@ void CImodUtil::SaveCtfFile(void)
 	//-----------------
 	char acFile[256] = {'\0'};	
 	mCreateFileName(m_acCtfFile, acFile);
-	FILE* pFile = fopen(acFile, "w");
-	if(pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(acFile, m_iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
  	//--------------------------------------
 	float fExtPhase = pCtfResults->GetExtPhase(0);
 	if(fExtPhase == 0) fprintf(pFile, "1  0  0.0  0.0  0.0  3\n");
@@ -305,7 +316,7 @@ void CImodUtil::SaveCtfFile(void)
 			   pCtfResults->GetExtPhase(i));
 		}
 	}
-	fclose(pFile);
+	pWriteText->Submit();
 }
 
 void CImodUtil::mCreateFileName(const char* pcInFileName, char* pcOutFileName)
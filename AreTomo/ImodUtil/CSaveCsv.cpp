@@ -19,7 +19,6 @@ CSaveCsv::CSaveCsv(void)
 
 CSaveCsv::~CSaveCsv(void)
 {
-	if(m_pFile != 0L) fclose(m_pFile);
 	mClean();
 }
 
@@ -28,8 +27,12 @@ void CSaveCsv::DoIt
 	const char* pcFileName
 )
 {	mClean();
-	m_pFile = fopen(pcFileName, "wt");
-	if(m_pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	m_pFile = pWriteText->Open(pcFileName, iNthGpu);
+	if(m_pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//-----------------
 	m_iNthGpu = iNthGpu;
 	mGenList();
@@ -39,7 +42,7 @@ void CSaveCsv::DoIt
 	else if(pInput->m_iOutImod == 2) mSaveForWarp();
 	else if(pInput->m_iOutImod == 3) mSaveForAligned();
 	//-----------------
-	fclose(m_pFile);
+	pWriteText->Submit();
 	m_pFile = 0L;
 	mClean();
 }
@@ -21,7 +21,6 @@ CSaveTilts::CSaveTilts(void)
 
 CSaveTilts::~CSaveTilts(void)
 {
-	if(m_pFile != 0L) fclose(m_pFile);
 	mClean();
 }
 
@@ -38,8 +37,12 @@ void CSaveTilts::DoIt(int iNthGpu, const char* pcFileName)
 {
 	mClean();
 	//-----------------
-	m_pFile = fopen(pcFileName, "wt");
-	if(m_pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	m_pFile = pWriteText->Open(pcFileName, iNthGpu);
+	if(m_pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//-----------------
 	m_iNthGpu = iNthGpu;
 	//-----------------
@@ -48,7 +51,7 @@ void CSaveTilts::DoIt(int iNthGpu, const char* pcFileName)
 	else if(pInput->m_iOutImod == 2) mSaveForWarp();
 	else if(pInput->m_iOutImod == 3) mSaveForAligned();
 	//-----------------
-	fclose(m_pFile);
+	pWriteText->Submit();
 	m_pFile = 0L;
 }
 
@@ -20,8 +20,12 @@ CSaveXF::~CSaveXF(void)
 
 void CSaveXF::DoIt(int iNthGpu, const char* pcFileName)
 {	
-	m_pFile = fopen(pcFileName, "wt");
-	if(m_pFile == 0L) return;
+	MD::CWriteText* pWriteText = new MD::CWriteText;
+	m_pFile = pWriteText->Open(pcFileName, iNthGpu);
+	if(m_pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	m_iNthGpu = iNthGpu;
 	//-----------------
 	CAtInput* pInput = CAtInput::GetInstance();
@@ -29,7 +33,7 @@ void CSaveXF::DoIt(int iNthGpu, const char* pcFileName)
 	else if(pInput->m_iOutImod == 2) mSaveForWarp();
 	else if(pInput->m_iOutImod == 3) mSaveForAligned();
 	//-----------------
-	fclose(m_pFile);
+	pWriteText->Submit();
 	m_pFile = 0L;
 }
 
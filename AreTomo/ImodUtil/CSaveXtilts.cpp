@@ -21,8 +21,12 @@ void CSaveXtilts::DoIt
 (	int iNthGpu,
 	const char* pcFileName
 )
-{	FILE* pFile = fopen(pcFileName, "wt");
-	if(pFile == 0L) return;
+{	MD::CWriteText* pWriteText = new MD::CWriteText;
+	FILE* pFile = pWriteText->Open(pcFileName, iNthGpu);
+	if(pFile == 0L)
+	{	delete pWriteText;
+		return;
+	}
 	//-----------------
 	CAtInput* pInput = CAtInput::GetInstance();
 	MAM::CDarkFrames* pDarkFrames = 
@@ -39,5 +43,5 @@ void CSaveXtilts::DoIt
 	for(int i=0; i<=iLast; i++)
 	{	fprintf(pFile, "0\n");
 	}
-	fclose(pFile);
+	pWriteText->Submit();
 }
@@ -424,6 +424,52 @@ void CAlignParam::mSwap(int iFrame1, int iFrame2)
 	this->SetShift(iFrame2, afShift1);
 }
 
+//-------------------------------------------------------------------
+// 1. Stores everything alignment determines for -StageCache.
+//    ReadEntry restores it in the same order.
+//-------------------------------------------------------------------
+void CAlignParam::WriteEntry(MD::CStageEntry* pEntry)
+{
+	pEntry->WriteInt(m_iNumFrames);
+	pEntry->Write(m_piSecIndex, sizeof(int) * m_iNumFrames);
+	pEntry->Write(m_pfTilts, sizeof(float) * m_iNumFrames);
+	pEntry->Write(m_pfTiltAxis, sizeof(float) * m_iNumFrames);
+	pEntry->Write(m_pfShiftXs, sizeof(float) * m_iNumFrames * 2);
+	//-----------------
+	pEntry->Write(m_afCenter, sizeof(m_afCenter));
+	pEntry->Write(m_afTiltRange, sizeof(m_afTiltRange));
+	pEntry->WriteFloat(m_fX0);
+	pEntry->WriteFloat(m_fY0);
+	pEntry->WriteFloat(m_fZ0);
+	pEntry->WriteFloat(m_fAlphaOffset);
+	pEntry->WriteFloat(m_fBetaOffset);
+	pEntry->WriteInt(m_iThickness);
+	pEntry->WriteInt(m_iOffsetZ);
+}
+
+bool CAlignParam::ReadEntry(MD::CStageEntry* pEntry)
+{
+	int iNumFrames = pEntry->ReadInt();
+	if(iNumFrames <= 0) return false;
+	this->Create(iNumFrames);
+	//-----------------
+	pEntry->Read(m_piSecIndex, sizeof(int) * m_iNumFrames);
+	pEntry->Read(m_pfTilts, sizeof(float) * m_iNumFrames);
+	pEntry->Read(m_pfTiltAxis, sizeof(float) * m_iNumFrames);
+	pEntry->Read(m_pfShiftXs, sizeof(float) * m_iNumFrames * 2);
+	//-----------------
+	pEntry->Read(m_afCenter, sizeof(m_afCenter));
+	pEntry->Read(m_afTiltRange, sizeof(m_afTiltRange));
+	m_fX0 = pEntry->ReadFloat();
+	m_fY0 = pEntry->ReadFloat();
+	m_fZ0 = pEntry->ReadFloat();
+	m_fAlphaOffset = pEntry->ReadFloat();
+	m_fBetaOffset = pEntry->ReadFloat();
+	m_iThickness = pEntry->ReadInt();
+	m_iOffsetZ = pEntry->ReadInt();
+	return !pEntry->m_bFailed;
+}
+
 void CAlignParam::LogShift(char* pcLogFile)
 {
 	if(pcLogFile == 0L) return;
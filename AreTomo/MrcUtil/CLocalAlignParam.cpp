@@ -154,6 +154,28 @@ float CLocalAlignParam::GetBadPercentage(float fMaxTilt)
 	return fPercentage;
 }
 
+void CLocalAlignParam::WriteEntry(MD::CStageEntry* pEntry)
+{
+	pEntry->WriteInt(m_iNumTilts);
+	pEntry->WriteInt(m_iNumPatches);
+	if(m_iNumPatches <= 0) return;
+	//-----------------
+	size_t tBytes = sizeof(float) * m_iNumTilts * m_iNumPatches;
+	pEntry->Write(m_pfCoordXs, tBytes * m_iNumParams);
+}
+
+bool CLocalAlignParam::ReadEntry(MD::CStageEntry* pEntry)
+{
+	int iNumTilts = pEntry->ReadInt();
+	int iNumPatches = pEntry->ReadInt();
+	if(pEntry->m_bFailed) return false;
+	this->Setup(iNumTilts, iNumPatches);
+	if(m_iNumPatches <= 0) return true;
+	//-----------------
+	size_t tBytes = sizeof(float) * m_iNumTilts * m_iNumPatches;
+	return pEntry->Read(m_pfCoordXs, tBytes * m_iNumParams);
+}
+
 int CLocalAlignParam::mGetNumBads(int iTilt)
 {
 	int iBadCount = 0;
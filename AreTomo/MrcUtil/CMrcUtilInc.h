@@ -81,6 +81,8 @@ public:
 	void ToOneBased(void);
 	//-----------------
 	void LogShift(char* pcLogFile);
+	void WriteEntry(MD::CStageEntry* pEntry);
+	bool ReadEntry(MD::CStageEntry* pEntry);
 	//-----------------
 	float m_fAlphaOffset;
 	float m_fBetaOffset;
@@ -127,6 +129,8 @@ public:
 	void GetShift(int iTilt, int iPatch, float* pfShift);
 	float GetGood(int iTilt, int iPatch);
 	float GetBadPercentage(float fMaxTilt);
+	void WriteEntry(MD::CStageEntry* pEntry);
+	bool ReadEntry(MD::CStageEntry* pEntry);
 	//-----------------
 	float* m_pfCoordXs;
 	float* m_pfCoordYs;
@@ -297,6 +301,7 @@ private:
 	CAlignParam* m_pAlignParam;
 	CLocalAlignParam* m_pLocalParam;
 	//-----------------
+	MD::CWriteText* m_pWriteText;
 	FILE* m_pFile;
 	int m_iNumTilts;
 	int m_iNumPatches;
@@ -350,6 +355,7 @@ public:
 	  float* pfStats,
 	  bool bVolume
 	);
+	int m_iNthGpu;
 private:
 	void mDrawTiltAxis(float* pfImg, int* piSize, float fTiltAxis);
 	Mrc::CSaveMrc m_aSaveMrc;
@@ -17,6 +17,7 @@ char CSaveAlignFile::m_acThicknessTag[] = "Thickness";
 CSaveAlignFile::CSaveAlignFile(void)
 {
 	m_pFile = 0L;
+	m_pWriteText = 0L;
 }
 
 CSaveAlignFile::~CSaveAlignFile(void)
@@ -46,9 +47,12 @@ void CSaveAlignFile::DoIt(int iNthGpu)
 	bool bSave = true;
 	CSaveAlignFile::GenFileName(iNthGpu, bSave, acAlnFile);
 	//-----------------
-	m_pFile = fopen(acAlnFile, "wt");
+	m_pWriteText = new MD::CWriteText;
+	m_pFile = m_pWriteText->Open(acAlnFile, iNthGpu);
 	if(m_pFile == 0L)
-	{	printf("GPU %d: Alignment data will not be saved\n"
+	{	delete m_pWriteText;
+		m_pWriteText = 0L;
+		printf("GPU %d: Alignment data will not be saved\n"
 		   "   Unable to open aln file %s\n\n", m_iNthGpu, acAlnFile);
 		return;
 	}
@@ -145,9 +149,13 @@ void CSaveAlignFile::mSaveLocal(void)
 	}
 }
 
+//--------------------------------------------------------------------
+// 1. The aln file is handed to MD::CAsyncWriter when complete.
+//--------------------------------------------------------------------
 void CSaveAlignFile::mCloseFile(void)
 {
-	if(m_pFile == 0L) return;
-	fclose(m_pFile);
+	if(m_pWriteText == 0L) return;
+	m_pWriteText->Submit();
+	m_pWriteText = 0L;
 	m_pFile = 0L;
 }
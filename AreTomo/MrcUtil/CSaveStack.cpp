@@ -1,5 +1,4 @@
 #include "CMrcUtilInc.h"
-#include <Util/Util_Time.h>
 #include <stdio.h>
 #include <memory.h>
 #include <string.h>
@@ -10,6 +9,7 @@ using namespace McAreTomo::AreTomo::MrcUtil;
 CSaveStack::CSaveStack(void)
 {
 	memset(m_acMrcFile, 0, sizeof(m_acMrcFile));
+	m_iNthGpu = 0;
 }
 
 CSaveStack::~CSaveStack(void)
@@ -23,6 +23,10 @@ bool CSaveStack::OpenFile(char* pcMrcFile)
 	return bOpen;
 }
 	
+//-------------------------------------------------------------------
+// 1. The stack is queued in MD::CAsyncWriter and copied there since
+//    it stays with the caller.
+//-------------------------------------------------------------------
 void CSaveStack::DoIt
 (	MD::CTiltSeries* pTiltSeries,
 	CAlignParam* pAlignParam,
@@ -30,39 +34,30 @@ void CSaveStack::DoIt
 	float* pfStats,
 	bool bVolume
 )
-{	Util_Time utilTime;
-	utilTime.Measure();
+{	m_aSaveMrc.CloseFile();
+	printf("Saving %s\n", m_acMrcFile);
 	//-----------------
-	m_aSaveMrc.OpenFile(m_acMrcFile);
-	m_aSaveMrc.SetMode(Mrc::eMrcFloat);
-	m_aSaveMrc.SetImgSize(pTiltSeries->m_aiStkSize, 
-	   pTiltSeries->m_aiStkSize[2], 1, fPixelSize);
-	m_aSaveMrc.SetExtHeader(0, 32, 0);
+	MD::CWriteStack* pWriteStack = new MD::CWriteStack;
+	strcpy(pWriteStack->m_acFile, m_acMrcFile);
+	pWriteStack->m_iNthGpu = m_iNthGpu;
+	bool bOwn = true;
+	pWriteStack->SetStack(pTiltSeries, !bOwn);
+	pWriteStack->SetExtHeader(0, 32);
+	pWriteStack->SetPixSize(fPixelSize);
 	if(pfStats != 0L)
-	{	m_aSaveMrc.SaveMinMaxMean(pfStats[0], pfStats[1], pfStats[2]);
+	{	pWriteStack->SetMinMaxMean(pfStats[0], pfStats[1], pfStats[2]);
 	}
-	m_aSaveMrc.m_pSaveMain->DoIt();
-	//-----------------------------
-	printf("Saving %s\n", m_acMrcFile);
+	//-----------------
+	int iNumTilts = pTiltSeries->m_aiStkSize[2];
 	if(!bVolume)
-	{	for(int i=0; i<pTiltSeries->m_aiStkSize[2]; i++)
-		{	float fTilt = pAlignParam->GetTilt(i);
-			m_aSaveMrc.m_pSaveExt->SetTilt(i, &fTilt, 1);
-			m_aSaveMrc.m_pSaveExt->DoIt();
+	{	float* pfTilts = new float[iNumTilts];
+		for(int i=0; i<iNumTilts; i++)
+		{	pfTilts[i] = pAlignParam->GetTilt(i);
 		}
+		pWriteStack->SetTilts(pfTilts);
+		delete[] pfTilts;
 	}
-	//---------------------------------------------
-	int iLast = pTiltSeries->m_aiStkSize[2] - 1;
-	for(int i=0; i<pTiltSeries->m_aiStkSize[2]; i++)
-	{	float* pfFrame = (float*)pTiltSeries->GetFrame(i);
-		m_aSaveMrc.m_pSaveImg->DoIt(i, pfFrame);
-		if(i % 100 != 0 && i != iLast) continue;
-		printf("...... %4d volume sliices saved, %4d left\n",
-		   i+1, iLast-i);
-	}
-	//-----------------------
-	m_aSaveMrc.CloseFile();
-	printf("Saving time: %.2f\n", utilTime.GetElapsedSeconds());
+	MD::CAsyncWriter::GetInstance()->Submit(pWriteStack);
 }
 
 void CSaveStack::mDrawTiltAxis(float* pfImg, int* piSize, float fTiltAxis)
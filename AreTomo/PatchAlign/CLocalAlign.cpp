@@ -30,6 +30,13 @@ void CLocalAlign::Setup(int iNthGpu)
 	m_iNthGpu = iNthGpu;
 }
 
+//-------------------------------------------------------------------
+// 1. Each patch is aligned with a fresh copy of ProjAlign::CParam.
+//    Several CLocalAlign can then run concurrently, and what one
+//    patch changes, e.g. the AlignZ cap, never leaks into the next
+//    patch of the same worker.
+//-------------------------------------------------------------------
+
 void CLocalAlign::DoIt(MAM::CAlignParam* pAlignParam, int* piRoi)
 {	
 	pAlignParam->ResetShift();
@@ -51,13 +58,14 @@ void CLocalAlign::DoIt(MAM::CAlignParam* pAlignParam, int* piRoi)
 	}
 	//-------------------------------------
 	CAtInput* pAtInput = CAtInput::GetInstance();
-	ProjAlign::CParam* pParam = ProjAlign::CParam::GetInstance(m_iNthGpu);
+	ProjAlign::CParam* pParam = ProjAlign::CParam::GetInstance
+	   (m_iNthGpu)->GetCopy();
 	pParam->m_fXcfSize = 1024.0f * 1.0f;
 	pParam->m_afMaskSize[0] = 0.8f;
 	pParam->m_afMaskSize[1] = 0.8f;
 	m_pProjAlignMain->Set0(400.0f, m_iNthGpu);
+	m_pProjAlignMain->Set2(true); // before Set1: no CBufferPool
 	m_pProjAlignMain->Set1(pParam);
-	m_pProjAlignMain->Set2(true);
 	//-----------------
 	pAlignParam->SetRotationCenterZ(0.0f);
 	float fLastErr = m_pProjAlignMain->DoIt(pAlignParam);
@@ -88,5 +96,6 @@ void CLocalAlign::DoIt(MAM::CAlignParam* pAlignParam, int* piRoi)
 		}
 	}
 	delete pLastParam;
+	delete pParam;
 }
 
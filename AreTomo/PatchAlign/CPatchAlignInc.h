@@ -2,6 +2,8 @@
 #include "../CAreTomoInc.h"
 #include "../ProjAlign/CProjAlignFwd.h"
 #include "../MrcUtil/CMrcUtilFwd.h"
+#include "../Util/CUtilInc.h"
+#include <Util/Util_Thread.h>
 #include <cuda.h>
 #include <cufft.h>
 #include <pthread.h>
@@ -208,6 +210,32 @@ private:
 	int m_iNthGpu;
 };
 
+//-------------------------------------------------------------------
+// 1. A worker of CPatchAlignMain. It owns its own CLocalAlign and
+//    thus its own CProjAlignMain workspace on the GPU.
+// 2. Patches are pulled from pNextPatch. The aligned parameters of
+//    patch i are placed in ppPatchParams[i] and are gathered by
+//    CPatchAlignMain in patch order.
+//-------------------------------------------------------------------
+class CPatchAlignThread : public Util_Thread
+{
+public:
+	CPatchAlignThread(void);
+	~CPatchAlignThread(void);
+	void Run
+	( int iNthGpu,
+	  MAM::CAlignParam** ppPatchParams,
+	  MAU::CNextItem* pNextPatch
+	);
+	void ThreadMain(void);
+private:
+	void mAlignPatch(int iPatch);
+	CLocalAlign* m_pLocalAlign;
+	MAM::CAlignParam** m_ppPatchParams;
+	MAU::CNextItem* m_pNextPatch;
+	int m_iNthGpu;
+};
+
 class CDetectFeatures
 {
 public:
@@ -268,16 +296,17 @@ public:
 	//-----------------
 	~CPatchAlignMain(void);
 	void DoIt(void);
+	int m_iNumThreads; // 0: decided by GPU memory and CPU cores
 private:
 	CPatchAlignMain(void);
-	void mAlignStack(int iPatch);
+	int mCalcNumThreads(int iNumPatches);
 	//-----------------
 	MD::CTiltSeries* m_pTiltSeries;
 	MAM::CAlignParam* m_pFullParam;
 	//-----------------
 	MAM::CPatchShifts* m_pPatchShifts;
 	MAM::CLocalAlignParam* m_pLocalParam;
-	CLocalAlign* m_pLocalAlign;
+	MAU::CNextItem m_aNextPatch;
 	int m_iNthGpu;
 	//-----------------
 	static CPatchAlignMain* m_pInstances;
@@ -1,5 +1,6 @@
 #include "CPatchAlignInc.h"
 #include "../MrcUtil/CMrcUtilInc.h"
+#include <sys/sysinfo.h>
 #include <memory.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -9,6 +10,7 @@
 using namespace McAreTomo::AreTomo::PatchAlign;
 
 static float s_fD2R = 0.0174533f;
+static int s_iMaxThreads = 4;
 CPatchAlignMain* CPatchAlignMain::m_pInstances = 0L;
 int CPatchAlignMain::m_iNumGpus = 0;
 
@@ -44,12 +46,20 @@ CPatchAlignMain* CPatchAlignMain::GetInstance(int iNthGpu)
 
 CPatchAlignMain::CPatchAlignMain(void)
 {
+	m_iNumThreads = 0;
 }
 
 CPatchAlignMain::~CPatchAlignMain(void)
 {
 }
 
+//-------------------------------------------------------------------
+// 1. Patches are aligned concurrently by CPatchAlignThread, each
+//    with its own CProjAlignMain workspace.
+// 2. The results are gathered into CPatchShifts in patch order
+//    after all workers exit, so the outcome does not depend on
+//    which worker aligned which patch.
+//-------------------------------------------------------------------
 void CPatchAlignMain::DoIt(void)
 {	
 	MD::CTsPackage* pPkg = MD::CTsPackage::GetInstance(m_iNthGpu);
@@ -58,47 +68,66 @@ void CPatchAlignMain::DoIt(void)
 	m_pLocalParam = MAM::CLocalAlignParam::GetInstance(m_iNthGpu);
 	m_pPatchShifts = MAM::CPatchShifts::GetInstance(m_iNthGpu);
 	CPatchTargets* pPatchTargets = CPatchTargets::GetInstance(m_iNthGpu);
+	int iNumPatches = pPatchTargets->m_iNumTgts;
 	//-----------------
-	m_pLocalParam->Setup(m_pTiltSeries->m_aiStkSize[2],
-	   pPatchTargets->m_iNumTgts);
+	m_pLocalParam->Setup(m_pTiltSeries->m_aiStkSize[2], iNumPatches);
+	m_pPatchShifts->Setup(iNumPatches, m_pTiltSeries->m_aiStkSize[2]);
 	//-----------------
-	m_pPatchShifts->Setup(pPatchTargets->m_iNumTgts, 
-	   m_pTiltSeries->m_aiStkSize[2]);
+	MAM::CAlignParam** ppPatchParams = new MAM::CAlignParam*[iNumPatches];
+	memset(ppPatchParams, 0, sizeof(MAM::CAlignParam*) * iNumPatches);
 	//-----------------
-	m_pLocalAlign = new CLocalAlign;
-	m_pLocalAlign->Setup(m_iNthGpu);
-	for(int i=0; i<pPatchTargets->m_iNumTgts; i++)
-	{	mAlignStack(i);
+	int iNumThreads = mCalcNumThreads(iNumPatches);
+	printf("Patch align: %d patches, %d threads\n\n", 
+	   iNumPatches, iNumThreads);
+	m_aNextPatch.Create(iNumPatches);
+	CPatchAlignThread* pThreads = new CPatchAlignThread[iNumThreads];
+	for(int i=0; i<iNumThreads; i++)
+	{	pThreads[i].Run(m_iNthGpu, ppPatchParams, &m_aNextPatch);
 	}
+	for(int i=0; i<iNumThreads; i++)
+	{	pThreads[i].WaitForExit(-1.0f);
+	}
+	delete[] pThreads;
+	//-----------------
+	for(int i=0; i<iNumPatches; i++)
+	{	if(ppPatchParams[i] == 0L) continue;
+		m_pPatchShifts->SetRawShift(i, ppPatchParams[i]);
+		delete ppPatchParams[i];
+	}
+	delete[] ppPatchParams;
 	//-----------------
 	CFitPatchShifts aFitPatchShifts;
-	aFitPatchShifts.Setup(m_pFullParam, pPatchTargets->m_iNumTgts);
+	aFitPatchShifts.Setup(m_pFullParam, iNumPatches);
 	aFitPatchShifts.DoIt(m_pPatchShifts, m_pLocalParam);
-	//-----------------
-	delete m_pLocalAlign; 
-	m_pLocalAlign = 0L;
 }
 
-void CPatchAlignMain::mAlignStack(int iPatch)
+//-------------------------------------------------------------------
+// 1. Each worker holds about eight raw-sized float frames on the
+//    GPU: its own corrected-stack buffers, CCorrProj buffers and
+//    the central xcf buffers. Only what is left after the buffer
+//    pool is counted.
+// 2. The CPU threads are shared with the other GPUs.
+// 3. m_iNumThreads > 0 overrides all of these (Benchmark).
+//-------------------------------------------------------------------
+int CPatchAlignMain::mCalcNumThreads(int iNumPatches)
 {
-	CPatchTargets* pPatchTargets = CPatchTargets::GetInstance(m_iNthGpu);
-	int iLeft = pPatchTargets->m_iNumTgts - 1 - iPatch;
-	//------------------
-	int aiCent[2] = {0};
-	pPatchTargets->GetTarget(iPatch, aiCent);
-	//------------------
-	MAM::CAlignParam* pAlignParam = m_pFullParam->GetCopy();
-	//------------------
-	printf("Align patch at (%d, %d), %d patches left\n", aiCent[0],
-	   aiCent[1], iLeft);
-	m_pLocalAlign->DoIt(pAlignParam, aiCent);
-	m_pPatchShifts->SetRawShift(iPatch, pAlignParam);
+	if(m_iNumThreads > 0)
+	{	if(m_iNumThreads > iNumPatches) return iNumPatches;
+		else return m_iNumThreads;
+	}
+	//-----------------
+	size_t tFree = 0, tTotal = 0;
+	cudaMemGetInfo(&tFree, &tTotal);
+	size_t tWorkerBytes = sizeof(float) * 8
+	   * m_pTiltSeries->GetPixels();
+	int iNumThreads = (int)(tFree * 0.8 / tWorkerBytes);
 	//-----------------
-	/*
 	CInput* pInput = CInput::GetInstance();
-	char* pcLogFile = pInput->GetLogFile("PatchStack.txt", &iPatch);
-	pAlignParam->LogShift(pcLogFile);
-	if(pcLogFile != 0L) delete[] pcLogFile;
-	*/
+	int iNumGpus = (pInput->m_iNumGpus > 0) ? pInput->m_iNumGpus : 1;
+	int iNumCpus = get_nprocs() / iNumGpus;
+	if(iNumThreads > iNumCpus) iNumThreads = iNumCpus;
+	if(iNumThreads > s_iMaxThreads) iNumThreads = s_iMaxThreads;
+	if(iNumThreads > iNumPatches) iNumThreads = iNumPatches;
+	if(iNumThreads < 1) iNumThreads = 1;
+	return iNumThreads;
 }
-
@@ -0,0 +1,72 @@
+#include "CPatchAlignInc.h"
+#include "../MrcUtil/CMrcUtilInc.h"
+#include <memory.h>
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <stdio.h>
+
+using namespace McAreTomo::AreTomo::PatchAlign;
+
+CPatchAlignThread::CPatchAlignThread(void)
+{
+	m_pLocalAlign = 0L;
+	m_ppPatchParams = 0L;
+	m_pNextPatch = 0L;
+	m_iNthGpu = -1;
+}
+
+CPatchAlignThread::~CPatchAlignThread(void)
+{
+	if(m_pLocalAlign != 0L) delete m_pLocalAlign;
+	m_pLocalAlign = 0L;
+}
+
+void CPatchAlignThread::Run
+(	int iNthGpu,
+	MAM::CAlignParam** ppPatchParams,
+	MAU::CNextItem* pNextPatch
+)
+{	m_iNthGpu = iNthGpu;
+	m_ppPatchParams = ppPatchParams;
+	m_pNextPatch = pNextPatch;
+	this->Start();
+}
+
+//-------------------------------------------------------------------
+// 1. CLocalAlign is created here since its GPU buffers must be
+//    allocated after the device is set for this thread.
+//-------------------------------------------------------------------
+void CPatchAlignThread::ThreadMain(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	cudaSetDevice(pInput->m_piGpuIDs[m_iNthGpu]);
+	//-----------------
+	m_pLocalAlign = new CLocalAlign;
+	m_pLocalAlign->Setup(m_iNthGpu);
+	//-----------------
+	while(true)
+	{	int iPatch = m_pNextPatch->GetNext();
+		if(iPatch < 0) break;
+		mAlignPatch(iPatch);
+	}
+	//-----------------
+	delete m_pLocalAlign;
+	m_pLocalAlign = 0L;
+}
+
+void CPatchAlignThread::mAlignPatch(int iPatch)
+{
+	CPatchTargets* pPatchTargets = CPatchTargets::GetInstance(m_iNthGpu);
+	int iLeft = pPatchTargets->m_iNumTgts - 1 - iPatch;
+	//-----------------
+	int aiCent[2] = {0};
+	pPatchTargets->GetTarget(iPatch, aiCent);
+	//-----------------
+	MAM::CAlignParam* pFullParam = MAM::CAlignParam::GetInstance(m_iNthGpu);
+	MAM::CAlignParam* pAlignParam = pFullParam->GetCopy();
+	//-----------------
+	printf("Align patch %d at (%d, %d), %d patches left\n", iPatch,
+	   aiCent[0], aiCent[1], iLeft);
+	m_pLocalAlign->DoIt(pAlignParam, aiCent);
+	m_ppPatchParams[iPatch] = pAlignParam;
+}
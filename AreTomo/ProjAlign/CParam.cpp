@@ -47,3 +47,19 @@ CParam::~CParam(void)
 {
 }
 
+//-------------------------------------------------------------------
+// 1. The copy lets a patch worker change its own xcf and mask sizes
+//    without touching the per-GPU instance shared by other workers.
+//-------------------------------------------------------------------
+CParam* CParam::GetCopy(void)
+{
+	CParam* pParam = new CParam;
+	memcpy(pParam->m_afMaskSize, m_afMaskSize, sizeof(m_afMaskSize));
+	pParam->m_iIterations = m_iIterations;
+	pParam->m_fTol = m_fTol;
+	pParam->m_iAlignZ = m_iAlignZ;
+	pParam->m_fXcfSize = m_fXcfSize;
+	pParam->m_iNthGpu = m_iNthGpu;
+	return pParam;
+}
+
@@ -15,6 +15,7 @@ public:
 	static void DeleteInstances(void);
 	//-----------------
 	~CParam(void);
+	CParam* GetCopy(void);
 	float m_afMaskSize[2];
 	int m_iIterations;
 	float m_fTol;
@@ -173,6 +174,11 @@ public:
 	void Clean(void);
 	void Set0(float fBFactor, int iNthGpu);
 	void Set1(CParam* pParam);
+	//-----------------------------------------------------------
+	// bLocal must be set before Set1 where CCorrTomoStack binds
+	// its buffers. Local (patch) alignment runs concurrently and
+	// cannot use the tmp frames of CBufferPool.
+	//-----------------------------------------------------------
 	void Set2(bool bLocal) { m_bLocal = bLocal; }
 	float DoIt(MAM::CAlignParam* pAlignParam);
 private:
@@ -80,6 +80,7 @@ void CProjAlignMain::Set1(CParam* pParam)
 	   MAM::CAlignParam::GetInstance(m_iNthGpu);
 	float fTiltAxis = pAlignParam->GetTiltAxis(m_iNumProjs / 2);
 	//-----------------
+	m_pCorrTomoStack->UseOwnBuffers(m_bLocal);
 	m_pCorrTomoStack->Set1(0, fTiltAxis);
 	m_pCorrTomoStack->Set2((float)m_iBin, !bFourierCrop, bRandomFill);
 	m_pCorrTomoStack->Set3(!bShiftOnly, false, !bRWeight);
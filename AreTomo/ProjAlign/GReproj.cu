@@ -8,9 +8,11 @@
 
 using namespace McAreTomo::AreTomo::ProjAlign;
 
-static __device__ __constant__ int giProjSize[2];
-static __device__ __constant__ int giVolSize[2];
-
+//-------------------------------------------------------------------
+// 1. Sizes are passed as kernel arguments rather than __constant__
+//    symbols since patch workers on the same GPU reproject stacks
+//    of different binnings at the same time.
+//-------------------------------------------------------------------
 static __device__ float mDIntProj(float* gfProj, float fX)
 {
 	int x = (int)fX;
@@ -25,17 +27,19 @@ static __global__ void mGBackProj
 	float fProjAngle,
 	int iStartIdx,
 	int iEndIdx,
+	int2 aiProjSize,
+	int2 aiVolSize,
 	float* gfVol // xz slice
 )
 {	int iX = blockIdx.x * blockDim.x + threadIdx.x;
-	if(iX >= giVolSize[0]) return;
-	float fX = iX +0.5f - giVolSize[0] * 0.5f;
-	float fZ = blockIdx.y + 0.5f - giVolSize[1] * 0.5f;
+	if(iX >= aiVolSize.x) return;
+	float fX = iX +0.5f - aiVolSize.x * 0.5f;
+	float fZ = blockIdx.y + 0.5f - aiVolSize.y * 0.5f;
 	//-------------------------------------------------
 	float fInt = 0.0f;
 	float fCount = 0.0f;
-	float fCentX = giProjSize[0] * 0.5f;
-	int iEnd = giProjSize[0] - 1;
+	float fCentX = aiProjSize.x * 0.5f;
+	int iEnd = aiProjSize.x - 1;
 	//-----------------------------------
 	for(int i=iStartIdx; i<=iEndIdx; i++)
 	{	float fW = cosf((fProjAngle - gfTiltAngles[i]) * s_fD2R);
@@ -46,7 +50,7 @@ static __global__ void mGBackProj
 		fV = fX * fCos + fZ * fSin + fCentX;
 		if(fV < 0 || fV > iEnd) continue;
 		//-------------------------------
-		float* gfProj = gfSinogram + i * giProjSize[0];
+		float* gfProj = gfSinogram + i * aiProjSize.x;
 		fV = mDIntProj(gfProj, fV);
 		if(fV < (float)-1e20) continue;
 		//------------------------------------------------
@@ -56,7 +60,7 @@ static __global__ void mGBackProj
 		fInt += (fV * fCos * fW);
 		fCount += fW;
 	}
-	int i = blockIdx.y * giVolSize[0] + iX;
+	int i = blockIdx.y * aiVolSize.x + iX;
 	if(fCount < 0.001f) gfVol[i] = (float)-1e30;
 	else gfVol[i] = fInt / fCount;
 }
@@ -68,6 +72,7 @@ static __global__ void mGForProj
 	int iRayLength,
 	float fCos,
 	float fSin,
+	int2 aiVolSize,
 	float* gfReproj
 )
 {	float* sfSum = (float*)&s_cArray[0];
@@ -77,13 +82,13 @@ static __global__ void mGForProj
 	__syncthreads();
 	//--------------
 	float fXp = blockIdx.x + 0.5f - gridDim.x * 0.5f;
-	float fTempX = fXp * fCos + giVolSize[0] * 0.5f;
-	float fTempZ = fXp * fSin + giVolSize[1] * 0.5f;
+	float fTempX = fXp * fCos + aiVolSize.x * 0.5f;
+	float fTempZ = fXp * fSin + aiVolSize.y * 0.5f;
 	float fZStartp = -fXp * fSin / fCos - 0.5f * iRayLength;
 	//------------------------------------------------------
 	int i = 0;
-	int iEndX = giVolSize[0] - 1;
-	int iEndZ = giVolSize[1] - 1;
+	int iEndX = aiVolSize.x - 1;
+	int iEndZ = aiVolSize.y - 1;
 	float fX = 0.0f, fZ = 0.0f, fV = 0.0f;
 	int iSegments = iRayLength / blockDim.y + 1;
 	for(i=0; i<iSegments; i++)
@@ -95,7 +100,7 @@ static __global__ void mGForProj
 		fZ = fTempZ + fZ * fCos;
 		//----------------------
 		if(fX >= 0 && fX < iEndX && fZ >= 0 && fZ < iEndZ)
-		{	fV = gfVol[giVolSize[0] * (int)(fZ) + (int)(fX)];
+		{	fV = gfVol[aiVolSize.x * (int)(fZ) + (int)(fX)];
 			if(fV >= (float)-1e10)
 			{	sfSum[threadIdx.y] += fV;
 				siCount[threadIdx.y] += 1;
@@ -155,11 +160,7 @@ void GReproj::SetSizes
 	m_aiVolSize[0] = iVolX;
 	m_aiVolSize[1] = iVolZ;
 	//---------------------
-	int iBytes = sizeof(int) * 2;
-	cudaMemcpyToSymbol(giProjSize, m_aiProjSize, iBytes);
-	cudaMemcpyToSymbol(giVolSize, m_aiVolSize, iBytes);
-	//-------------------------------------------------
-	iBytes = m_aiProjSize[0] * sizeof(float);
+	int iBytes = m_aiProjSize[0] * sizeof(float);
 	cudaMalloc(&m_gfReproj, iBytes);
 	//------------------------------
 	iBytes = m_aiVolSize[0] * m_aiVolSize[1] * sizeof(float);
@@ -189,7 +190,9 @@ void GReproj::mBackProj(float fProjAngle, int* piProjRange)
 	//--------------------------------------------
 	mGBackProj<<<aGridDim, aBlockDim, 0, m_stream>>>
 	( m_gfSinogram, m_gfTiltAngles, fProjAngle, 
-	  piProjRange[0], piProjRange[1], m_gfVol
+	  piProjRange[0], piProjRange[1], 
+	  make_int2(m_aiProjSize[0], m_aiProjSize[1]),
+	  make_int2(m_aiVolSize[0], m_aiVolSize[1]), m_gfVol
 	);
 }
 
@@ -205,7 +208,8 @@ void GReproj::mForwardProj(float fProjAngle)
 	int iShmBytes = (sizeof(float) + sizeof(int)) * aBlockDim.y;
 	//----------------------------------------------------------
 	mGForProj<<<aGridDim, aBlockDim, iShmBytes, m_stream>>>
-	( m_gfVol, iRayLength, fCos, fSin, m_gfReproj
+	( m_gfVol, iRayLength, fCos, fSin, 
+	  make_int2(m_aiVolSize[0], m_aiVolSize[1]), m_gfReproj
 	);
 }
 
@@ -0,0 +1,143 @@
+#include "CReconInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+//-------------------------------------------------------------------
+// 1. The same expression as in GBackProj for the projected x of
+//    a volume x.
+//-------------------------------------------------------------------
+static inline float sProjX(int iX, float fHalfX, float fCos, float fOffset,
+	float fCentX)
+{
+	float fX = iX + 0.5f - fHalfX;
+	return fX * fCos + fOffset + fCentX;
+}
+
+CBackProj::CBackProj(void)
+{
+	m_pfSum = 0L;
+	m_pfCount = 0L;
+	m_iStartProj = 0;
+	m_iEndProj = 0;
+}
+
+CBackProj::~CBackProj(void)
+{
+	this->Clean();
+}
+
+void CBackProj::Clean(void)
+{
+	if(m_pfSum != 0L) delete[] m_pfSum;
+	if(m_pfCount != 0L) delete[] m_pfCount;
+	m_pfSum = 0L;
+	m_pfCount = 0L;
+}
+
+void CBackProj::SetSize(int* piPadProjSize, int* piVolSize)
+{
+	this->Clean();
+	m_iPadProjX = piPadProjSize[0];
+	m_iProjX = (piPadProjSize[0] / 2 - 1) * 2;
+	m_aiVolSize[0] = piVolSize[0];
+	m_aiVolSize[1] = piVolSize[1];
+	m_iStartProj = 0;
+	m_iEndProj = piPadProjSize[1];
+	//-----------------
+	m_pfSum = new float[m_aiVolSize[0]];
+	m_pfCount = new float[m_aiVolSize[0]];
+}
+
+void CBackProj::SetSubset(int iStartProj, int iEndProj)
+{
+	m_iStartProj = iStartProj;
+	m_iEndProj = iEndProj;
+}
+
+//-------------------------------------------------------------------
+// 1. Counts are kept in floats so that the inner loop works on
+//    one data type and vectorizes. They are exact up to 2^24.
+//-------------------------------------------------------------------
+void CBackProj::DoIt
+(	float* pfPadSinogram,
+	float* pfCosSin,
+	bool* pbNoProjs,
+	bool bSart,
+	float fRelax,
+	float* pfVolXZ
+)
+{	int iVolX = m_aiVolSize[0];
+	float fHalfX = iVolX * 0.5f;
+	float fCentX = m_iProjX / 2.0f;
+	int aiRange[2] = {0};
+	//-----------------
+	for(int z=0; z<m_aiVolSize[1]; z++)
+	{	float fZ = z + 0.5f - m_aiVolSize[1] * 0.5f;
+		memset(m_pfSum, 0, sizeof(float) * iVolX);
+		memset(m_pfCount, 0, sizeof(float) * iVolX);
+		//----------------
+		for(int i=m_iStartProj; i<m_iEndProj; i++)
+		{	if(pbNoProjs[i]) continue;
+			float fCos = pfCosSin[2 * i];
+			float fOffset = fZ * pfCosSin[2 * i + 1];
+			mGetRangeX(fCos, fOffset, aiRange);
+			//---------------
+			float* pfLine = pfPadSinogram + i * m_iPadProjX;
+			for(int x=aiRange[0]; x<aiRange[1]; x++)
+			{	int iXp = (int)sProjX(x, fHalfX, fCos, fOffset, fCentX);
+				float fVal = pfLine[iXp];
+				bool bValid = fVal > (float)-1e10;
+				m_pfSum[x] += bValid ? fVal : 0.0f;
+				m_pfCount[x] += bValid ? 1.0f : 0.0f;
+			}
+		}
+		//----------------
+		float* pfVolLine = pfVolXZ + z * iVolX;
+		for(int x=0; x<iVolX; x++)
+		{	if(m_pfCount[x] <= 0) continue;
+			float fInt = fRelax * m_pfSum[x] / (int)m_pfCount[x]
+			   + pfVolLine[x];
+			if(bSart) pfVolLine[x] = fmaxf(fInt, 0.0f);
+			else pfVolLine[x] = fInt;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Returns [start, end) of volume x whose projected x is in
+//    [0, m_iProjX - 2] as tested in GBackProj. The analytic range
+//    is widened by a pixel and then trimmed with the exact test.
+//-------------------------------------------------------------------
+void CBackProj::mGetRangeX(float fCos, float fOffset, int* piRange)
+{
+	int iVolX = m_aiVolSize[0];
+	float fHalfX = iVolX * 0.5f;
+	float fCentX = m_iProjX / 2.0f;
+	int iProjEndX = m_iProjX - 2;
+	piRange[0] = 0;
+	piRange[1] = iVolX;
+	//-----------------
+	if(fabsf(fCos) > 1e-6f)
+	{	double dX1 = (0.0 - fOffset - fCentX) / fCos;
+		double dX2 = (iProjEndX - fOffset - fCentX) / fCos;
+		if(dX1 > dX2) { double dT = dX1; dX1 = dX2; dX2 = dT; }
+		dX1 = floor(dX1 + fHalfX - 0.5) - 1;
+		dX2 = ceil(dX2 + fHalfX - 0.5) + 2;
+		if(dX1 > piRange[0]) piRange[0] = (int)fmin(dX1, iVolX);
+		if(dX2 < piRange[1]) piRange[1] = (int)fmax(dX2, 0);
+	}
+	//-----------------
+	while(piRange[0] < piRange[1])
+	{	float fXp = sProjX(piRange[0], fHalfX, fCos, fOffset, fCentX);
+		if(fXp >= 0 && fXp <= iProjEndX) break;
+		piRange[0] += 1;
+	}
+	while(piRange[1] > piRange[0])
+	{	float fXp = sProjX(piRange[1] - 1, fHalfX, fCos, fOffset, fCentX);
+		if(fXp >= 0 && fXp <= iProjEndX) break;
+		piRange[1] -= 1;
+	}
+}
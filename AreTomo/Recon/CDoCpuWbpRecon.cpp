@@ -0,0 +1,109 @@
+#include "CReconInc.h"
+#include "../MrcUtil/CMrcUtilInc.h"
+#include <Util/Util_Time.h>
+#include <sys/sysinfo.h>
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CDoCpuWbpRecon::CDoCpuWbpRecon(void)
+{
+	m_iNumThreads = 0;
+	m_pVolSeries = 0L;
+	m_pfCosSin = 0L;
+	m_pbNoProjs = 0L;
+}
+
+CDoCpuWbpRecon::~CDoCpuWbpRecon(void)
+{
+	mClean();
+	if(m_pVolSeries != 0L) delete m_pVolSeries;
+}
+
+MD::CTiltSeries* CDoCpuWbpRecon::DoIt
+(	MD::CTiltSeries* pTiltSeries,
+	MAM::CAlignParam* pAlignParam,
+	int iVolZ
+)
+{	m_pTiltSeries = pTiltSeries;
+	m_pAlignParam = pAlignParam;
+	//-----------------
+	int aiVolSize[3] = {1, iVolZ, pTiltSeries->m_aiStkSize[1]};
+	aiVolSize[0] = pTiltSeries->m_aiStkSize[0] / 2 * 2;
+	m_pVolSeries = new MD::CTiltSeries;
+	m_pVolSeries->Create(aiVolSize);
+	//-----------------
+	MD::CTraceSpan aSpan("CDoCpuWbpRecon::DoIt");
+	aSpan.AddBytes(m_pVolSeries->m_tFmBytes * aiVolSize[2]);
+	aSpan.AddItems(aiVolSize[2]);
+	mSetup();
+	mReconstruct();
+	mClean();
+	//-----------------
+	MD::CTiltSeries* pVolSeries = m_pVolSeries;
+	m_pVolSeries = 0L;
+	return pVolSeries;
+}
+
+//-------------------------------------------------------------------
+// 1. The cosines and sines are computed as in CTomoBase.
+//-------------------------------------------------------------------
+void CDoCpuWbpRecon::mSetup(void)
+{
+	mClean();
+	int iNumProjs = m_pTiltSeries->m_aiStkSize[2];
+	m_pbNoProjs = new bool[iNumProjs];
+	memset(m_pbNoProjs, 0, sizeof(bool) * iNumProjs);
+	//-----------------
+	bool bCopy = true;
+	float fRad = 3.1415926f / 180.0f;
+	float* pfTilts = m_pAlignParam->GetTilts(!bCopy);
+	m_pfCosSin = new float[iNumProjs * 2];
+	for(int i=0; i<iNumProjs; i++)
+	{	float fAngle = fRad * pfTilts[i];
+		m_pfCosSin[2 * i] = (float)cos(fAngle);
+		m_pfCosSin[2 * i + 1] = (float)sin(fAngle);
+	}
+	//-----------------
+	if(m_iNumThreads <= 0)
+	{	CInput* pInput = CInput::GetInstance();
+		int iNumGpus = (pInput->m_iNumGpus > 0) ? pInput->m_iNumGpus : 1;
+		m_iNumThreads = get_nprocs() / iNumGpus;
+	}
+	int iNumSlices = m_pVolSeries->m_aiStkSize[2];
+	if(m_iNumThreads > iNumSlices) m_iNumThreads = iNumSlices;
+	if(m_iNumThreads < 1) m_iNumThreads = 1;
+}
+
+void CDoCpuWbpRecon::mReconstruct(void)
+{
+	Util_Time aTimer;
+	aTimer.Measure();
+	//-----------------
+	m_aNextY.Create(m_pVolSeries->m_aiStkSize[2]);
+	CWbpThread* pThreads = new CWbpThread[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].Run(m_pTiltSeries, m_pVolSeries,
+		   m_pfCosSin, m_pbNoProjs, &m_aNextY);
+	}
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].WaitForExit(-1.0f);
+	}
+	delete[] pThreads;
+	//-----------------
+	float fSeconds = aTimer.GetElapsedSeconds();
+	double dVoxels = (double)m_pVolSeries->GetPixels()
+	   * m_pVolSeries->m_aiStkSize[2];
+	printf("CPU WBP: %d threads, %.2f sec, %.1f Mvoxels/s\n",
+	   m_iNumThreads, fSeconds, dVoxels * 1e-6 / fmax(fSeconds, 1e-6));
+}
+
+void CDoCpuWbpRecon::mClean(void)
+{
+	if(m_pfCosSin != 0L) delete[] m_pfCosSin;
+	if(m_pbNoProjs != 0L) delete[] m_pbNoProjs;
+	m_pfCosSin = 0L;
+	m_pbNoProjs = 0L;
+}
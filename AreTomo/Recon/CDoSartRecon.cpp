@@ -1,7 +1,9 @@
 #include "CReconInc.h"
 #include "../MrcUtil/CMrcUtilInc.h"
+#include <sys/sysinfo.h>
 #include <memory.h>
 #include <stdio.h>
+#include <math.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 
@@ -11,7 +13,12 @@ CDoSartRecon::CDoSartRecon(void)
 {
 	m_iNumIters = 1;
 	m_iNumSubsets = 1;
+	m_iCpuRecon = 0;
+	m_iNumThreads = 0;
 	m_pVolSeries = 0L;
+	m_pCpuThreads = 0L;
+	m_pfCosSin = 0L;
+	m_pbNoProjs = 0L;
 }
 
 CDoSartRecon::~CDoSartRecon(void)
@@ -23,6 +30,7 @@ void CDoSartRecon::Clean(void)
 {
 	CDoBaseRecon::Clean();
 	m_aTomoSart.Clean();
+	mCleanCpu();
 	if(m_pVolSeries != 0L) delete m_pVolSeries;
 	m_pVolSeries = 0L;
 }
@@ -49,6 +57,9 @@ MD::CTiltSeries* CDoSartRecon::DoIt
 	m_pVolSeries = new MD::CTiltSeries;
 	m_pVolSeries->Create(aiVolSize, aiVolSize[2]);
 	//-----------------
+	MD::CTraceSpan aSpan("CDoSartRecon::DoIt");
+	aSpan.AddBytes(m_pVolSeries->m_tFmBytes * aiVolSize[2]);
+	aSpan.AddItems(aiVolSize[2]);
 	mDoIt();
 	//-----------------
 	MD::CTiltSeries* pVolSeries = m_pVolSeries;
@@ -56,7 +67,19 @@ MD::CTiltSeries* CDoSartRecon::DoIt
 	return pVolSeries;		
 }
 
+//-------------------------------------------------------------------
+// 1. The CPU threads are started first and the GPU, if used, works
+//    on this thread. Both pull y-slices from m_aNextY.
+//-------------------------------------------------------------------
 void CDoSartRecon::mDoIt(void)
+{
+	m_aNextY.Create(m_pTiltSeries->m_aiStkSize[1]);
+	if(m_iCpuRecon != 0) mStartCpu();
+	if(m_iCpuRecon != 1) mGpuRecon();
+	if(m_iCpuRecon != 0) mWaitCpu();
+}
+
+void CDoSartRecon::mGpuRecon(void)
 {
 	int iPadX = (m_pTiltSeries->m_aiStkSize[0] / 2 + 1) * 2;
 	size_t tBytes = sizeof(float) * iPadX * m_pTiltSeries->m_aiStkSize[2];
@@ -78,8 +101,10 @@ void CDoSartRecon::mDoIt(void)
 	cudaEventCreate(&m_eventSino);
 	//-----------------
 	int iLastY = -1;
-	for(int iY=0; iY<m_pTiltSeries->m_aiStkSize[1]; iY++)
-	{	if(iY % 101 == 0)
+	while(true)
+	{	int iY = m_aNextY.GetNext();
+		if(iY < 0) break;
+		if(iY % 101 == 0)
 		{	int iLeft = m_pTiltSeries->m_aiStkSize[1] - 1 - iY;
 			printf("...... reconstruct slice %4d, "
 			   "%4d slices left\n", iY+1, iLeft);
@@ -144,3 +169,63 @@ void CDoSartRecon::mReconstruct(int iY)
 	   cudaMemcpyDefault, m_stream);
 }
 
+//-------------------------------------------------------------------
+// 1. The cosines and sines are computed as in CTomoBase.
+//-------------------------------------------------------------------
+void CDoSartRecon::mStartCpu(void)
+{
+	mCleanCpu();
+	int iNumProjs = m_pTiltSeries->m_aiStkSize[2];
+	m_pbNoProjs = new bool[iNumProjs];
+	memset(m_pbNoProjs, 0, sizeof(bool) * iNumProjs);
+	//-----------------
+	bool bCopy = true;
+	float fRad = 3.1415926f / 180.0f;
+	float* pfTilts = m_pAlignParam->GetTilts(!bCopy);
+	m_pfCosSin = new float[iNumProjs * 2];
+	for(int i=0; i<iNumProjs; i++)
+	{	float fAngle = fRad * pfTilts[i];
+		m_pfCosSin[2 * i] = (float)cos(fAngle);
+		m_pfCosSin[2 * i + 1] = (float)sin(fAngle);
+	}
+	//-----------------
+	if(m_iNumThreads <= 0)
+	{	CInput* pInput = CInput::GetInstance();
+		int iNumGpus = (pInput->m_iNumGpus > 0) ? pInput->m_iNumGpus : 1;
+		m_iNumThreads = get_nprocs() / iNumGpus;
+		if(m_iCpuRecon == 2) m_iNumThreads -= 1;
+	}
+	int iNumSlices = m_pVolSeries->m_aiStkSize[2];
+	if(m_iNumThreads > iNumSlices) m_iNumThreads = iNumSlices;
+	if(m_iNumThreads < 1) m_iNumThreads = 1;
+	//-----------------
+	int aiTiltRange[] = {m_iStartTilt, m_iNumTilts};
+	m_pCpuThreads = new CSartThread[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	m_pCpuThreads[i].Run(m_pTiltSeries, m_pVolSeries, m_pfCosSin,
+		   m_pbNoProjs, aiTiltRange, m_iNumIters, m_iNumSubsets,
+		   &m_aNextY);
+	}
+}
+
+void CDoSartRecon::mWaitCpu(void)
+{
+	int iCpuSlices = 0;
+	for(int i=0; i<m_iNumThreads; i++)
+	{	m_pCpuThreads[i].WaitForExit(-1.0f);
+		iCpuSlices += m_pCpuThreads[i].m_iNumSlices;
+	}
+	printf("CPU SART: %d threads reconstructed %d of %d slices\n",
+	   m_iNumThreads, iCpuSlices, m_pVolSeries->m_aiStkSize[2]);
+	mCleanCpu();
+}
+
+void CDoSartRecon::mCleanCpu(void)
+{
+	if(m_pCpuThreads != 0L) delete[] m_pCpuThreads;
+	if(m_pfCosSin != 0L) delete[] m_pfCosSin;
+	if(m_pbNoProjs != 0L) delete[] m_pbNoProjs;
+	m_pCpuThreads = 0L;
+	m_pfCosSin = 0L;
+	m_pbNoProjs = 0L;
+}
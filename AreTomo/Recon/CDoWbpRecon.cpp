@@ -39,6 +39,9 @@ MD::CTiltSeries* CDoWbpRecon::DoIt
 	m_pVolSeries = new MD::CTiltSeries;
 	m_pVolSeries->Create(aiVolSize);
 	//-----------------
+	MD::CTraceSpan aSpan("CDoWbpRecon::DoIt");
+	aSpan.AddBytes(m_pVolSeries->m_tFmBytes * aiVolSize[2]);
+	aSpan.AddItems(aiVolSize[2]);
 	mDoIt();
 	//-----------------
 	MD::CTiltSeries* pVolSeries = m_pVolSeries;
@@ -0,0 +1,132 @@
+#include "CReconInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CForProj::CForProj(void)
+{
+	m_iSlabZ = 0;
+	m_piSteps = 0L;
+	m_piCounts = 0L;
+	m_pfSums = 0L;
+}
+
+CForProj::~CForProj(void)
+{
+	this->Clean();
+}
+
+void CForProj::Clean(void)
+{
+	if(m_piSteps != 0L) delete[] m_piSteps;
+	if(m_piCounts != 0L) delete[] m_piCounts;
+	if(m_pfSums != 0L) delete[] m_pfSums;
+	m_piSteps = 0L;
+	m_piCounts = 0L;
+	m_pfSums = 0L;
+}
+
+//-------------------------------------------------------------------
+// 1. A slab of about 64K voxels, 256 KB, fits in L2 cache.
+//-------------------------------------------------------------------
+void CForProj::SetSize(int* piPadProjSize, int* piVolSize)
+{
+	this->Clean();
+	m_iPadProjX = piPadProjSize[0];
+	m_iProjX = (piPadProjSize[0] / 2 - 1) * 2;
+	m_aiVolSize[0] = piVolSize[0];
+	m_aiVolSize[1] = piVolSize[1];
+	//-----------------
+	m_iSlabZ = 65536 / m_aiVolSize[0];
+	if(m_iSlabZ < 8) m_iSlabZ = 8;
+	//-----------------
+	int iRays = m_iProjX * piPadProjSize[1];
+	m_piSteps = new int[iRays];
+	m_piCounts = new int[iRays];
+	m_pfSums = new float[iRays];
+}
+
+void CForProj::DoIt
+(	float* pfVolXZ,
+	float* pfCosSin,
+	int iNumProjs,
+	float* pfPadForProjs
+)
+{	int iRays = m_iProjX * iNumProjs;
+	memset(m_piSteps, 0, sizeof(int) * iRays);
+	memset(m_piCounts, 0, sizeof(int) * iRays);
+	memset(m_pfSums, 0, sizeof(float) * iRays);
+	//-----------------
+	for(int z=0; z<m_aiVolSize[1]; z+=m_iSlabZ)
+	{	int iEndZ = z + m_iSlabZ;
+		if(iEndZ > m_aiVolSize[1]) iEndZ = m_aiVolSize[1];
+		mProjectSlab(pfVolXZ, pfCosSin, iNumProjs, z, iEndZ);
+	}
+	//-----------------
+	for(int i=0; i<iNumProjs; i++)
+	{	int* piCounts = m_piCounts + i * m_iProjX;
+		float* pfSums = m_pfSums + i * m_iProjX;
+		float* pfForProj = pfPadForProjs + i * m_iPadProjX;
+		for(int x=0; x<m_iProjX; x++)
+		{	if(piCounts[x] == 0) pfForProj[x] = (float)-1e30;
+			else pfForProj[x] = pfSums[x] / piCounts[x];
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. The ray geometry is that of mGForProjs. The z of a ray grows
+//    with its step since |tilt| < 90, so a ray leaves the slab at
+//    the first step whose z reaches iEndZ. The last slab takes
+//    every remaining step.
+//-------------------------------------------------------------------
+void CForProj::mProjectSlab
+(	float* pfVolXZ,
+	float* pfCosSin,
+	int iNumProjs,
+	int iStartZ,
+	int iEndZ
+)
+{	int iEndX = m_aiVolSize[0] - 1;
+	int iLastZ = m_aiVolSize[1] - 1;
+	float fSlabEndZ = (iEndZ > iLastZ) ? 1e30f : (float)iEndZ;
+	//-----------------
+	for(int p=0; p<iNumProjs; p++)
+	{	float fCos = pfCosSin[2 * p];
+		float fSin = pfCosSin[2 * p + 1];
+		int iRayLength = (int)(m_aiVolSize[1] / fCos + 1.5f);
+		int* piSteps = m_piSteps + p * m_iProjX;
+		int* piCounts = m_piCounts + p * m_iProjX;
+		float* pfSums = m_pfSums + p * m_iProjX;
+		//----------------
+		for(int x=0; x<m_iProjX; x++)
+		{	float fXp = x + 0.5f - 0.5f * m_iProjX;
+			float fTempX = fXp * fCos + m_aiVolSize[0] * 0.5f;
+			float fTempZ = fXp * fSin + m_aiVolSize[1] * 0.5f;
+			float fZStartp = -fXp * fSin / fCos - 0.5f * iRayLength;
+			//---------------
+			int i = piSteps[x];
+			int iCount = piCounts[x];
+			float fInt = pfSums[x];
+			for(; i<iRayLength; i++)
+			{	float fZ = i + fZStartp;
+				float fX = fTempX - fZ * fSin;
+				fZ = fTempZ + fZ * fCos;
+				if(fZ >= fSlabEndZ) break;
+				if(fX < 0 || fZ < 0 || fX > iEndX || fZ > iLastZ)
+				{	continue;
+				}
+				//--------------
+				float fVal = pfVolXZ[m_aiVolSize[0] * (int)fZ + (int)fX];
+				if(fVal < (float)-1e10) continue;
+				fInt += fVal;
+				iCount += 1;
+			}
+			piSteps[x] = i;
+			piCounts[x] = iCount;
+			pfSums[x] = fInt;
+		}
+	}
+}
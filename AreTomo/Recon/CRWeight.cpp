@@ -0,0 +1,66 @@
+#include "CReconInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CRWeight::CRWeight(void)
+{
+	m_iPadProjX = 0;
+	m_iCmpSizeX = 0;
+	m_iNumProjs = 0;
+	m_pfFilter = 0L;
+}
+
+CRWeight::~CRWeight(void)
+{
+	this->Clean();
+}
+
+void CRWeight::Clean(void)
+{
+	if(m_pfFilter != 0L) delete[] m_pfFilter;
+	m_pfFilter = 0L;
+	m_aFFT1D.DestroyPlan();
+}
+
+//-------------------------------------------------------------------
+// 1. The filter is that of GRWeight, r-weighting with a cosine
+//    roll-off, where r is the frequency in [0, 0.5].
+//-------------------------------------------------------------------
+void CRWeight::SetSize(int iPadProjX, int iNumProjs)
+{
+	this->Clean();
+	int iFFTSize = (iPadProjX / 2 - 1) * 2;
+	m_iPadProjX = iPadProjX;
+	m_iCmpSizeX = iFFTSize / 2 + 1;
+	m_iNumProjs = iNumProjs;
+	m_aFFT1D.CreatePlan(iFFTSize);
+	//-----------------
+	float fN = 2 * (m_iCmpSizeX - 1.0f);
+	m_pfFilter = new float[m_iCmpSizeX];
+	for(int x=0; x<m_iCmpSizeX; x++)
+	{	float fR = x / fN;
+		m_pfFilter[x] = 2 * fR * (0.55f + 0.45f * cosf(6.2831852f * fR));
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Divide then multiply as GRWeight does so that both round
+//    the same way.
+//-------------------------------------------------------------------
+void CRWeight::DoIt(float* pfPadSinogram)
+{
+	float fN = 2 * (m_iCmpSizeX - 1.0f);
+	bool bNorm = true;
+	for(int i=0; i<m_iNumProjs; i++)
+	{	float* pfLine = pfPadSinogram + i * m_iPadProjX;
+		m_aFFT1D.Forward(pfLine, !bNorm);
+		//----------------
+		for(int x=0; x<m_iCmpSizeX * 2; x++)
+		{	pfLine[x] = pfLine[x] / fN * m_pfFilter[x / 2];
+		}
+		m_aFFT1D.Inverse((cufftComplex*)pfLine);
+	}
+}
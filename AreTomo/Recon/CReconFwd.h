@@ -7,11 +7,18 @@ namespace McAreTomo::AreTomo::Recon
 	class GDiffProj;     // Projsections are y-slice
 	class GCalcRFactor;  // Projections are y-slice
 	class GWeightProjs;
+	class CRWeight;
+	class CBackProj;
+	class CForProj;
 	class CTomoWbp;
 	class CTomoSart;
 	class CDoBaseRecon; 
 	class CDoWbpRecon;
+	class CWbpThread;
+	class CDoCpuWbpRecon;
+	class CSartThread;
 	class CDoSartRecon;
+	class CStreamRecon;
 }
 
 namespace MAR = McAreTomo::AreTomo::Recon;
@@ -116,6 +116,103 @@ public:
 private:
 };
 
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GRWeight. The projections of a padded
+//    y-slice sinogram are ramp filtered one at a time.
+//-------------------------------------------------------------------
+class CRWeight
+{
+public:
+	CRWeight(void);
+	~CRWeight(void);
+	void Clean(void);
+	void SetSize(int iPadProjX, int iNumProjs);
+	void DoIt(float* pfPadSinogram);
+private:
+	int m_iPadProjX;
+	int m_iCmpSizeX;
+	int m_iNumProjs;
+	float* m_pfFilter;
+	MU::CFFT1D m_aFFT1D;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GBackProj with the same arguments. Each
+//    volume line is accumulated one projection at a time over the
+//    range of x that projects inside the sinogram, which keeps
+//    the inner loop free of range tests.
+//-------------------------------------------------------------------
+class CBackProj
+{
+public:
+	CBackProj(void);
+	~CBackProj(void);
+	void Clean(void);
+	void SetSize
+	( int* piPadProjSize, // iPadProjX, iAllProjs
+	  int* piVolSize      // iVolX, iVolZ
+	);
+	void SetSubset(int iStartProj, int iEndProj);
+	void DoIt
+	( float* pfPadSinogram, // y-slice of all projections
+	  float* pfCosSin,
+	  bool* pbNoProjs,      // which projections are excluded
+	  bool bSart,
+	  float fRelax,
+	  float* pfVolXZ        // y-slice of volume
+	);
+private:
+	void mGetRangeX(float fCos, float fOffset, int* piRange);
+	int m_iProjX;
+	int m_iPadProjX;
+	int m_aiVolSize[2];
+	int m_iStartProj;
+	int m_iEndProj;
+	float* m_pfSum;
+	float* m_pfCount;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GForProj for an unpadded volume slice and
+//    padded projections. The rays of all projections are marched
+//    through one slab of volume rows before moving to the next, so
+//    that the slab stays in cache.
+// 2. Each ray resumes at its own step in the next slab. The samples
+//    are therefore summed in the same order as in GForProj.
+//-------------------------------------------------------------------
+class CForProj
+{
+public:
+	CForProj(void);
+	~CForProj(void);
+	void Clean(void);
+	void SetSize
+	( int* piPadProjSize, // iPadProjX, iAllProjs
+	  int* piVolSize      // iVolX, iVolZ
+	);
+	void DoIt
+	( float* pfVolXZ,
+	  float* pfCosSin,      // of the first projection to project
+	  int iNumProjs,
+	  float* pfPadForProjs  // of the first projection to project
+	);
+	int m_iSlabZ;
+private:
+	void mProjectSlab
+	( float* pfVolXZ,
+	  float* pfCosSin,
+	  int iNumProjs,
+	  int iStartZ,
+	  int iEndZ
+	);
+	int m_iProjX;
+	int m_iPadProjX;
+	int m_aiVolSize[2];
+	int* m_piSteps;
+	int* m_piCounts;
+	float* m_pfSums;
+};
+
 class CTomoBase
 {
 public:
@@ -253,6 +350,126 @@ private:
 	cudaEvent_t m_eventSino;
 };
 
+//-------------------------------------------------------------------
+// 1. Worker of CDoCpuWbpRecon. Each thread takes y-slices from the
+//    shared CNextItem and reconstructs them with its own sinogram,
+//    volume slice, CRWeight, and CBackProj.
+//-------------------------------------------------------------------
+class CWbpThread : public Util_Thread
+{
+public:
+	CWbpThread(void);
+	~CWbpThread(void);
+	void Run
+	( MD::CTiltSeries* pTiltSeries,
+	  MD::CTiltSeries* pVolSeries,
+	  float* pfCosSin,
+	  bool* pbNoProjs,
+	  MAU::CNextItem* pNextY
+	);
+	void ThreadMain(void);
+private:
+	void mExtractSinogram(int iY);
+	void mWeightSinogram(void);
+	void mGetReconResult(int iY);
+	void mClean(void);
+	//-----------------
+	MD::CTiltSeries* m_pTiltSeries;
+	MD::CTiltSeries* m_pVolSeries;
+	float* m_pfCosSin;
+	bool* m_pbNoProjs;
+	MAU::CNextItem* m_pNextY;
+	int m_iPadProjX;
+	float* m_pfPadSinogram;
+	float* m_pfVolXZ;
+	CRWeight m_aRWeight;
+	CBackProj m_aBackProj;
+};
+
+//-------------------------------------------------------------------
+// 1. WBP on CPU threads, producing the same volume as CDoWbpRecon.
+//    Selected with -CpuRecon 1.
+// 2. m_iNumThreads <= 0 lets DoIt split the CPU cores evenly among
+//    the GPU threads.
+//-------------------------------------------------------------------
+class CDoCpuWbpRecon
+{
+public:
+	CDoCpuWbpRecon(void);
+	~CDoCpuWbpRecon(void);
+	MD::CTiltSeries* DoIt
+	( MD::CTiltSeries* pTiltSeries,
+	  MAM::CAlignParam* pAlignParam,
+	  int iVolZ
+	);
+	int m_iNumThreads;
+private:
+	void mSetup(void);
+	void mReconstruct(void);
+	void mClean(void);
+	//-----------------
+	MD::CTiltSeries* m_pTiltSeries;
+	MD::CTiltSeries* m_pVolSeries;
+	MAM::CAlignParam* m_pAlignParam;
+	float* m_pfCosSin;
+	bool* m_pbNoProjs;
+	MAU::CNextItem m_aNextY;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU worker of CDoSartRecon. It takes y-slices from the queue
+//    shared with the GPU and runs the subset loop of CTomoSart::DoIt
+//    with CForProj and CBackProj.
+//-------------------------------------------------------------------
+class CSartThread : public Util_Thread
+{
+public:
+	CSartThread(void);
+	~CSartThread(void);
+	void Run
+	( MD::CTiltSeries* pTiltSeries,
+	  MD::CTiltSeries* pVolSeries,
+	  float* pfCosSin,
+	  bool* pbNoProjs,
+	  int* piTiltRange,   // start and num tilts
+	  int iNumIters,
+	  int iNumSubsets,
+	  MAU::CNextItem* pNextY
+	);
+	void ThreadMain(void);
+	int m_iNumSlices;
+private:
+	void mExtractSinogram(int iY);
+	void mWeightSinogram(void);
+	void mReconstruct(void);
+	void mDiffProj(int iStartProj, int iNumProjs);
+	void mGetReconResult(int iY);
+	void mClean(void);
+	//-----------------
+	MD::CTiltSeries* m_pTiltSeries;
+	MD::CTiltSeries* m_pVolSeries;
+	float* m_pfCosSin;
+	bool* m_pbNoProjs;
+	MAU::CNextItem* m_pNextY;
+	int m_aiTiltRange[2];
+	int m_iNumIters;
+	int m_iNumSubsets;
+	int m_iPadProjX;
+	float* m_pfPadSinogram;
+	float* m_pfPadForProjs;
+	float* m_pfVolXZ;
+	CForProj m_aForProj;
+	CBackProj m_aBackProj;
+};
+
+//-------------------------------------------------------------------
+// 1. m_iCpuRecon selects where the y-slices are reconstructed:
+//    0 on the GPU, 1 on CPU threads, 2 on both. In the last case
+//    the GPU and the CPU threads take slices from the same queue.
+// 2. m_iNumThreads <= 0 lets DoIt split the CPU cores evenly among
+//    the GPU threads, less one core feeding the GPU when both are
+//    used.
+//-------------------------------------------------------------------
 class CDoSartRecon : public CDoBaseRecon
 {
 public:
@@ -268,11 +485,17 @@ public:
 	  int iIterations,
 	  int iNumSubsets
 	);
+	int m_iCpuRecon;
+	int m_iNumThreads;
 private:
 	void mDoIt(void);
+	void mGpuRecon(void);
 	void mExtractSinogram(int iY);
 	void mGetReconResult(int iLastY);
 	void mReconstruct(int iY);
+	void mStartCpu(void);
+	void mWaitCpu(void);
+	void mCleanCpu(void);
 	//-----------------
 	int m_iStartTilt;
 	int m_iNumTilts;
@@ -280,10 +503,58 @@ private:
 	int m_iNumSubsets;
 	//-----------------
 	CTomoSart m_aTomoSart;
+	MAU::CNextItem m_aNextY;
+	CSartThread* m_pCpuThreads;
+	float* m_pfCosSin;
+	bool* m_pbNoProjs;
 	cudaStream_t m_stream;
 	cudaEvent_t m_eventSino;
 };
 
+//-------------------------------------------------------------------
+// 1. Reconstructs the volume in y-slabs and writes each slab into
+//    the MRC file with MD::CSaveMrcSlabs before reconstructing the
+//    next one, so that the whole volume is never in memory.
+// 2. m_fSlabMem in GB bounds a slab: its rows of the tilt series,
+//    its xz slices, and the staging buffer of the transpose.
+// 3. Each slab is reconstructed by CDoWbpRecon, CDoCpuWbpRecon, or
+//    CDoSartRecon as selected by m_iCpuRecon and SetSart. Since the
+//    y-slices are independent, the volume is the same as the one
+//    reconstructed at once.
+//-------------------------------------------------------------------
+class CStreamRecon
+{
+public:
+	CStreamRecon(void);
+	~CStreamRecon(void);
+	void SetSart
+	( int iStartTilt,
+	  int iNumTilts,
+	  int iIterations,
+	  int iNumSubsets
+	);
+	bool DoIt
+	( MD::CTiltSeries* pTiltSeries,
+	  MAM::CAlignParam* pAlignParam,
+	  int iVolZ,
+	  const char* pcMrcFile
+	);
+	int m_iCpuRecon;
+	int m_iFlipVol;
+	float m_fSlabMem;
+private:
+	int mCalcSlabRows(MD::CSaveMrcSlabs* pSaveSlabs);
+	MD::CTiltSeries* mReconSlab(MD::CTiltSeries* pSlabSeries);
+	//-----------------
+	MD::CTiltSeries* m_pTiltSeries;
+	MAM::CAlignParam* m_pAlignParam;
+	int m_iVolZ;
+	bool m_bSart;
+	int m_aiTiltRange[2]; // start and num tilts
+	int m_iNumIters;
+	int m_iNumSubsets;
+};
+
 class CCalcVolThick
 {
 public:
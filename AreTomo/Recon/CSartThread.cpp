@@ -0,0 +1,172 @@
+#include "CReconInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CSartThread::CSartThread(void)
+{
+	m_iNumSlices = 0;
+	m_pfPadSinogram = 0L;
+	m_pfPadForProjs = 0L;
+	m_pfVolXZ = 0L;
+}
+
+CSartThread::~CSartThread(void)
+{
+	mClean();
+}
+
+void CSartThread::Run
+(	MD::CTiltSeries* pTiltSeries,
+	MD::CTiltSeries* pVolSeries,
+	float* pfCosSin,
+	bool* pbNoProjs,
+	int* piTiltRange,
+	int iNumIters,
+	int iNumSubsets,
+	MAU::CNextItem* pNextY
+)
+{	mClean();
+	m_pTiltSeries = pTiltSeries;
+	m_pVolSeries = pVolSeries;
+	m_pfCosSin = pfCosSin;
+	m_pbNoProjs = pbNoProjs;
+	m_aiTiltRange[0] = piTiltRange[0];
+	m_aiTiltRange[1] = piTiltRange[1];
+	m_iNumIters = iNumIters;
+	m_iNumSubsets = iNumSubsets;
+	m_pNextY = pNextY;
+	m_iNumSlices = 0;
+	//-----------------
+	int iNumProjs = m_pTiltSeries->m_aiStkSize[2];
+	m_iPadProjX = (m_pTiltSeries->m_aiStkSize[0] / 2 + 1) * 2;
+	int iPadPixels = m_iPadProjX * iNumProjs;
+	m_pfPadSinogram = new float[iPadPixels];
+	m_pfPadForProjs = new float[iPadPixels];
+	m_pfVolXZ = new float[m_pVolSeries->GetPixels()];
+	//-----------------
+	int aiPadProjSize[] = {m_iPadProjX, iNumProjs};
+	m_aForProj.SetSize(aiPadProjSize, m_pVolSeries->m_aiStkSize);
+	m_aBackProj.SetSize(aiPadProjSize, m_pVolSeries->m_aiStkSize);
+	this->Start();
+}
+
+void CSartThread::ThreadMain(void)
+{
+	while(true)
+	{	int iY = m_pNextY->GetNext();
+		if(iY < 0) break;
+		//----------------
+		mExtractSinogram(iY);
+		mWeightSinogram();
+		mReconstruct();
+		mGetReconResult(iY);
+		m_iNumSlices += 1;
+	}
+}
+
+void CSartThread::mExtractSinogram(int iY)
+{
+	int iProjX = m_pTiltSeries->m_aiStkSize[0];
+	size_t tBytes = sizeof(float) * iProjX;
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	float* pfProj = (float*)m_pTiltSeries->GetFrame(i);
+		float* pfSrc = pfProj + (size_t)iY * iProjX;
+		float* pfDst = m_pfPadSinogram + i * m_iPadProjX;
+		memcpy(pfDst, pfSrc, tBytes);
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same as GWeightProjs on the padded sinogram.
+//-------------------------------------------------------------------
+void CSartThread::mWeightSinogram(void)
+{
+	int iProjX = (m_iPadProjX / 2 - 1) * 2;
+	int iVolZ = m_pVolSeries->m_aiStkSize[1];
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	float* pfLine = m_pfPadSinogram + i * m_iPadProjX;
+		float fW = m_pfCosSin[2 * i] / iVolZ;
+		for(int x=0; x<iProjX; x++) pfLine[x] *= fW;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same subsets and relaxation as CTomoSart::DoIt.
+//-------------------------------------------------------------------
+void CSartThread::mReconstruct(void)
+{
+	memset(m_pfVolXZ, 0, m_pVolSeries->GetPixels() * sizeof(float));
+	int iNumProjs = m_pTiltSeries->m_aiStkSize[2];
+	bool bSart = true;
+	float fRelax = 1.0f;
+	m_aBackProj.SetSubset(0, iNumProjs);
+	m_aBackProj.DoIt(m_pfPadSinogram, m_pfCosSin, m_pbNoProjs,
+	   bSart, fRelax, m_pfVolXZ);
+	//-----------------
+	MAU::CSplitItems splitItems;
+	splitItems.Create(m_aiTiltRange[1], m_iNumSubsets);
+	fRelax = 1.0f / m_iNumSubsets;
+	if(fRelax < 0.1f) fRelax = 0.1f;
+	//-----------------
+	for(int iIter=0; iIter<m_iNumIters; iIter++)
+	{	for(int i=0; i<m_iNumSubsets; i++)
+		{	int iStartProj = splitItems.GetStart(i);
+			int iNumProjs = splitItems.GetSize(i);
+			iStartProj += m_aiTiltRange[0];
+			int iEndProj = iStartProj + iNumProjs;
+			//---------------
+			m_aForProj.DoIt(m_pfVolXZ, m_pfCosSin + iStartProj * 2,
+			   iNumProjs, m_pfPadForProjs + iStartProj * m_iPadProjX);
+			mDiffProj(iStartProj, iNumProjs);
+			m_aBackProj.SetSubset(iStartProj, iEndProj);
+			m_aBackProj.DoIt(m_pfPadForProjs, m_pfCosSin,
+			   m_pbNoProjs, bSart, fRelax, m_pfVolXZ);
+		}
+		fRelax *= 0.8f;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same as GDiffProj, written without branches so that it
+//    vectorizes.
+//-------------------------------------------------------------------
+void CSartThread::mDiffProj(int iStartProj, int iNumProjs)
+{
+	int iProjX = (m_iPadProjX / 2 - 1) * 2;
+	for(int i=iStartProj; i<iStartProj+iNumProjs; i++)
+	{	float* pfRaw = m_pfPadSinogram + i * m_iPadProjX;
+		float* pfFor = m_pfPadForProjs + i * m_iPadProjX;
+		for(int x=0; x<iProjX; x++)
+		{	bool bSkip = pfFor[x] < (float)-1e10
+			   || pfRaw[x] < (float)-1e10;
+			pfFor[x] = bSkip ? (float)-1e30 : pfRaw[x] - pfFor[x];
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Flip z to match IMOD handedness as CDoSartRecon does.
+//-------------------------------------------------------------------
+void CSartThread::mGetReconResult(int iY)
+{
+	float* pfVolXZ = (float*)m_pVolSeries->GetFrame(iY);
+	int iVolX = m_pVolSeries->m_aiStkSize[0];
+	int iLastZ = m_pVolSeries->m_aiStkSize[1] - 1;
+	for(int z=0; z<=iLastZ; z++)
+	{	float* pfSrc = m_pfVolXZ + z * iVolX;
+		float* pfDst = pfVolXZ + (iLastZ - z) * iVolX;
+		memcpy(pfDst, pfSrc, iVolX * sizeof(float));
+	}
+}
+
+void CSartThread::mClean(void)
+{
+	if(m_pfPadSinogram != 0L) delete[] m_pfPadSinogram;
+	if(m_pfPadForProjs != 0L) delete[] m_pfPadForProjs;
+	if(m_pfVolXZ != 0L) delete[] m_pfVolXZ;
+	m_pfPadSinogram = 0L;
+	m_pfPadForProjs = 0L;
+	m_pfVolXZ = 0L;
+}
@@ -0,0 +1,134 @@
+#include "CReconInc.h"
+#include "../MrcUtil/CMrcUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CStreamRecon::CStreamRecon(void)
+{
+	m_iCpuRecon = 0;
+	m_iFlipVol = 0;
+	m_fSlabMem = 0.0f;
+	m_bSart = false;
+	m_iNumIters = 1;
+	m_iNumSubsets = 1;
+	memset(m_aiTiltRange, 0, sizeof(m_aiTiltRange));
+}
+
+CStreamRecon::~CStreamRecon(void)
+{
+}
+
+void CStreamRecon::SetSart
+(	int iStartTilt,
+	int iNumTilts,
+	int iIterations,
+	int iNumSubsets
+)
+{	m_bSart = true;
+	m_aiTiltRange[0] = iStartTilt;
+	m_aiTiltRange[1] = iNumTilts;
+	m_iNumIters = iIterations;
+	m_iNumSubsets = iNumSubsets;
+}
+
+bool CStreamRecon::DoIt
+(	MD::CTiltSeries* pTiltSeries,
+	MAM::CAlignParam* pAlignParam,
+	int iVolZ,
+	const char* pcMrcFile
+)
+{	m_pTiltSeries = pTiltSeries;
+	m_pAlignParam = pAlignParam;
+	m_iVolZ = iVolZ;
+	//-----------------
+	int iSizeY = pTiltSeries->m_aiStkSize[1];
+	int aiVolSize[3] = {1, iVolZ, iSizeY};
+	aiVolSize[0] = pTiltSeries->m_aiStkSize[0] / 2 * 2;
+	MD::CSaveMrcSlabs aSaveSlabs;
+	if(!aSaveSlabs.Open(pcMrcFile, aiVolSize, m_iFlipVol,
+	   pTiltSeries->m_fPixSize)) return false;
+	//-----------------
+	int iRows = mCalcSlabRows(&aSaveSlabs);
+	int aiStart[3] = {0, 0, 0};
+	int aiSize[3] = {pTiltSeries->m_aiStkSize[0], iRows,
+	   pTiltSeries->m_aiStkSize[2]};
+	bool bSaved = true;
+	for(int y=0; y<iSizeY; y+=iRows)
+	{	aiStart[1] = y;
+		aiSize[1] = (iSizeY - y < iRows) ? (iSizeY - y) : iRows;
+		printf("...... slab at y %5d, %5d y-slices\n", y, aiSize[1]);
+		MD::CTraceSpan aSpan("CStreamRecon::Slab");
+		aSpan.AddItems(aiSize[1]);
+		//----------------
+		MD::CTiltSeries* pSlabSeries =
+		   pTiltSeries->GetSubSeries(aiStart, aiSize);
+		MD::CTiltSeries* pSlab = mReconSlab(pSlabSeries);
+		delete pSlabSeries;
+		//----------------
+		MD::CTraceSpan* pSaveSpan = new MD::CTraceSpan(
+		   "CSaveMrcSlabs::DoIt");
+		pSaveSpan->AddBytes(pSlab->m_tFmBytes * pSlab->m_aiStkSize[2]);
+		bSaved = aSaveSlabs.DoIt(pSlab, y);
+		delete pSaveSpan;
+		delete pSlab;
+		if(!bSaved) break;
+	}
+	if(!aSaveSlabs.Close()) bSaved = false;
+	return bSaved;
+}
+
+//-------------------------------------------------------------------
+// 1. A y-slice costs its row of every projection, its xz slice,
+//    and, when the volume is saved in xyz, its share of the
+//    staging buffer.
+//-------------------------------------------------------------------
+int CStreamRecon::mCalcSlabRows(MD::CSaveMrcSlabs* pSaveSlabs)
+{
+	int* piStkSize = m_pTiltSeries->m_aiStkSize;
+	size_t tRowBytes = sizeof(float) * piStkSize[0]
+	   * ((size_t)piStkSize[2] + m_iVolZ);
+	tRowBytes += pSaveSlabs->GetStageBytes(1);
+	//-----------------
+	double dBudget = m_fSlabMem * 1024.0 * 1024.0 * 1024.0;
+	int iRows = (int)(dBudget / tRowBytes);
+	if(iRows < 1)
+	{	printf("Warning: -SlabMem %.2f GB is less than one y-slice,"
+		   " %.2f MB.\n", m_fSlabMem, tRowBytes / (1024.0 * 1024.0));
+		iRows = 1;
+	}
+	if(iRows > piStkSize[1]) iRows = piStkSize[1];
+	//-----------------
+	int iNumSlabs = (piStkSize[1] + iRows - 1) / iRows;
+	printf("Slab reconstruction: %d slabs of %d y-slices, "
+	   "%.2f GB per slab\n", iNumSlabs, iRows,
+	   iRows * tRowBytes / (1024.0 * 1024.0 * 1024.0));
+	return iRows;
+}
+
+//-------------------------------------------------------------------
+// 1. A new reconstructor per slab since their DoIt allocate their
+//    buffers for the given tilt series.
+//-------------------------------------------------------------------
+MD::CTiltSeries* CStreamRecon::mReconSlab(MD::CTiltSeries* pSlabSeries)
+{
+	MD::CTiltSeries* pSlab = 0L;
+	if(m_bSart)
+	{	CDoSartRecon aDoSartRecon;
+		aDoSartRecon.m_iCpuRecon = m_iCpuRecon;
+		pSlab = aDoSartRecon.DoIt(pSlabSeries, m_pAlignParam,
+		   m_aiTiltRange[0], m_aiTiltRange[1], m_iVolZ,
+		   m_iNumIters, m_iNumSubsets);
+	}
+	else if(m_iCpuRecon == 1)
+	{	CDoCpuWbpRecon aDoCpuWbpRecon;
+		pSlab = aDoCpuWbpRecon.DoIt(pSlabSeries,
+		   m_pAlignParam, m_iVolZ);
+	}
+	else
+	{	CDoWbpRecon aDoWbpRecon;
+		pSlab = aDoWbpRecon.DoIt(pSlabSeries, m_pAlignParam, m_iVolZ);
+	}
+	return pSlab;
+}
@@ -0,0 +1,109 @@
+#include "CReconInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::AreTomo::Recon;
+
+CWbpThread::CWbpThread(void)
+{
+	m_pfPadSinogram = 0L;
+	m_pfVolXZ = 0L;
+}
+
+CWbpThread::~CWbpThread(void)
+{
+	mClean();
+}
+
+void CWbpThread::Run
+(	MD::CTiltSeries* pTiltSeries,
+	MD::CTiltSeries* pVolSeries,
+	float* pfCosSin,
+	bool* pbNoProjs,
+	MAU::CNextItem* pNextY
+)
+{	mClean();
+	m_pTiltSeries = pTiltSeries;
+	m_pVolSeries = pVolSeries;
+	m_pfCosSin = pfCosSin;
+	m_pbNoProjs = pbNoProjs;
+	m_pNextY = pNextY;
+	//-----------------
+	int iNumProjs = m_pTiltSeries->m_aiStkSize[2];
+	m_iPadProjX = (m_pTiltSeries->m_aiStkSize[0] / 2 + 1) * 2;
+	m_pfPadSinogram = new float[m_iPadProjX * iNumProjs];
+	m_pfVolXZ = new float[m_pVolSeries->GetPixels()];
+	//-----------------
+	int aiPadProjSize[] = {m_iPadProjX, iNumProjs};
+	m_aRWeight.SetSize(m_iPadProjX, iNumProjs);
+	m_aBackProj.SetSize(aiPadProjSize, m_pVolSeries->m_aiStkSize);
+	this->Start();
+}
+
+void CWbpThread::ThreadMain(void)
+{
+	size_t tBytes = m_pVolSeries->GetPixels() * sizeof(float);
+	bool bSart = true;
+	while(true)
+	{	int iY = m_pNextY->GetNext();
+		if(iY < 0) break;
+		//----------------
+		mExtractSinogram(iY);
+		mWeightSinogram();
+		m_aRWeight.DoIt(m_pfPadSinogram);
+		//----------------
+		memset(m_pfVolXZ, 0, tBytes);
+		m_aBackProj.DoIt(m_pfPadSinogram, m_pfCosSin, m_pbNoProjs,
+		   !bSart, 1.0f, m_pfVolXZ);
+		mGetReconResult(iY);
+	}
+}
+
+void CWbpThread::mExtractSinogram(int iY)
+{
+	int iProjX = m_pTiltSeries->m_aiStkSize[0];
+	size_t tBytes = sizeof(float) * iProjX;
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	float* pfProj = (float*)m_pTiltSeries->GetFrame(i);
+		float* pfSrc = pfProj + (size_t)iY * iProjX;
+		float* pfDst = m_pfPadSinogram + i * m_iPadProjX;
+		memcpy(pfDst, pfSrc, tBytes);
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same as GWeightProjs.
+//-------------------------------------------------------------------
+void CWbpThread::mWeightSinogram(void)
+{
+	int iProjX = m_pTiltSeries->m_aiStkSize[0];
+	int iVolZ = m_pVolSeries->m_aiStkSize[1];
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	float* pfLine = m_pfPadSinogram + i * m_iPadProjX;
+		float fW = m_pfCosSin[2 * i] / iVolZ;
+		for(int x=0; x<iProjX; x++) pfLine[x] *= fW;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Flip z to match IMOD handedness as CDoWbpRecon does.
+//-------------------------------------------------------------------
+void CWbpThread::mGetReconResult(int iY)
+{
+	float* pfVolXZ = (float*)m_pVolSeries->GetFrame(iY);
+	int iVolX = m_pVolSeries->m_aiStkSize[0];
+	int iLastZ = m_pVolSeries->m_aiStkSize[1] - 1;
+	for(int z=0; z<=iLastZ; z++)
+	{	float* pfSrc = m_pfVolXZ + z * iVolX;
+		float* pfDst = pfVolXZ + (iLastZ - z) * iVolX;
+		memcpy(pfDst, pfSrc, iVolX * sizeof(float));
+	}
+}
+
+void CWbpThread::mClean(void)
+{
+	if(m_pfPadSinogram != 0L) delete[] m_pfPadSinogram;
+	if(m_pfVolXZ != 0L) delete[] m_pfVolXZ;
+	m_pfPadSinogram = 0L;
+	m_pfVolXZ = 0L;
+}
@@ -207,6 +207,7 @@ public:
 	  float* gfOutImg,
 	  cudaStream_t stream = 0
 	);
+	int m_aiInSize[2];
 	int m_aiOutSize[2];
 	int m_iOutImgX;
 	int m_aiBinning[2];
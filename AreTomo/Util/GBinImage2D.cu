@@ -6,25 +6,28 @@
 
 using namespace McAreTomo::AreTomo::Util;
 
-static __device__ __constant__ int giInSize[2];
-static __device__ __constant__ int giOutSize[2];
-
+//-------------------------------------------------------------------
+// 1. The sizes are kernel arguments, not __constant__ symbols, so
+//    that concurrent patch workers can bin by different factors.
+//-------------------------------------------------------------------
 static __global__ void mGBinImage
 (	float* gfInImg,
+	int2 aiInSize,
+	int2 aiOutSize,
 	int iBinX,
 	int iBinY,
 	float* gfOutImg
 )
 {	int y =  blockIdx.y * blockDim.y + threadIdx.y;
-	if(y >= giOutSize[1]) return;
-	int i = y * giOutSize[0] + blockIdx.x;
+	if(y >= aiOutSize.y) return;
+	int i = y * aiOutSize.x + blockIdx.x;
 	gfOutImg[i] = (float)-1e30;
 	//-------------------------
 	int x =  blockIdx.x * iBinX;
 	y = y * iBinY;
 	float fSum = 0.0f;
 	for(int iy=0; iy<iBinY; iy++)
-	{	float* pfPtr = gfInImg + (y + iy) * giInSize[0];
+	{	float* pfPtr = gfInImg + (y + iy) * aiInSize.x;
 		for(int ix=0; ix<iBinX; ix++)
 		{	float fVal = pfPtr[x + ix];
 			if(fVal < (float)-1e10) return;
@@ -72,12 +75,11 @@ void GBinImage2D::SetupBinnings
 	int* piBinning,
 	bool bOutPadded
 )
-{	cudaMemcpyToSymbol(giInSize, piInSize, sizeof(giInSize));
+{	memcpy(m_aiInSize, piInSize, sizeof(m_aiInSize));
 	memcpy(m_aiBinning, piBinning, sizeof(m_aiBinning));
 	//--------------------------------------------------
 	GBinImage2D::GetBinSize(piInSize, bInPadded, piBinning, 
 		m_aiOutSize, bOutPadded);
-	cudaMemcpyToSymbol(giOutSize, m_aiOutSize, sizeof(giOutSize));
 	//------------------------------------------------------------
 	m_iOutImgX = m_aiOutSize[0];
 	if(bOutPadded) m_iOutImgX = (m_aiOutSize[0] / 2 - 1) * 2;
@@ -98,8 +100,7 @@ void GBinImage2D::SetupSizes
 	int* piOutSize, bool bOutPadded
 )
 {	int iBytes = sizeof(int) * 2;
-	cudaMemcpyToSymbol(giInSize, piInSize, iBytes);
-	cudaMemcpyToSymbol(giOutSize, piOutSize, iBytes);
+	memcpy(m_aiInSize, piInSize, iBytes);
 	memcpy(m_aiOutSize, piOutSize, iBytes);
 	//-------------------------------------
 	int iInImgX = piInSize[0];
@@ -120,6 +121,9 @@ void GBinImage2D::DoIt
 	dim3 aGridDim(m_iOutImgX, 1);
 	aGridDim.y = (m_aiOutSize[1] + aBlockDim.y - 1) / aBlockDim.y;
 	//----------------------------------------------------------
+	int2 aiInSize = make_int2(m_aiInSize[0], m_aiInSize[1]);
+	int2 aiOutSize = make_int2(m_aiOutSize[0], m_aiOutSize[1]);
 	mGBinImage<<<aGridDim, aBlockDim, 0, stream>>>(gfInImg, 
-	   m_aiBinning[0], m_aiBinning[1], gfOutImg);
+	   aiInSize, aiOutSize, m_aiBinning[0], m_aiBinning[1],
+	   gfOutImg);
 }
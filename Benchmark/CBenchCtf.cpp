@@ -0,0 +1,323 @@
+#include "CBenchInc.h"
+#include "../AreTomo/FindCtf/CFindCtfInc.h"
+#include <Util/Util_Time.h>
+#include <cuda_runtime.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+namespace MAF = McAreTomo::AreTomo::FindCtf;
+
+static const int s_iGridSteps = 51;
+static const int s_aiGrid1D[] = {501, 9}; // defocus, phase
+static const float s_fDfMean = 20000.0f;  // angstrom
+static const float s_fAstRatio = 0.03f;
+static const float s_fAstAngle = 30.0f;   // degree
+
+CBenchCtf::CBenchCtf(void)
+{
+	m_pfSpect = 0L;
+	m_gfSpect = 0L;
+	m_pfCands = 0L;
+	m_iNumCands = 0;
+	m_pCtfParam = 0L;
+}
+
+CBenchCtf::~CBenchCtf(void)
+{
+	if(m_pfSpect != 0L) delete[] m_pfSpect;
+	if(m_gfSpect != 0L) cudaFree(m_gfSpect);
+	if(m_pfCands != 0L) delete[] m_pfCands;
+	if(m_pCtfParam != 0L) delete m_pCtfParam;
+	MU::SetBackend(MU::gpuBackend);
+}
+
+//-------------------------------------------------------------------
+// 1. Scores the 51 x 51 astigmatism grid of CFindDefocus2D one
+//    candidate at a time with GCalcCTF2D and GCC2D, then in one
+//    batch on GPU and on -Threads host threads.
+// 2. Then the same for the defocus x phase grid of CFindDefocus1D
+//    on the radial average, see mDo1D.
+//-------------------------------------------------------------------
+bool CBenchCtf::DoIt(void)
+{
+	cudaSetDevice(0);
+	mGenSpect();
+	mGenCands();
+	//-----------------
+	float* pfScores = new float[m_iNumCands * 3];
+	float fSeconds = mScoreEach(pfScores);
+	mReport("GPU each", fSeconds);
+	fSeconds = mScoreBatch(false, pfScores + m_iNumCands);
+	mReport("GPU batch", fSeconds);
+	fSeconds = mScoreBatch(true, pfScores + m_iNumCands * 2);
+	mReport("Host batch", fSeconds);
+	//-----------------
+	bool bSuccess = mCompare(pfScores, pfScores + m_iNumCands, "GPU");
+	bSuccess = mCompare(pfScores, pfScores + m_iNumCands * 2, "Host")
+	   && bSuccess;
+	delete[] pfScores;
+	printf("\n");
+	//-----------------
+	bSuccess = mDo1D() && bSuccess;
+	printf("\n");
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. A half spectrum of -CamSize x -CamSize / 2 + 1 with the CTF^2
+//    of known defocus and astigmatism, minus 0.5, plus noise. The
+//    DC is at y = iCmpY / 2 as in CFindCtfBase.
+//-------------------------------------------------------------------
+void CBenchCtf::mGenSpect(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iSize = pBenchInput->m_aiCamSize[0] / 2 * 2;
+	if(iSize > 1024) iSize = 1024;
+	m_aiCmpSize[0] = iSize / 2 + 1;
+	m_aiCmpSize[1] = iSize;
+	//-----------------
+	m_pCtfParam = new MD::CCtfParam;
+	m_pCtfParam->Setup(300, 2.7f, 0.07f, 1.0f);
+	float fW = m_pCtfParam->m_fWavelength;
+	float fCs = m_pCtfParam->m_fCs;
+	float fDfMin = s_fDfMean * (1.0f - s_fAstRatio);
+	float fDfMax = s_fDfMean * (1.0f + s_fAstRatio);
+	float fAzimuth = s_fAstAngle * 0.01745329f;
+	float fAmpPhase = atanf(0.07f / sqrtf(1.0f - 0.07f * 0.07f));
+	//-----------------
+	int iPixels = m_aiCmpSize[0] * m_aiCmpSize[1];
+	m_pfSpect = new float[iPixels];
+	unsigned int uiSeed = 29;
+	for(int y=0; y<m_aiCmpSize[1]; y++)
+	{	float fY = (y - m_aiCmpSize[1] / 2) / (float)m_aiCmpSize[1];
+		for(int x=0; x<m_aiCmpSize[0]; x++)
+		{	float fX = x * 0.5f / (m_aiCmpSize[0] - 1);
+			float fS2 = fX * fX + fY * fY;
+			float fDf = 0.5f * (fDfMin + fDfMax) + 0.5f * (fDfMax
+			   - fDfMin) * cosf(2.0f * (atanf(fY / (fX + 1e-30f))
+			   - fAzimuth));
+			float fC = sinf(fAmpPhase + 3.1415926f * fW * fS2
+			   * (fDf - 0.5f * fW * fW * fS2 * fCs));
+			m_pfSpect[y * m_aiCmpSize[0] + x] = fC * fC - 0.5f
+			   + (rand_r(&uiSeed) / (float)RAND_MAX - 0.5f);
+		}
+	}
+	cudaMalloc(&m_gfSpect, sizeof(float) * iPixels);
+	cudaMemcpy(m_gfSpect, m_pfSpect, sizeof(float) * iPixels,
+	   cudaMemcpyDefault);
+	//-----------------
+	float fRes1 = m_aiCmpSize[1] * m_pCtfParam->m_fPixelSize;
+	m_afFreqRange[0] = fRes1 / 15.0f;
+	m_afFreqRange[1] = fRes1 / 3.5f;
+	printf("Ctf: %d x %d half spectrum, %d x %d candidates\n\n",
+	   m_aiCmpSize[0], m_aiCmpSize[1], s_iGridSteps, s_iGridSteps);
+}
+
+//-------------------------------------------------------------------
+// 1. Same grid as CFindDefocus2D::mFindAstig: astigmatism in
+//    [0, 0.06) and angle in [-90, 90) degree at the true defocus.
+//-------------------------------------------------------------------
+void CBenchCtf::mGenCands(void)
+{
+	m_iNumCands = s_iGridSteps * s_iGridSteps;
+	m_pfCands = new float[m_iNumCands * 4];
+	float fPixSize = m_pCtfParam->m_fPixelSize;
+	for(int j=0; j<s_iGridSteps; j++)
+	{	float fAng = -90.0f + j * 180.0f / s_iGridSteps;
+		for(int i=0; i<s_iGridSteps; i++)
+		{	float fAst = i * 0.06f / s_iGridSteps;
+			float* pfCand = m_pfCands + (j * s_iGridSteps + i) * 4;
+			pfCand[0] = s_fDfMean * (1.0f - fAst) / fPixSize;
+			pfCand[1] = s_fDfMean * (1.0f + fAst) / fPixSize;
+			pfCand[2] = fAng * 0.01745329f;
+			pfCand[3] = 0.0f;
+		}
+	}
+}
+
+float CBenchCtf::mScoreEach(float* pfScores)
+{
+	MAF::GCalcCTF2D aGCalcCtf2D;
+	aGCalcCtf2D.SetParam(m_pCtfParam);
+	MAF::GCC2D aGCC2D;
+	aGCC2D.SetSize(m_aiCmpSize);
+	aGCC2D.Setup(m_afFreqRange[0], m_afFreqRange[1], 100.0f);
+	float* gfCtf2D = 0L;
+	cudaMalloc(&gfCtf2D, sizeof(float) * m_aiCmpSize[0]
+	   * m_aiCmpSize[1]);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	for(int i=0; i<m_iNumCands; i++)
+	{	float* pfCand = m_pfCands + i * 4;
+		aGCalcCtf2D.DoIt(pfCand[0], pfCand[1], pfCand[2], pfCand[3],
+		   gfCtf2D, m_aiCmpSize);
+		pfScores[i] = aGCC2D.DoIt(gfCtf2D, m_gfSpect);
+	}
+	float fSeconds = aTimer.GetElapsedSeconds();
+	cudaFree(gfCtf2D);
+	return fSeconds;
+}
+
+float CBenchCtf::mScoreBatch(bool bHost, float* pfScores)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	Util_Time aTimer;
+	if(bHost)
+	{	MU::SetBackend(MU::hostBackend, pBenchInput->m_iNumThreads);
+		MAF::CCtfScore2D aCtfScore2D;
+		aCtfScore2D.SetParam(m_pCtfParam);
+		aCtfScore2D.SetSize(m_aiCmpSize);
+		aCtfScore2D.Setup(m_afFreqRange[0], m_afFreqRange[1], 100.0f);
+		aTimer.Measure();
+		aCtfScore2D.DoIt(m_pfSpect, m_pfCands, m_iNumCands, pfScores);
+		MU::SetBackend(MU::gpuBackend);
+		return aTimer.GetElapsedSeconds();
+	}
+	//-----------------
+	MAF::GCtfScore2D aGCtfScore2D;
+	aGCtfScore2D.SetParam(m_pCtfParam);
+	aGCtfScore2D.SetSize(m_aiCmpSize);
+	aGCtfScore2D.Setup(m_afFreqRange[0], m_afFreqRange[1], 100.0f);
+	aGCtfScore2D.DoIt(m_gfSpect, m_pfCands, 1, pfScores);
+	aTimer.Measure();
+	aGCtfScore2D.DoIt(m_gfSpect, m_pfCands, m_iNumCands, pfScores);
+	return aTimer.GetElapsedSeconds();
+}
+
+//-------------------------------------------------------------------
+// 1. The scores must agree within 1e-4 and pick the same best
+//    candidate.
+//-------------------------------------------------------------------
+bool CBenchCtf::mCompare
+(	float* pfRefScores,
+	float* pfScores,
+	const char* pcName
+)
+{	float fMaxDiff = 0.0f;
+	int iRefMax = 0, iMax = 0;
+	for(int i=0; i<m_iNumCands; i++)
+	{	float fDiff = fabsf(pfRefScores[i] - pfScores[i]);
+		if(fDiff > fMaxDiff) fMaxDiff = fDiff;
+		if(pfRefScores[i] > pfRefScores[iRefMax]) iRefMax = i;
+		if(pfScores[i] > pfScores[iMax]) iMax = i;
+	}
+	float* pfCand = m_pfCands + iMax * 4;
+	float fAst = (pfCand[1] - pfCand[0]) / (pfCand[1] + pfCand[0]);
+	printf("   %-5s batch vs each: max diff %.3e, best astig %.4f "
+	   "angle %.1f\n", pcName, fMaxDiff, fAst, pfCand[2] * 57.29578f);
+	//-----------------
+	if(fMaxDiff < 1e-4f && iMax == iRefMax) return true;
+	fprintf(stderr, "Error: %s batched CTF scores differ, max diff "
+	   "%.3e, best %d vs %d\n", pcName, fMaxDiff, iMax, iRefMax);
+	return false;
+}
+
+//-------------------------------------------------------------------
+// 1. The radial average has the CTF^2 of the mean defocus with a
+//    phase shift of 10 degree, minus 0.5, plus noise. It is scored
+//    on the 1-D grid with GCalcCTF1D and GCC1D per point as in
+//    CFindDefocus1D on GPU, then in one batch with CCtfScore1D.
+// 2. The resolution window is the one of the 2-D grid.
+//-------------------------------------------------------------------
+bool CBenchCtf::mDo1D(void)
+{
+	int iCmpSize = m_aiCmpSize[0];
+	float fW = m_pCtfParam->m_fWavelength;
+	float fCs = m_pCtfParam->m_fCs;
+	float fPixSize = m_pCtfParam->m_fPixelSize;
+	float fPhase = 10.0f * 0.01745329f + atanf(0.07f
+	   / sqrtf(1.0f - 0.07f * 0.07f));
+	float* pfAvg = new float[iCmpSize];
+	unsigned int uiSeed = 31;
+	for(int x=0; x<iCmpSize; x++)
+	{	float fS = x * 0.5f / (iCmpSize - 1);
+		float fS2 = fS * fS;
+		float fC = sinf(fPhase + 3.1415926f * fW * fS2 * (s_fDfMean
+		   / fPixSize - 0.5f * fW * fW * fS2 * fCs));
+		pfAvg[x] = fC * fC - 0.5f + (rand_r(&uiSeed)
+		   / (float)RAND_MAX - 0.5f);
+	}
+	float* gfAvg = 0L, *gfCtf = 0L;
+	cudaMalloc(&gfAvg, sizeof(float) * iCmpSize);
+	cudaMalloc(&gfCtf, sizeof(float) * iCmpSize);
+	cudaMemcpy(gfAvg, pfAvg, sizeof(float) * iCmpSize, cudaMemcpyDefault);
+	//-----------------
+	int iNumCands = s_aiGrid1D[0] * s_aiGrid1D[1];
+	float* pfCands = new float[iNumCands * 2];
+	for(int i=0; i<iNumCands; i++)
+	{	int iFocus = i % s_aiGrid1D[0];
+		int iPhase = i / s_aiGrid1D[0];
+		pfCands[2 * i] = (5000.0f + iFocus * 50.0f) / fPixSize;
+		pfCands[2 * i + 1] = iPhase * 2.0f * 0.01745329f;
+	}
+	float fRes1 = (iCmpSize - 1) * 2 * fPixSize;
+	float fFreqLow = fRes1 / 15.0f, fFreqHigh = fRes1 / 3.5f;
+	float* pfScores = new float[iNumCands * 2];
+	printf("Ctf: %d radial average, %d x %d candidates\n\n",
+	   iCmpSize, s_aiGrid1D[0], s_aiGrid1D[1]);
+	//-----------------
+	MAF::GCalcCTF1D aGCalcCtf1D;
+	aGCalcCtf1D.SetParam(m_pCtfParam);
+	MAF::GCC1D aGCC1D;
+	aGCC1D.SetSize(iCmpSize);
+	aGCC1D.Setup(fFreqLow, fFreqHigh, 0.0f);
+	Util_Time aTimer;
+	aTimer.Measure();
+	for(int i=0; i<iNumCands; i++)
+	{	aGCalcCtf1D.DoIt(pfCands[2 * i], pfCands[2 * i + 1],
+		   gfCtf, iCmpSize);
+		pfScores[i] = aGCC1D.DoIt(gfCtf, gfAvg);
+	}
+	mReport("GPU 1D each", aTimer.GetElapsedSeconds(), iNumCands);
+	//-----------------
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	MU::SetBackend(MU::hostBackend, pBenchInput->m_iNumThreads);
+	MAF::CCtfScore1D aCtfScore1D;
+	aCtfScore1D.SetParam(m_pCtfParam);
+	aCtfScore1D.SetSize(iCmpSize);
+	aCtfScore1D.Setup(fFreqLow, fFreqHigh, 0.0f);
+	aTimer.Measure();
+	aCtfScore1D.DoIt(pfAvg, pfCands, iNumCands, pfScores + iNumCands);
+	mReport("Host 1D batch", aTimer.GetElapsedSeconds(), iNumCands);
+	MU::SetBackend(MU::gpuBackend);
+	//-----------------
+	float fMaxDiff = 0.0f;
+	int iRefMax = 0, iMax = 0;
+	float* pfHost = pfScores + iNumCands;
+	for(int i=0; i<iNumCands; i++)
+	{	float fDiff = fabsf(pfScores[i] - pfHost[i]);
+		if(fDiff > fMaxDiff) fMaxDiff = fDiff;
+		if(pfScores[i] > pfScores[iRefMax]) iRefMax = i;
+		if(pfHost[i] > pfHost[iMax]) iMax = i;
+	}
+	printf("   Host  batch vs each: max diff %.3e, best defocus %.1f "
+	   "phase %.1f\n", fMaxDiff, pfCands[2 * iMax] * fPixSize,
+	   pfCands[2 * iMax + 1] * 57.29578f);
+	//-----------------
+	cudaFree(gfAvg);
+	cudaFree(gfCtf);
+	delete[] pfAvg;
+	delete[] pfCands;
+	delete[] pfScores;
+	if(fMaxDiff < 1e-4f && iMax == iRefMax) return true;
+	fprintf(stderr, "Error: host 1D CTF scores differ, max diff "
+	   "%.3e, best %d vs %d\n", fMaxDiff, iMax, iRefMax);
+	return false;
+}
+
+void CBenchCtf::mReport
+(	const char* pcName,
+	float fSeconds,
+	int iNumCands
+)
+{	if(iNumCands <= 0) iNumCands = m_iNumCands;
+	printf("%-13s  %8.3f sec  %10.1f candidates/s\n", pcName, fSeconds,
+	   iNumCands / fmaxf(fSeconds, 1e-6f));
+	CBenchReport::GetInstance()->Add(pcName, fSeconds,
+	   iNumCands, "candidates");
+}
@@ -0,0 +1,121 @@
+#include "CBenchInc.h"
+#include "../MotionCor/CMotionCorInc.h"
+#include <Util/Util_Time.h>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdio.h>
+
+using namespace McAreTomo::Benchmark;
+
+CBenchEer::CBenchEer(void)
+{
+	m_iFile = -1;
+	m_pLoadHeader = 0L;
+	m_pLoadFrames = 0L;
+	m_tEerBytes = 0;
+}
+
+CBenchEer::~CBenchEer(void)
+{
+	if(m_pLoadHeader != 0L) delete m_pLoadHeader;
+	if(m_pLoadFrames != 0L) delete m_pLoadFrames;
+	if(m_iFile != -1) close(m_iFile);
+}
+
+bool CBenchEer::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	sprintf(m_acEerFile, "%sAreTomo3Bench.eer", pBenchInput->m_acTmpDir);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	CGenEerFile aGenEerFile;
+	bool bGen = aGenEerFile.DoIt(m_acEerFile, pBenchInput->m_aiCamSize,
+	   pBenchInput->m_iNumFrames, pBenchInput->m_iEerBits,
+	   pBenchInput->m_fFmDose);
+	if(!bGen) return false;
+	printf("EER generated: %s\n   %d frames, %d electrons, "
+	   "%.1f MB, %.2f sec\n\n", m_acEerFile, pBenchInput->m_iNumFrames,
+	   aGenEerFile.m_iNumElectrons, aGenEerFile.m_tFileBytes / 1.0e6,
+	   aTimer.GetElapsedSeconds());
+	//-----------------
+	bool bLoaded = mLoadFrames();
+	if(bLoaded)
+	{	if(pBenchInput->m_iNumThreads != 1) mRender(1);
+		mRender(pBenchInput->m_iNumThreads);
+	}
+	remove(m_acEerFile);
+	return bLoaded;
+}
+
+bool CBenchEer::mLoadFrames(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	pMcInput->m_iFmInt = pBenchInput->m_iFmInt;
+	pMcInput->m_iEerSampling = pBenchInput->m_iEerSampling;
+	//-----------------
+	m_iFile = open(m_acEerFile, O_RDONLY);
+	if(m_iFile == -1) return false;
+	//-----------------
+	m_pLoadHeader = new MME::CLoadEerHeader;
+	m_pLoadFrames = new MME::CLoadEerFrames;
+	bool bLoaded = m_pLoadHeader->DoIt(m_iFile, 
+	   pBenchInput->m_iEerSampling);
+	if(!bLoaded) return false;
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	bLoaded = m_pLoadFrames->DoIt(m_iFile, m_pLoadHeader->m_iNumFrames);
+	float fSecs = aTimer.GetElapsedSeconds();
+	if(!bLoaded) return false;
+	//-----------------
+	m_tEerBytes = 0;
+	for(int i=0; i<m_pLoadHeader->m_iNumFrames; i++)
+	{	m_tEerBytes += m_pLoadFrames->GetEerFrameSize(i);
+	}
+	printf("EER loaded: %.2f sec, %.3f GB/s\n\n", fSecs,
+	   m_tEerBytes / (fSecs + 1e-6f) / 1.0e9);
+	char acName[64] = {'\0'};
+	sprintf(acName, "Load %d-bit", pBenchInput->m_iEerBits);
+	CBenchReport::GetInstance()->Add(acName, fSecs,
+	   m_tEerBytes / 1.0e6, "MB");
+	//-----------------
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(0);
+	MMD::CFmIntParam* pFmIntParam = MMD::CFmIntParam::GetInstance(0);
+	pFmIntParam->Setup(m_pLoadHeader->m_iNumFrames, 
+	   Mrc::eMrcUChar, 0.0f);
+	int aiStkSize[3] = {0};
+	memcpy(aiStkSize, m_pLoadHeader->m_aiFrmSize, sizeof(int) * 2);
+	aiStkSize[2] = pFmIntParam->m_iNumIntFms;
+	pPackage->m_pRawStack->Create(Mrc::eMrc4Bits, aiStkSize);
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Reports EER frames/s, compressed GB/s read by the decoder and
+//    rendered GB/s written into the integrated frames.
+//-------------------------------------------------------------------
+void CBenchEer::mRender(int iNumThreads)
+{
+	MME::CRenderMrcStack aRenderMrcStack;
+	aRenderMrcStack.m_iNumThreads = iNumThreads;
+	aRenderMrcStack.DoIt(m_pLoadHeader, m_pLoadFrames, 0);
+	//-----------------
+	int iNumFrames = m_pLoadHeader->m_iNumFrames;
+	int* piFrmSize = m_pLoadHeader->m_aiFrmSize;
+	double dOutBytes = (double)piFrmSize[0] * piFrmSize[1] * iNumFrames;
+	float fSecs = aRenderMrcStack.m_fRenderTime + 1e-6f;
+	printf("EER decode: %3d threads  %9.1f frames/s  "
+	   "%7.3f GB/s in  %7.3f GB/s out\n\n", 
+	   aRenderMrcStack.m_iNumThreads, iNumFrames / fSecs,
+	   m_tEerBytes / fSecs / 1.0e9, dOutBytes / fSecs / 1.0e9);
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	char acName[64] = {'\0'};
+	sprintf(acName, "Decode %d-bit sampling %d %d threads",
+	   pBenchInput->m_iEerBits, pBenchInput->m_iEerSampling,
+	   aRenderMrcStack.m_iNumThreads);
+	CBenchReport::GetInstance()->Add(acName, fSecs, iNumFrames, "frames");
+}
@@ -0,0 +1,400 @@
+#pragma once
+#include "../CMcAreTomoInc.h"
+#include "../DataUtil/CDataUtilInc.h"
+#include "../MotionCor/EerUtil/CEerUtilInc.h"
+#include "../MotionCor/TiffUtil/CTiffUtilInc.h"
+#include "../AreTomo/MrcUtil/CMrcUtilFwd.h"
+#include <Util/Util_Time.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace MME = McAreTomo::MotionCor::EerUtil;
+
+namespace McAreTomo::Benchmark
+{
+class CBenchInput
+{
+public:
+	static CBenchInput* GetInstance(void);
+	static void DeleteInstance(void);
+	~CBenchInput(void);
+	void ShowTags(void);
+	void Parse(int argc, char* argv[]);
+	//-----------------
+	char m_acTmpDir[256];
+	int m_aiCamSize[2];
+	int m_iNumFrames;
+	int m_iEerBits;
+	int m_iEerSampling;
+	float m_fFmDose;   // electrons per pixel per EER frame
+	int m_iFmInt;
+	int m_iNumThreads;
+	int m_iNumSections;
+	int m_iNumJobs;
+	int m_iVolZ;
+	char m_acReportFile[256];
+	//-----------------
+	char m_acTmpDirTag[32];
+	char m_acCamSizeTag[32];
+	char m_acNumFramesTag[32];
+	char m_acEerBitsTag[32];
+	char m_acEerSamplingTag[32];
+	char m_acFmDoseTag[32];
+	char m_acFmIntTag[32];
+	char m_acThreadsTag[32];
+	char m_acSectionsTag[32];
+	char m_acJobsTag[32];
+	char m_acVolZTag[32];
+	char m_acReportTag[32];
+private:
+	CBenchInput(void);
+	void mPrint(void);
+	static CBenchInput* m_pInstance;
+};
+
+//-------------------------------------------------------------------
+// 1. One row per timed case: the benchmark, the case, the input
+//    sizes, seconds, amount of work with its unit, throughput and
+//    the peak RSS of the process at the time the case ended.
+// 2. Save appends the rows in CSV to -Report, with a header when
+//    the file is new, so that runs of different releases can be
+//    compared. Without -Report the rows are printed.
+//-------------------------------------------------------------------
+class CBenchReport
+{
+public:
+	static CBenchReport* GetInstance(void);
+	static void DeleteInstance(void);
+	~CBenchReport(void);
+	void SetBench(const char* pcBench);
+	void Add
+	( const char* pcCase, float fSeconds,
+	  double dAmount, const char* pcUnit
+	);
+	bool Save(void);
+	static float GetPeakRss(void); // MB
+private:
+	CBenchReport(void);
+	//-----------------
+	char m_acBench[32];
+	std::vector<std::string> m_aRows;
+	static CBenchReport* m_pInstance;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes a synthetic EER movie, one strip per frame, with
+//    electrons randomly placed at the given dose.
+// 2. iEerBits is 7 (compression 65001) or 8 (compression 65000).
+//-------------------------------------------------------------------
+class CGenEerFile
+{
+public:
+	CGenEerFile(void);
+	~CGenEerFile(void);
+	bool DoIt
+	( const char* pcEerFile,
+	  int* piCamSize,
+	  int iNumFrames,
+	  int iEerBits,
+	  float fFmDose
+	);
+	size_t m_tFileBytes;
+	int m_iNumElectrons;
+private:
+	int mEncodeFrame(void);
+	void mPutBits(unsigned int uiVal, int iNumBits);
+	void mPutRun(unsigned int uiRun, bool bElectron);
+	void mWriteIfd(int iFrmBytes, unsigned int uiStripOffset);
+	//-----------------
+	FILE* m_pFile;
+	unsigned char* m_pucFrame;
+	size_t m_tBitPos;
+	int m_aiCamSize[2];
+	int m_iEerBits;
+	float m_fFmDose;
+	unsigned int m_uiSeed;
+	long m_lLastNextIfd;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes a SerialEM style mdoc of iNumTilts tilts, -60 degrees
+//    in steps of 2, whose frames are pcMovieExt files named after
+//    the mdoc.
+//-------------------------------------------------------------------
+class CGenMdocFile
+{
+public:
+	CGenMdocFile(void);
+	~CGenMdocFile(void);
+	bool DoIt
+	( const char* pcMdocFile,
+	  int* piCamSize,
+	  int iNumTilts,
+	  float fTiltDose,
+	  const char* pcMovieExt
+	);
+	size_t m_tFileBytes;
+};
+
+class CBenchEer
+{
+public:
+	CBenchEer(void);
+	~CBenchEer(void);
+	bool DoIt(void);
+private:
+	bool mLoadFrames(void);
+	void mRender(int iNumThreads);
+	//-----------------
+	char m_acEerFile[256];
+	int m_iFile;
+	MME::CLoadEerHeader* m_pLoadHeader;
+	MME::CLoadEerFrames* m_pLoadFrames;
+	size_t m_tEerBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes an 8-bit LZW compressed TIFF movie with electrons
+//    randomly placed at -FmDose and loads it with CLoadTiffMain,
+//    integrating frames on GPU and then on CPU (-CpuFmInt).
+// 2. Both integrated stacks must be identical.
+//-------------------------------------------------------------------
+class CBenchTiff
+{
+public:
+	CBenchTiff(void);
+	~CBenchTiff(void);
+	bool DoIt(void);
+private:
+	bool mGenTiff(void);
+	bool mLoad(int iCpuFmInt);
+	bool mCompare(void);
+	//-----------------
+	char m_acTiffFile[256];
+	size_t m_tTiffBytes;
+	unsigned char* m_pucGpuStack;
+};
+
+//-------------------------------------------------------------------
+// 1. Saves a synthetic float tilt series of -CamSize and -Sections
+//    with Mrc::CSaveMrc section by section, then with
+//    MD::CSaveMrcStack buffered and with O_DIRECT.
+// 2. All three files must be identical.
+//-------------------------------------------------------------------
+class CBenchMrc
+{
+public:
+	CBenchMrc(void);
+	~CBenchMrc(void);
+	bool DoIt(void);
+private:
+	void mGenSeries(void);
+	bool mSaveSections(const char* pcMrcFile);
+	bool mSaveStack(const char* pcMrcFile, bool bDirect);
+	bool mCompare(const char* pcMrcFile1, const char* pcMrcFile2);
+	bool mLoadSections(const char* pcMrcFile);
+	void mReport(const char* pcName, float fSeconds, float fSync);
+	float mSync(const char* pcMrcFile);
+	//-----------------
+	char m_acMrcFiles[3][256];
+	MD::CTiltSeries* m_pTiltSeries;
+	size_t m_tFileBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes an mdoc of -Sections tilts and parses it -Jobs times
+//    with MD::CReadMdoc.
+// 2. Fills MD::CTsPackage with a synthetic tilt series of -CamSize
+//    for that mdoc, saves it through MD::CAsyncWriter and loads it
+//    back with -MmapLoad 0, 1 and 2. The loaded tilt series must
+//    match the saved one.
+//-------------------------------------------------------------------
+class CBenchTs
+{
+public:
+	CBenchTs(void);
+	~CBenchTs(void);
+	bool DoIt(void);
+private:
+	bool mReadMdoc(void);
+	void mGenSeries(void);
+	bool mSave(void);
+	bool mLoad(int iMmapLoad);
+	bool mCompare(void);
+	void mReport(const char* pcName, float fSeconds);
+	void mClean(void);
+	//-----------------
+	char m_acMdocFile[256];
+	char m_acMrcMain[256];
+	MD::CTiltSeries* m_pTiltSeries;
+	size_t m_tFileBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Reconstructs a synthetic tilt series of -CamSize and -Sections
+//    (tilts from -60 in steps of 2) into -VolZ slices with WBP on
+//    GPU and on CPU, first with 1 then with -Threads threads.
+// 2. Voxels/s is reported for each. The CPU volumes must match the
+//    GPU volume within a tolerance relative to its RMS.
+// 3. m_bSart does the same with 20 iterations of SART and 5 tilts
+//    per subset, and adds a run that shares the slices between GPU
+//    and CPU threads.
+//-------------------------------------------------------------------
+class CBenchWbp
+{
+public:
+	CBenchWbp(void);
+	~CBenchWbp(void);
+	bool DoIt(void);
+	bool m_bSart;
+private:
+	void mGenSeries(void);
+	MD::CTiltSeries* mReconGpu(void);
+	MD::CTiltSeries* mReconCpu(int iNumThreads);
+	MD::CTiltSeries* mReconSart(int iCpuRecon, int iNumThreads);
+	bool mCompare(MD::CTiltSeries* pVol1, MD::CTiltSeries* pVol2);
+	void mReport(const char* pcName, float fSeconds);
+	//-----------------
+	MD::CTiltSeries* m_pTiltSeries;
+	MD::CTiltSeries* m_pGpuVol;
+	MAM::CAlignParam* m_pAlignParam;
+	double m_dVoxels;
+};
+
+//-------------------------------------------------------------------
+// 1. Times each MaUtil primitive that has a host backend on GPU
+//    and on -Threads host threads (MU::SetBackend) with an image of
+//    -CamSize, and reports milliseconds per call.
+// 2. The host results must match the GPU results within 1e-4 of
+//    the RMS of the GPU result.
+//-------------------------------------------------------------------
+class CBenchUtil
+{
+public:
+	CBenchUtil(void);
+	~CBenchUtil(void);
+	bool DoIt(void);
+private:
+	void mGenImages(void);
+	float mRun(int iPrim, bool bHost);
+	int mGetResult(int iPrim, bool bHost, float* pfRes);
+	double mCompare
+	( int iPrim, float* pfGpuRes,
+	  float* pfHostRes, int iSize
+	);
+	void mReport(int iPrim, float fMs, bool bHost);
+	//-----------------
+	float* m_apfBufs[5];
+	float* m_agfBufs[5];
+	float* m_pfGpuRes;
+	float m_afScalars[2];
+	int m_aiImgSize[2];
+	int m_aiPadSize[2];
+	int m_aiCmpSize[2];
+	size_t m_tBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Aligns 3 x 3 patches of a synthetic tilt series of -CamSize
+//    and -Sections with MAP::CPatchAlignMain, first with 1 thread
+//    then with -Threads threads (4 when -Threads is 0 or 1).
+// 2. The per-patch shifts of both runs must match.
+//-------------------------------------------------------------------
+class CBenchPatch
+{
+public:
+	CBenchPatch(void);
+	~CBenchPatch(void);
+	bool DoIt(void);
+private:
+	void mGenSeries(void);
+	void mAlign(int iNumThreads);
+	void mGetShifts(float** ppfShifts);
+	bool mCompare(float* pfShifts);
+	//-----------------
+	MAM::CAlignParam* m_pFullParam;
+	float* m_pfRefShifts;
+	int m_iNumShifts;
+};
+
+//-------------------------------------------------------------------
+// 1. Scores the astigmatism grid of CFindDefocus2D on a synthetic
+//    CTF spectrum one candidate at a time on GPU, then batched on
+//    GPU (GCtfScore2D) and on -Threads host threads (CCtfScore2D).
+//-------------------------------------------------------------------
+class CBenchCtf
+{
+public:
+	CBenchCtf(void);
+	~CBenchCtf(void);
+	bool DoIt(void);
+private:
+	void mGenSpect(void);
+	void mGenCands(void);
+	float mScoreEach(float* pfScores);
+	float mScoreBatch(bool bHost, float* pfScores);
+	bool mCompare
+	( float* pfRefScores, float* pfScores,
+	  const char* pcName
+	);
+	bool mDo1D(void);
+	void mReport
+	( const char* pcName, float fSeconds,
+	  int iNumCands = 0
+	);
+	//-----------------
+	float* m_pfSpect;
+	float* m_gfSpect;
+	float* m_pfCands;
+	int m_iNumCands;
+	int m_aiCmpSize[2];
+	float m_afFreqRange[2];
+	MD::CCtfParam* m_pCtfParam;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU stand-in for CProcessThread. It pulls jobs from
+//    MD::CTsScheduler, sleeps instead of processing, and defers
+//    "*_partial.mdoc" jobs on their first attempt.
+//-------------------------------------------------------------------
+class CSchedWorker : public Util_Thread
+{
+public:
+	CSchedWorker(void);
+	~CSchedWorker(void);
+	void ThreadMain(void);
+	int m_iWorker;
+	int m_iSleepUs;
+	std::vector<std::string> m_aDone;
+};
+
+//-------------------------------------------------------------------
+// 1. Ordering: one worker takes -Jobs queued files. MRC files and
+//    settled mdocs must all come before mdocs still being written.
+// 2. Throughput: -Threads workers (default 4) take -Jobs files.
+//    Each file must be processed exactly once.
+// 3. Back-pressure: as 2 but the memory check always fails. Jobs
+//    then run one at a time and each must still run exactly once.
+//-------------------------------------------------------------------
+class CBenchSched
+{
+public:
+	CBenchSched(void);
+	~CBenchSched(void);
+	bool DoIt(void);
+private:
+	void mPushJobs(void);
+	bool mCheckOrder(void);
+	bool mRun(int iNumWorkers, int iSleepUs);
+	bool mCheckOnce(void);
+	void mClean(void);
+	//-----------------
+	std::vector<std::string> m_aFiles;
+	std::vector<bool> m_abComplete;
+	CSchedWorker* m_pWorkers;
+	int m_iNumWorkers;
+};
+}
+
+namespace MB = McAreTomo::Benchmark;
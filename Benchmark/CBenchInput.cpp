@@ -0,0 +1,193 @@
+#include "CBenchInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+
+using namespace McAreTomo::Benchmark;
+
+CBenchInput* CBenchInput::m_pInstance = 0L;
+
+CBenchInput* CBenchInput::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CBenchInput;
+	return m_pInstance;
+}
+
+void CBenchInput::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+CBenchInput::CBenchInput(void)
+{
+	strcpy(m_acTmpDirTag, "-TmpDir");
+	strcpy(m_acCamSizeTag, "-CamSize");
+	strcpy(m_acNumFramesTag, "-Frames");
+	strcpy(m_acEerBitsTag, "-EerBits");
+	strcpy(m_acEerSamplingTag, "-EerSampling");
+	strcpy(m_acFmDoseTag, "-FmDose");
+	strcpy(m_acFmIntTag, "-FmInt");
+	strcpy(m_acThreadsTag, "-Threads");
+	strcpy(m_acSectionsTag, "-Sections");
+	strcpy(m_acJobsTag, "-Jobs");
+	strcpy(m_acVolZTag, "-VolZ");
+	strcpy(m_acReportTag, "-Report");
+	//-----------------
+	strcpy(m_acTmpDir, "/tmp/");
+	m_aiCamSize[0] = 4096;
+	m_aiCamSize[1] = 4096;
+	m_iNumFrames = 500;
+	m_iEerBits = 7;
+	m_iEerSampling = 1;
+	m_fFmDose = 0.01f;
+	m_iFmInt = 20;
+	m_iNumThreads = 0;
+	m_iNumSections = 61;
+	m_iNumJobs = 200;
+	m_iVolZ = 256;
+	memset(m_acReportFile, 0, sizeof(m_acReportFile));
+}
+
+CBenchInput::~CBenchInput(void)
+{
+}
+
+void CBenchInput::ShowTags(void)
+{
+	printf("%-15s\n"
+	   "  1. Directory where synthetic data are generated.\n"
+	   "  2. Default /tmp/.\n\n", m_acTmpDirTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Camera size in x and y, default 4096 4096.\n\n",
+	   m_acCamSizeTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Number of frames of the synthetic movie, default 500.\n\n",
+	   m_acNumFramesTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. 7 or 8 bit EER encoding, default 7.\n\n", m_acEerBitsTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. EER rendering 1, 2, or 3 as in AreTomo3, default 1.\n\n",
+	   m_acEerSamplingTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Electrons per camera pixel per frame, default 0.01.\n\n",
+	   m_acFmDoseTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Raw frames per rendered frame, default 20.\n\n",
+	   m_acFmIntTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Number of decoding threads. Default 0 uses all cores.\n\n",
+	   m_acThreadsTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Number of sections of the MRC stack, default 61.\n\n",
+	   m_acSectionsTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Number of stub tilt series for Sched, default 200.\n\n",
+	   m_acJobsTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Number of z slices of the Wbp volume, default 256.\n\n",
+	   m_acVolZTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. CSV file the results are appended to, one row per\n"
+	   "     case with throughput and peak RSS.\n"
+	   "  2. By default the rows are printed at the end.\n\n",
+	   m_acReportTag);
+}
+
+void CBenchInput::Parse(int argc, char* argv[])
+{
+	int aiRange[2];
+	MU::CParseArgs aParseArgs;
+	aParseArgs.Set(argc, argv);
+	//-----------------
+	if(aParseArgs.FindVals(m_acTmpDirTag, aiRange))
+	{	aParseArgs.GetVal(aiRange[0], m_acTmpDir);
+		int iLen = strlen(m_acTmpDir);
+		if(iLen > 0 && m_acTmpDir[iLen-1] != '/') 
+		{	strcat(m_acTmpDir, "/");
+		}
+	}
+	//-----------------
+	aParseArgs.FindVals(m_acCamSizeTag, aiRange);
+	if(aiRange[1] > 2) aiRange[1] = 2;
+	aParseArgs.GetVals(aiRange, m_aiCamSize);
+	//-----------------
+	aParseArgs.FindVals(m_acNumFramesTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iNumFrames);
+	//-----------------
+	aParseArgs.FindVals(m_acEerBitsTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iEerBits);
+	if(m_iEerBits != 8) m_iEerBits = 7;
+	//-----------------
+	aParseArgs.FindVals(m_acEerSamplingTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iEerSampling);
+	//-----------------
+	aParseArgs.FindVals(m_acFmDoseTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_fFmDose);
+	//-----------------
+	aParseArgs.FindVals(m_acFmIntTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iFmInt);
+	if(m_iFmInt < 1) m_iFmInt = 1;
+	//-----------------
+	aParseArgs.FindVals(m_acThreadsTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iNumThreads);
+	//-----------------
+	aParseArgs.FindVals(m_acSectionsTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iNumSections);
+	if(m_iNumSections < 1) m_iNumSections = 1;
+	//-----------------
+	aParseArgs.FindVals(m_acJobsTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iNumJobs);
+	if(m_iNumJobs < 1) m_iNumJobs = 1;
+	//-----------------
+	aParseArgs.FindVals(m_acVolZTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iVolZ);
+	if(m_iVolZ < 1) m_iVolZ = 1;
+	//-----------------
+	if(aParseArgs.FindVals(m_acReportTag, aiRange))
+	{	aParseArgs.GetVal(aiRange[0], m_acReportFile);
+	}
+	mPrint();
+}
+
+void CBenchInput::mPrint(void)
+{
+	printf("Benchmark input parameters\n");
+	printf("--------------------------\n");
+	printf("%-15s  %s\n", m_acTmpDirTag, m_acTmpDir);
+	printf("%-15s  %d  %d\n", m_acCamSizeTag, 
+	   m_aiCamSize[0], m_aiCamSize[1]);
+	printf("%-15s  %d\n", m_acNumFramesTag, m_iNumFrames);
+	printf("%-15s  %d\n", m_acEerBitsTag, m_iEerBits);
+	printf("%-15s  %d\n", m_acEerSamplingTag, m_iEerSampling);
+	printf("%-15s  %.4f\n", m_acFmDoseTag, m_fFmDose);
+	printf("%-15s  %d\n", m_acFmIntTag, m_iFmInt);
+	printf("%-15s  %d\n", m_acThreadsTag, m_iNumThreads);
+	printf("%-15s  %d\n", m_acSectionsTag, m_iNumSections);
+	printf("%-15s  %d\n", m_acJobsTag, m_iNumJobs);
+	printf("%-15s  %d\n", m_acVolZTag, m_iVolZ);
+	printf("%-15s  %s\n", m_acReportTag, m_acReportFile);
+	printf("\n\n");
+}
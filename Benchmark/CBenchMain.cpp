@@ -0,0 +1,115 @@
+#include "CBenchInc.h"
+#include "../MotionCor/CMotionCorInc.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace McAreTomo;
+using namespace McAreTomo::Benchmark;
+
+static const char* s_pcBenches[] = {"Eer", "Tiff", "Mrc", "Ts",
+   "Sched", "Wbp", "Sart", "Util", "Ctf", "Patch"};
+static const int s_iNumBenches = sizeof(s_pcBenches) / sizeof(char*);
+
+static bool sRunBench(const char* pcBench)
+{
+	CBenchReport::GetInstance()->SetBench(pcBench);
+	printf("Benchmark %s\n\n", pcBench);
+	bool bSuccess = false;
+	if(strcasecmp(pcBench, "Eer") == 0)
+	{	CBenchEer aBenchEer;
+		bSuccess = aBenchEer.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Tiff") == 0)
+	{	CBenchTiff aBenchTiff;
+		bSuccess = aBenchTiff.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Mrc") == 0)
+	{	CBenchMrc aBenchMrc;
+		bSuccess = aBenchMrc.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Ts") == 0)
+	{	CBenchTs aBenchTs;
+		bSuccess = aBenchTs.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Sched") == 0)
+	{	CBenchSched aBenchSched;
+		bSuccess = aBenchSched.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Wbp") == 0)
+	{	CBenchWbp aBenchWbp;
+		bSuccess = aBenchWbp.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Sart") == 0)
+	{	CBenchWbp aBenchWbp;
+		aBenchWbp.m_bSart = true;
+		bSuccess = aBenchWbp.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Util") == 0)
+	{	CBenchUtil aBenchUtil;
+		bSuccess = aBenchUtil.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Ctf") == 0)
+	{	CBenchCtf aBenchCtf;
+		bSuccess = aBenchCtf.DoIt();
+	}
+	else if(strcasecmp(pcBench, "Patch") == 0)
+	{	CBenchPatch aBenchPatch;
+		bSuccess = aBenchPatch.DoIt();
+	}
+	else fprintf(stderr, "Error: unknown benchmark %s\n\n", pcBench);
+	//-----------------
+	if(!bSuccess) fprintf(stderr, "Error: benchmark %s failed\n\n",
+	   pcBench);
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// Usage: AreTomo3Bench Eer|Tiff|Mrc|Ts|Sched|Wbp|Sart|Util|Ctf|Patch|All
+//        [Tags]
+// 1. All runs every benchmark in turn and fails if any fails.
+//-------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	if(argc < 2 || strcasecmp(argv[1], "--help") == 0)
+	{	printf("\nUsage: AreTomo3Bench Eer|Tiff|Mrc|Ts|Sched|Wbp|Sart"
+		   "|Util|Ctf|Patch|All [Tags]\n\n");
+		pBenchInput->ShowTags();
+		return 0;
+	}
+	pBenchInput->Parse(argc, argv);
+	//-----------------
+	CInput* pInput = CInput::GetInstance();
+	pInput->m_iNumGpus = 1;
+	if(pInput->m_piGpuIDs == 0L)
+	{	pInput->m_piGpuIDs = new int[1];
+		pInput->m_piGpuIDs[0] = 0;
+	}
+	MD::CMcPackage::CreateInstances(1);
+	MD::CReadMdoc::CreateInstances(1);
+	MD::CTsPackage::CreateInstances(1);
+	MMD::CFmIntParam::CreateInstances(1);
+	MMD::CFmGroupParam::CreateInstances(1);
+	//-----------------
+	bool bSuccess = true;
+	if(strcasecmp(argv[1], "All") != 0) bSuccess = sRunBench(argv[1]);
+	else
+	{	for(int i=0; i<s_iNumBenches; i++)
+		{	bSuccess = sRunBench(s_pcBenches[i]) && bSuccess;
+		}
+	}
+	//-----------------
+	CBenchReport* pBenchReport = CBenchReport::GetInstance();
+	if(!pBenchReport->Save()) bSuccess = false;
+	printf("Peak RSS: %.1f MB\n\n", CBenchReport::GetPeakRss());
+	//-----------------
+	MD::CAsyncWriter::DeleteInstance();
+	MMD::CFmGroupParam::DeleteInstances();
+	MMD::CFmIntParam::DeleteInstances();
+	MD::CTsPackage::DeleteInstances();
+	MD::CReadMdoc::DeleteInstances();
+	MD::CMcPackage::DeleteInstances();
+	CBenchReport::DeleteInstance();
+	CBenchInput::DeleteInstance();
+	return bSuccess ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+#include "CBenchInc.h"
+#include <Util/Util_Time.h>
+#include <Mrcfile/CMrcFileInc.h>
+#include <memory.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+
+CBenchMrc::CBenchMrc(void)
+{
+	m_pTiltSeries = 0L;
+	m_tFileBytes = 0;
+	memset(m_acMrcFiles, 0, sizeof(m_acMrcFiles));
+}
+
+CBenchMrc::~CBenchMrc(void)
+{
+	if(m_pTiltSeries != 0L) delete m_pTiltSeries;
+}
+
+bool CBenchMrc::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	const char* pcNames[] = {"Sections", "Stack", "Direct"};
+	for(int i=0; i<3; i++)
+	{	sprintf(m_acMrcFiles[i], "%sAreTomo3Bench%s.mrc",
+		   pBenchInput->m_acTmpDir, pcNames[i]);
+	}
+	//-----------------
+	mGenSeries();
+	bool bSuccess = mSaveSections(m_acMrcFiles[0])
+	   && mSaveStack(m_acMrcFiles[1], false)
+	   && mSaveStack(m_acMrcFiles[2], true)
+	   && mLoadSections(m_acMrcFiles[0])
+	   && mCompare(m_acMrcFiles[0], m_acMrcFiles[1])
+	   && mCompare(m_acMrcFiles[0], m_acMrcFiles[2]);
+	for(int i=0; i<3; i++) remove(m_acMrcFiles[i]);
+	return bSuccess;
+}
+
+void CBenchMrc::mGenSeries(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumSections = pBenchInput->m_iNumSections;
+	m_pTiltSeries = new MD::CTiltSeries;
+	m_pTiltSeries->Create(pBenchInput->m_aiCamSize, iNumSections);
+	m_pTiltSeries->m_fPixSize = 1.0f;
+	//-----------------
+	unsigned int uiSeed = 17;
+	int iPixels = m_pTiltSeries->GetPixels();
+	for(int i=0; i<iNumSections; i++)
+	{	float* pfImg = (float*)m_pTiltSeries->GetFrame(i);
+		for(int j=0; j<iPixels; j++)
+		{	pfImg[j] = rand_r(&uiSeed) / (float)RAND_MAX;
+		}
+		m_pTiltSeries->m_pfTilts[i] = -60.0f + i * 2.0f;
+	}
+	m_tFileBytes = 1024 + iNumSections * 32 * sizeof(float)
+	   + m_pTiltSeries->m_tFmBytes * iNumSections;
+	printf("MRC stack: %d x %d x %d, %.1f MB\n\n",
+	   m_pTiltSeries->m_aiStkSize[0], m_pTiltSeries->m_aiStkSize[1],
+	   iNumSections, m_tFileBytes / 1.0e6);
+}
+
+//-------------------------------------------------------------------
+// 1. SetExtHeader must follow SetImgSize, which resets it.
+//-------------------------------------------------------------------
+bool CBenchMrc::mSaveSections(const char* pcMrcFile)
+{
+	Util_Time aTimer;
+	aTimer.Measure();
+	//-----------------
+	Mrc::CSaveMrc aSaveMrc;
+	if(!aSaveMrc.OpenFile((char*)pcMrcFile)) return false;
+	aSaveMrc.SetMode(Mrc::eMrcFloat);
+	aSaveMrc.SetImgSize(m_pTiltSeries->m_aiStkSize,
+	   m_pTiltSeries->m_aiStkSize[2], 1, m_pTiltSeries->m_fPixSize);
+	aSaveMrc.SetExtHeader(0, 32, 0);
+	aSaveMrc.m_pSaveMain->DoIt();
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	float fTilt = m_pTiltSeries->m_pfTilts[i];
+		aSaveMrc.m_pSaveExt->SetTilt(i, &fTilt, 1);
+		aSaveMrc.m_pSaveExt->DoIt();
+		aSaveMrc.m_pSaveImg->DoIt(i, m_pTiltSeries->GetFrame(i));
+	}
+	aSaveMrc.CloseFile();
+	float fSeconds = aTimer.GetElapsedSeconds();
+	//-----------------
+	mReport("Per section", fSeconds, mSync(pcMrcFile));
+	return true;
+}
+
+bool CBenchMrc::mSaveStack(const char* pcMrcFile, bool bDirect)
+{
+	MD::CSaveMrcStack aSaveStack;
+	aSaveStack.SetExtHeader(0, 32);
+	bool bSaved = aSaveStack.DoIt(pcMrcFile, m_pTiltSeries,
+	   m_pTiltSeries->m_pfTilts, bDirect);
+	if(!bSaved) return false;
+	//-----------------
+	const char* pcName = "pwritev";
+	if(aSaveStack.m_bDirect) pcName = "O_DIRECT";
+	else if(bDirect) pcName = "pwritev (no O_DIRECT)";
+	mReport(pcName, aSaveStack.m_fSeconds, mSync(pcMrcFile));
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Loads the sections back with Mrc::CLoadImage. The file was
+//    just written and is read from the page cache.
+//-------------------------------------------------------------------
+bool CBenchMrc::mLoadSections(const char* pcMrcFile)
+{
+	Mrc::CLoadMrc aLoadMrc;
+	if(!aLoadMrc.OpenFile((char*)pcMrcFile)) return false;
+	float* pfImg = new float[m_pTiltSeries->GetPixels()];
+	bool bSame = true;
+	float fSeconds = 0.0f;
+	Util_Time aTimer;
+	for(int i=0; i<m_pTiltSeries->m_aiStkSize[2]; i++)
+	{	aTimer.Measure();
+		aLoadMrc.m_pLoadImg->DoIt(i, pfImg);
+		fSeconds += aTimer.GetElapsedSeconds();
+		if(memcmp(pfImg, m_pTiltSeries->GetFrame(i),
+		   m_pTiltSeries->m_tFmBytes) != 0) bSame = false;
+	}
+	aLoadMrc.CloseFile();
+	delete[] pfImg;
+	if(!bSame)
+	{	fprintf(stderr, "Error: sections loaded from %s differ\n\n",
+		   pcMrcFile);
+		return false;
+	}
+	double dMB = m_tFileBytes / 1.0e6;
+	printf("%-22s  %8.3f sec  %8.1f MB/s\n\n", "Load per section",
+	   fSeconds, dMB / fmax(fSeconds, 1e-6));
+	CBenchReport::GetInstance()->Add("Load per section", fSeconds,
+	   dMB, "MB");
+	return true;
+}
+
+bool CBenchMrc::mCompare(const char* pcMrcFile1, const char* pcMrcFile2)
+{
+	FILE* pFile1 = fopen(pcMrcFile1, "rb");
+	FILE* pFile2 = fopen(pcMrcFile2, "rb");
+	bool bSame = (pFile1 != 0L && pFile2 != 0L);
+	//-----------------
+	size_t tBufBytes = 16 * 1024 * 1024;
+	char* pcBuf1 = new char[tBufBytes];
+	char* pcBuf2 = new char[tBufBytes];
+	size_t tTotal = 0;
+	while(bSame)
+	{	size_t tRead1 = fread(pcBuf1, 1, tBufBytes, pFile1);
+		size_t tRead2 = fread(pcBuf2, 1, tBufBytes, pFile2);
+		if(tRead1 != tRead2) bSame = false;
+		else if(memcmp(pcBuf1, pcBuf2, tRead1) != 0) bSame = false;
+		tTotal += tRead1;
+		if(tRead1 < tBufBytes) break;
+	}
+	if(bSame && tTotal != m_tFileBytes) bSame = false;
+	delete[] pcBuf1;
+	delete[] pcBuf2;
+	if(pFile1 != 0L) fclose(pFile1);
+	if(pFile2 != 0L) fclose(pFile2);
+	//-----------------
+	if(bSame) printf("%s matches %s\n\n", pcMrcFile2, pcMrcFile1);
+	else fprintf(stderr, "Error: %s differs from %s\n\n",
+	   pcMrcFile2, pcMrcFile1);
+	return bSame;
+}
+
+void CBenchMrc::mReport(const char* pcName, float fSeconds, float fSync)
+{
+	double dMB = m_tFileBytes / 1.0e6;
+	printf("%-22s  %8.3f sec  %8.1f MB/s  "
+	   "(with fsync %8.3f sec  %8.1f MB/s)\n", pcName,
+	   fSeconds, dMB / fmax(fSeconds, 1e-6), fSeconds + fSync,
+	   dMB / fmax(fSeconds + fSync, 1e-6));
+	CBenchReport::GetInstance()->Add(pcName, fSeconds + fSync,
+	   dMB, "MB");
+}
+
+float CBenchMrc::mSync(const char* pcMrcFile)
+{
+	Util_Time aTimer;
+	aTimer.Measure();
+	int iFile = open(pcMrcFile, O_RDONLY);
+	if(iFile == -1) return 0.0f;
+	fsync(iFile);
+	close(iFile);
+	return aTimer.GetElapsedSeconds();
+}
@@ -0,0 +1,176 @@
+#include "CBenchInc.h"
+#include "../AreTomo/CAreTomoInc.h"
+#include "../AreTomo/MrcUtil/CMrcUtilInc.h"
+#include "../AreTomo/PatchAlign/CPatchAlignInc.h"
+#include <Util/Util_Time.h>
+#include <cuda_runtime.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const int s_iNumBlobs = 400;
+static const int s_iNumPatches = 3; // per axis
+
+CBenchPatch::CBenchPatch(void)
+{
+	m_pFullParam = 0L;
+	m_pfRefShifts = 0L;
+	m_iNumShifts = 0;
+}
+
+CBenchPatch::~CBenchPatch(void)
+{
+	if(m_pFullParam != 0L) delete m_pFullParam;
+	if(m_pfRefShifts != 0L) delete[] m_pfRefShifts;
+	AreTomo::CAtInstances::DeleteInstances();
+}
+
+bool CBenchPatch::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	cudaSetDevice(0);
+	AreTomo::CAtInstances::CreateInstances(1);
+	mGenSeries();
+	//-----------------
+	CAtInput* pAtInput = CAtInput::GetInstance();
+	pAtInput->m_aiAtPatches[0] = s_iNumPatches;
+	pAtInput->m_aiAtPatches[1] = s_iNumPatches;
+	MAP::CPatchTargets::GetInstance(0)->Detect();
+	//-----------------
+	int iNumThreads = pBenchInput->m_iNumThreads;
+	if(iNumThreads <= 1) iNumThreads = 4;
+	mAlign(1);
+	mGetShifts(&m_pfRefShifts);
+	mAlign(iNumThreads);
+	float* pfShifts = 0L;
+	mGetShifts(&pfShifts);
+	bool bSuccess = mCompare(pfShifts);
+	delete[] pfShifts;
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. Gaussian blobs at random (x, y, z) are projected along the
+//    tilt angles, -60 in steps of 2, about the y axis. Each blob
+//    is drawn within 4 sigma only.
+//-------------------------------------------------------------------
+void CBenchPatch::mGenSeries(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumSections = pBenchInput->m_iNumSections;
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(0);
+	MD::CTiltSeries* pSeries = pTsPackage->GetSeries(0);
+	pSeries->Create(pBenchInput->m_aiCamSize, iNumSections);
+	pSeries->m_fPixSize = 1.0f;
+	MAM::CAlignParam* pAlignParam = MAM::CAlignParam::GetInstance(0);
+	pAlignParam->Create(iNumSections);
+	//-----------------
+	int iSizeX = pSeries->m_aiStkSize[0];
+	int iSizeY = pSeries->m_aiStkSize[1];
+	float afBlobs[s_iNumBlobs * 4];
+	unsigned int uiSeed = 29;
+	for(int b=0; b<s_iNumBlobs; b++)
+	{	float* pfBlob = afBlobs + b * 4;
+		pfBlob[0] = (rand_r(&uiSeed) / (float)RAND_MAX - 0.5f)
+		   * iSizeX * 0.8f;
+		pfBlob[1] = (rand_r(&uiSeed) / (float)RAND_MAX) * iSizeY;
+		pfBlob[2] = (rand_r(&uiSeed) / (float)RAND_MAX - 0.5f)
+		   * pBenchInput->m_iVolZ * 0.6f;
+		pfBlob[3] = 3.0f + rand_r(&uiSeed) % 6;
+	}
+	//-----------------
+	for(int i=0; i<iNumSections; i++)
+	{	float fTilt = -60.0f + i * 2.0f;
+		pSeries->m_pfTilts[i] = fTilt;
+		pAlignParam->SetTilt(i, fTilt);
+		float fCos = (float)cos(fTilt * 3.1415926 / 180.0);
+		float fSin = (float)sin(fTilt * 3.1415926 / 180.0);
+		//----------------
+		float* pfImg = (float*)pSeries->GetFrame(i);
+		memset(pfImg, 0, sizeof(float) * pSeries->GetPixels());
+		for(int b=0; b<s_iNumBlobs; b++)
+		{	float* pfBlob = afBlobs + b * 4;
+			float fX = pfBlob[0] * fCos + pfBlob[2] * fSin
+			   + iSizeX * 0.5f;
+			int iR = (int)(4 * pfBlob[3]);
+			for(int y=(int)pfBlob[1]-iR; y<=(int)pfBlob[1]+iR; y++)
+			{	if(y < 0 || y >= iSizeY) continue;
+				float fDy = (y - pfBlob[1]) / pfBlob[3];
+				float* pfRow = pfImg + (size_t)y * iSizeX;
+				for(int x=(int)fX-iR; x<=(int)fX+iR; x++)
+				{	if(x < 0 || x >= iSizeX) continue;
+					float fDx = (x - fX) / pfBlob[3];
+					pfRow[x] += expf(-0.5f *
+					   (fDx * fDx + fDy * fDy));
+				}
+			}
+		}
+	}
+	m_pFullParam = pAlignParam->GetCopy();
+	printf("Patch: %d x %d x %d tilt series, %d x %d patches\n\n",
+	   iSizeX, iSizeY, iNumSections, s_iNumPatches, s_iNumPatches);
+}
+
+//-------------------------------------------------------------------
+// 1. CFitPatchShifts may refine the tilt axis of the global
+//    alignment. It is restored so that every run starts the same.
+//-------------------------------------------------------------------
+void CBenchPatch::mAlign(int iNumThreads)
+{
+	MAM::CAlignParam::GetInstance(0)->Set(m_pFullParam);
+	MAP::CPatchAlignMain* pPatchAlignMain =
+	   MAP::CPatchAlignMain::GetInstance(0);
+	pPatchAlignMain->m_iNumThreads = iNumThreads;
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	pPatchAlignMain->DoIt();
+	float fSeconds = aTimer.GetElapsedSeconds();
+	//-----------------
+	int iNumTgts = MAP::CPatchTargets::GetInstance(0)->m_iNumTgts;
+	char acName[64] = {'\0'};
+	sprintf(acName, "%d threads", iNumThreads);
+	printf("%-16s  %8.3f sec  %8.2f patches/s\n\n", acName,
+	   fSeconds, iNumTgts / fmax(fSeconds, 1e-6));
+	CBenchReport::GetInstance()->Add(acName, fSeconds,
+	   iNumTgts, "patches");
+}
+
+void CBenchPatch::mGetShifts(float** ppfShifts)
+{
+	MAM::CPatchShifts* pPatchShifts = MAM::CPatchShifts::GetInstance(0);
+	m_iNumShifts = pPatchShifts->m_iNumPatches
+	   * pPatchShifts->m_iNumTilts;
+	float* pfShifts = new float[m_iNumShifts * 2];
+	for(int p=0; p<pPatchShifts->m_iNumPatches; p++)
+	{	for(int t=0; t<pPatchShifts->m_iNumTilts; t++)
+		{	int i = p * pPatchShifts->m_iNumTilts + t;
+			pPatchShifts->GetShift(p, t, pfShifts + 2 * i);
+		}
+	}
+	ppfShifts[0] = pfShifts;
+}
+
+//-------------------------------------------------------------------
+// 1. Each patch is aligned by the same code on the same data no
+//    matter which worker takes it. The per-patch shifts must match
+//    the single-thread run to well below a pixel.
+//-------------------------------------------------------------------
+bool CBenchPatch::mCompare(float* pfShifts)
+{
+	double dMaxDiff = 0.0;
+	for(int i=0; i<m_iNumShifts * 2; i++)
+	{	double dDiff = fabs(pfShifts[i] - m_pfRefShifts[i]);
+		if(dDiff > dMaxDiff) dMaxDiff = dDiff;
+	}
+	printf("   threads vs 1 thread: max shift diff %.3e pixels\n\n",
+	   dMaxDiff);
+	if(dMaxDiff < 1e-3) return true;
+	fprintf(stderr, "Error: concurrent patch shifts differ from the "
+	   "serial run by %.3e pixels\n\n", dMaxDiff);
+	return false;
+}
@@ -0,0 +1,97 @@
+#include "CBenchInc.h"
+#include <sys/resource.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <time.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const char* s_pcHeader = "time,bench,case,cam_x,cam_y,frames,"
+   "sections,threads,seconds,amount,unit,per_sec,peak_rss_mb";
+
+CBenchReport* CBenchReport::m_pInstance = 0L;
+
+CBenchReport* CBenchReport::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CBenchReport;
+	return m_pInstance;
+}
+
+void CBenchReport::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+CBenchReport::CBenchReport(void)
+{
+	memset(m_acBench, 0, sizeof(m_acBench));
+}
+
+CBenchReport::~CBenchReport(void)
+{
+}
+
+void CBenchReport::SetBench(const char* pcBench)
+{
+	memset(m_acBench, 0, sizeof(m_acBench));
+	strncpy(m_acBench, pcBench, sizeof(m_acBench) - 1);
+}
+
+void CBenchReport::Add
+(	const char* pcCase,
+	float fSeconds,
+	double dAmount,
+	const char* pcUnit
+)
+{	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	double dRate = (fSeconds > 0) ? dAmount / fSeconds : 0.0;
+	char acRow[512] = {'\0'};
+	snprintf(acRow, sizeof(acRow), "%ld,%s,%s,%d,%d,%d,%d,%d,"
+	   "%.6f,%.6g,%s,%.6g,%.1f", (long)time(0L), m_acBench, pcCase,
+	   pBenchInput->m_aiCamSize[0], pBenchInput->m_aiCamSize[1],
+	   pBenchInput->m_iNumFrames, pBenchInput->m_iNumSections,
+	   pBenchInput->m_iNumThreads, fSeconds, dAmount, pcUnit,
+	   dRate, CBenchReport::GetPeakRss());
+	m_aRows.push_back(acRow);
+}
+
+bool CBenchReport::Save(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	if(pBenchInput->m_acReportFile[0] == '\0')
+	{	printf("Report\n------\n%s\n", s_pcHeader);
+		for(int i=0; i<(int)m_aRows.size(); i++)
+		{	printf("%s\n", m_aRows[i].c_str());
+		}
+		printf("\n");
+		return true;
+	}
+	//-----------------
+	FILE* pFile = fopen(pBenchInput->m_acReportFile, "a");
+	if(pFile == 0L)
+	{	fprintf(stderr, "Error: unable to open %s\n\n",
+		   pBenchInput->m_acReportFile);
+		return false;
+	}
+	if(ftell(pFile) == 0) fprintf(pFile, "%s\n", s_pcHeader);
+	for(int i=0; i<(int)m_aRows.size(); i++)
+	{	fprintf(pFile, "%s\n", m_aRows[i].c_str());
+	}
+	fclose(pFile);
+	printf("Report appended to %s\n\n", pBenchInput->m_acReportFile);
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. ru_maxrss is in kilobytes on Linux.
+//-------------------------------------------------------------------
+float CBenchReport::GetPeakRss(void)
+{
+	struct rusage aUsage;
+	if(getrusage(RUSAGE_SELF, &aUsage) != 0) return 0.0f;
+	return aUsage.ru_maxrss / 1024.0f;
+}
@@ -0,0 +1,208 @@
+#include "CBenchInc.h"
+#include <Util/Util_Time.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unordered_set>
+
+using namespace McAreTomo::Benchmark;
+
+CSchedWorker::CSchedWorker(void)
+{
+	m_iWorker = 0;
+	m_iSleepUs = 0;
+}
+
+CSchedWorker::~CSchedWorker(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. A partial mdoc is "finished" by moving its modification time
+//    back an hour and is then deferred, so that its next attempt
+//    finds it settled.
+//-------------------------------------------------------------------
+void CSchedWorker::ThreadMain(void)
+{
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	char acInFile[256] = {'\0'};
+	while(pScheduler->WaitJob(m_iWorker, acInFile))
+	{	bool bDefer = false;
+		struct stat aStat;
+		if(strstr(acInFile, "_partial") != 0L &&
+		   stat(acInFile, &aStat) == 0 &&
+		   difftime(time(0L), aStat.st_mtime) < 60.0)
+		{	struct utimbuf aTimes;
+			aTimes.actime = time(0L) - 3600;
+			aTimes.modtime = aTimes.actime;
+			utime(acInFile, &aTimes);
+			bDefer = true;
+		}
+		//----------------
+		if(bDefer) pScheduler->Defer(m_iWorker);
+		else
+		{	if(m_iSleepUs > 0) usleep(m_iSleepUs);
+			m_aDone.push_back(acInFile);
+		}
+		pScheduler->JobDone(m_iWorker);
+	}
+}
+
+CBenchSched::CBenchSched(void)
+{
+	m_pWorkers = 0L;
+	m_iNumWorkers = 0;
+}
+
+CBenchSched::~CBenchSched(void)
+{
+	mClean();
+}
+
+bool CBenchSched::DoIt(void)
+{
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	pScheduler->m_fSettleSecs = 60.0f;
+	pScheduler->m_fRetrySecs = 0.01f;
+	pScheduler->m_tMinAvailBytes = 0;
+	//-----------------
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumWorkers = pBenchInput->m_iNumThreads;
+	if(iNumWorkers <= 0) iNumWorkers = 4;
+	//-----------------
+	bool bSuccess = mRun(1, 0) && mCheckOrder() && mCheckOnce();
+	if(bSuccess) bSuccess = mRun(iNumWorkers, 2000) && mCheckOnce();
+	//-----------------
+	// Memory back-pressure: no amount of memory is ever enough, so
+	// the workers can only take a job when none is running.
+	//-----------------
+	if(bSuccess)
+	{	pScheduler->m_tMinAvailBytes = (size_t)-1;
+		bSuccess = mRun(iNumWorkers, 2000) && mCheckOnce();
+		pScheduler->m_tMinAvailBytes = 0;
+	}
+	mClean();
+	MD::CTsScheduler::DeleteInstance();
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. Every third job is an MRC file, a settled mdoc, or a partial
+//    mdoc that was modified just now.
+//-------------------------------------------------------------------
+void CBenchSched::mPushJobs(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	const char* pcKinds[] = {".mrc", ".mdoc", "_partial.mdoc"};
+	m_aFiles.clear();
+	m_abComplete.clear();
+	//-----------------
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	char acFile[256] = {'\0'};
+	for(int i=0; i<pBenchInput->m_iNumJobs; i++)
+	{	int iKind = i % 3;
+		sprintf(acFile, "%sAreTomo3Sched_%04d%s",
+		   pBenchInput->m_acTmpDir, i, pcKinds[iKind]);
+		if(iKind > 0)
+		{	FILE* pFile = fopen(acFile, "w");
+			if(pFile != 0L) fclose(pFile);
+		}
+		if(iKind == 1)
+		{	struct utimbuf aTimes;
+			aTimes.actime = time(0L) - 3600;
+			aTimes.modtime = aTimes.actime;
+			utime(acFile, &aTimes);
+		}
+		m_aFiles.push_back(acFile);
+		m_abComplete.push_back(iKind < 2);
+		pScheduler->PushFile(acFile);
+	}
+}
+
+bool CBenchSched::mRun(int iNumWorkers, int iSleepUs)
+{
+	mClean();
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	pScheduler->Setup(iNumWorkers);
+	mPushJobs();
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	m_iNumWorkers = iNumWorkers;
+	m_pWorkers = new CSchedWorker[m_iNumWorkers];
+	for(int i=0; i<m_iNumWorkers; i++)
+	{	m_pWorkers[i].m_iWorker = i;
+		m_pWorkers[i].m_iSleepUs = iSleepUs;
+		m_pWorkers[i].Start();
+	}
+	pScheduler->Close();
+	for(int i=0; i<m_iNumWorkers; i++)
+	{	m_pWorkers[i].WaitForExit(-1.0f);
+	}
+	float fSeconds = aTimer.GetElapsedSeconds();
+	//-----------------
+	int iNumJobs = (int)m_aFiles.size();
+	float fIdeal = iNumJobs * iSleepUs * 1e-6f / m_iNumWorkers;
+	printf("%d workers, %d jobs, %.3f sec, %.1f jobs/s",
+	   m_iNumWorkers, iNumJobs, fSeconds, iNumJobs / fSeconds);
+	if(fIdeal > 0) printf(", %.1f%% of ideal", fIdeal / fSeconds * 100);
+	printf("\n");
+	char acName[64] = {'\0'};
+	sprintf(acName, "%d workers", m_iNumWorkers);
+	CBenchReport::GetInstance()->Add(acName, fSeconds, iNumJobs, "jobs");
+	pScheduler->PrintStats();
+	return true;
+}
+
+bool CBenchSched::mCheckOrder(void)
+{
+	std::vector<std::string>* pDone = &m_pWorkers[0].m_aDone;
+	int iNumDone = (int)pDone->size();
+	int iPos = 0;
+	for(int i=0; i<(int)m_aFiles.size(); i++)
+	{	if(!m_abComplete[i]) continue;
+		if(iPos >= iNumDone || (*pDone)[iPos] != m_aFiles[i])
+		{	fprintf(stderr, "Error: %s is out of order.\n\n",
+			   m_aFiles[i].c_str());
+			return false;
+		}
+		iPos += 1;
+	}
+	printf("Complete jobs were dispatched first, in order.\n\n");
+	return true;
+}
+
+bool CBenchSched::mCheckOnce(void)
+{
+	std::unordered_set<std::string> aDone;
+	int iNumDone = 0;
+	for(int i=0; i<m_iNumWorkers; i++)
+	{	std::vector<std::string>* pDone = &m_pWorkers[i].m_aDone;
+		for(int j=0; j<(int)pDone->size(); j++)
+		{	aDone.insert((*pDone)[j]);
+			iNumDone += 1;
+		}
+	}
+	bool bOnce = (iNumDone == (int)m_aFiles.size());
+	for(int i=0; i<(int)m_aFiles.size() && bOnce; i++)
+	{	if(aDone.find(m_aFiles[i]) == aDone.end()) bOnce = false;
+	}
+	if(bOnce) return true;
+	fprintf(stderr, "Error: %d jobs processed, %d expected, "
+	   "%d distinct.\n\n", iNumDone, (int)m_aFiles.size(),
+	   (int)aDone.size());
+	return false;
+}
+
+void CBenchSched::mClean(void)
+{
+	if(m_pWorkers != 0L) delete[] m_pWorkers;
+	m_pWorkers = 0L;
+	m_iNumWorkers = 0;
+	for(int i=0; i<(int)m_aFiles.size(); i++)
+	{	remove(m_aFiles[i].c_str());
+	}
+}
@@ -0,0 +1,150 @@
+#include "CBenchInc.h"
+#include "../MotionCor/CMotionCorInc.h"
+#include <Util/Util_Time.h>
+#include <sys/stat.h>
+#include <memory.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+namespace MMT = McAreTomo::MotionCor::TiffUtil;
+
+CBenchTiff::CBenchTiff(void)
+{
+	m_tTiffBytes = 0;
+	m_pucGpuStack = 0L;
+}
+
+CBenchTiff::~CBenchTiff(void)
+{
+	if(m_pucGpuStack != 0L) delete[] m_pucGpuStack;
+}
+
+bool CBenchTiff::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	sprintf(m_acTiffFile, "%sAreTomo3Bench.tif", pBenchInput->m_acTmpDir);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	if(!mGenTiff()) return false;
+	printf("TIFF generated: %s\n   %d frames, %.1f MB, %.2f sec\n\n",
+	   m_acTiffFile, pBenchInput->m_iNumFrames, m_tTiffBytes / 1.0e6,
+	   aTimer.GetElapsedSeconds());
+	//-----------------
+	bool bSuccess = mLoad(0) && mLoad(1) && mCompare();
+	remove(m_acTiffFile);
+	return bSuccess;
+}
+
+bool CBenchTiff::mGenTiff(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	TIFF* pTiff = TIFFOpen(m_acTiffFile, "w");
+	if(pTiff == 0L) return false;
+	//-----------------
+	int* piCamSize = pBenchInput->m_aiCamSize;
+	int iPixels = piCamSize[0] * piCamSize[1];
+	int iRowsPerStrip = 64;
+	unsigned char* pucFrm = new unsigned char[iPixels];
+	unsigned int uiSeed = 17;
+	double dMeanGap = 1.0 / fmaxf(pBenchInput->m_fFmDose, 1e-6f);
+	//-----------------
+	for(int f=0; f<pBenchInput->m_iNumFrames; f++)
+	{	memset(pucFrm, 0, iPixels);
+		double dPos = 0.0;
+		while(true)
+		{	double dRand = (rand_r(&uiSeed) + 1.0) / (RAND_MAX + 2.0);
+			dPos += -log(dRand) * dMeanGap;
+			if(dPos >= iPixels) break;
+			pucFrm[(int)dPos] += 1;
+		}
+		//----------------
+		TIFFSetField(pTiff, TIFFTAG_IMAGEWIDTH, piCamSize[0]);
+		TIFFSetField(pTiff, TIFFTAG_IMAGELENGTH, piCamSize[1]);
+		TIFFSetField(pTiff, TIFFTAG_BITSPERSAMPLE, 8);
+		TIFFSetField(pTiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+		TIFFSetField(pTiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+		TIFFSetField(pTiff, TIFFTAG_ROWSPERSTRIP, iRowsPerStrip);
+		TIFFSetField(pTiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+		TIFFSetField(pTiff, TIFFTAG_PHOTOMETRIC, 
+		   PHOTOMETRIC_MINISBLACK);
+		TIFFSetField(pTiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+		for(int y=0; y<piCamSize[1]; y+=iRowsPerStrip)
+		{	int iRows = piCamSize[1] - y;
+			if(iRows > iRowsPerStrip) iRows = iRowsPerStrip;
+			TIFFWriteEncodedStrip(pTiff, y / iRowsPerStrip,
+			   pucFrm + y * piCamSize[0], iRows * piCamSize[0]);
+		}
+		TIFFWriteDirectory(pTiff);
+	}
+	TIFFClose(pTiff);
+	delete[] pucFrm;
+	//-----------------
+	struct stat aStat;
+	if(stat(m_acTiffFile, &aStat) != 0) return false;
+	m_tTiffBytes = aStat.st_size;
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Reports raw frames/s and uncompressed GB/s of raw frames.
+//-------------------------------------------------------------------
+bool CBenchTiff::mLoad(int iCpuFmInt)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	pMcInput->m_iFmInt = pBenchInput->m_iFmInt;
+	pMcInput->m_iCpuFmInt = iCpuFmInt;
+	//-----------------
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(0);
+	strcpy(pPackage->m_acMoviePath, m_acTiffFile);
+	pPackage->m_fTotalDose = 0.0f;
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	MMT::CLoadTiffMain aLoadTiffMain;
+	bool bLoaded = aLoadTiffMain.DoIt(0);
+	float fSecs = aTimer.GetElapsedSeconds() + 1e-6f;
+	if(!bLoaded) return false;
+	//-----------------
+	int iNumFrames = pBenchInput->m_iNumFrames;
+	int* piCamSize = pBenchInput->m_aiCamSize;
+	double dRawBytes = (double)piCamSize[0] * piCamSize[1] * iNumFrames;
+	printf("TIFF integrate on %s:  %9.1f frames/s  %7.3f GB/s\n\n",
+	   (iCpuFmInt == 0) ? "GPU" : "CPU", iNumFrames / fSecs,
+	   dRawBytes / fSecs / 1.0e9);
+	CBenchReport::GetInstance()->Add((iCpuFmInt == 0) ? 
+	   "Load GPU integrate" : "Load CPU integrate", fSecs,
+	   iNumFrames, "frames");
+	//-----------------
+	if(iCpuFmInt != 0) return true;
+	MD::CMrcStack* pRawStack = pPackage->m_pRawStack;
+	size_t tFmBytes = pRawStack->m_tFmBytes;
+	if(m_pucGpuStack != 0L) delete[] m_pucGpuStack;
+	m_pucGpuStack = new unsigned char[tFmBytes * pRawStack->m_aiStkSize[2]];
+	for(int i=0; i<pRawStack->m_aiStkSize[2]; i++)
+	{	memcpy(m_pucGpuStack + i * tFmBytes, pRawStack->GetFrame(i),
+		   tFmBytes);
+	}
+	return true;
+}
+
+bool CBenchTiff::mCompare(void)
+{
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(0);
+	MD::CMrcStack* pRawStack = pPackage->m_pRawStack;
+	size_t tFmBytes = pRawStack->m_tFmBytes;
+	for(int i=0; i<pRawStack->m_aiStkSize[2]; i++)
+	{	int iDiff = memcmp(m_pucGpuStack + i * tFmBytes, 
+		   pRawStack->GetFrame(i), tFmBytes);
+		if(iDiff == 0) continue;
+		fprintf(stderr, "Error: GPU and CPU integrated frame %d "
+		   "differ.\n\n", i);
+		return false;
+	}
+	printf("TIFF integrate: GPU and CPU stacks are identical.\n\n");
+	return true;
+}
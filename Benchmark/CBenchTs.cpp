@@ -0,0 +1,219 @@
+#include "CBenchInc.h"
+#include <Util/Util_Time.h>
+#include <memory.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const float s_fTiltDose = 3.0f;
+
+CBenchTs::CBenchTs(void)
+{
+	m_pTiltSeries = 0L;
+	m_tFileBytes = 0;
+	memset(m_acMdocFile, 0, sizeof(m_acMdocFile));
+	memset(m_acMrcMain, 0, sizeof(m_acMrcMain));
+}
+
+CBenchTs::~CBenchTs(void)
+{
+	if(m_pTiltSeries != 0L) delete m_pTiltSeries;
+}
+
+//-------------------------------------------------------------------
+// 1. The tilt series is saved into and loaded from -TmpDir as the
+//    output folder, the way CTsPackage does for mdoc input.
+// 2. The loads after the save read from the page cache.
+//-------------------------------------------------------------------
+bool CBenchTs::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	sprintf(m_acMdocFile, "%sAreTomo3BenchTs.mdoc",
+	   pBenchInput->m_acTmpDir);
+	//-----------------
+	CInput* pInput = CInput::GetInstance();
+	strcpy(pInput->m_acOutDir, pBenchInput->m_acTmpDir);
+	pInput->m_iSplitSum = 0;
+	//-----------------
+	bool bSuccess = mReadMdoc();
+	if(bSuccess)
+	{	mGenSeries();
+		bSuccess = mSave();
+		for(int i=0; i<=2; i++)
+		{	if(!bSuccess) break;
+			bSuccess = mLoad(i) && mCompare();
+		}
+	}
+	mClean();
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. CReadMdoc holds at most 1024 tilts and needs at least 7.
+//-------------------------------------------------------------------
+bool CBenchTs::mReadMdoc(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumTilts = pBenchInput->m_iNumSections;
+	if(iNumTilts < 7) iNumTilts = 7;
+	else if(iNumTilts > 1024) iNumTilts = 1024;
+	//-----------------
+	CGenMdocFile aGenMdocFile;
+	bool bGen = aGenMdocFile.DoIt(m_acMdocFile, pBenchInput->m_aiCamSize,
+	   iNumTilts, s_fTiltDose, ".eer");
+	if(!bGen) return false;
+	printf("Mdoc generated: %s\n   %d tilts, %.1f KB\n\n", m_acMdocFile,
+	   iNumTilts, aGenMdocFile.m_tFileBytes / 1.0e3);
+	//-----------------
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(0);
+	Util_Time aTimer;
+	aTimer.Measure();
+	bool bRead = true;
+	for(int i=0; i<pBenchInput->m_iNumJobs; i++)
+	{	bRead = pReadMdoc->DoIt(m_acMdocFile);
+		if(!bRead) break;
+	}
+	float fSeconds = aTimer.GetElapsedSeconds();
+	if(!bRead || pReadMdoc->m_iNumTilts != iNumTilts)
+	{	fprintf(stderr, "Error: CReadMdoc read %d tilts of %d\n\n",
+		   pReadMdoc->m_iNumTilts, iNumTilts);
+		return false;
+	}
+	for(int i=0; i<iNumTilts; i++)
+	{	if(fabsf(pReadMdoc->GetTilt(i) - (-60.0f + i * 2.0f)) < 0.01f
+		   && pReadMdoc->GetAcqIdx(i) == i) continue;
+		fprintf(stderr, "Error: CReadMdoc tilt %d is %.2f\n\n",
+		   i, pReadMdoc->GetTilt(i));
+		return false;
+	}
+	//-----------------
+	int iNumJobs = pBenchInput->m_iNumJobs;
+	printf("%-22s  %8.3f sec  %10.1f mdocs/s\n\n", "CReadMdoc",
+	   fSeconds, iNumJobs / fmax(fSeconds, 1e-6));
+	CBenchReport::GetInstance()->Add("CReadMdoc", fSeconds,
+	   iNumJobs, "mdocs");
+	return true;
+}
+
+void CBenchTs::mGenSeries(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(0);
+	int iNumTilts = pReadMdoc->m_iNumTilts;
+	m_pTiltSeries = new MD::CTiltSeries;
+	m_pTiltSeries->Create(pBenchInput->m_aiCamSize, iNumTilts);
+	m_pTiltSeries->m_fPixSize = 1.0f;
+	//-----------------
+	unsigned int uiSeed = 23;
+	int iPixels = m_pTiltSeries->GetPixels();
+	for(int i=0; i<iNumTilts; i++)
+	{	float* pfImg = (float*)m_pTiltSeries->GetFrame(i);
+		for(int j=0; j<iPixels; j++)
+		{	pfImg[j] = rand_r(&uiSeed) / (float)RAND_MAX;
+		}
+		m_pTiltSeries->m_pfTilts[i] = pReadMdoc->GetTilt(i);
+		m_pTiltSeries->m_pfDoses[i] = pReadMdoc->GetDose(i);
+		m_pTiltSeries->m_piAcqIndices[i] = pReadMdoc->GetAcqIdx(i);
+	}
+	m_tFileBytes = 1024 + iNumTilts * 32 * sizeof(float)
+	   + m_pTiltSeries->m_tFmBytes * iNumTilts;
+	//-----------------
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(0);
+	pTsPackage->SetInFile(m_acMdocFile);
+	strcpy(m_acMrcMain, CInput::GetInstance()->m_acOutDir);
+	strcat(m_acMrcMain, pTsPackage->m_acMrcMain);
+	printf("Tilt series: %d x %d x %d, %.1f MB\n\n",
+	   m_pTiltSeries->m_aiStkSize[0], m_pTiltSeries->m_aiStkSize[1],
+	   iNumTilts, m_tFileBytes / 1.0e6);
+}
+
+//-------------------------------------------------------------------
+// 1. The time includes copying the tilt series into the writer
+//    queue and writing it and the TLT file to disk with fdatasync.
+//-------------------------------------------------------------------
+bool CBenchTs::mSave(void)
+{
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(0);
+	MD::CTiltSeries* pSeries = pTsPackage->GetSeries(0);
+	int iNumTilts = m_pTiltSeries->m_aiStkSize[2];
+	pSeries->Create(m_pTiltSeries->m_aiStkSize, iNumTilts);
+	pSeries->m_fPixSize = m_pTiltSeries->m_fPixSize;
+	for(int i=0; i<iNumTilts; i++)
+	{	pSeries->SetImage(i, m_pTiltSeries->GetFrame(i));
+		pSeries->m_pfTilts[i] = m_pTiltSeries->m_pfTilts[i];
+		pSeries->m_pfDoses[i] = m_pTiltSeries->m_pfDoses[i];
+		pSeries->m_piAcqIndices[i] = m_pTiltSeries->m_piAcqIndices[i];
+	}
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	pTsPackage->SaveTiltSeries();
+	bool bClear = true;
+	bool bSaved = MD::CAsyncWriter::GetInstance()->WaitGpu(0, bClear);
+	float fSeconds = aTimer.GetElapsedSeconds();
+	if(!bSaved) return false;
+	mReport("SaveTiltSeries", fSeconds);
+	return true;
+}
+
+bool CBenchTs::mLoad(int iMmapLoad)
+{
+	CInput* pInput = CInput::GetInstance();
+	pInput->m_iMmapLoad = iMmapLoad;
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(0);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	bool bLoaded = pTsPackage->LoadTiltSeries();
+	float fSeconds = aTimer.GetElapsedSeconds();
+	if(!bLoaded)
+	{	fprintf(stderr, "Error: LoadTiltSeries failed, -MmapLoad %d\n\n",
+		   iMmapLoad);
+		return false;
+	}
+	char acName[64] = {'\0'};
+	sprintf(acName, "LoadTiltSeries mmap %d", iMmapLoad);
+	mReport(acName, fSeconds);
+	return true;
+}
+
+bool CBenchTs::mCompare(void)
+{
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(0);
+	MD::CTiltSeries* pSeries = pTsPackage->GetSeries(0);
+	int* piStkSize = m_pTiltSeries->m_aiStkSize;
+	bool bSame = (memcmp(pSeries->m_aiStkSize, piStkSize,
+	   sizeof(int) * 3) == 0);
+	for(int i=0; i<piStkSize[2]; i++)
+	{	if(!bSame) break;
+		if(pSeries->m_pfTilts[i] != m_pTiltSeries->m_pfTilts[i]
+		   || memcmp(pSeries->GetFrame(i), m_pTiltSeries->GetFrame(i),
+		   m_pTiltSeries->m_tFmBytes) != 0) bSame = false;
+	}
+	if(!bSame) fprintf(stderr, "Error: loaded tilt series differs "
+	   "from the saved one.\n\n");
+	return bSame;
+}
+
+void CBenchTs::mReport(const char* pcName, float fSeconds)
+{
+	double dMB = m_tFileBytes / 1.0e6;
+	printf("%-22s  %8.3f sec  %8.1f MB/s\n", pcName, fSeconds,
+	   dMB / fmax(fSeconds, 1e-6));
+	CBenchReport::GetInstance()->Add(pcName, fSeconds, dMB, "MB");
+}
+
+void CBenchTs::mClean(void)
+{
+	remove(m_acMdocFile);
+	if(m_acMrcMain[0] == '\0') return;
+	char acFile[256] = {'\0'};
+	sprintf(acFile, "%s.mrc", m_acMrcMain);
+	remove(acFile);
+	sprintf(acFile, "%s_TLT.txt", m_acMrcMain);
+	remove(acFile);
+	printf("\n");
+}
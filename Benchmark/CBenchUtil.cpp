@@ -0,0 +1,245 @@
+#include "CBenchInc.h"
+#include "../MaUtil/CMaUtilInc.h"
+#include <Util/Util_Time.h>
+#include <cuda_runtime.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const int s_iNumPrims = 8;
+static const int s_iNumRepeats = 5;
+static const char* s_acPrims[] = {"FFT forward", "FFT inverse",
+   "Normalize2D", "CalcMoment2D", "FindMinMax2D", "PhaseShift2D",
+   "FtResize2D", "CalcFRC"};
+
+CBenchUtil::CBenchUtil(void)
+{
+	memset(m_apfBufs, 0, sizeof(m_apfBufs));
+	memset(m_agfBufs, 0, sizeof(m_agfBufs));
+	m_pfGpuRes = 0L;
+	m_tBytes = 0;
+}
+
+CBenchUtil::~CBenchUtil(void)
+{
+	for(int i=0; i<5; i++)
+	{	if(m_apfBufs[i] != 0L) delete[] m_apfBufs[i];
+		if(m_agfBufs[i] != 0L) cudaFree(m_agfBufs[i]);
+	}
+	if(m_pfGpuRes != 0L) delete[] m_pfGpuRes;
+	MU::SetBackend(MU::gpuBackend);
+}
+
+bool CBenchUtil::DoIt(void)
+{
+	cudaSetDevice(0);
+	mGenImages();
+	printf("%-14s  %10s  %10s  %8s  %10s\n", "Primitive", "GPU ms",
+	   "Host ms", "Speedup", "Rel diff");
+	//-----------------
+	bool bSuccess = true;
+	for(int i=0; i<s_iNumPrims; i++)
+	{	float fGpuMs = mRun(i, false);
+		int iSize = mGetResult(i, false, m_pfGpuRes);
+		float fHostMs = mRun(i, true);
+		mGetResult(i, true, m_apfBufs[4]);
+		double dDiff = mCompare(i, m_pfGpuRes, m_apfBufs[4], iSize);
+		printf("%-14s  %10.3f  %10.3f  %8.2f  %10.3e\n", s_acPrims[i],
+		   fGpuMs, fHostMs, fGpuMs / fmaxf(fHostMs, 1e-6f), dDiff);
+		mReport(i, fGpuMs, false);
+		mReport(i, fHostMs, true);
+		//----------------
+		if(dDiff < 1e-4) continue;
+		fprintf(stderr, "Error: host %s differs from GPU, relative "
+		   "rms %.3e\n", s_acPrims[i], dDiff);
+		bSuccess = false;
+	}
+	printf("\n");
+	return bSuccess;
+}
+
+void CBenchUtil::mReport(int iPrim, float fMs, bool bHost)
+{
+	char acName[64] = {'\0'};
+	sprintf(acName, "%s %s", s_acPrims[iPrim], bHost ? "Host" : "GPU");
+	CBenchReport::GetInstance()->Add(acName, fMs * 1e-3f, 1.0, "calls");
+}
+
+//-------------------------------------------------------------------
+// 1. Buffer 0 is a padded image of random blobs, 1 its spectrum,
+//    and 2 the spectrum of the image with noise added. Buffer 3 is
+//    the work buffer and 4 the output. The GPU gets the same.
+//-------------------------------------------------------------------
+void CBenchUtil::mGenImages(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	m_aiImgSize[0] = pBenchInput->m_aiCamSize[0] / 2 * 2;
+	m_aiImgSize[1] = pBenchInput->m_aiCamSize[1] / 2 * 2;
+	m_aiPadSize[0] = (m_aiImgSize[0] / 2 + 1) * 2;
+	m_aiPadSize[1] = m_aiImgSize[1];
+	m_aiCmpSize[0] = m_aiPadSize[0] / 2;
+	m_aiCmpSize[1] = m_aiPadSize[1];
+	m_tBytes = sizeof(float) * m_aiPadSize[0] * m_aiPadSize[1];
+	//-----------------
+	int iPadPixels = m_aiPadSize[0] * m_aiPadSize[1];
+	for(int i=0; i<5; i++)
+	{	m_apfBufs[i] = new float[iPadPixels];
+		memset(m_apfBufs[i], 0, m_tBytes);
+		cudaMalloc(&m_agfBufs[i], m_tBytes);
+	}
+	m_pfGpuRes = new float[iPadPixels];
+	//-----------------
+	unsigned int uiSeed = 17;
+	for(int y=0; y<m_aiImgSize[1]; y++)
+	{	float* pfRow = m_apfBufs[0] + y * m_aiPadSize[0];
+		float fY = sinf(y * 0.013f);
+		for(int x=0; x<m_aiImgSize[0]; x++)
+		{	pfRow[x] = fY * cosf(x * 0.021f) + rand_r(&uiSeed)
+			   / (float)RAND_MAX;
+		}
+	}
+	memcpy(m_apfBufs[1], m_apfBufs[0], m_tBytes);
+	for(int y=0; y<m_aiImgSize[1]; y++)
+	{	float* pfRow = m_apfBufs[2] + y * m_aiPadSize[0];
+		float* pfImg = m_apfBufs[0] + y * m_aiPadSize[0];
+		for(int x=0; x<m_aiImgSize[0]; x++)
+		{	pfRow[x] = pfImg[x] + 2.0f * rand_r(&uiSeed)
+			   / (float)RAND_MAX;
+		}
+	}
+	MU::SetBackend(MU::hostBackend, pBenchInput->m_iNumThreads);
+	MU::CFFT2D aFFT2D;
+	aFFT2D.CreatePlan(m_aiImgSize[0], m_aiImgSize[1],
+	   MU::GetHostThreads());
+	aFFT2D.Forward(m_apfBufs[1], true);
+	aFFT2D.Forward(m_apfBufs[2], true);
+	MU::SetBackend(MU::gpuBackend);
+	//-----------------
+	for(int i=0; i<3; i++)
+	{	cudaMemcpy(m_agfBufs[i], m_apfBufs[i], m_tBytes,
+		   cudaMemcpyDefault);
+	}
+	printf("Util: %d x %d image, %d threads\n\n", m_aiImgSize[0],
+	   m_aiImgSize[1], MU::GetHostThreads());
+}
+
+//-------------------------------------------------------------------
+// 1. The same calls run on GPU or host buffers, selected by
+//    MU::SetBackend. The work buffer is restored before each call
+//    outside of the timing.
+// 2. Returns milliseconds per call.
+//-------------------------------------------------------------------
+float CBenchUtil::mRun(int iPrim, bool bHost)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	MU::SetBackend(bHost ? MU::hostBackend : MU::gpuBackend,
+	   pBenchInput->m_iNumThreads);
+	float** ppfBufs = bHost ? m_apfBufs : m_agfBufs;
+	float* pfWork = ppfBufs[3];
+	float* pfOut = ppfBufs[4];
+	cufftComplex* pCmp1 = (cufftComplex*)ppfBufs[1];
+	cufftComplex* pCmp2 = (cufftComplex*)ppfBufs[2];
+	int aiOutSize[] = {m_aiCmpSize[0] / 2 + 1, m_aiCmpSize[1] / 2};
+	float afShift[] = {3.5f, -2.25f};
+	//-----------------
+	MU::CCufft2D aCufft2D;
+	MU::GCalcMoment2D aCalcMoment2D;
+	MU::GFindMinMax2D aFindMinMax2D;
+	if(iPrim == 0) aCufft2D.CreateForwardPlan(m_aiPadSize, true);
+	else if(iPrim == 1) aCufft2D.CreateInversePlan(m_aiCmpSize, true);
+	else if(iPrim == 3) aCalcMoment2D.SetSize(m_aiPadSize, true);
+	else if(iPrim == 4) aFindMinMax2D.SetSize(m_aiPadSize, true);
+	//-----------------
+	Util_Time aTimer;
+	double dSeconds = 0.0;
+	for(int r=0; r<s_iNumRepeats; r++)
+	{	int iSrc = (iPrim == 1) ? 1 : 0;
+		cudaMemcpy(pfWork, ppfBufs[iSrc], m_tBytes, cudaMemcpyDefault);
+		cudaDeviceSynchronize();
+		aTimer.Measure();
+		//----------------
+		if(iPrim == 0)
+		{	aCufft2D.Forward(pfWork, (cufftComplex*)pfOut, true);
+		}
+		else if(iPrim == 1)
+		{	aCufft2D.Inverse((cufftComplex*)pfWork, pfOut);
+		}
+		else if(iPrim == 2)
+		{	MU::GNormalize2D aNormalize2D;
+			aNormalize2D.DoIt(pfWork, m_aiPadSize, true, 0.5f, 2.0f);
+		}
+		else if(iPrim == 3)
+		{	m_afScalars[bHost] = aCalcMoment2D.DoIt(pfWork, 2, true);
+		}
+		else if(iPrim == 4)
+		{	m_afScalars[bHost] = aFindMinMax2D.DoMax(pfWork, true);
+		}
+		else if(iPrim == 5)
+		{	MU::GPhaseShift2D aPhaseShift2D;
+			aPhaseShift2D.DoIt(pCmp1, m_aiCmpSize, afShift, false,
+			   (cufftComplex*)pfOut);
+		}
+		else if(iPrim == 6)
+		{	MU::GFtResize2D aFtResize2D;
+			aFtResize2D.DownSample(pCmp1, m_aiCmpSize,
+			   (cufftComplex*)pfOut, aiOutSize, false);
+		}
+		else
+		{	MU::GCalcFRC aCalcFRC;
+			aCalcFRC.DoIt(pCmp1, pCmp2, pfOut, 1, m_aiCmpSize);
+		}
+		cudaDeviceSynchronize();
+		dSeconds += aTimer.GetElapsedSeconds();
+	}
+	MU::SetBackend(MU::gpuBackend);
+	return (float)(dSeconds * 1000.0 / s_iNumRepeats);
+}
+
+//-------------------------------------------------------------------
+// 1. Copies the output of iPrim into pfRes and returns the number
+//    of floats to compare. Real images keep their padding so that
+//    mCompare skips it.
+//-------------------------------------------------------------------
+int CBenchUtil::mGetResult(int iPrim, bool bHost, float* pfRes)
+{
+	float** ppfBufs = bHost ? m_apfBufs : m_agfBufs;
+	if(iPrim == 3 || iPrim == 4)
+	{	pfRes[0] = m_afScalars[bHost];
+		return 1;
+	}
+	float* pfOut = (iPrim == 2) ? ppfBufs[3] : ppfBufs[4];
+	int iSize = m_aiPadSize[0] * m_aiPadSize[1];
+	if(iPrim == 6) iSize = (m_aiCmpSize[0] / 2 + 1)
+	   * (m_aiCmpSize[1] / 2) * 2;
+	else if(iPrim == 7) iSize = m_aiCmpSize[0];
+	if(pfRes != pfOut)
+	{	cudaMemcpy(pfRes, pfOut, sizeof(float) * iSize,
+		   cudaMemcpyDefault);
+	}
+	return iSize;
+}
+
+//-------------------------------------------------------------------
+// 1. RMS of the difference relative to the RMS of the GPU result.
+//    The padding columns of real images are not compared.
+//-------------------------------------------------------------------
+double CBenchUtil::mCompare
+(	int iPrim,
+	float* pfGpuRes,
+	float* pfHostRes,
+	int iSize
+)
+{	bool bReal = (iPrim == 1 || iPrim == 2);
+	double dSum = 0.0, dSumDiff = 0.0;
+	for(int i=0; i<iSize; i++)
+	{	if(bReal && (i % m_aiPadSize[0]) >= m_aiImgSize[0]) continue;
+		double dDiff = pfGpuRes[i] - pfHostRes[i];
+		dSum += pfGpuRes[i] * (double)pfGpuRes[i];
+		dSumDiff += dDiff * dDiff;
+	}
+	return sqrt(dSumDiff / fmax(dSum, 1e-30));
+}
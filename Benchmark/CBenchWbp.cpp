@@ -0,0 +1,217 @@
+#include "CBenchInc.h"
+#include "../AreTomo/MrcUtil/CMrcUtilInc.h"
+#include "../AreTomo/Recon/CReconFwd.h"
+#include "../AreTomo/Recon/CReconInc.h"
+#include <Util/Util_Time.h>
+#include <cuda_runtime.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const int s_iNumBlobs = 24;
+static const int s_iSartIters = 20;
+static const int s_iSartTilts = 5;
+
+CBenchWbp::CBenchWbp(void)
+{
+	m_pTiltSeries = 0L;
+	m_pGpuVol = 0L;
+	m_pAlignParam = 0L;
+	m_dVoxels = 0.0;
+	m_bSart = false;
+}
+
+CBenchWbp::~CBenchWbp(void)
+{
+	if(m_pTiltSeries != 0L) delete m_pTiltSeries;
+	if(m_pGpuVol != 0L) delete m_pGpuVol;
+	if(m_pAlignParam != 0L) delete m_pAlignParam;
+}
+
+bool CBenchWbp::DoIt(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	mGenSeries();
+	m_pGpuVol = mReconGpu();
+	//-----------------
+	bool bSuccess = true;
+	if(pBenchInput->m_iNumThreads != 1)
+	{	MD::CTiltSeries* pCpuVol = mReconCpu(1);
+		bSuccess = mCompare(m_pGpuVol, pCpuVol);
+		delete pCpuVol;
+	}
+	MD::CTiltSeries* pCpuVol = mReconCpu(pBenchInput->m_iNumThreads);
+	bSuccess = mCompare(m_pGpuVol, pCpuVol) && bSuccess;
+	delete pCpuVol;
+	//-----------------
+	if(m_bSart)
+	{	pCpuVol = mReconSart(2, pBenchInput->m_iNumThreads);
+		bSuccess = mCompare(m_pGpuVol, pCpuVol) && bSuccess;
+		delete pCpuVol;
+	}
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. Gaussian blobs at random (x, z) are projected along the tilt
+//    angles. Their amplitude varies along y.
+//-------------------------------------------------------------------
+void CBenchWbp::mGenSeries(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumSections = pBenchInput->m_iNumSections;
+	m_pTiltSeries = new MD::CTiltSeries;
+	m_pTiltSeries->Create(pBenchInput->m_aiCamSize, iNumSections);
+	m_pTiltSeries->m_fPixSize = 1.0f;
+	m_pAlignParam = new MAM::CAlignParam;
+	m_pAlignParam->Create(iNumSections);
+	//-----------------
+	int iSizeX = m_pTiltSeries->m_aiStkSize[0];
+	int iSizeY = m_pTiltSeries->m_aiStkSize[1];
+	float afBlobs[s_iNumBlobs * 3];
+	unsigned int uiSeed = 23;
+	for(int b=0; b<s_iNumBlobs; b++)
+	{	float* pfBlob = afBlobs + b * 3;
+		pfBlob[0] = (rand_r(&uiSeed) / (float)RAND_MAX - 0.5f)
+		   * iSizeX * 0.6f;
+		pfBlob[1] = (rand_r(&uiSeed) / (float)RAND_MAX - 0.5f)
+		   * pBenchInput->m_iVolZ * 0.6f;
+		pfBlob[2] = 2.0f + rand_r(&uiSeed) % 8;
+	}
+	//-----------------
+	float* pfLine = new float[iSizeX];
+	for(int i=0; i<iNumSections; i++)
+	{	float fTilt = -60.0f + i * 2.0f;
+		m_pTiltSeries->m_pfTilts[i] = fTilt;
+		m_pAlignParam->SetTilt(i, fTilt);
+		float fCos = (float)cos(fTilt * 3.1415926 / 180.0);
+		float fSin = (float)sin(fTilt * 3.1415926 / 180.0);
+		//----------------
+		memset(pfLine, 0, sizeof(float) * iSizeX);
+		for(int b=0; b<s_iNumBlobs; b++)
+		{	float* pfBlob = afBlobs + b * 3;
+			float fX = pfBlob[0] * fCos + pfBlob[1] * fSin
+			   + iSizeX * 0.5f;
+			for(int x=0; x<iSizeX; x++)
+			{	float fD = (x - fX) / pfBlob[2];
+				pfLine[x] += expf(-0.5f * fD * fD);
+			}
+		}
+		float* pfImg = (float*)m_pTiltSeries->GetFrame(i);
+		for(int y=0; y<iSizeY; y++)
+		{	float fAmp = 1.0f + 0.5f * sinf(y * 0.01f);
+			float* pfRow = pfImg + (size_t)y * iSizeX;
+			for(int x=0; x<iSizeX; x++) pfRow[x] = fAmp * pfLine[x];
+		}
+	}
+	delete[] pfLine;
+	//-----------------
+	m_dVoxels = (double)(iSizeX / 2 * 2) * iSizeY * pBenchInput->m_iVolZ;
+	printf("%s: %d x %d x %d tilt series, %d x %d x %d volume\n\n",
+	   m_bSart ? "SART" : "WBP", iSizeX, iSizeY, iNumSections,
+	   iSizeX / 2 * 2, pBenchInput->m_iVolZ, iSizeY);
+}
+
+MD::CTiltSeries* CBenchWbp::mReconGpu(void)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	cudaSetDevice(0);
+	if(m_bSart) return mReconSart(0, 0);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	MAR::CDoWbpRecon aDoWbpRecon;
+	MD::CTiltSeries* pVol = aDoWbpRecon.DoIt(m_pTiltSeries,
+	   m_pAlignParam, pBenchInput->m_iVolZ);
+	mReport("GPU", aTimer.GetElapsedSeconds());
+	return pVol;
+}
+
+MD::CTiltSeries* CBenchWbp::mReconCpu(int iNumThreads)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	if(m_bSart) return mReconSart(1, iNumThreads);
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	MAR::CDoCpuWbpRecon aDoCpuWbpRecon;
+	aDoCpuWbpRecon.m_iNumThreads = iNumThreads;
+	MD::CTiltSeries* pVol = aDoCpuWbpRecon.DoIt(m_pTiltSeries,
+	   m_pAlignParam, pBenchInput->m_iVolZ);
+	//-----------------
+	char acName[64] = {'\0'};
+	sprintf(acName, "CPU %d threads", aDoCpuWbpRecon.m_iNumThreads);
+	mReport(acName, aTimer.GetElapsedSeconds());
+	return pVol;
+}
+
+MD::CTiltSeries* CBenchWbp::mReconSart(int iCpuRecon, int iNumThreads)
+{
+	CBenchInput* pBenchInput = CBenchInput::GetInstance();
+	int iNumTilts = m_pTiltSeries->m_aiStkSize[2];
+	int iNumSubsets = iNumTilts / s_iSartTilts;
+	if(iNumSubsets < 1) iNumSubsets = 1;
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	MAR::CDoSartRecon aDoSartRecon;
+	aDoSartRecon.m_iCpuRecon = iCpuRecon;
+	aDoSartRecon.m_iNumThreads = iNumThreads;
+	MD::CTiltSeries* pVol = aDoSartRecon.DoIt(m_pTiltSeries,
+	   m_pAlignParam, 0, iNumTilts, pBenchInput->m_iVolZ,
+	   s_iSartIters, iNumSubsets);
+	//-----------------
+	char acName[64] = {'\0'};
+	if(iCpuRecon == 0) strcpy(acName, "GPU");
+	else if(iCpuRecon == 1) sprintf(acName, "CPU %d threads",
+	   aDoSartRecon.m_iNumThreads);
+	else sprintf(acName, "GPU+%d threads", aDoSartRecon.m_iNumThreads);
+	mReport(acName, aTimer.GetElapsedSeconds());
+	return pVol;
+}
+
+//-------------------------------------------------------------------
+// 1. Rounding and cosf differ slightly between CPU and GPU, and a
+//    projected x right at an integer may truncate differently.
+//    The RMS of the difference must be below 1e-4 of the RMS of
+//    the GPU volume, or 1e-3 for SART whose iterations amplify
+//    the rounding differences.
+//-------------------------------------------------------------------
+bool CBenchWbp::mCompare(MD::CTiltSeries* pVol1, MD::CTiltSeries* pVol2)
+{
+	double dSum1 = 0.0, dSumDiff = 0.0, dMaxDiff = 0.0;
+	size_t tPixels = pVol1->GetPixels();
+	for(int i=0; i<pVol1->m_aiStkSize[2]; i++)
+	{	float* pfSlice1 = (float*)pVol1->GetFrame(i);
+		float* pfSlice2 = (float*)pVol2->GetFrame(i);
+		for(size_t j=0; j<tPixels; j++)
+		{	double dDiff = fabs(pfSlice1[j] - pfSlice2[j]);
+			dSum1 += pfSlice1[j] * (double)pfSlice1[j];
+			dSumDiff += dDiff * dDiff;
+			if(dDiff > dMaxDiff) dMaxDiff = dDiff;
+		}
+	}
+	double dRms = sqrt(dSum1 / m_dVoxels);
+	double dRmsDiff = sqrt(dSumDiff / m_dVoxels);
+	double dRatio = dRmsDiff / fmax(dRms, 1e-30);
+	printf("   CPU vs GPU: rms diff %.3e, max diff %.3e, "
+	   "GPU rms %.3e\n\n", dRmsDiff, dMaxDiff, dRms);
+	double dTol = m_bSart ? 1e-3 : 1e-4;
+	if(dRatio < dTol) return true;
+	fprintf(stderr, "Error: CPU %s differs from GPU %s, "
+	   "relative rms %.3e\n\n", m_bSart ? "SART" : "WBP",
+	   m_bSart ? "SART" : "WBP", dRatio);
+	return false;
+}
+
+void CBenchWbp::mReport(const char* pcName, float fSeconds)
+{
+	printf("%-16s  %8.3f sec  %10.1f Mvoxels/s\n", pcName,
+	   fSeconds, m_dVoxels * 1e-6 / fmax(fSeconds, 1e-6));
+	CBenchReport::GetInstance()->Add(pcName, fSeconds,
+	   m_dVoxels, "voxels");
+}
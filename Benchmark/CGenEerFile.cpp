@@ -0,0 +1,167 @@
+#include "CBenchInc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <math.h>
+#include <stdio.h>
+
+using namespace McAreTomo::Benchmark;
+
+static const int s_iNumIfdEntries = 9;
+
+CGenEerFile::CGenEerFile(void)
+{
+	m_pFile = 0L;
+	m_pucFrame = 0L;
+	m_tFileBytes = 0;
+	m_iNumElectrons = 0;
+	m_uiSeed = 1234;
+}
+
+CGenEerFile::~CGenEerFile(void)
+{
+	if(m_pucFrame != 0L) delete[] m_pucFrame;
+	if(m_pFile != 0L) fclose(m_pFile);
+}
+
+bool CGenEerFile::DoIt
+(	const char* pcEerFile,
+	int* piCamSize,
+	int iNumFrames,
+	int iEerBits,
+	float fFmDose
+)
+{	m_pFile = fopen(pcEerFile, "wb");
+	if(m_pFile == 0L)
+	{	fprintf(stderr, "CGenEerFile: cannot create %s\n\n", pcEerFile);
+		return false;
+	}
+	m_aiCamSize[0] = piCamSize[0];
+	m_aiCamSize[1] = piCamSize[1];
+	m_iEerBits = iEerBits;
+	m_fFmDose = fFmDose;
+	m_iNumElectrons = 0;
+	//-----------------------------------------------------
+	// Worst case every pixel is hit, 12 bits per electron.
+	//-----------------------------------------------------
+	size_t tPixels = (size_t)m_aiCamSize[0] * m_aiCamSize[1];
+	size_t tMaxBytes = tPixels * 3 / 2 + 16;
+	m_pucFrame = new unsigned char[tMaxBytes];
+	//-----------------
+	unsigned char aucHeader[8] = {'I', 'I', 42, 0, 0, 0, 0, 0};
+	fwrite(aucHeader, 1, 8, m_pFile);
+	m_lLastNextIfd = 4;
+	//-----------------
+	for(int i=0; i<iNumFrames; i++)
+	{	int iFrmBytes = mEncodeFrame();
+		unsigned int uiStripOffset = (unsigned int)ftell(m_pFile);
+		fwrite(m_pucFrame, 1, iFrmBytes, m_pFile);
+		if(iFrmBytes % 2 == 1) fputc(0, m_pFile);
+		mWriteIfd(iFrmBytes, uiStripOffset);
+	}
+	m_tFileBytes = (size_t)ftell(m_pFile);
+	//-----------------
+	fclose(m_pFile);
+	m_pFile = 0L;
+	delete[] m_pucFrame;
+	m_pucFrame = 0L;
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. The gaps between electrons are drawn from the geometric
+//    distribution of the given dose.
+// 2. The stream ends with empty runs that move past the last pixel.
+//-------------------------------------------------------------------
+int CGenEerFile::mEncodeFrame(void)
+{
+	unsigned int uiCamPixels = m_aiCamSize[0] * m_aiCamSize[1];
+	size_t tMaxBytes = (size_t)uiCamPixels * 3 / 2 + 16;
+	memset(m_pucFrame, 0, tMaxBytes);
+	m_tBitPos = 0;
+	//-----------------
+	double dLogQ = log(1.0 - fmin(fmax(m_fFmDose, 1e-6), 0.999));
+	unsigned int uiNumPixels = 0;
+	while(true)
+	{	double dRand = (rand_r(&m_uiSeed) + 1.0) / (RAND_MAX + 2.0);
+		unsigned int uiGap = (unsigned int)(log(dRand) / dLogQ);
+		if(uiNumPixels + uiGap >= uiCamPixels) break;
+		mPutRun(uiGap, true);
+		uiNumPixels += (uiGap + 1);
+		m_iNumElectrons += 1;
+	}
+	mPutRun(uiCamPixels - uiNumPixels, false);
+	//-----------------
+	int iBytes = (int)((m_tBitPos + 7) / 8);
+	if(m_iEerBits == 8) iBytes = (iBytes + 2) / 3 * 3;
+	return iBytes;
+}
+
+void CGenEerFile::mPutBits(unsigned int uiVal, int iNumBits)
+{
+	for(int i=0; i<iNumBits; i++)
+	{	if((uiVal >> i) & 1)
+		{	m_pucFrame[m_tBitPos >> 3] |= (1 << (m_tBitPos & 7));
+		}
+		m_tBitPos += 1;
+	}
+}
+
+void CGenEerFile::mPutRun(unsigned int uiRun, bool bElectron)
+{
+	unsigned int uiMaxRun = (m_iEerBits == 7) ? 127 : 255;
+	while(uiRun >= uiMaxRun)
+	{	mPutBits(uiMaxRun, m_iEerBits);
+		if(m_iEerBits == 8) mPutBits(0, 4);
+		uiRun -= uiMaxRun;
+	}
+	if(!bElectron)
+	{	mPutBits(uiRun, m_iEerBits);
+		if(m_iEerBits == 8) mPutBits(0, 4);
+		return;
+	}
+	//-----------------
+	mPutBits(uiRun, m_iEerBits);
+	mPutBits(rand_r(&m_uiSeed) & 15, 4);
+}
+
+//-------------------------------------------------------------------
+// 1. Little-endian IFD with one strip. The next-IFD offset of the
+//    previous directory is patched to point at this one.
+//-------------------------------------------------------------------
+void CGenEerFile::mWriteIfd(int iFrmBytes, unsigned int uiStripOffset)
+{
+	unsigned int uiIfdOffset = (unsigned int)ftell(m_pFile);
+	fseek(m_pFile, m_lLastNextIfd, SEEK_SET);
+	fwrite(&uiIfdOffset, 4, 1, m_pFile);
+	fseek(m_pFile, uiIfdOffset, SEEK_SET);
+	//-----------------
+	unsigned short usCompression = (m_iEerBits == 7) ? 65001 : 65000;
+	unsigned int aauiEntries[s_iNumIfdEntries][3] = 
+	{	{256, 4, (unsigned int)m_aiCamSize[0]},
+		{257, 4, (unsigned int)m_aiCamSize[1]},
+		{258, 3, 1},
+		{259, 3, usCompression},
+		{262, 3, 1},
+		{273, 4, uiStripOffset},
+		{277, 3, 1},
+		{278, 4, (unsigned int)m_aiCamSize[1]},
+		{279, 4, (unsigned int)iFrmBytes}
+	};
+	//-----------------
+	unsigned short usNumEntries = s_iNumIfdEntries;
+	fwrite(&usNumEntries, 2, 1, m_pFile);
+	for(int i=0; i<s_iNumIfdEntries; i++)
+	{	unsigned short usTag = (unsigned short)aauiEntries[i][0];
+		unsigned short usType = (unsigned short)aauiEntries[i][1];
+		unsigned int uiCount = 1;
+		unsigned int uiVal = aauiEntries[i][2];
+		fwrite(&usTag, 2, 1, m_pFile);
+		fwrite(&usType, 2, 1, m_pFile);
+		fwrite(&uiCount, 4, 1, m_pFile);
+		fwrite(&uiVal, 4, 1, m_pFile);
+	}
+	m_lLastNextIfd = ftell(m_pFile);
+	unsigned int uiNextIfd = 0;
+	fwrite(&uiNextIfd, 4, 1, m_pFile);
+}
@@ -0,0 +1,59 @@
+#include "CBenchInc.h"
+#include <string.h>
+#include <stdio.h>
+
+using namespace McAreTomo::Benchmark;
+
+CGenMdocFile::CGenMdocFile(void)
+{
+	m_tFileBytes = 0;
+}
+
+CGenMdocFile::~CGenMdocFile(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. CReadMdoc counts a tilt at the line after SubFramePath, hence
+//    DateTime after it, as SerialEM writes.
+//-------------------------------------------------------------------
+bool CGenMdocFile::DoIt
+(	const char* pcMdocFile,
+	int* piCamSize,
+	int iNumTilts,
+	float fTiltDose,
+	const char* pcMovieExt
+)
+{	FILE* pFile = fopen(pcMdocFile, "wt");
+	if(pFile == 0L)
+	{	fprintf(stderr, "CGenMdocFile: cannot create %s\n\n",
+		   pcMdocFile);
+		return false;
+	}
+	//-----------------
+	char acMain[256] = {'\0'};
+	const char* pcName = strrchr(pcMdocFile, '/');
+	strcpy(acMain, (pcName != 0L) ? &pcName[1] : pcMdocFile);
+	char* pcExt = strstr(acMain, ".mrc.mdoc");
+	if(pcExt == 0L) pcExt = strrchr(acMain, '.');
+	if(pcExt != 0L) pcExt[0] = '\0';
+	//-----------------
+	fprintf(pFile, "PixelSpacing = 1.0\n");
+	fprintf(pFile, "ImageFile = %s.mrc\n", acMain);
+	fprintf(pFile, "ImageSize = %d %d\n", piCamSize[0], piCamSize[1]);
+	fprintf(pFile, "DataMode = 1\n\n");
+	fprintf(pFile, "[T = SerialEM: synthetic tilt series]\n\n");
+	for(int i=0; i<iNumTilts; i++)
+	{	float fTilt = -60.0f + i * 2.0f;
+		fprintf(pFile, "[ZValue = %d]\n", i);
+		fprintf(pFile, "TiltAngle = %.2f\n", fTilt);
+		fprintf(pFile, "ExposureDose = %.3f\n", fTiltDose);
+		fprintf(pFile, "SubFramePath = X:\\Frames\\%s_%03d_%.2f%s\n",
+		   acMain, i + 1, fTilt, pcMovieExt);
+		fprintf(pFile, "DateTime = 01-Jan-25  12:%02d:%02d\n\n",
+		   (i / 60) % 60, i % 60);
+	}
+	m_tFileBytes = (size_t)ftell(pFile);
+	fclose(pFile);
+	return true;
+}
@@ -40,6 +40,8 @@ CAtInput::CAtInput(void)
 	strcpy(m_acFlipIntTag, "-FlipInt");
 	strcpy(m_acSartTag, "-Sart");
 	strcpy(m_acWbpTag, "-Wbp");
+	strcpy(m_acCpuReconTag, "-CpuRecon");
+	strcpy(m_acSlabMemTag, "-SlabMem");
 	strcpy(m_acAtPatchTag, "-AtPatch");
 	strcpy(m_acOutXFTag, "-OutXF");
 	strcpy(m_acAlignTag, "-Align");
@@ -69,6 +71,8 @@ CAtInput::CAtInput(void)
 	m_aiSartParam[0] = 20;
 	m_aiSartParam[1] = 5;
 	m_iWbp = 0;
+	m_iCpuRecon = 0;
+	m_fSlabMem = 0.0f;
 	m_iOutXF = 0;
 	m_iAlign = 1;
 	m_fDarkTol = 0.7f;
@@ -168,6 +172,24 @@ void CAtInput::ShowTags(void)
 	printf("   1. By specifying 1, weighted back projection is enabled\n");
 	printf("      to reconstruct volume.\n\n");
 	//-----------------
+	printf("%-10s\n", m_acCpuReconTag);
+	printf("   1. By specifying 1, WBP and SART reconstructions run on\n");
+	printf("      CPU threads instead of GPU. The cores are shared\n");
+	printf("      evenly among the GPUs. The default is 0.\n");
+	printf("   2. By specifying 2, SART reconstruction runs on both\n");
+	printf("      GPU and CPU threads that share the y-slices. WBP\n");
+	printf("      runs on GPU.\n");
+	printf("   3. By specifying 3, each tilt series is reconstructed on\n");
+	printf("      CPU threads as with 1 if other tilt series are waiting\n");
+	printf("      for a GPU when it starts, otherwise on GPU.\n\n");
+	//-----------------
+	printf("%-10s\n", m_acSlabMemTag);
+	printf("   1. Memory in GB for reconstructing the volume in y-slabs.\n");
+	printf("      Each slab is written into the output MRC file before\n");
+	printf("      the next one is reconstructed so that the whole\n");
+	printf("      volume is never held in memory.\n");
+	printf("   2. The default 0 reconstructs the whole volume at once.\n\n");
+	//-----------------
 	printf("%-10s\n", m_acDarkTolTag);
 	printf("   1. Set tolerance for removing dark images. The range is\n"
 	   "      in (0, 1). The default value is 0.7. The higher value is\n"
@@ -274,6 +296,16 @@ void CAtInput::Parse(int argc, char* argv[])
 	if(aiRange[1] > 1) aiRange[1] = 1;
 	aParseArgs.GetVals(aiRange, &m_iWbp);
 	//-----------------------------------
+	aParseArgs.FindVals(m_acCpuReconTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iCpuRecon);
+	if(m_iCpuRecon < 0) m_iCpuRecon = 0;
+	else if(m_iCpuRecon > 3) m_iCpuRecon = 3;
+	//-----------------------------------
+	aParseArgs.FindVals(m_acSlabMemTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_fSlabMem);
+	//-----------------------------------
 	aParseArgs.FindVals(m_acAtPatchTag, aiRange);
 	if(aiRange[1] > 2) aiRange[1] = 2;
 	aParseArgs.GetVals(aiRange, m_aiAtPatches);
@@ -353,6 +385,8 @@ void CAtInput::mPrint(void)
 	printf("%-10s  %d  %d\n", m_acSartTag, 
 	   m_aiSartParam[0], m_aiSartParam[1]);
 	printf("%-10s  %d\n", m_acWbpTag, m_iWbp);
+	printf("%-10s  %d\n", m_acCpuReconTag, m_iCpuRecon);
+	printf("%-10s  %.2f\n", m_acSlabMemTag, m_fSlabMem);
 	//-----------------
 	printf("%-10s  %d  %d\n", m_acAtPatchTag, m_aiAtPatches[0],
 	   m_aiAtPatches[1]);
@@ -44,9 +44,16 @@ CInput::CInput(void)
 	strcpy(m_acCmdTag, "-Cmd");
 	strcpy(m_acResumeTag, "-Resume");
 	strcpy(m_acSerialTag, "-Serial");
+	strcpy(m_acDirectIOTag, "-DirectIO");
+	strcpy(m_acMmapLoadTag, "-MmapLoad");
+	strcpy(m_acTraceTag, "-Trace");
+	strcpy(m_acStreamTag, "-Stream");
+	strcpy(m_acStageCacheTag, "-StageCache");
+	strcpy(m_acHostScoreTag, "-HostScore");
 	//-----------------
 	m_iNumGpus = 0;
 	m_piGpuIDs = 0L;
+	memset(m_acTmpDir, 0, sizeof(m_acTmpDir));
 	//-----------------
 	m_iKv = 300;
 	m_fCs = 2.7f;
@@ -57,6 +64,12 @@ CInput::CInput(void)
 	m_iCmd = 0;
 	m_iResume = 0;
 	m_iSerial = 0;
+	m_iDirectIO = 0;
+	m_iMmapLoad = 1;
+	m_iTrace = 0;
+	m_iStream = 0;
+	m_iStageCache = 0;
+	m_iHostScore = 0;
 }
 
 CInput::~CInput(void)
@@ -139,6 +152,70 @@ void CInput::ShowTags(void)
 	   "     files in MdocDone.txt file in the output folder.\n\n",
 	   m_acResumeTag); 
 	//-----------------
+	printf("%-15s\n"
+	   "  1. Default 0 writes MRC tilt series and tomograms through\n"
+	   "     the page cache.\n"
+	   "  2. -DirectIO 1 writes them with O_DIRECT, which avoids\n"
+	   "     filling the page cache with multi-GB tomograms on\n"
+	   "     parallel file systems. It falls back to buffered\n"
+	   "     writes where O_DIRECT is not supported.\n\n",
+	   m_acDirectIOTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. How MRC tilt series (-Cmd 1, 2, 3 and mrc inputs) and\n"
+	   "     gain/dark references are loaded.\n"
+	   "  2. 0 reads them section by section with read().\n"
+	   "  3. 1 (default) memory-maps the files and converts the\n"
+	   "     sections to float in one pass.\n"
+	   "  4. 2 also uses float tilt series in place from the\n"
+	   "     mapping instead of copying them. The files must not\n"
+	   "     be modified while they are processed.\n\n",
+	   m_acMmapLoadTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Default 0 records no trace.\n"
+	   "  2. -Trace 1 records the time spent in each processing\n"
+	   "     stage, loader and writer of every GPU and saves it in\n"
+	   "     Trace.json in the output folder at exit. The file can\n"
+	   "     be opened in chrome://tracing or ui.perfetto.dev.\n\n",
+	   m_acTraceTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Default 0 starts a mdoc file once it is complete and\n"
+	   "     motion corrects all its movies together.\n"
+	   "  2. -Stream N (seconds) starts a mdoc file as soon as it\n"
+	   "     lists a tilt, with -Cmd 0. Each movie is motion\n"
+	   "     corrected once it has been saved, while the rest of\n"
+	   "     the tilt series is being collected.\n"
+	   "  3. The tilt series is aligned and reconstructed when all\n"
+	   "     its listed movies are corrected and the mdoc file has\n"
+	   "     not changed for N seconds. N should be longer than the\n"
+	   "     time taken to collect one tilt.\n\n",
+	   m_acStreamTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Default 0 caches nothing.\n"
+	   "  2. -StageCache 1 saves the CTF estimation and alignment\n"
+	   "     of each tilt series in StageCache in the output\n"
+	   "     folder. A rerun on the same data with the same CTF\n"
+	   "     and alignment parameters loads them instead, e.g.\n"
+	   "     when only -VolZ or -AtBin is changed.\n"
+	   "  3. -StageCache 2 also caches the motion corrected sums\n"
+	   "     of each movie, which takes about as much disk space\n"
+	   "     as the tilt series.\n"
+	   "  4. Entries are keyed by the input data and parameters.\n"
+	   "     The folder can be deleted at any time.\n\n",
+	   m_acStageCacheTag);
+	//-----------------
+	printf("%-15s\n"
+	   "  1. Default 0 scores the CTF and common line candidates\n"
+	   "     on the GPU.\n"
+	   "  2. -HostScore N scores them on N CPU threads of each\n"
+	   "     GPU instead, which frees the GPU for the other\n"
+	   "     stages when there are enough CPU cores. The rest of\n"
+	   "     the processing stays on the GPU.\n\n",
+	   m_acHostScoreTag);
+	//-----------------
 	printf("%-15s\n", m_acGpuIDTag);
 	printf("   GPU IDs. Default 0.\n");
 	printf("   For multiple GPUs, separate IDs by space.\n");
@@ -227,6 +304,31 @@ void CInput::Parse(int argc, char* argv[])
 	if(aiRange[1] > 1) aiRange[1] = 1;
 	aParseArgs.GetVals(aiRange, &m_iResume);
 	//-----------------
+	aParseArgs.FindVals(m_acDirectIOTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iDirectIO);
+	//-----------------
+	aParseArgs.FindVals(m_acMmapLoadTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iMmapLoad);
+	//-----------------
+	aParseArgs.FindVals(m_acTraceTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iTrace);
+	//-----------------
+	aParseArgs.FindVals(m_acStreamTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iStream);
+	//-----------------
+	aParseArgs.FindVals(m_acStageCacheTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iStageCache);
+	//-----------------
+	aParseArgs.FindVals(m_acHostScoreTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iHostScore);
+	if(m_iHostScore < 0) m_iHostScore = 0;
+	//-----------------
 	mExtractInDir();
 	mAddEndSlash(m_acOutDir);
 	mAddEndSlash(m_acLogDir);
@@ -255,6 +357,12 @@ void CInput::mPrint(void)
 	printf("%-15s  %d\n", m_acResumeTag, m_iResume);
 	//-----------------
 	printf("%-15s  %d\n", m_acSplitSumTag, m_iSplitSum);
+	printf("%-15s  %d\n", m_acDirectIOTag, m_iDirectIO);
+	printf("%-15s  %d\n", m_acMmapLoadTag, m_iMmapLoad);
+	printf("%-15s  %d\n", m_acTraceTag, m_iTrace);
+	printf("%-15s  %d\n", m_acStreamTag, m_iStream);
+	printf("%-15s  %d\n", m_acStageCacheTag, m_iStageCache);
+	printf("%-15s  %d\n", m_acHostScoreTag, m_iHostScore);
 	//-----------------
 	printf("%-15s", m_acGpuIDTag);
 	for(int i=0; i<m_iNumGpus; i++)
@@ -40,6 +40,12 @@ public:
 	int m_iCmd;
 	int m_iResume;
 	int m_iSerial;
+	int m_iDirectIO;
+	int m_iMmapLoad;
+	int m_iTrace;
+	int m_iStream;
+	int m_iStageCache;
+	int m_iHostScore;
 	//-----------------
 	char m_acInPrefixTag[32];
 	char m_acInSuffixTag[32];
@@ -59,6 +65,12 @@ public:
 	char m_acCmdTag[32];
 	char m_acResumeTag[32];
 	char m_acSerialTag[32];
+	char m_acDirectIOTag[32];
+	char m_acMmapLoadTag[32];
+	char m_acTraceTag[32];
+	char m_acStreamTag[32];
+	char m_acStageCacheTag[32];
+	char m_acHostScoreTag[32];
 private:
         CInput(void);
 	void mExtractInDir(void);
@@ -97,7 +109,10 @@ public:
 	float m_afMag[3];
 	int m_iInFmMotion;
 	int m_iEerSampling;
+	int m_iEerStream;
 	int m_iTiffOrder;
+	int m_iCpuFmInt;
+	int m_iPrefetch;
 	int m_iCorrInterp;
 	//-----------------
 	char m_acGainFileTag[32];
@@ -116,7 +131,10 @@ public:
 	char m_acMagTag[32];
 	char m_acInFmMotionTag[32];
 	char m_acEerSamplingTag[32];
+	char m_acEerStreamTag[32];
 	char m_acTiffOrderTag[32];
+	char m_acCpuFmIntTag[32];
+	char m_acPrefetchTag[32];
 	char m_acCorrInterpTag[32];
 private:
         CMcInput(void);
@@ -154,6 +172,8 @@ public:
 	int m_iFlipInt;
 	int m_aiSartParam[2];
 	int m_iWbp;
+	int m_iCpuRecon;
+	float m_fSlabMem;
 	int m_aiAtPatches[2];
 	int m_aiCropVol[2];
 	int m_iOutXF;
@@ -178,6 +198,8 @@ public:
 	char m_acFlipIntTag[32];
 	char m_acSartTag[32];
 	char m_acWbpTag[32];
+	char m_acCpuReconTag[32];
+	char m_acSlabMemTag[32];
 	char m_acAtPatchTag[32];
 	char m_acOutXFTag[32];
 	char m_acAlignTag[32];
@@ -288,25 +310,38 @@ class CProcessThread : public Util_Thread
 public:
 	static void CreateInstances(int iNumGpus);
 	static void DeleteInstances(void);
-	static CProcessThread* GetFreeThread(void);
+	static void StartAll(void);
 	static bool WaitExitAll(float fSeconds);
 	~CProcessThread(void);
-	int DoIt(void);
 	void ThreadMain(void);
 	int m_iNthGpu;
 private:
 	CProcessThread(void);
+	bool mCheckInput(void);
+	void mSelectRecon(void);
+	void mProcessJob(void);
 	void mProcessTsPackage(void);
 	void mProcessMovies(void);
+	bool mStreamMovies(void);
+	void mSaveTiltSeries(void);
 	bool mLoadTiltSeries(void);
+	void mCreateBufferPool(void);
 	//-----------------
+	void mSetupMovie(int iTilt, int iSlot);
+	bool mLoadMovie(int iTilt, int iSlot);
 	void mProcessMovie(int iTilt);
-	void mAssembleTiltSeries(int iTilt);
+	void mGenMovieKey(int iTilt, MD::CStageKey* pKey);
+	bool mMovieCached(int iTilt);
+	bool mLoadMovieStage(int iTilt);
+	void mSaveMovieStage(int iTilt);
+	void mAssembleTiltSeries(int iTilt, int iSec);
 	void mProcessTiltSeries(void);
+	bool mWaitTilt(int iTilt);
+	bool mWaitMovie(int iTilt, float fMaxSecs);
+	bool mMdocSettled(void);
 	//-----------------
 	static CProcessThread* m_pInstances;
 	static int m_iNumGpus;
-	static std::unordered_map<std::string, int> *m_pMdocFiles;
 };
 
 class CGenStarFile
@@ -337,8 +372,6 @@ public:
 	CMcAreTomoMain(void);
 	~CMcAreTomoMain(void);
 	bool DoIt(void);
-private:
-	void mProcess(void);
 };
 
 }
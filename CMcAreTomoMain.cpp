@@ -20,6 +20,18 @@ CMcAreTomoMain::CMcAreTomoMain(void)
 {
 	CInput* pInput = CInput::GetInstance();
 	int iNumGpus = pInput->m_iNumGpus;
+	//-----------------------------------------------
+	// 1) The tracer starts before any thread so that
+	// the writer threads get their names in the trace.
+	//-----------------------------------------------
+	if(pInput->m_iTrace != 0)
+	{	char acTraceFile[256] = {'\0'};
+		strcpy(acTraceFile, pInput->m_acOutDir);
+		strcat(acTraceFile, "Trace.json");
+		MD::CTracer* pTracer = MD::CTracer::GetInstance();
+		pTracer->Start(acTraceFile, iNumGpus);
+		pTracer->NameThread("Main");
+	}
 	//-----------------
 	MD::CDuInstances::CreateInstances(iNumGpus);
 	MotionCor::CMcInstances::CreateInstances(iNumGpus);
@@ -51,6 +63,9 @@ bool CMcAreTomoMain::DoIt(void)
 	// processed mdoc files. If yes, this mdoc will not be 
 	// processed.
 	//---------------------------------------------------------
+	CInput* pInput = CInput::GetInstance();
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	pScheduler->Setup(pInput->m_iNumGpus);
 	s_pStackFolder = MD::CStackFolder::GetInstance();
 	bool bSuccess = s_pStackFolder->ReadFiles();
 	if(!bSuccess)
@@ -62,7 +77,6 @@ bool CMcAreTomoMain::DoIt(void)
 	// Use the first GPU since dark and gain references
 	// are allocated in pinned memory.
 	//--------------------------------------------------
-	CInput* pInput = CInput::GetInstance();
 	cudaSetDevice(pInput->m_piGpuIDs[0]);
 	//-----------------------------------
 	// load gain and/or dark references
@@ -72,46 +86,21 @@ bool CMcAreTomoMain::DoIt(void)
 	{	MM::CMotionCorMain::LoadRefs();	
 	}
 	//--------------------------------------------------------
-	// wait a new movie for 10 minutes and quit if not found.
+	// 1) The processing threads wait on the scheduler for
+	// tilt series. 2) CStackFolder keeps feeding it until
+	// no new file shows up within -Serial seconds.
 	//--------------------------------------------------------
-	bool bExit = false;
-	while(true)
-	{	int iQueueSize = s_pStackFolder->GetQueueSize();
-		if(iQueueSize > 0) 
-		{	mProcess();
-			if(pInput->m_iCmd == 0)
-			{	s_pStackFolder->WaitForExit(5.0f);
-			}
-			continue;
-		}
-		bExit = s_pStackFolder->WaitForExit(1.0f);
-		if(bExit) break;
-	}
-	printf("All input files have been processed, "
+	CProcessThread::StartAll();
+	s_pStackFolder->WaitForExit(-1.0f);
+	pScheduler->Close();
+	printf("All input files have been found, "
 	   "waiting processing to finish.\n\n");
 	//-----------------
 	while(true)
-	{	bExit = CProcessThread::WaitExitAll(1.0f);
+	{	bool bExit = CProcessThread::WaitExitAll(1.0f);
 		if(bExit) break;
 	}
+	pScheduler->PrintStats();
 	printf("All threads have finished, program exits.\n\n");
 	return true;
 }
-
-void CMcAreTomoMain::mProcess(void)
-{
-	CProcessThread* pProcessThread = CProcessThread::GetFreeThread();
-	if(pProcessThread == 0L)
-	{	printf("All GPUs are used, wait ......\n\n");
-		return;
-	}
-	int iNthGpu = pProcessThread->m_iNthGpu; 
-	//-----------------
-	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(iNthGpu);
-	char* pcInFile = s_pStackFolder->GetFile(true);
-	pTsPackage->SetInFile(pcInFile);
-	if(pcInFile != 0L) delete[] pcInFile;
-	//-----------------
-	pProcessThread->DoIt();
-}
-
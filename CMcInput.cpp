@@ -41,7 +41,10 @@ CMcInput::CMcInput(void)
 	strcpy(m_acMagTag, "-Mag");
 	strcpy(m_acInFmMotionTag, "-InFmMotion");
 	strcpy(m_acEerSamplingTag, "-EerSampling");
+	strcpy(m_acEerStreamTag, "-EerStream");
 	strcpy(m_acTiffOrderTag, "-TiffOrder");
+	strcpy(m_acCpuFmIntTag, "-CpuFmInt");
+	strcpy(m_acPrefetchTag, "-Prefetch");
 	//------------------
 	m_aiNumPatches[0] = 0;
 	m_aiNumPatches[1] = 0;
@@ -60,7 +63,10 @@ CMcInput::CMcInput(void)
 	m_afMag[2] = 0.0f;
 	m_iInFmMotion = 0;
 	m_iEerSampling = 1;
+	m_iEerStream = 256;
 	m_iTiffOrder = 1;
+	m_iCpuFmInt = 1;
+	m_iPrefetch = 1;
 	m_iCorrInterp = 0;
 }
 
@@ -154,6 +160,23 @@ void CMcInput::ShowTags(void)
 	printf("%-15s\n", m_acInFmMotionTag);
 	printf("   1. 1 - Account for in-frame motion.\n");
 	printf("      0 - Do not account for in-frame motion.\n\n");
+	//-----------------
+	printf("%-15s\n", m_acEerStreamTag);
+	printf("   1. Number of EER frames kept in memory while an EER\n");
+	printf("      file is read and rendered concurrently, default\n");
+	printf("      256.\n");
+	printf("   2. 0 loads the whole EER file before rendering.\n\n");
+	//-----------------
+	printf("%-15s\n", m_acCpuFmIntTag);
+	printf("   1. 1 - Integrate frames of 8-bit TIFF movies on CPU\n");
+	printf("          threads, default.\n");
+	printf("      0 - Integrate them on GPU.\n\n");
+	//-----------------
+	printf("%-15s\n", m_acPrefetchTag);
+	printf("   1. 1 - Load the next movie of the tilt series while\n");
+	printf("          the current one is motion corrected, default.\n");
+	printf("          This holds two raw stacks per GPU in memory.\n");
+	printf("      0 - Load each movie when it is processed.\n\n");
 }
 
 void CMcInput::Parse(int argc, char* argv[])
@@ -182,6 +205,11 @@ void CMcInput::Parse(int argc, char* argv[])
 	if(aiRange[1] > 1) aiRange[1] = 1;
 	aParseArgs.GetVals(aiRange, &m_iEerSampling);
 	//-----------------
+	aParseArgs.FindVals(m_acEerStreamTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iEerStream);
+	if(m_iEerStream < 0) m_iEerStream = 0;
+	//-----------------
 	aParseArgs.FindVals(m_acPatchesTag, aiRange);
 	aParseArgs.GetVals(aiRange, m_aiNumPatches);
 	if(m_aiNumPatches[0] <= 1) m_aiNumPatches[0] = 0;
@@ -242,6 +270,14 @@ void CMcInput::Parse(int argc, char* argv[])
 	if(aiRange[1] > 1) aiRange[1] = 1;
 	aParseArgs.GetVals(aiRange, &m_iTiffOrder);
 	//-----------------
+	aParseArgs.FindVals(m_acCpuFmIntTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iCpuFmInt);
+	//-----------------
+	aParseArgs.FindVals(m_acPrefetchTag, aiRange);
+	if(aiRange[1] > 1) aiRange[1] = 1;
+	aParseArgs.GetVals(aiRange, &m_iPrefetch);
+	//-----------------
 	aParseArgs.FindVals(m_acCorrInterpTag, aiRange);
 	if(aiRange[1] > 1) aiRange[1] = 1;
 	aParseArgs.GetVals(aiRange, &m_iCorrInterp);
@@ -288,6 +324,7 @@ void CMcInput::mPrint(void)
 	printf("%-15s  %s\n", m_acDarkMrcTag, m_acDarkMrc);
 	printf("%-15s  %s\n", m_acDefectFileTag, m_acDefectFile);
 	printf("%-15s  %d\n", m_acEerSamplingTag, m_iEerSampling);
+	printf("%-15s  %d\n", m_acEerStreamTag, m_iEerStream);
 	printf("%-15s  %d  %d  %d\n", m_acPatchesTag,
            m_aiNumPatches[0], m_aiNumPatches[1], m_aiNumPatches[2]);
 	printf("%-15s  %d\n", m_acIterTag, m_iMcIter);
@@ -303,6 +340,8 @@ void CMcInput::mPrint(void)
 	   m_afMag[1], m_afMag[2]);
 	printf("%-15s  %d\n", m_acInFmMotionTag, m_iInFmMotion);
 	printf("%-15s  %d\n", m_acTiffOrderTag, m_iTiffOrder);
+	printf("%-15s  %d\n", m_acCpuFmIntTag, m_iCpuFmInt);
+	printf("%-15s  %d\n", m_acPrefetchTag, m_iPrefetch);
 	printf("%-15s  %d\n", m_acCorrInterpTag, m_iCorrInterp);
 	printf("\n\n");
 }
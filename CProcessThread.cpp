@@ -6,6 +6,8 @@
 #include <Util/Util_Time.h>
 #include <memory.h>
 #include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <cufft.h>
@@ -15,7 +17,6 @@ using namespace McAreTomo;
 
 CProcessThread* CProcessThread::m_pInstances = 0L;
 int CProcessThread::m_iNumGpus = 0;
-std::unordered_map<std::string, int>* CProcessThread::m_pMdocFiles = 0L;
 
 void CProcessThread::CreateInstances(int iNumGpus)
 {
@@ -28,11 +29,6 @@ void CProcessThread::CreateInstances(int iNumGpus)
 	{	m_pInstances[i].m_iNthGpu = i;
 	}
 	m_iNumGpus = iNumGpus;
-	//--------------------------------------------------
-	// store reading-failed mdoc files and the number
-	// of attempts.
-	//--------------------------------------------------
-	m_pMdocFiles = new std::unordered_map<std::string, int>;
 }
 
 void CProcessThread::DeleteInstances(void)
@@ -41,29 +37,17 @@ void CProcessThread::DeleteInstances(void)
 	delete[] m_pInstances;
 	m_pInstances = 0L;
 	m_iNumGpus = 0;
-	//-----------------
-	m_pMdocFiles->clear();
-	delete m_pMdocFiles;
-	m_pMdocFiles = 0L;	
 }
 
-CProcessThread* CProcessThread::GetFreeThread(void)
+//--------------------------------------------------------------------
+// 1. One thread per GPU is started. Each takes tilt series from
+//    CTsScheduler until the scheduler is closed and drained.
+//--------------------------------------------------------------------
+void CProcessThread::StartAll(void)
 {
-	int iWaitTime = 0.0f;
-	while(true)
-	{	for(int i=0; i<m_iNumGpus; i++)
-		{	CProcessThread* pThread = &m_pInstances[i];
-			if(!pThread->IsAlive()) return pThread;
-		}
-		for(int i=0; i<m_iNumGpus; i++)
-		{	CProcessThread* pThread = &m_pInstances[i];
-			pThread->WaitForExit(0.1f);
-			if(!pThread->IsAlive()) return pThread;
-			else iWaitTime += 0.1f;
-		}
-		if(iWaitTime > 600.0f) break;
+	for(int i=0; i<m_iNumGpus; i++)
+	{	m_pInstances[i].Start();
 	}
-	return 0L;
 }
 
 bool CProcessThread::WaitExitAll(float fSeconds)
@@ -86,79 +70,105 @@ CProcessThread::~CProcessThread(void)
 {
 }
 
-int CProcessThread::DoIt(void)
+void CProcessThread::ThreadMain(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	cudaSetDevice(pInput->m_piGpuIDs[m_iNthGpu]);
+	if(pInput->m_iHostScore > 0)
+	{	MU::SetBackend(MU::scoreBackend, pInput->m_iHostScore);
+	}
+	char acName[64] = {'\0'};
+	sprintf(acName, "Process GPU %d", m_iNthGpu);
+	MD::CTracer::GetInstance()->NameThread(acName);
+	//-----------------
+	MD::CTsScheduler* pScheduler = MD::CTsScheduler::GetInstance();
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
+	char acInFile[256] = {'\0'};
+	while(pScheduler->WaitJob(m_iNthGpu, acInFile))
+	{	pTsPackage->SetInFile(acInFile);
+		mSelectRecon();
+		if(mCheckInput()) mProcessJob();
+		else pScheduler->Defer(m_iNthGpu);
+		pScheduler->JobDone(m_iNthGpu);
+	}
+	printf("GPU %d: process thread exiting.\n\n", m_iNthGpu);
+}
+
+//--------------------------------------------------------------------
+// 1. MRC (.mrc or .st) inputs bypass loading mdoc files.
+// 2. An mdoc file that cannot be loaded yet, for example when it
+//    is still being written, is returned to the scheduler.
+// 3. -Stream with -Cmd 0 starts a mdoc file once it can be opened,
+//    even before it lists a tilt. mStreamMovies waits for them.
+//--------------------------------------------------------------------
+bool CProcessThread::mCheckInput(void)
 {
-	//-----------------------------------------------
-	// 1) Input is a MRC file, bypass loading mdoc.
-	//-----------------------------------------------
 	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	char* pcExt = strrchr(pTsPackage->m_acInFile, '.');
-	if(strcasestr(pcExt, ".mrc") != 0L)
-	{	this->Start();
-		return 1;
+	if(pcExt != 0L)
+	{	if(strcasestr(pcExt, ".mrc") != 0L) return true;
+		if(strcasestr(pcExt, ".st") != 0L) return true;
 	}
-	//-----------------------------------------------
-	// 2) Input is a st file, which is also a MRC
-	// file, bypass loading mdoc file.
-	//-----------------------------------------------
-	if(strcasestr(pcExt, ".st") != 0L)
-        {       this->Start();
-                return 1;
-        }
-	//-----------------------------------------------
-	// 1) If the input is a mdoc file and can be 
-	// loaded, start the processing thread.
-	//-----------------------------------------------
+	//-----------------
+	CInput* pInput = CInput::GetInstance();
 	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
-	bool bLoaded = pReadMdoc->DoIt(pTsPackage->m_acInFile);
-	if(bLoaded)
-	{	this->Start();
-		return 1;
-	}
-	//-----------------------------------------------
-	// 2) If the mdoc cannot be loaded, then try to
-	// load it some other time.
-	//-----------------------------------------------
-	MD::CStackFolder* pStackFolder = MD::CStackFolder::GetInstance();
-	auto item = m_pMdocFiles->find(pTsPackage->m_acInFile);
-	if(item == m_pMdocFiles->end())
-	{	m_pMdocFiles->insert({pTsPackage->m_acInFile, 1});
-		pStackFolder->PushFile(pTsPackage->m_acInFile);
-		return 0;
-	}
-	//-----------------------------------------------
-	// 3) Try reload no more than 10 times.
-	//-----------------------------------------------
-	if(item->second < 10)
-	{	item->second = item->second + 1;
-		pStackFolder->PushFile(pTsPackage->m_acInFile);
-		return 0;
+	if(pInput->m_iStream > 0 && pInput->m_iCmd == 0)
+	{	return pReadMdoc->Open(pTsPackage->m_acInFile);
 	}
+	return pReadMdoc->DoIt(pTsPackage->m_acInFile);
+}
+
+//--------------------------------------------------------------------
+// 1. -CpuRecon 3 picks the reconstruction backend of each tilt
+//    series when it is dispatched. While other tilt series wait
+//    for a GPU, it is reconstructed on CPU threads so that the GPU
+//    can take the next one sooner. Otherwise it stays on the GPU.
+//--------------------------------------------------------------------
+void CProcessThread::mSelectRecon(void)
+{
+	CAtInput* pAtInput = CAtInput::GetInstance();
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
+	pTsPackage->m_iCpuRecon = pAtInput->m_iCpuRecon;
+	if(pAtInput->m_iCpuRecon != 3) return;
 	//-----------------
-	printf("Warning: failed to read mdoc file.\n");
-	printf("   mdoc file: %s\n\n", pTsPackage->m_acInFile);
-	return -1;
+	int iQueued = MD::CTsScheduler::GetInstance()->GetQueueSize();
+	pTsPackage->m_iCpuRecon = (iQueued > 0) ? 1 : 0;
+	printf("GPU %d: %d tilt series queued, reconstruct on %s.\n\n",
+	   m_iNthGpu, iQueued, (iQueued > 0) ? "CPU" : "GPU");
 }
 
-void CProcessThread::ThreadMain(void)
+void CProcessThread::mProcessJob(void)
 {
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
 	pTimeStamp->Record("ProcessStart");
         pTimeStamp->Save();
-	//---------------------------
-	CInput* pInput = CInput::GetInstance();
-	cudaSetDevice(pInput->m_piGpuIDs[m_iNthGpu]);
 	//-----------------
 	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
 	MD::CLogFiles* pLogFiles = MD::CLogFiles::GetInstance(m_iNthGpu);
 	pLogFiles->Create(pReadMdoc->m_acMdocFile);
 	//-----------------	
+	MD::CTraceSpan aSpan("CProcessThread::mProcessJob", m_iNthGpu);
 	mProcessTsPackage();
+	//-----------------------------------------------
+	// 1) The mdoc is marked done only when all the
+	// output files of the series are on disk so
+	// that -Resume redoes a series cut short.
+	//-----------------------------------------------
+	MD::CAsyncWriter* pAsyncWriter = MD::CAsyncWriter::GetInstance();
+	bool bClear = true;
+	MD::CTraceSpan aWaitSpan("WaitOutput", m_iNthGpu);
+	bool bWritten = pAsyncWriter->WaitGpu(m_iNthGpu, bClear);
+	if(bWritten)
+	{	MD::CSaveMdocDone* pSaveMdocDone = 
+		   MD::CSaveMdocDone::GetInstance();
+		pSaveMdocDone->DoIt(pReadMdoc->m_acMdocFile);
+	}
+	else
+	{	fprintf(stderr, "GPU %d: output of %s incomplete, "
+		   "not marked done.\n\n", m_iNthGpu, 
+		   pReadMdoc->m_acMdocFile);
+	}
 	//-----------------
-	MD::CSaveMdocDone* pSaveMdocDone = MD::CSaveMdocDone::GetInstance();
-	pSaveMdocDone->DoIt(pReadMdoc->m_acMdocFile);
-	//-----------------
-	printf("GPU %d: process thread exiting.\n\n", m_iNthGpu);
 	pTimeStamp->Record("ProcessExit");
 	pTimeStamp->Save();
 }
@@ -175,7 +185,8 @@ void CProcessThread::mProcessTsPackage(void)
 	//-----------------
 	CInput* pInput = CInput::GetInstance();
 	if(pInput->m_iCmd == 0 && !bMrcFile) 
-	{	mProcessMovies();
+	{	if(pInput->m_iStream <= 0) mProcessMovies();
+		else if(!mStreamMovies()) return;
 		mProcessTiltSeries();
 	}
 	else if(pInput->m_iCmd >= 1 || bMrcFile)
@@ -191,18 +202,129 @@ void CProcessThread::mProcessTsPackage(void)
 
 void CProcessThread::mProcessMovies(void)
 {
+	MD::CTraceSpan aSpan("CProcessThread::mProcessMovies", m_iNthGpu);
 	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
 	pTimeStamp->Record("ProcessMovies:Start");
 	//---------------------------
 	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
-	//---------------------------
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	//--------------------------------------------------
+	// 1) Movie i+1 is loaded into the prefetch slot
+	// while movie i is motion corrected on the GPU.
+	// 2) Wait swaps it into the slot of this GPU.
+	//--------------------------------------------------
+	MotionCor::CPrefetchMovie aPrefetch;
+	int iSlot = MotionCor::CPrefetchMovie::GetSlot(m_iNthGpu);
+	//--------------------------------------------------
+	// 1) -StageCache 2: movies whose sums are cached
+	// are neither loaded nor prefetched.
+	//--------------------------------------------------
+	bool bCorrected = false;
 	for(int i=0; i<pReadMdoc->m_iNumTilts; i++)
-	{	mProcessMovie(i);
-		mAssembleTiltSeries(i);
+	{	bool bLoaded = false, bCached = false;
+		if(aPrefetch.bPrefetched(i)) bLoaded = aPrefetch.Wait();
+		else if(!(bCached = mLoadMovieStage(i)))
+		{	bLoaded = mLoadMovie(i, m_iNthGpu);
+		}
+		//--------------------
+		int iNext = i + 1;
+		if(pMcInput->m_iPrefetch != 0 && 
+		   iNext < pReadMdoc->m_iNumTilts &&
+		   !mMovieCached(iNext))
+		{	mSetupMovie(iNext, iSlot);
+			aPrefetch.Run(iNext, m_iNthGpu);
+		}
+		//--------------------
+		if(bLoaded) 
+		{	mProcessMovie(i);
+			mSaveMovieStage(i);
+			bCorrected = true;
+		}
+		mAssembleTiltSeries(i, i);
 	}
+	if(!bCorrected) mCreateBufferPool();
 	pTsPackage->SetLoaded(true);
 	pTimeStamp->Record("ProcessMovies:End");
+	aSpan.AddItems(pReadMdoc->m_iNumTilts);
+	mSaveTiltSeries();
+}
+
+//--------------------------------------------------------------------
+// 1. -Stream: tilts are motion corrected in the order they are
+//    listed in the mdoc file, each once its movie has been saved.
+//    The mdoc file is read again for new tilts in between.
+// 2. The acquisition is over when all the listed tilts are done
+//    and the mdoc file has not changed for -Stream seconds.
+// 3. A tilt whose movie is not saved in time or fails to load is
+//    left out. iNumSecs counts the tilts in the tilt series.
+//--------------------------------------------------------------------
+bool CProcessThread::mStreamMovies(void)
+{
+	MD::CTraceSpan aSpan("CProcessThread::mStreamMovies", m_iNthGpu);
+	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
+	pTimeStamp->Record("StreamMovies:Start");
+	//---------------------------
+	CInput* pInput = CInput::GetInstance();
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	//---------------------------
+	MotionCor::CPrefetchMovie aPrefetch;
+	int iSlot = MotionCor::CPrefetchMovie::GetSlot(m_iNthGpu);
+	int iNumTilts = 0, iNumSecs = 0;
+	//--------------------------------------------------
+	// 1) The next movie is only prefetched when it has
+	// already been saved, so that prefetching never
+	// waits for the microscope.
+	//--------------------------------------------------
+	while(mWaitTilt(iNumTilts))
+	{	int i = iNumTilts;
+		bool bLoaded = false;
+		if(aPrefetch.bPrefetched(i)) bLoaded = aPrefetch.Wait();
+		else if(mWaitMovie(i, (float)pInput->m_iStream))
+		{	bLoaded = mLoadMovie(i, m_iNthGpu);
+		}
+		else
+		{	printf("GPU %d: Warning: %s has not been saved, "
+			   "skip.\n\n", m_iNthGpu, 
+			   pReadMdoc->GetFrameFileName(i));
+		}
+		//--------------------
+		int iNext = i + 1;
+		pReadMdoc->ReadNew();
+		if(pMcInput->m_iPrefetch != 0 && 
+		   iNext < pReadMdoc->m_iNumTilts &&
+		   mWaitMovie(iNext, 0.0f))
+		{	mSetupMovie(iNext, iSlot);
+			aPrefetch.Run(iNext, m_iNthGpu);
+		}
+		//--------------------
+		if(bLoaded)
+		{	mProcessMovie(i);
+			mAssembleTiltSeries(i, iNumSecs);
+			iNumSecs += 1;
+		}
+		iNumTilts += 1;
+	}
+	pTimeStamp->Record("StreamMovies:End");
+	aSpan.AddItems(iNumTilts);
+	//---------------------------
+	if(iNumSecs < 7)
+	{	printf("GPU %d: Warning: %s has only %d tilts, skip.\n\n",
+		   m_iNthGpu, pReadMdoc->m_acMdocFile, iNumSecs);
+		return false;
+	}
+	pTsPackage->TrimTiltSeries(iNumSecs);
+	pTsPackage->SetLoaded(true);
+	mSaveTiltSeries();
+	return true;
+}
+
+void CProcessThread::mSaveTiltSeries(void)
+{
+	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	//--------------------------------------------------
 	// 1) Tilt series are sorted by tilt angle and then
 	// saved into MRC file.
@@ -211,7 +333,9 @@ void CProcessThread::mProcessMovies(void)
 	//--------------------------------------------------
 	pTimeStamp->Record("SaveTiltSeries:Start");
 	pTsPackage->SortTiltSeries(0);
-	pTsPackage->SaveTiltSeries();
+	{	MD::CTraceSpan aSaveSpan("CTsPackage::SaveTiltSeries");
+		pTsPackage->SaveTiltSeries();
+	}
 	pTimeStamp->Record("SaveTiltSeries:End");
 	//--------------------------------------------------
 	// 1) Resetting section indices makes the section
@@ -231,25 +355,32 @@ bool CProcessThread::mLoadTiltSeries(void)
 	bool bLoaded = pTsPackage->LoadTiltSeries();
 	pTimeStamp->Record("LoadTiltSeries:End");
 	if(!bLoaded) return false;
-	//---------------------------------------------------------
-	// 1) Create buffer pool since there are several classes
-	// in Correct folder use it.
-	// 2) Buffer pool is created here only for -Cmd 1.
-	// 3) This is a patch and needs improvement.
-	//---------------------------------------------------------
+	mCreateBufferPool();
+	return true;	
+}
+
+//--------------------------------------------------------------------
+// 1) Create buffer pool since there are several classes in Correct
+//    folder use it.
+// 2) Buffer pool is created here only for -Cmd 1 and when all the
+//    sums are loaded from -StageCache.
+// 3) This is a patch and needs improvement.
+//--------------------------------------------------------------------
+void CProcessThread::mCreateBufferPool(void)
+{
+	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	MD::CTiltSeries* pTiltSeries = pTsPackage->GetSeries(0);
 	MD::CBufferPool* pBufferPool = MD::CBufferPool::GetInstance(m_iNthGpu);
 	int aiStkSize[3] = {0};
 	memcpy(aiStkSize, pTiltSeries->m_aiStkSize, sizeof(int) * 3);
 	if(aiStkSize[2] > 10) aiStkSize[2] = 10;
 	pBufferPool->Create(aiStkSize);
-	return true;	
 }
 
-void CProcessThread::mProcessMovie(int iTilt)
+void CProcessThread::mSetupMovie(int iTilt, int iSlot)
 {
 	CInput* pInput = CInput::GetInstance();
-	MD::CMcPackage* pMcPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	MD::CMcPackage* pMcPackage = MD::CMcPackage::GetInstance(iSlot);
         MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
 	//-----------------
 	char* pcFileName = pReadMdoc->GetFrameFileName(iTilt);
@@ -257,25 +388,156 @@ void CProcessThread::mProcessMovie(int iTilt)
 	pMcPackage->m_iAcqIdx = pReadMdoc->GetAcqIdx(iTilt);
 	pMcPackage->m_fTilt = pReadMdoc->GetTilt(iTilt);
 	pMcPackage->m_fPixSize = pInput->m_fPixSize;
-	//-----------------
+}
+
+bool CProcessThread::mLoadMovie(int iTilt, int iSlot)
+{
+	mSetupMovie(iTilt, iSlot);
+	MotionCor::CMotionCorMain mcMain;
+	return mcMain.LoadStack(iSlot);
+}
+
+void CProcessThread::mProcessMovie(int iTilt)
+{
+        MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	char* pcFileName = pReadMdoc->GetFrameFileName(iTilt);
 	printf("GPU %d: Motion correct %s\n"
 	   "------------------\n\n", 
 	   m_iNthGpu, pcFileName);
 	//-----------------
 	MotionCor::CMotionCorMain mcMain;
-	mcMain.DoIt(m_iNthGpu);
+	mcMain.Correct(m_iNthGpu);
+}
+
+//--------------------------------------------------------------------
+// 1. -StageCache 2: the key of the motion corrected sums hashes the
+//    movie, gain, dark and defect files by path, size and time of
+//    modification, rather than their content, and every parameter
+//    of motion correction.
+//--------------------------------------------------------------------
+void CProcessThread::mGenMovieKey(int iTilt, MD::CStageKey* pKey)
+{
+	CInput* pInput = CInput::GetInstance();
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	char acMoviePath[256] = {'\0'};
+	strcpy(acMoviePath, pInput->m_acInDir);
+	strcat(acMoviePath, pReadMdoc->GetFrameFileName(iTilt));
+	//-----------------
+	pKey->AddFile(acMoviePath);
+	pKey->AddFile(pMcInput->m_acGainFile);
+	pKey->AddFile(pMcInput->m_acDarkMrc);
+	pKey->AddFile(pMcInput->m_acDefectFile);
+	pKey->AddFloat(pInput->m_fPixSize);
+	pKey->AddFloat(pInput->m_fFmDose);
+	pKey->AddInt(pInput->m_iKv);
+	pKey->AddInt(pInput->m_iSplitSum);
+	pKey->AddInt(MD::CAlnSums::m_iNumSums);
+	//-----------------
+	pKey->Add(pMcInput->m_aiNumPatches, sizeof(int) * 3);
+	pKey->AddInt(pMcInput->m_iMcIter);
+	pKey->AddFloat(pMcInput->m_fMcTol);
+	pKey->AddFloat(pMcInput->m_fMcBin);
+	pKey->AddInt(pMcInput->m_iFmInt);
+	pKey->Add(pMcInput->m_aiGroup, sizeof(int) * 2);
+	pKey->AddInt(pMcInput->m_iFmRef);
+	pKey->AddInt(pMcInput->m_iRotGain);
+	pKey->AddInt(pMcInput->m_iFlipGain);
+	pKey->AddInt(pMcInput->m_iInvGain);
+	pKey->Add(pMcInput->m_afMag, sizeof(float) * 3);
+	pKey->AddInt(pMcInput->m_iInFmMotion);
+	pKey->AddInt(pMcInput->m_iEerSampling);
+	pKey->AddInt(pMcInput->m_iTiffOrder);
+	pKey->AddInt(pMcInput->m_iCorrInterp);
+}
+
+bool CProcessThread::mMovieCached(int iTilt)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(2)) return false;
+	//-----------------
+	MD::CStageKey aKey;
+	mGenMovieKey(iTilt, &aKey);
+	return pStageCache->bExists("Mc", &aKey);
+}
+
+//--------------------------------------------------------------------
+// 1. Loads the sums of iTilt into the package of this GPU. The
+//    motion correction log files are not written again.
+//--------------------------------------------------------------------
+bool CProcessThread::mLoadMovieStage(int iTilt)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(2)) return false;
+	//-----------------
+	MD::CStageKey aKey;
+	mGenMovieKey(iTilt, &aKey);
+	MD::CStageEntry aEntry;
+	if(!pStageCache->Load("Mc", &aKey, &aEntry)) return false;
+	//-----------------
+	int aiStkSize[3] = {0};
+	aEntry.Read(aiStkSize, sizeof(int) * 3);
+	float fPixSize = aEntry.ReadFloat();
+	float fStkDose = aEntry.ReadFloat();
+	if(aEntry.m_bFailed) return false;
+	if(aiStkSize[2] != MD::CAlnSums::m_iNumSums) return false;
+	//-----------------
+	mSetupMovie(iTilt, m_iNthGpu);
+	MD::CMcPackage* pMcPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	MD::CAlnSums* pAlnSums = pMcPackage->m_pAlnSums;
+	pAlnSums->Create(aiStkSize);
+	for(int i=0; i<aiStkSize[2]; i++)
+	{	aEntry.Read(pAlnSums->GetFrame(i), pAlnSums->m_tFmBytes);
+	}
+	if(aEntry.m_bFailed) return false;
+	pAlnSums->m_fPixSize = fPixSize;
+	pMcPackage->m_pRawStack->m_fStkDose = fStkDose;
+	//-----------------
+	printf("GPU %d: motion corrected sums loaded from %s\n\n",
+	   m_iNthGpu, aEntry.m_acFile);
+	return true;
 }
 
-void CProcessThread::mAssembleTiltSeries(int iTilt)
+void CProcessThread::mSaveMovieStage(int iTilt)
+{
+	MD::CStageCache* pStageCache = MD::CStageCache::GetInstance();
+	if(!pStageCache->bEnabled(2)) return;
+	//-----------------
+	MD::CMcPackage* pMcPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	MD::CAlnSums* pAlnSums = pMcPackage->m_pAlnSums;
+	MD::CStageEntry* pEntry = new MD::CStageEntry;
+	pEntry->Write(pAlnSums->m_aiStkSize, sizeof(int) * 3);
+	pEntry->WriteFloat(pAlnSums->m_fPixSize);
+	pEntry->WriteFloat(pMcPackage->m_pRawStack->m_fStkDose);
+	for(int i=0; i<pAlnSums->m_aiStkSize[2]; i++)
+	{	pEntry->Write(pAlnSums->GetFrame(i), pAlnSums->m_tFmBytes);
+	}
+	//-----------------
+	MD::CStageKey aKey;
+	mGenMovieKey(iTilt, &aKey);
+	pStageCache->Save("Mc", &aKey, pEntry, m_iNthGpu);
+}
+
+//--------------------------------------------------------------------
+// 1. Stores the sums of mdoc tilt iTilt as section iSec of the
+//    tilt series. They differ only in -Stream when tilts are left
+//    out.
+//--------------------------------------------------------------------
+void CProcessThread::mAssembleTiltSeries(int iTilt, int iSec)
 {
 	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
 	MD::CMcPackage* pMcPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
 	MD::CTsPackage* pTsPackage = MD::CTsPackage::GetInstance(m_iNthGpu);
 	//-----------------
-	if(iTilt == 0) pTsPackage->CreateTiltSeries();
+	//--------------------------------------------------
+	// 1) -Stream: the tilt series is created with the
+	// tilts listed so far and grows as more are listed.
+	//--------------------------------------------------
+	if(iSec == 0) pTsPackage->CreateTiltSeries();
+	else pTsPackage->GrowTiltSeries(iSec + 1);
 	//-----------------
 	float fTilt = pReadMdoc->GetTilt(iTilt);
-	pTsPackage->SetTiltAngle(iTilt, fTilt);
+	pTsPackage->SetTiltAngle(iSec, fTilt);
 	//--------------------------------------------------
 	// 1) when processing starts with movies, section
 	// indices are the same as acquisition  indices. 
@@ -286,14 +548,14 @@ void CProcessThread::mAssembleTiltSeries(int iTilt)
 	// acquisition sequence.
 	//--------------------------------------------------
 	int iAcqIdx = pReadMdoc->GetAcqIdx(iTilt);
-	pTsPackage->SetAcqIdx(iTilt, iAcqIdx);
-	pTsPackage->SetSecIdx(iTilt, iAcqIdx);
+	pTsPackage->SetAcqIdx(iSec, iAcqIdx);
+	pTsPackage->SetSecIdx(iSec, iAcqIdx);
 	//-----------------
-	pTsPackage->SetSums(iTilt, pMcPackage->m_pAlnSums);
+	pTsPackage->SetSums(iSec, pMcPackage->m_pAlnSums);
 	//-----------------
 	float fImgDose = pReadMdoc->GetDose(iTilt);
 	if(fImgDose <= 0) fImgDose = pMcPackage->m_pRawStack->m_fStkDose;
-	pTsPackage->SetImgDose(iTilt, fImgDose);
+	pTsPackage->SetImgDose(iSec, fImgDose);
 }
 
 void CProcessThread::mProcessTiltSeries(void)
@@ -301,3 +563,61 @@ void CProcessThread::mProcessTiltSeries(void)
 	MA::CAreTomoMain areTomoMain;
 	areTomoMain.DoIt(m_iNthGpu);
 }
+
+//--------------------------------------------------------------------
+// 1. -Stream: waits until the mdoc file lists iTilt. Returns false
+//    when the acquisition is over before that.
+//--------------------------------------------------------------------
+bool CProcessThread::mWaitTilt(int iTilt)
+{
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	while(true)
+	{	pReadMdoc->ReadNew();
+		if(iTilt < pReadMdoc->m_iNumTilts) return true;
+		if(mMdocSettled()) return false;
+		this->mWait(1.0f);
+	}
+}
+
+//--------------------------------------------------------------------
+// 1. -Stream: waits up to fMaxSecs for the movie of iTilt to be
+//    saved, that is, to exist and be unchanged for the stable time
+//    of CStackFolder. fMaxSecs = 0 checks only once.
+//--------------------------------------------------------------------
+bool CProcessThread::mWaitMovie(int iTilt, float fMaxSecs)
+{
+	CInput* pInput = CInput::GetInstance();
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	char acMoviePath[256] = {'\0'};
+	strcpy(acMoviePath, pInput->m_acInDir);
+	strcat(acMoviePath, pReadMdoc->GetFrameFileName(iTilt));
+	//-----------------
+	float fStableSecs = MD::CStackFolder::GetInstance()->m_fStableSecs;
+	double dStart = MD::CTsScheduler::GetSeconds();
+	MD::CWatchedFile aMovie;
+	bool bFound = false;
+	while(true)
+	{	if(!bFound) bFound = aMovie.Setup(acMoviePath);
+		if(bFound)
+		{	int iStable = aMovie.Check(acMoviePath, fStableSecs);
+			if(iStable > 0) return true;
+			if(iStable < 0) bFound = false;
+		}
+		//----------------
+		double dWait = MD::CTsScheduler::GetSeconds() - dStart;
+		if(dWait >= fMaxSecs) return false;
+		this->mWait(1.0f);
+	}
+}
+
+bool CProcessThread::mMdocSettled(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	MD::CReadMdoc* pReadMdoc = MD::CReadMdoc::GetInstance(m_iNthGpu);
+	struct stat aStat;
+	if(stat(pReadMdoc->m_acMdocFile, &aStat) != 0) return true;
+	//-----------------
+	time_t tNow = time(0L);
+	double dAge = difftime(tNow, aStat.st_mtime);
+	return dAge >= pInput->m_iStream;
+}
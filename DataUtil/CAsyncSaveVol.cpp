@@ -35,94 +35,68 @@ void CAsyncSaveVol::DeleteInstances(void)
 	m_pInstances = 0L;
 }
 
-//------------------------------------------------------------------------------
-// m_aMutex: It is initialized in Util_Thread. Do not init here
-//------------------------------------------------------------------------------
 CAsyncSaveVol::CAsyncSaveVol(void)
 {
 	m_iNthGpu = 0;
-	m_pVolSeries = 0L;
 }
 
-//------------------------------------------------------------------------------
-// m_aMutex: It is destroyed in Util_Thread. Do not destroy here.
-//------------------------------------------------------------------------------
 CAsyncSaveVol::~CAsyncSaveVol(void)
 {
-	if(m_pVolSeries != 0L) 
-	{	delete m_pVolSeries;
-	}
 }
 
+//------------------------------------------------------------------------------
+// 1. The volume is handed to CAsyncWriter. With bClean the job takes
+//    it over, otherwise it is copied when queued and stays with the
+//    caller.
+// 2. Without bAsync the volume is written before returning.
+//------------------------------------------------------------------------------
 bool CAsyncSaveVol::DoIt
 (	CTiltSeries* pVolSeries, 
 	int iNthVol,
 	bool bAsync,
 	bool bClean
 )
-{	if(m_pVolSeries != 0L)
-	{	delete m_pVolSeries;
-		m_pVolSeries = 0L;
+{	char acMrcFile[256] = {'\0'};
+	if(!this->GetVolFile(iNthVol, acMrcFile))
+	{	if(bClean) delete pVolSeries;
+		return true;
 	}
-	//-----------------
-	m_pVolSeries = pVolSeries;
-	m_iNthVol = iNthVol;
-	m_bClean = bClean;
-	//-----------------
-	if(bAsync) this->Start();
-	else mSaveVol();
-	return true;
-}
-
-void CAsyncSaveVol::ThreadMain(void)
-{
-	mSaveVol();
+	//---------------------------
+	CWriteStack* pWriteStack = new CWriteStack;
+	strcpy(pWriteStack->m_acFile, acMrcFile);
+	strcpy(pWriteStack->m_acStamp, "SaveTomogram");
+	pWriteStack->m_iNthGpu = m_iNthGpu;
+	pWriteStack->m_bReport = true;
+	pWriteStack->SetStack(pVolSeries, bClean);
+	pWriteStack->SetTilts(pVolSeries->m_pfTilts);
+	//---------------------------
+	CAsyncWriter* pAsyncWriter = CAsyncWriter::GetInstance();
+	pAsyncWriter->Submit(pWriteStack);
+	if(bAsync) return true;
+	bool bClear = true;
+	return pAsyncWriter->WaitGpu(m_iNthGpu, !bClear);
 }
 
-void CAsyncSaveVol::mSaveVol(void)
+//------------------------------------------------------------------------------
+// 1. Returns false when the iNthVol volume is not to be saved, i.e.
+//    the even and odd volumes without -SplitSum.
+//------------------------------------------------------------------------------
+bool CAsyncSaveVol::GetVolFile(int iNthVol, char* pcMrcFile)
 {
 	CInput* pInput = CInput::GetInstance();
 	if(pInput->m_iSplitSum == 0)
-	{	if(m_iNthVol == 1) return;
-		if(m_iNthVol == 2) return;
-	}
-	//---------------------------
-	MD::CTimeStamp* pTimeStamp = MD::CTimeStamp::GetInstance(m_iNthGpu);
-	pTimeStamp->Record("SaveTomogram:Start");
-	//---------------------------
-	char acExt[32] = {'\0'}, acMrcFile[256] = {'\0'};
-	if(m_iNthVol == 0) strcpy(acExt, "_Vol.mrc");
-	else if(m_iNthVol == 1) strcpy(acExt, "_EVN_Vol.mrc");
-	else if(m_iNthVol == 2) strcpy(acExt, "_ODD_Vol.mrc");
-	else if(m_iNthVol == 3) strcpy(acExt, "_2ND_Vol.mrc");
-	else if(m_iNthVol == 4) strcpy(acExt, "_3RD_Vol.mrc");
-	mGenFullPath(acExt, acMrcFile);
-	//---------------------------
-	Mrc::CSaveMrc saveMrc;
-	saveMrc.OpenFile(acMrcFile);
-	saveMrc.SetMode(Mrc::eMrcFloat);
-	saveMrc.SetExtHeader(0, 32, 0);
-	saveMrc.SetImgSize(m_pVolSeries->m_aiStkSize,
-	   m_pVolSeries->m_aiStkSize[2], 1,
-	   m_pVolSeries->m_fPixSize);
-	saveMrc.m_pSaveMain->DoIt();
-	//---------------------------
-	float** ppfImages = m_pVolSeries->GetImages();
-	for(int i=0; i<m_pVolSeries->m_aiStkSize[2]; i++)
-	{	float fTilt = m_pVolSeries->m_pfTilts[i];
-		saveMrc.m_pSaveExt->SetTilt(i, &fTilt, 1);
-		saveMrc.m_pSaveExt->DoIt();
-		saveMrc.m_pSaveImg->DoIt(i, ppfImages[i]);
+	{	if(iNthVol == 1) return false;
+		if(iNthVol == 2) return false;
 	}
-	saveMrc.CloseFile();
 	//---------------------------
-	if(m_bClean && m_pVolSeries != 0L) 
-	{	delete m_pVolSeries;
-		m_pVolSeries = 0L;
-	}
-	//---------------------------
-	pTimeStamp->Record("SaveTomogram:End");
-	printf("GPU %d: MRC file saved: %s\n\n", m_iNthGpu, acMrcFile);
+	char acExt[32] = {'\0'};
+	if(iNthVol == 0) strcpy(acExt, "_Vol.mrc");
+	else if(iNthVol == 1) strcpy(acExt, "_EVN_Vol.mrc");
+	else if(iNthVol == 2) strcpy(acExt, "_ODD_Vol.mrc");
+	else if(iNthVol == 3) strcpy(acExt, "_2ND_Vol.mrc");
+	else if(iNthVol == 4) strcpy(acExt, "_3RD_Vol.mrc");
+	mGenFullPath(acExt, pcMrcFile);
+	return true;
 }
 
 void CAsyncSaveVol::mGenFullPath(const char* pcSuffix, char* pcFullPath)
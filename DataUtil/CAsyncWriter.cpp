@@ -0,0 +1,219 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#include <unistd.h>
+
+using namespace McAreTomo::DataUtil;
+
+static const int s_iNumThreads = 2;
+
+CAsyncWriterThread::CAsyncWriterThread(void)
+{
+	m_pWriter = 0L;
+}
+
+CAsyncWriterThread::~CAsyncWriterThread(void)
+{
+}
+
+void CAsyncWriterThread::Run(CAsyncWriter* pWriter)
+{
+	m_pWriter = pWriter;
+	this->Start();
+}
+
+void CAsyncWriterThread::ThreadMain(void)
+{
+	CTracer::GetInstance()->NameThread("Writer");
+	m_pWriter->RunJobs();
+}
+
+CAsyncWriter* CAsyncWriter::m_pInstance = 0L;
+
+CAsyncWriter* CAsyncWriter::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CAsyncWriter;
+	return m_pInstance;
+}
+
+//-------------------------------------------------------------------
+// 1. All queued files are written before the threads exit.
+//-------------------------------------------------------------------
+void CAsyncWriter::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+//-------------------------------------------------------------------
+// 1. The budget defaults to a quarter of the physical memory.
+//-------------------------------------------------------------------
+CAsyncWriter::CAsyncWriter(void)
+{
+	long lPages = sysconf(_SC_PHYS_PAGES);
+	long lPageSize = sysconf(_SC_PAGESIZE);
+	m_tMaxBytes = (size_t)1024 * 1024 * 1024;
+	if(lPages > 0 && lPageSize > 0)
+	{	m_tMaxBytes = (size_t)lPages * lPageSize / 4;
+	}
+	m_iMaxJobs = 64;
+	m_tQueuedBytes = 0;
+	m_iNumPendings = 0;
+	m_bExit = false;
+	//-----------------
+	pthread_mutex_init(&m_aMutex, 0L);
+	pthread_cond_init(&m_aJobCond, 0L);
+	pthread_cond_init(&m_aRoomCond, 0L);
+	pthread_cond_init(&m_aDoneCond, 0L);
+	//-----------------
+	m_iNumThreads = s_iNumThreads;
+	m_pThreads = new CAsyncWriterThread[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	m_pThreads[i].Run(this);
+	}
+}
+
+CAsyncWriter::~CAsyncWriter(void)
+{
+	this->WaitAll();
+	pthread_mutex_lock(&m_aMutex);
+	m_bExit = true;
+	pthread_cond_broadcast(&m_aJobCond);
+	pthread_mutex_unlock(&m_aMutex);
+	for(int i=0; i<m_iNumThreads; i++)
+	{	m_pThreads[i].WaitForExit(-1.0f);
+	}
+	delete[] m_pThreads;
+	//-----------------
+	pthread_cond_destroy(&m_aJobCond);
+	pthread_cond_destroy(&m_aRoomCond);
+	pthread_cond_destroy(&m_aDoneCond);
+	pthread_mutex_destroy(&m_aMutex);
+}
+
+//-------------------------------------------------------------------
+// 1. Blocks while the queued jobs already hold the budget. A job
+//    always gets in when nothing is held so that a large job does
+//    not wait forever.
+// 2. The borrowed buffers of the job are copied outside the lock
+//    after its room has been reserved.
+//-------------------------------------------------------------------
+void CAsyncWriter::Submit(CWriteJob* pWriteJob)
+{
+	if(pWriteJob == 0L) return;
+	pthread_mutex_lock(&m_aMutex);
+	m_aPendings[pWriteJob->m_iNthGpu] += 1;
+	m_iNumPendings += 1;
+	if(pWriteJob->m_tBytes > m_tMaxBytes)
+	{	pthread_mutex_unlock(&m_aMutex);
+		mRunJob(pWriteJob, false);
+		return;
+	}
+	//-----------------
+	while(m_tQueuedBytes > 0)
+	{	bool bFull = (m_tQueuedBytes + pWriteJob->m_tBytes > m_tMaxBytes)
+		   || ((int)m_aJobQueue.size() >= m_iMaxJobs);
+		if(!bFull) break;
+		pthread_cond_wait(&m_aRoomCond, &m_aMutex);
+	}
+	m_tQueuedBytes += pWriteJob->m_tBytes;
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	pWriteJob->Detach();
+	pthread_mutex_lock(&m_aMutex);
+	m_aJobQueue.push_back(pWriteJob);
+	pthread_cond_signal(&m_aJobCond);
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+bool CAsyncWriter::WaitGpu(int iNthGpu, bool bClear)
+{
+	pthread_mutex_lock(&m_aMutex);
+	while(m_aPendings[iNthGpu] > 0)
+	{	pthread_cond_wait(&m_aDoneCond, &m_aMutex);
+	}
+	int iFailures = m_aFailures[iNthGpu];
+	if(bClear) m_aFailures[iNthGpu] = 0;
+	pthread_mutex_unlock(&m_aMutex);
+	return (iFailures == 0);
+}
+
+void CAsyncWriter::WaitAll(void)
+{
+	pthread_mutex_lock(&m_aMutex);
+	while(m_iNumPendings > 0)
+	{	pthread_cond_wait(&m_aDoneCond, &m_aMutex);
+	}
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+void CAsyncWriter::RunJobs(void)
+{
+	while(true)
+	{	pthread_mutex_lock(&m_aMutex);
+		while(m_aJobQueue.empty() && !m_bExit)
+		{	pthread_cond_wait(&m_aJobCond, &m_aMutex);
+		}
+		if(m_aJobQueue.empty())
+		{	pthread_mutex_unlock(&m_aMutex);
+			break;
+		}
+		CWriteJob* pWriteJob = m_aJobQueue.front();
+		m_aJobQueue.pop_front();
+		pthread_mutex_unlock(&m_aMutex);
+		//----------------
+		mRunJob(pWriteJob, true);
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. The room of a queued job is released only after it has been
+//    written since its buffers are held until then.
+//-------------------------------------------------------------------
+void CAsyncWriter::mRunJob(CWriteJob* pWriteJob, bool bQueued)
+{
+	CTimeStamp* pTimeStamp = CTimeStamp::GetInstance(pWriteJob->m_iNthGpu);
+	char acAction[128] = {'\0'};
+	if(pWriteJob->m_acStamp[0] != '\0')
+	{	sprintf(acAction, "%s:Start", pWriteJob->m_acStamp);
+		pTimeStamp->Record(acAction);
+	}
+	//-----------------
+	CTraceSpan* pSpan = new CTraceSpan("CAsyncWriter::Write",
+	   pWriteJob->m_iNthGpu);
+	pSpan->AddBytes(pWriteJob->m_tBytes);
+	bool bWritten = pWriteJob->DoIt();
+	delete pSpan;
+	if(!bWritten)
+	{	fprintf(stderr, "Error (GPU %d): unable to write %s\n"
+		   "   %s\n\n", pWriteJob->m_iNthGpu,
+		   pWriteJob->m_acFile, strerror(errno));
+	}
+	else if(pWriteJob->m_bReport)
+	{	printf("GPU %d: MRC file saved: %s\n\n",
+		   pWriteJob->m_iNthGpu, pWriteJob->m_acFile);
+	}
+	if(pWriteJob->m_acStamp[0] != '\0')
+	{	sprintf(acAction, "%s:End", pWriteJob->m_acStamp);
+		pTimeStamp->Record(acAction);
+	}
+	//-----------------
+	int iNthGpu = pWriteJob->m_iNthGpu;
+	size_t tBytes = pWriteJob->m_tBytes;
+	delete pWriteJob;
+	//-----------------
+	pthread_mutex_lock(&m_aMutex);
+	if(bQueued)
+	{	m_tQueuedBytes -= tBytes;
+		pthread_cond_broadcast(&m_aRoomCond);
+	}
+	if(!bWritten) m_aFailures[iNthGpu] += 1;
+	m_aPendings[iNthGpu] -= 1;
+	m_iNumPendings -= 1;
+	pthread_cond_broadcast(&m_aDoneCond);
+	pthread_mutex_unlock(&m_aMutex);
+}
@@ -390,6 +390,49 @@ void CCtfResults::RemoveDarkCTFs(void)
 	m_iNumImgs = iCount;
 }
 
+//--------------------------------------------------------------------
+// 1. -StageCache: CCtfParam is stored as raw bytes as SetParam
+//    copies it.
+//--------------------------------------------------------------------
+void CCtfResults::WriteEntry(CStageEntry* pEntry)
+{
+	pEntry->WriteInt(m_iNumImgs);
+	pEntry->Write(m_aiSpectSize, sizeof(m_aiSpectSize));
+	pEntry->WriteInt(m_iDfHand);
+	pEntry->WriteFloat(m_fAlphaOffset);
+	pEntry->WriteFloat(m_fBetaOffset);
+	//-----------------
+	size_t tSpectBytes = sizeof(float) * m_aiSpectSize[0]
+	   * m_aiSpectSize[1];
+	for(int i=0; i<m_iNumImgs; i++)
+	{	pEntry->Write(m_ppCtfParams[i], sizeof(CCtfParam));
+		pEntry->Write(m_ppfSpects[i], tSpectBytes);
+	}
+}
+
+bool CCtfResults::ReadEntry(CStageEntry* pEntry)
+{
+	int iNumImgs = pEntry->ReadInt();
+	int aiSpectSize[2] = {0};
+	pEntry->Read(aiSpectSize, sizeof(aiSpectSize));
+	m_iDfHand = pEntry->ReadInt();
+	m_fAlphaOffset = pEntry->ReadFloat();
+	m_fBetaOffset = pEntry->ReadFloat();
+	if(pEntry->m_bFailed || iNumImgs < 0) return false;
+	//-----------------
+	CCtfParam aCtfParam;
+	if(iNumImgs > 0) this->Setup(iNumImgs, aiSpectSize, &aCtfParam);
+	else this->Clean();
+	//-----------------
+	size_t tSpectBytes = sizeof(float) * m_aiSpectSize[0]
+	   * m_aiSpectSize[1];
+	for(int i=0; i<m_iNumImgs; i++)
+	{	pEntry->Read(m_ppCtfParams[i], sizeof(CCtfParam));
+		pEntry->Read(m_ppfSpects[i], tSpectBytes);
+	}
+	return !pEntry->m_bFailed;
+}
+
 void CCtfResults::mRemoveEntry(int iEntry)
 {
 	if(m_ppCtfParams[iEntry] != 0L) delete m_ppCtfParams[iEntry];
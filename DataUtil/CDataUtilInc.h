@@ -4,23 +4,97 @@
 #include <Util/Util_Time.h>
 #include <Mrcfile/CMrcFileInc.h>
 #include <queue>
+#include <deque>
 #include <unordered_map>
 #include <string>
 #include <cuda.h>
 
 namespace McAreTomo::DataUtil
 {
+class CStageEntry;
 
+//-------------------------------------------------------------------
+// 1. Process-wide pool of page-aligned blocks that back CMrcStack.
+//    Freed blocks are cached and handed out again so that stacks
+//    created per movie or per tilt series do not fault in fresh
+//    pages every time.
+//-------------------------------------------------------------------
+class CStackArena
+{
+public:
+	static CStackArena* GetInstance(void);
+	static void DeleteInstance(void);
+	~CStackArena(void);
+	void* Alloc(size_t tBytes, size_t* ptBlockBytes);
+	void Free(void* pvBlock, size_t tBlockBytes);
+	void Trim(void);
+	//-----------------
+	size_t m_tMaxCachedBytes;
+	bool m_bHugePages;
+private:
+	CStackArena(void);
+	void* mMap(size_t tBlockBytes);
+	//-----------------
+	static const int s_iMaxBlocks = 32;
+	void* m_apvBlocks[s_iMaxBlocks];
+	size_t m_atBlockBytes[s_iMaxBlocks];
+	int m_iNumBlocks;
+	size_t m_tCachedBytes;
+	pthread_mutex_t m_aMutex;
+	static CStackArena* m_pInstance;
+};
+
+//-------------------------------------------------------------------
+// 1. Memory-mapped MRC file. Sections are read through a private
+//    writable mapping so that float sections in native byte order
+//    can be used in place (see CMrcStack::MapFrames).
+// 2. ReadFloat swaps bytes and converts modes 0, 1, 2, and 6 to
+//    float in one pass. Sections ahead of the one being read are
+//    advised with MADV_WILLNEED so that the kernel reads them
+//    while the current one is converted.
+//-------------------------------------------------------------------
+class CMapMrc
+{
+public:
+	CMapMrc(void);
+	~CMapMrc(void);
+	bool OpenFile(const char* pcMrcFile);
+	void CloseFile(void);
+	void* GetSection(int iSection);
+	bool ReadFloat(int iSection, float* pfImg);
+	void WillNeed(int iStart, int iNumSections);
+	bool bFloatView(void);
+	//-----------------
+	int m_aiSize[3];
+	int m_iMode;
+	float m_fPixSize;
+	bool m_bSwapByte;
+	size_t m_tSecBytes;
+	int m_iAhead;
+private:
+	char* m_pcMap;
+	size_t m_tMapBytes;
+	size_t m_tDataStart;
+	int m_iAdvised;
+};
+
+//-------------------------------------------------------------------
+// 1. All frames are views into one contiguous block taken from
+//    CStackArena. Create reuses the block when it is large enough.
+// 2. MapFrames makes the frames views into a CMapMrc instead. The
+//    stack then owns the mapping until the next Create.
+//-------------------------------------------------------------------
 class CMrcStack
 {
 public:
 	CMrcStack(void);
 	virtual ~CMrcStack(void);
-	void Create(int iMode, int* piStkSize);
+	virtual void Create(int iMode, int* piStkSize);
 	void* GetFrame(int iFrame);
 	void** GetFrames(void) { return m_ppvFrames; }
 	void RemoveFrame(int iFrame);
 	int GetPixels(void);
+	bool MapFrames(CMapMrc* pMapMrc);
 	//-----------------
 	int m_aiStkSize[3];
 	int m_iMode;
@@ -28,10 +102,12 @@ public:
 	float m_fPixSize;
 	float m_fStkDose;
 protected:
-	void mExpandBuf(int iNumFrms);
 	void mCleanFrames(void);
 	void** m_ppvFrames;
 	int m_iBufSize;
+	void* m_pvBlock;
+	size_t m_tBlockBytes;
+	CMapMrc* m_pMapMrc;
 };
 
 class CTiltSeries : public CMrcStack
@@ -50,6 +126,7 @@ public:
 	void SetSecIndices(int* piSecIndices);
 	//-----------------
 	void SetImage(int iTilt, void* pvImage);
+	bool MapFrames(CMapMrc* pMapMrc);
 	void SetCenter(int iFrame, float* pfCent);
 	void GetCenter(int iFrame, float* pfCent);
 	int GetTiltIdx(float fTilt);
@@ -91,6 +168,129 @@ public:
 	static int m_iNumSums;
 };
 
+//-------------------------------------------------------------------
+// 1. Raw frames of a movie. Counting frames are created in mode
+//    Mrc::eMrc4Bits and set by SetFrame, which packs two pixels
+//    per byte.
+// 2. Pixels counting more than 15 are kept per frame as sparse
+//    {pixel index, count} pairs. A frame with more than 1/16 of
+//    its pixels over 15 is kept as 8-bit instead, so that a frame
+//    never takes more than 1.5 times its 8-bit size.
+// 3. Both are decoded on the fly when the gain is applied in
+//    MotionCor::MrcUtil::CApplyRefs.
+//-------------------------------------------------------------------
+class CRawStack : public CMrcStack
+{
+public:
+	CRawStack(void);
+	virtual ~CRawStack(void);
+	void Create(int iMode, int* piStkSize);
+	bool bPacked(void);
+	void SetFrame(int iFrame, unsigned char* pucFrame);
+	int* GetSparse(int iFrame, int* piNumPairs); // do not free
+	unsigned char* GetDense(int iFrame);          // do not free
+private:
+	void mCleanExtras(void);
+	int** m_ppiSparse;
+	int* m_piNumPairs;
+	unsigned char** m_ppucDense;
+	int m_iNumExtras;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes a whole MRC stack in a few pwritev calls. The main and
+//    extended headers are built in memory and sent together with
+//    the sections, which are coalesced when they are contiguous.
+// 2. With bDirect the file is written through O_DIRECT using an
+//    aligned staging buffer. It falls back to buffered writes when
+//    the file system does not support O_DIRECT.
+// 3. The extended header holds iNumInts ints followed by iNumFloats
+//    floats per section. The tilt angle is the first float.
+//-------------------------------------------------------------------
+class CSaveMrcStack
+{
+public:
+	CSaveMrcStack(void);
+	~CSaveMrcStack(void);
+	void SetExtHeader(int iNumInts, int iNumFloats);
+	void SetPixSize(float fPixSize);
+	void SetMinMaxMean(float fMin, float fMax, float fMean);
+	bool DoIt
+	( const char* pcMrcFile,
+	  CMrcStack* pMrcStack,
+	  float* pfTilts,
+	  bool bDirect
+	);
+	//-----------------
+	size_t m_tBatchBytes;
+	size_t m_tStageBytes;
+	size_t m_tFileBytes;
+	float m_fSeconds;
+	bool m_bDirect;
+	bool m_bSync;
+private:
+	void mBuildHeader(float* pfTilts);
+	bool mWriteVectored(void);
+	bool mWriteDirect(void);
+	bool mWriteAll(void* pvBuf, size_t tBytes, size_t tOffset);
+	void mSetDirect(bool bDirect);
+	void mClean(void);
+	CMrcStack* m_pMrcStack;
+	char* m_pcHeader;
+	size_t m_tHeaderBytes;
+	int m_iNumInts;
+	int m_iNumFloats;
+	int m_iFile;
+	float m_fPixSize;
+	float m_afStats[3];
+	bool m_bStats;
+};
+
+//-------------------------------------------------------------------
+// 1. Writes a reconstructed volume into an MRC file one y-slab at
+//    a time. A slab is a CTiltSeries of xz slices, one per y, as
+//    produced by CDoWbpRecon and CDoSartRecon.
+// 2. iFlipVol follows -FlipVol. With 0 the xz slices are written
+//    as they are. Otherwise the slab is transposed in tiles into
+//    a staging buffer and each xy section receives the rows of
+//    the slab, with 1 reversing the section order as FlipVol does.
+// 3. Min, max, and mean are accumulated over the slabs and put
+//    into the header by Close.
+//-------------------------------------------------------------------
+class CSaveMrcSlabs
+{
+public:
+	CSaveMrcSlabs(void);
+	~CSaveMrcSlabs(void);
+	bool Open
+	( const char* pcMrcFile,
+	  int* piVolSize,   // x, z, y of the xzy volume
+	  int iFlipVol,
+	  float fPixSize
+	);
+	bool DoIt(CTiltSeries* pSlab, int iStartY);
+	bool Close(void);
+	size_t GetStageBytes(int iNumRows);
+	size_t m_tFileBytes;
+private:
+	bool mWriteXZY(CTiltSeries* pSlab, int iStartY);
+	bool mWriteXYZ(CTiltSeries* pSlab, int iStartY);
+	void mTranspose(CTiltSeries* pSlab);
+	bool mWriteHeader(bool bStats);
+	bool mWriteAll(void* pvBuf, size_t tBytes, size_t tOffset);
+	void mClean(void);
+	int m_aiVolSize[3];
+	int m_iFlipVol;
+	float m_fPixSize;
+	int m_iFile;
+	size_t m_tHeaderBytes;
+	float* m_pfStage;
+	size_t m_tStageFloats;
+	float m_afMinMax[2];
+	double m_dSum;
+	size_t m_tPixels;
+};
+
 class CGpuBuffer
 {
 public:
@@ -277,6 +477,8 @@ public:
 	CCtfParam* GetCtfParamFromTilt(float fTilt);
 	//-----------------
 	void RemoveDarkCTFs(void);
+	void WriteEntry(CStageEntry* pEntry);
+	bool ReadEntry(CStageEntry* pEntry);
 	//-----------------
 	int m_aiSpectSize[2];
 	int m_iNumImgs;
@@ -303,6 +505,7 @@ public:
 	//-----------------
 	~CMcPackage(void);
 	void SetMovieName(char* pcMovieName);
+	void Swap(CMcPackage* pPackage);
 	bool bTiffFile(void);
 	bool bEerFile(void);
 	//-----------------
@@ -310,7 +513,7 @@ public:
 	int GetMovieMode(void);
 	//-----------------
 	char m_acMoviePath[256];
-	CMrcStack* m_pRawStack;
+	CRawStack* m_pRawStack;
 	CAlnSums* m_pAlnSums;
 	//-------------------
 	int m_iAcqIdx;
@@ -332,6 +535,8 @@ public:
 	static CReadMdoc* GetInstance(int iNthGpu);
 	~CReadMdoc(void);
 	bool DoIt(const char* pcMdocFile);
+	bool Open(const char* pcMdocFile);
+	int ReadNew(void);
 	char* GetFramePath(int iTilt);     // do not free
 	char* GetFrameFileName(int iTilt); // do not free
 	int GetAcqIdx(int iTilt);
@@ -353,6 +558,7 @@ private:
 	float* m_pfTilts;
 	float* m_pfDoses;
 	int m_iBufSize;
+	long m_lOffset;
 	static CReadMdoc* m_pInstances;
 	static int m_iNumGpus;
 };
@@ -368,6 +574,8 @@ public:
 	void SetInFile(char* pcInFile);
 	//-----------------
 	void CreateTiltSeries(void);
+	void GrowTiltSeries(int iNumTilts);
+	void TrimTiltSeries(int iNumTilts);
 	bool LoadTiltSeries(void);
 	void SetLoaded(bool bLoaded);
 	//-----------------
@@ -391,6 +599,7 @@ public:
 	char m_acMrcExt[16];
 	int m_iNumSeries;
 	int m_iNthGpu;
+	int m_iCpuRecon; // -CpuRecon of this tilt series, 0 to 2
 private:
 	void mCreateTiltSeries(int* piImgSize, 
 	   int iNumTilts, float fPixSize);
@@ -399,6 +608,7 @@ private:
 	void mSaveMrc(const char* pcExt,CTiltSeries* pTiltSeries); 
 	//-----------------
 	bool mLoadMrc(const char* pcExt, CTiltSeries* pTiltSeries);
+	bool mMapMrc(const char* pcMrcFile, CTiltSeries* pTiltSeries);
 	bool mLoadTiltFile(void);
 	//-----------------
 	void mGenInPath(const char* pcSuffix, char* pcInPath);
@@ -411,6 +621,29 @@ private:
 	static int m_iNumGpus;
 };
 
+//-------------------------------------------------------------------
+// 1. A file that is still being written, either found in -Serial
+//    live mode or a movie listed in a streamed mdoc file. It is
+//    used once its size and mtime have not changed for a while.
+//-------------------------------------------------------------------
+class CWatchedFile
+{
+public:
+	CWatchedFile(void);
+	bool Setup(const char* pcFile);
+	int Check(const char* pcFile, float fStableSecs);
+	long long m_llSize;
+	double m_dMtime;    // seconds, wall clock
+	double m_dChanged;  // seconds, monotonic clock
+};
+
+//-------------------------------------------------------------------
+// 1. -Serial 1 reads the folder once. -Serial > 1 watches it with
+//    inotify for closed and moved-in files. Folders on network
+//    file systems, whose writes by other hosts raise no events,
+//    are polled by their mtime every m_fPollSecs instead.
+// 2. Files found while watching are queued once stable.
+//-------------------------------------------------------------------
 class CStackFolder : public Util_Thread
 {
 public:
@@ -418,21 +651,30 @@ public:
 	static void DeleteInstance(void);
 	~CStackFolder(void);
 	void PushFile(char* pcInFile);
-	char* GetFile(bool bPop);
-	void DeleteFront(void);
 	int GetQueueSize(void);
 	//---------------------
 	bool ReadFiles(void);
 	void ThreadMain(void);
+	//---------------------
+	float m_fStableSecs;
+	float m_fPollSecs;
 private:
         CStackFolder(void);
         bool mReadSingle(void);
         bool mGetDirName(void);
-        bool mOpenDir(void);
-        int mReadFolder(void);
+        int mReadFolder(bool bWatch);
         bool mAsyncReadFolder(void);
 	//-----------------
+	bool mMatch(const char* pcName);
 	bool mCheckSkips(const char* pcString);
+	void mQueueFile(const char* pcName);
+	void mWatchFile(const char* pcName);
+	int mCheckWatched(void);
+	//-----------------
+	bool mOpenWatch(void);
+	void mReadEvents(float fSeconds);
+	bool mDirChanged(void);
+	void mCloseWatch(void);
 	//-----------------
         void mClean(void);
 	//-----------------
@@ -441,13 +683,90 @@ private:
         char m_acSuffix[256];
 	char m_acSkips[256];
 	//-----------------
-	std::queue<char*> m_aFileQueue;
         std::unordered_map<std::string, int> m_aReadFiles;
+	std::unordered_map<std::string, CWatchedFile> m_aWatched;
+	int m_iNotify;
+	double m_dDirMtime;
+	double m_dLastScan;
         //-----------------
 	int m_iNumChars;
 	static CStackFolder* m_pInstance;
 };
 
+class CTsJob
+{
+public:
+	CTsJob(void);
+	char m_acInFile[256];
+	int m_iAttempts;
+	double m_dQueued;     // seconds, monotonic clock
+	double m_dNotBefore;  // deferred until
+};
+
+//-------------------------------------------------------------------
+// 1. Queue of tilt series (mdoc or MRC files) fed by CStackFolder
+//    and pulled by per-GPU workers with WaitJob. Workers block on
+//    a condition variable instead of being polled.
+// 2. MRC inputs and mdoc files that have not been modified for
+//    m_fSettleSecs are dispatched before mdocs still being
+//    written. Within a class the oldest job goes first.
+// 3. A worker that cannot read an mdoc yet returns it with Defer.
+//    It is retried after m_fRetrySecs, at most m_iMaxRetries times.
+// 4. No new job is started while less than m_tMinAvailBytes of
+//    memory is available, unless all workers are idle.
+// 5. Queue depth, wait time, and per-worker utilization are
+//    printed by PrintStats.
+//-------------------------------------------------------------------
+class CTsScheduler
+{
+public:
+	static CTsScheduler* GetInstance(void);
+	static void DeleteInstance(void);
+	~CTsScheduler(void);
+	void Setup(int iNumWorkers);
+	void PushFile(const char* pcInFile);
+	void Close(void);
+	bool WaitJob(int iWorker, char* pcInFile);
+	void Defer(int iWorker);
+	void JobDone(int iWorker);
+	int GetQueueSize(void);
+	void PrintStats(void);
+	static double GetSeconds(void);
+	//-----------------
+	float m_fSettleSecs;
+	float m_fRetrySecs;
+	int m_iMaxRetries;
+	size_t m_tMinAvailBytes;
+private:
+	CTsScheduler(void);
+	int mPickJob(double dNow, double* pdWakeUp);
+	bool mCheckMemory(void);
+	bool mIsComplete(CTsJob* pJob, double dNow);
+	void mClean(void);
+	//-----------------
+	std::deque<CTsJob*> m_aJobs;
+	CTsJob** m_ppRunning;
+	double* m_pdBusySecs;
+	double* m_pdStarts;
+	int* m_piNumJobs;
+	int m_iNumWorkers;
+	int m_iNumBusy;
+	bool m_bClosed;
+	bool m_bHolding;
+	//-----------------
+	double m_dStart;
+	double m_dWaitSecs;
+	double m_dMaxWait;
+	int m_iDispatched;
+	int m_iDeferred;
+	int m_iDropped;
+	int m_iMaxDepth;
+	//-----------------
+	pthread_mutex_t m_aMutex;
+	pthread_cond_t m_aCond;
+	static CTsScheduler* m_pInstance;
+};
+
 class CReadMdocDone
 {
 public:
@@ -481,7 +800,135 @@ private:
 	static CSaveMdocDone* m_pInstance;
 };
 
-class CAsyncSaveVol : public Util_Thread
+//-------------------------------------------------------------------
+// 1. An output file to be written by CAsyncWriter. A job is owned
+//    by CAsyncWriter once submitted and deleted after DoIt.
+// 2. m_tBytes is the memory the job holds while queued. It counts
+//    against the budget of CAsyncWriter.
+// 3. Detach is called before a job is queued. It copies whatever
+//    the job borrows from the caller.
+//-------------------------------------------------------------------
+class CWriteJob
+{
+public:
+	CWriteJob(void);
+	virtual ~CWriteJob(void);
+	virtual bool DoIt(void) = 0;
+	virtual void Detach(void);
+	char m_acFile[256];
+	char m_acStamp[64];
+	size_t m_tBytes;
+	int m_iNthGpu;
+	bool m_bReport;
+};
+
+//-------------------------------------------------------------------
+// 1. Text output. Open returns a FILE* on a memory buffer that the
+//    caller fprintf's into. Submit closes it and hands the job to
+//    CAsyncWriter, after which the job must not be touched.
+//-------------------------------------------------------------------
+class CWriteText : public CWriteJob
+{
+public:
+	CWriteText(void);
+	virtual ~CWriteText(void);
+	FILE* Open(const char* pcFile, int iNthGpu);
+	void Submit(void);
+	bool DoIt(void);
+private:
+	FILE* m_pStream;
+	char* m_pcText;
+	size_t m_tSize;
+};
+
+//-------------------------------------------------------------------
+// 1. MRC output written by CSaveMrcStack. A stack passed with
+//    bOwn false is only borrowed and gets copied when the job is
+//    queued.
+//-------------------------------------------------------------------
+class CWriteStack : public CWriteJob
+{
+public:
+	CWriteStack(void);
+	virtual ~CWriteStack(void);
+	void SetStack(CMrcStack* pMrcStack, bool bOwn);
+	void SetTilts(float* pfTilts);
+	void SetExtHeader(int iNumInts, int iNumFloats);
+	void SetPixSize(float fPixSize);
+	void SetMinMaxMean(float fMin, float fMax, float fMean);
+	bool DoIt(void);
+	void Detach(void);
+private:
+	CMrcStack* m_pMrcStack;
+	float* m_pfTilts;
+	int m_aiExtHeader[2];
+	float m_fPixSize;
+	float m_afStats[3];
+	bool m_bOwn;
+	bool m_bStats;
+};
+
+class CAsyncWriter;
+
+class CAsyncWriterThread : public Util_Thread
+{
+public:
+	CAsyncWriterThread(void);
+	~CAsyncWriterThread(void);
+	void Run(CAsyncWriter* pWriter);
+	void ThreadMain(void);
+private:
+	CAsyncWriter* m_pWriter;
+};
+
+//-------------------------------------------------------------------
+// 1. Process-wide pool of writer threads for the output files of
+//    all GPUs. Jobs are queued until the memory they hold reaches
+//    m_tMaxBytes or the queue m_iMaxJobs, when Submit blocks the
+//    caller.
+// 2. A job larger than m_tMaxBytes is written by the caller.
+// 3. Files are fdatasync'ed. WaitGpu returns when all files of
+//    the GPU are on disk and false if any of them failed since
+//    the failures were last cleared.
+//-------------------------------------------------------------------
+class CAsyncWriter
+{
+public:
+	static CAsyncWriter* GetInstance(void);
+	static void DeleteInstance(void);
+	//-----------------
+	~CAsyncWriter(void);
+	void Submit(CWriteJob* pWriteJob);
+	bool WaitGpu(int iNthGpu, bool bClear);
+	void WaitAll(void);
+	void RunJobs(void);
+	//-----------------
+	size_t m_tMaxBytes;
+	int m_iMaxJobs;
+private:
+	CAsyncWriter(void);
+	void mRunJob(CWriteJob* pWriteJob, bool bQueued);
+	//-----------------
+	std::deque<CWriteJob*> m_aJobQueue;
+	std::unordered_map<int, int> m_aPendings;
+	std::unordered_map<int, int> m_aFailures;
+	size_t m_tQueuedBytes;
+	int m_iNumPendings;
+	bool m_bExit;
+	pthread_mutex_t m_aMutex;
+	pthread_cond_t m_aJobCond;
+	pthread_cond_t m_aRoomCond;
+	pthread_cond_t m_aDoneCond;
+	CAsyncWriterThread* m_pThreads;
+	int m_iNumThreads;
+	static CAsyncWriter* m_pInstance;
+};
+
+//-------------------------------------------------------------------
+// 1. Submits volumes to CAsyncWriter. It keeps the file naming of
+//    the volumes.
+//-------------------------------------------------------------------
+class CAsyncSaveVol
 {
 public:
 	static void CreateInstances(int iNumGpus);
@@ -495,15 +942,11 @@ public:
 	  bool bAsync,
 	  bool bClean
 	);
-	void ThreadMain(void);
+	bool GetVolFile(int iNthVol, char* pcMrcFile);
 private:
 	CAsyncSaveVol(void);
-	void mSaveVol(void);
 	void mGenFullPath(const char* pcExt, char* pcMrcFile);
 	//-----------------
-	CTiltSeries* m_pVolSeries;
-	int m_iNthVol;
-	bool m_bClean;
 	int m_iNthGpu;
 	//-----------------
 	static CAsyncSaveVol* m_pInstances;
@@ -562,6 +1005,197 @@ private:
 	static CTimeStamp* m_pInstances;
 };
 
+//-------------------------------------------------------------------
+// 1. One timed span. m_pcName must be a string literal since only
+//    the pointer is kept.
+// 2. m_iLane is the GPU the span worked for, -1 for the host.
+//-------------------------------------------------------------------
+class CTraceEvent
+{
+public:
+	const char* m_pcName;
+	long long m_llStart;	// ns since CTracer::Start
+	long long m_llDur;
+	size_t m_tBytes;
+	int m_iItems;
+	int m_iLane;
+	int m_iDepth;
+};
+
+//-------------------------------------------------------------------
+// 1. Ring of events of one thread. Only the owning thread adds to
+//    it so no lock is taken. When it is full the oldest events
+//    are overwritten.
+//-------------------------------------------------------------------
+class CTraceBuffer
+{
+public:
+	CTraceBuffer(int iSize, int iThread);
+	~CTraceBuffer(void);
+	void Add(CTraceEvent* pEvent);
+	int GetCount(void);
+	CTraceEvent* GetEvent(int i); // i-th oldest
+	long long GetDropped(void);
+	//-----------------
+	char m_acName[64];
+	int m_iThread;
+	int m_iLane;
+	int m_iDepth;
+private:
+	CTraceEvent* m_pEvents;
+	int m_iSize;
+	long long m_llAdded;
+};
+
+//-------------------------------------------------------------------
+// 1. Collects the spans of all threads and saves them at exit in
+//    the Chrome trace format, which chrome://tracing and Perfetto
+//    read. Each GPU is a process there and each thread a track.
+// 2. Nothing is recorded unless Start has been called.
+//-------------------------------------------------------------------
+class CTracer
+{
+public:
+	static CTracer* GetInstance(void);
+	static void DeleteInstance(void);
+	static bool m_bEnabled;
+	//-----------------
+	~CTracer(void);
+	void Start(const char* pcTraceFile, int iNumGpus);
+	void NameThread(const char* pcName);
+	CTraceBuffer* GetBuffer(void);
+	long long GetNanoSecs(void);
+	bool Save(void);
+	int m_iBufSize;
+private:
+	CTracer(void);
+	void mSaveLanes(FILE* pFile);
+	void mSaveEvents(FILE* pFile, CTraceBuffer* pBuffer);
+	void mNewEntry(FILE* pFile);
+	//-----------------
+	std::deque<CTraceBuffer*> m_aBuffers;
+	int m_iNumEntries;
+	pthread_mutex_t m_aMutex;
+	char m_acTraceFile[256];
+	int m_iNumGpus;
+	long long m_llStart;
+	static CTracer* m_pInstance;
+};
+
+//-------------------------------------------------------------------
+// 1. Scoped span recorded by CTracer when it goes out of scope.
+//    Spans on the same thread nest. iNthGpu < 0 takes the GPU of
+//    the enclosing span.
+// 2. It costs one branch when tracing is off.
+//-------------------------------------------------------------------
+class CTraceSpan
+{
+public:
+	CTraceSpan(const char* pcName, int iNthGpu = -1);
+	~CTraceSpan(void);
+	void AddBytes(size_t tBytes);
+	void AddItems(int iItems);
+private:
+	CTraceBuffer* m_pBuffer;
+	CTraceEvent m_aEvent;
+	int m_iOldLane;
+};
+
+//-------------------------------------------------------------------
+// 1. 64-bit key of a CStageCache entry. Each Add hashes its bytes
+//    in four lanes as xxHash64 does, seeded with the hash so far,
+//    so hashing a tilt series runs near memory speed.
+// 2. AddFile hashes the path, size and mtime of a file instead of
+//    its content so that movies are not read twice.
+//-------------------------------------------------------------------
+class CStageKey
+{
+public:
+	CStageKey(void);
+	~CStageKey(void);
+	void Add(const void* pvData, size_t tBytes);
+	void AddInt(int iVal);
+	void AddFloat(float fVal);
+	void AddStr(const char* pcStr);
+	void AddFile(const char* pcFile);
+	void AddKey(CStageKey* pKey);
+	void GetHex(char* pcHex); // 17 chars
+	unsigned long long m_ullHash;
+};
+
+//-------------------------------------------------------------------
+// 1. Payload of a CStageCache entry. Values are appended with the
+//    Write functions and read back in the same order. A read past
+//    the end sets m_bFailed and returns zeros.
+// 2. The file starts with a header of the key, payload size and
+//    payload hash, which Load checks.
+// 3. It is written by CAsyncWriter like other output files. A
+//    cache file that cannot be written is only warned about so
+//    that the tilt series is still marked done.
+//-------------------------------------------------------------------
+class CStageEntry : public CWriteJob
+{
+public:
+	CStageEntry(void);
+	virtual ~CStageEntry(void);
+	void Clean(void);
+	void Write(const void* pvData, size_t tBytes);
+	void WriteInt(int iVal);
+	void WriteFloat(float fVal);
+	bool Read(void* pvData, size_t tBytes);
+	int ReadInt(void);
+	float ReadFloat(void);
+	bool Load(const char* pcFile, unsigned long long ullKey);
+	bool DoIt(void);
+	//-----------------
+	char* m_pcData;
+	size_t m_tSize;
+	size_t m_tReadPos;
+	unsigned long long m_ullKey;
+	bool m_bFailed;
+private:
+	size_t m_tCapacity;
+};
+
+//-------------------------------------------------------------------
+// 1. -StageCache: results of the processing stages are saved in
+//    StageCache in the output folder as <Stage>_<key>.bin, where
+//    the key hashes the input data and every parameter the stage
+//    depends on. Reruns load them instead of repeating the stage.
+// 2. Level 1 caches CTF estimation and alignment, level 2 also
+//    the motion corrected sums.
+//-------------------------------------------------------------------
+class CStageCache
+{
+public:
+	static CStageCache* GetInstance(void);
+	static void DeleteInstance(void);
+	~CStageCache(void);
+	bool bEnabled(int iLevel);
+	bool bExists(const char* pcStage, CStageKey* pKey);
+	bool Load
+	( const char* pcStage,
+	  CStageKey* pKey,
+	  CStageEntry* pEntry
+	);
+	void Save
+	( const char* pcStage,
+	  CStageKey* pKey,
+	  CStageEntry* pEntry,
+	  int iNthGpu
+	);
+private:
+	CStageCache(void);
+	void mGenPath
+	( const char* pcStage,
+	  CStageKey* pKey,
+	  char* pcPath
+	);
+	char m_acCacheDir[256];
+	int m_iLevel;
+	static CStageCache* m_pInstance;
+};
+
 class CDuInstances
 {
 public:
@@ -7,6 +7,8 @@ using namespace McAreTomo::DataUtil;
 
 void CDuInstances::CreateInstances(int iNumGpus)
 {
+	CStackArena::GetInstance();
+	CAsyncWriter::GetInstance();
 	CBufferPool::CreateInstances(iNumGpus);
 	CCtfResults::CreateInstances(iNumGpus);
 	CMcPackage::CreateInstances(iNumGpus);
@@ -15,17 +17,27 @@ void CDuInstances::CreateInstances(int iNumGpus)
 	CTsPackage::CreateInstances(iNumGpus);
 	CLogFiles::CreateInstances(iNumGpus);
 	CTimeStamp::CreateInstances();
+	CStageCache::GetInstance();
 }
 
+//-------------------------------------------------------------------
+// 1. CAsyncWriter goes first. It writes the queued files before
+//    the instances they use are deleted.
+//-------------------------------------------------------------------
 void CDuInstances::DeleteInstances(void)
 {
+	CAsyncWriter::DeleteInstance();
+	CTracer::DeleteInstance();
 	CBufferPool::DeleteInstances();
 	CCtfResults::DeleteInstances();
 	CMcPackage::DeleteInstances();
 	CReadMdoc::DeleteInstances();
 	CTsPackage::DeleteInstances();
 	CStackFolder::DeleteInstance();
+	CTsScheduler::DeleteInstance();
 	CLogFiles::DeleteInstances();
 	CAsyncSaveVol::DeleteInstances();
 	CTimeStamp::DeleteInstances();
+	CStageCache::DeleteInstance();
+	CStackArena::DeleteInstance();
 }
@@ -0,0 +1,192 @@
+#include "CDataUtilInc.h"
+#include <Mrcfile/CMrcFileInc.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo::DataUtil;
+
+static const size_t s_tAheadBytes = 64 * 1024 * 1024;
+
+template <typename T> static void sToFloat
+(	T* pSrc,
+	float* pfDst,
+	size_t tPixels
+)
+{	for(size_t i=0; i<tPixels; i++) pfDst[i] = pSrc[i];
+}
+
+static void sSwapToFloat
+(	unsigned short* pusSrc,
+	float* pfDst,
+	size_t tPixels,
+	bool bSigned
+)
+{	for(size_t i=0; i<tPixels; i++)
+	{	unsigned short usVal = __builtin_bswap16(pusSrc[i]);
+		if(bSigned) pfDst[i] = (short)usVal;
+		else pfDst[i] = usVal;
+	}
+}
+
+static void sSwapToFloat(unsigned int* puiSrc, float* pfDst, size_t tPixels)
+{
+	for(size_t i=0; i<tPixels; i++)
+	{	unsigned int uiVal = __builtin_bswap32(puiSrc[i]);
+		memcpy(pfDst + i, &uiVal, sizeof(float));
+	}
+}
+
+CMapMrc::CMapMrc(void)
+{
+	m_pcMap = 0L;
+	m_tMapBytes = 0;
+	m_tDataStart = 0;
+	m_iAdvised = 0;
+	m_iAhead = 1;
+	m_iMode = -1;
+	m_fPixSize = 0.0f;
+	m_bSwapByte = false;
+	m_tSecBytes = 0;
+	memset(m_aiSize, 0, sizeof(m_aiSize));
+}
+
+CMapMrc::~CMapMrc(void)
+{
+	this->CloseFile();
+}
+
+//-------------------------------------------------------------------
+// 1. The header is parsed by Mrc::CLoadMainHeader so that byte
+//    order detection matches Mrc::CLoadMrc.
+// 2. Files shorter than their header claims are rejected since
+//    touching pages past the end of file raises SIGBUS.
+//-------------------------------------------------------------------
+bool CMapMrc::OpenFile(const char* pcMrcFile)
+{
+	this->CloseFile();
+	int iFile = open(pcMrcFile, O_RDONLY);
+	if(iFile == -1) return false;
+	//-----------------
+	Mrc::CLoadMainHeader aLoadMain;
+	aLoadMain.DoIt(iFile);
+	aLoadMain.GetSize(m_aiSize, 3);
+	m_iMode = aLoadMain.GetMode();
+	m_fPixSize = aLoadMain.GetPixelSize();
+	m_bSwapByte = aLoadMain.m_bSwapByte;
+	int iSymbt = aLoadMain.GetSymbt();
+	//-----------------
+	struct stat aStat;
+	bool bValid = (fstat(iFile, &aStat) == 0);
+	if(m_aiSize[0] <= 0 || m_aiSize[1] <= 0) bValid = false;
+	if(m_aiSize[2] <= 0 || iSymbt < 0) bValid = false;
+	if(bValid)
+	{	m_tSecBytes = Mrc::C4BitImage::GetImgBytes(m_iMode, m_aiSize);
+		m_tDataStart = 1024 + (size_t)iSymbt;
+		size_t tEnd = m_tDataStart + m_tSecBytes * m_aiSize[2];
+		if(m_tSecBytes == 0 || tEnd > (size_t)aStat.st_size)
+		{	bValid = false;
+		}
+	}
+	if(!bValid)
+	{	close(iFile);
+		return false;
+	}
+	//-----------------
+	m_tMapBytes = aStat.st_size;
+	void* pvMap = mmap(0L, m_tMapBytes, PROT_READ | PROT_WRITE,
+	   MAP_PRIVATE, iFile, 0);
+	close(iFile);
+	if(pvMap == MAP_FAILED)
+	{	m_tMapBytes = 0;
+		return false;
+	}
+	m_pcMap = (char*)pvMap;
+	madvise(m_pcMap, m_tMapBytes, MADV_SEQUENTIAL);
+	//-----------------
+	m_iAhead = (int)(s_tAheadBytes / m_tSecBytes);
+	if(m_iAhead < 1) m_iAhead = 1;
+	m_iAdvised = 0;
+	return true;
+}
+
+void CMapMrc::CloseFile(void)
+{
+	if(m_pcMap != 0L) munmap(m_pcMap, m_tMapBytes);
+	m_pcMap = 0L;
+	m_tMapBytes = 0;
+	m_iAdvised = 0;
+}
+
+void* CMapMrc::GetSection(int iSection)
+{
+	if(m_pcMap == 0L) return 0L;
+	if(iSection < 0 || iSection >= m_aiSize[2]) return 0L;
+	return m_pcMap + m_tDataStart + iSection * m_tSecBytes;
+}
+
+bool CMapMrc::ReadFloat(int iSection, float* pfImg)
+{
+	void* pvSec = this->GetSection(iSection);
+	if(pvSec == 0L) return false;
+	this->WillNeed(iSection, m_iAhead);
+	//-----------------
+	size_t tPixels = (size_t)m_aiSize[0] * m_aiSize[1];
+	if(m_iMode == Mrc::eMrcFloat)
+	{	if(!m_bSwapByte) memcpy(pfImg, pvSec, m_tSecBytes);
+		else sSwapToFloat((unsigned int*)pvSec, pfImg, tPixels);
+	}
+	else if(m_iMode == Mrc::eMrcShort)
+	{	if(!m_bSwapByte) sToFloat((short*)pvSec, pfImg, tPixels);
+		else sSwapToFloat((unsigned short*)pvSec, pfImg, tPixels, true);
+	}
+	else if(m_iMode == Mrc::eMrcUShort)
+	{	if(!m_bSwapByte)
+		{	sToFloat((unsigned short*)pvSec, pfImg, tPixels);
+		}
+		else
+		{	sSwapToFloat((unsigned short*)pvSec, pfImg,
+			   tPixels, false);
+		}
+	}
+	else if(m_iMode == 0)
+	{	sToFloat((char*)pvSec, pfImg, tPixels);
+	}
+	else return false;
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Sections that have already been advised are skipped, so that
+//    calling this for every section advances a sliding window.
+//-------------------------------------------------------------------
+void CMapMrc::WillNeed(int iStart, int iNumSections)
+{
+	if(m_pcMap == 0L) return;
+	int iEnd = iStart + iNumSections;
+	if(iEnd > m_aiSize[2]) iEnd = m_aiSize[2];
+	if(iStart < m_iAdvised) iStart = m_iAdvised;
+	if(iStart >= iEnd) return;
+	//-----------------
+	size_t tPage = (size_t)sysconf(_SC_PAGESIZE);
+	size_t tStart = m_tDataStart + iStart * m_tSecBytes;
+	size_t tEnd = m_tDataStart + iEnd * m_tSecBytes;
+	tStart = tStart / tPage * tPage;
+	madvise(m_pcMap + tStart, tEnd - tStart, MADV_WILLNEED);
+	m_iAdvised = iEnd;
+}
+
+//-------------------------------------------------------------------
+// 1. Sections can be used in place as float images when they are
+//    floats in native byte order aligned to 4 bytes.
+//-------------------------------------------------------------------
+bool CMapMrc::bFloatView(void)
+{
+	if(m_pcMap == 0L) return false;
+	if(m_iMode != Mrc::eMrcFloat || m_bSwapByte) return false;
+	return (m_tDataStart % sizeof(float)) == 0;
+}
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <memory.h>
+#include <utility>
 
 using namespace McAreTomo;
 using namespace McAreTomo::DataUtil;
@@ -10,13 +11,18 @@ using namespace McAreTomo::DataUtil;
 CMcPackage* CMcPackage::m_pInstances = 0L;
 int CMcPackage::m_iNumGpus = 0;
 
+//-------------------------------------------------------------------
+// 1. Instances iNumGpus to 2 * iNumGpus - 1 are the prefetch slots
+//    into which MotionCor::CPrefetchMovie loads the next movie.
+//-------------------------------------------------------------------
 void CMcPackage::CreateInstances(int iNumGpus)
 {
 	if(m_iNumGpus == iNumGpus) return;
 	//-----------------
 	if(m_pInstances != 0L) delete[] m_pInstances;
-	m_pInstances = new CMcPackage[iNumGpus];
-	for(int i=0; i<iNumGpus; i++)
+	int iSize = 2 * iNumGpus;
+	m_pInstances = new CMcPackage[iSize];
+	for(int i=0; i<iSize; i++)
 	{	m_pInstances[i].m_iNthGpu = i;
 	}
 	m_iNumGpus = iNumGpus;
@@ -37,7 +43,7 @@ CMcPackage* CMcPackage::GetInstance(int iNthGpu)
 
 CMcPackage::CMcPackage(void)
 {
-	m_pRawStack = new CMrcStack;
+	m_pRawStack = new CRawStack;
 	m_pAlnSums = new CAlnSums;
 	memset(m_acMoviePath, 0, sizeof(m_acMoviePath));
 	//-----------------
@@ -60,6 +66,20 @@ void CMcPackage::SetMovieName(char* pcMovieName)
 	strcat(m_acMoviePath, pcMovieName);
 }
 
+//-------------------------------------------------------------------
+// 1. Exchanges the loaded movie with pPackage. The aligned sums stay
+//    with each instance since they are produced after loading.
+//-------------------------------------------------------------------
+void CMcPackage::Swap(CMcPackage* pPackage)
+{
+	std::swap(m_pRawStack, pPackage->m_pRawStack);
+	std::swap(m_acMoviePath, pPackage->m_acMoviePath);
+	std::swap(m_iAcqIdx, pPackage->m_iAcqIdx);
+	std::swap(m_fTilt, pPackage->m_fTilt);
+	std::swap(m_fPixSize, pPackage->m_fPixSize);
+	std::swap(m_fTotalDose, pPackage->m_fTotalDose);
+}
+
 bool CMcPackage::bTiffFile(void)
 {
 	char* pcDot = strrchr(m_acMoviePath, '.');
@@ -12,57 +12,52 @@ CMrcStack::CMrcStack(void)
 	memset(m_aiStkSize, 0, sizeof(m_aiStkSize));
 	m_iMode = -1;
 	m_tFmBytes = 0;
-	m_iBufSize = 0;
 	//-----------------
 	m_iBufSize = 0;
 	m_ppvFrames = 0L;
+	m_pvBlock = 0L;
+	m_tBlockBytes = 0;
+	m_pMapMrc = 0L;
 }
 
 CMrcStack::~CMrcStack(void)
 {
 	mCleanFrames();
 }
-/*
-void CMrcStack::Create(int iMode, int* piStkSize)
-{
-	//----------------------------------------------------
-	// reallocate only when the new frame byte is larger.
-	//----------------------------------------------------	
-	size_t tFmBytes = Mrc::C4BitImage::GetImgBytes(iMode, piStkSize);
-	if(tFmBytes > m_tFmBytes)
-	{	mCleanFrames();
-		m_tFmBytes = tFmBytes;
-		mExpandBuf(piStkSize[2]);
-	}
-	//-----------------------------------------
-	// increase number of frames of the buffer
-	//-----------------------------------------
-	else
-	{	m_tFmBytes = tFmBytes;
-		if(piStkSize[2] > m_iBufSize) mExpandBuf(piStkSize[2]);
-	}
-	m_iMode = iMode;
-	memcpy(m_aiStkSize, piStkSize, sizeof(int) * 3);
-}
-*/
 
+//-------------------------------------------------------------------
+// 1. The block is kept when it can hold the new stack and is not
+//    more than twice its size. Otherwise it is returned to the
+//    arena, which may hand out a better fitting one.
+// 2. Frames are laid out contiguously in the block. Frame pointers
+//    may later be permuted (CTiltSeries::SortByTilt) but are never
+//    freed individually.
+//-------------------------------------------------------------------
 void CMrcStack::Create(int iMode, int* piStkSize)
 {
-	mCleanFrames();
-	//-----------------
 	m_iMode = iMode;
 	memcpy(m_aiStkSize, piStkSize, sizeof(int) * 3);
 	m_tFmBytes = Mrc::C4BitImage::GetImgBytes(iMode, piStkSize);
 	//-----------------
-	m_ppvFrames = new void*[piStkSize[2]];
-        for(int i=0; i<piStkSize[2]; i++)
-	{	m_ppvFrames[i] = new char[m_tFmBytes];
+	size_t tBytes = m_tFmBytes * piStkSize[2];
+	if(tBytes > m_tBlockBytes || 2 * tBytes < m_tBlockBytes)
+	{	mCleanFrames();
+		CStackArena* pArena = CStackArena::GetInstance();
+		if(tBytes > 0) m_pvBlock = pArena->Alloc(tBytes, &m_tBlockBytes);
+	}
+	//-----------------
+	if(piStkSize[2] > m_iBufSize)
+	{	if(m_ppvFrames != 0L) delete[] m_ppvFrames;
+		m_ppvFrames = new void*[piStkSize[2]];
+		m_iBufSize = piStkSize[2];
+	}
+	//-----------------
+	char* pcBlock = (char*)m_pvBlock;
+	for(int i=0; i<piStkSize[2]; i++)
+	{	m_ppvFrames[i] = pcBlock + i * m_tFmBytes;
 	}
-        //-----------------
-        m_iBufSize = piStkSize[2];
 }
 
-
 void* CMrcStack::GetFrame(int iFrame)
 {
 	if(m_ppvFrames == 0L) return 0L;
@@ -75,34 +70,49 @@ int CMrcStack::GetPixels(void)
 	return m_aiStkSize[0] * m_aiStkSize[1];
 }
 
-void CMrcStack::mCleanFrames(void)
+//-------------------------------------------------------------------
+// 1. The stack must have been created as float and pMapMrc must
+//    have the same image size and at least as many sections.
+// 2. On success the block is released and the stack takes over
+//    pMapMrc. On failure the caller still owns it.
+//-------------------------------------------------------------------
+bool CMrcStack::MapFrames(CMapMrc* pMapMrc)
 {
-	if(m_ppvFrames == 0L) return;
-	for(int i=0; i<m_iBufSize; i++)
-	{	char* pcFrame = (char*)m_ppvFrames[i];
-		if(pcFrame != 0L) delete[] pcFrame;
+	if(pMapMrc == 0L || !pMapMrc->bFloatView()) return false;
+	if(m_iMode != Mrc::eMrcFloat) return false;
+	if(pMapMrc->m_aiSize[0] != m_aiStkSize[0]) return false;
+	if(pMapMrc->m_aiSize[1] != m_aiStkSize[1]) return false;
+	if(pMapMrc->m_aiSize[2] < m_aiStkSize[2]) return false;
+	if(m_ppvFrames == 0L) return false;
+	//-----------------
+	if(m_pvBlock != 0L)
+	{	CStackArena* pArena = CStackArena::GetInstance();
+		pArena->Free(m_pvBlock, m_tBlockBytes);
+		m_pvBlock = 0L;
+		m_tBlockBytes = 0;
 	}
+	if(m_pMapMrc != 0L) delete m_pMapMrc;
+	m_pMapMrc = pMapMrc;
 	//-----------------
-	delete[] (char**)m_ppvFrames;
-	m_ppvFrames = 0L;
-	m_iBufSize = 0;
+	for(int i=0; i<m_aiStkSize[2]; i++)
+	{	m_ppvFrames[i] = m_pMapMrc->GetSection(i);
+	}
+	m_pMapMrc->WillNeed(0, m_aiStkSize[2]);
+	return true;
 }
 
-void CMrcStack::mExpandBuf(int iNumFrames)
+void CMrcStack::mCleanFrames(void)
 {
-	if(iNumFrames <= m_iBufSize) return;
-	//-----------------
-	void** ppvFrames = new void*[iNumFrames];
-	for(int i=0; i<m_iBufSize; i++)
-	{	ppvFrames[i] = m_ppvFrames[i];
-	}
+	if(m_ppvFrames != 0L) delete[] m_ppvFrames;
+	m_ppvFrames = 0L;
+	m_iBufSize = 0;
 	//-----------------
-	for(int i=m_iBufSize; i<iNumFrames; i++)
-	{	ppvFrames[i] = new char[m_tFmBytes];
-	}
+	if(m_pMapMrc != 0L) delete m_pMapMrc;
+	m_pMapMrc = 0L;
 	//-----------------
-	if(m_ppvFrames != 0L) delete[] (char**)m_ppvFrames;
-	m_ppvFrames = ppvFrames;
-	m_iBufSize = iNumFrames;
+	if(m_pvBlock == 0L) return;
+	CStackArena* pArena = CStackArena::GetInstance();
+	pArena->Free(m_pvBlock, m_tBlockBytes);
+	m_pvBlock = 0L;
+	m_tBlockBytes = 0;
 }
-
@@ -0,0 +1,114 @@
+#include "CDataUtilInc.h"
+#include <Mrcfile/CMrcFileInc.h>
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::DataUtil;
+
+CRawStack::CRawStack(void)
+{
+	m_ppiSparse = 0L;
+	m_piNumPairs = 0L;
+	m_ppucDense = 0L;
+	m_iNumExtras = 0;
+}
+
+CRawStack::~CRawStack(void)
+{
+	mCleanExtras();
+}
+
+void CRawStack::Create(int iMode, int* piStkSize)
+{
+	mCleanExtras();
+	CMrcStack::Create(iMode, piStkSize);
+	if(iMode != Mrc::eMrc4Bits) return;
+	//-----------------
+	m_iNumExtras = piStkSize[2];
+	m_ppiSparse = new int*[m_iNumExtras];
+	m_piNumPairs = new int[m_iNumExtras];
+	m_ppucDense = new unsigned char*[m_iNumExtras];
+	memset(m_ppiSparse, 0, sizeof(int*) * m_iNumExtras);
+	memset(m_piNumPairs, 0, sizeof(int) * m_iNumExtras);
+	memset(m_ppucDense, 0, sizeof(unsigned char*) * m_iNumExtras);
+}
+
+bool CRawStack::bPacked(void)
+{
+	return (m_iMode == Mrc::eMrc4Bits);
+}
+
+//-------------------------------------------------------------------
+// 1. pucFrame holds one count per byte. It is copied as it is when
+//    the stack is not packed.
+// 2. Frames can be set concurrently by different threads.
+//-------------------------------------------------------------------
+void CRawStack::SetFrame(int iFrame, unsigned char* pucFrame)
+{
+	void* pvFrame = this->GetFrame(iFrame);
+	if(pvFrame == 0L) return;
+	if(!this->bPacked())
+	{	memcpy(pvFrame, pucFrame, m_tFmBytes);
+		return;
+	}
+	//-----------------
+	Mrc::C4BitImage::Pack(pucFrame, m_aiStkSize, pvFrame);
+	if(m_ppiSparse[iFrame] != 0L) delete[] m_ppiSparse[iFrame];
+	if(m_ppucDense[iFrame] != 0L) delete[] m_ppucDense[iFrame];
+	m_ppiSparse[iFrame] = 0L;
+	m_ppucDense[iFrame] = 0L;
+	m_piNumPairs[iFrame] = 0;
+	//-----------------
+	int iPixels = this->GetPixels();
+	int iNumPairs = 0;
+	for(int i=0; i<iPixels; i++)
+	{	if(pucFrame[i] > 15) iNumPairs += 1;
+	}
+	if(iNumPairs == 0) return;
+	//-----------------
+	if(iNumPairs > iPixels / 16)
+	{	m_ppucDense[iFrame] = new unsigned char[iPixels];
+		memcpy(m_ppucDense[iFrame], pucFrame, iPixels);
+		return;
+	}
+	//-----------------
+	int* piPairs = new int[iNumPairs * 2];
+	int j = 0;
+	for(int i=0; i<iPixels; i++)
+	{	if(pucFrame[i] <= 15) continue;
+		piPairs[j] = i;
+		piPairs[j+1] = pucFrame[i];
+		j += 2;
+	}
+	m_ppiSparse[iFrame] = piPairs;
+	m_piNumPairs[iFrame] = iNumPairs;
+}
+
+int* CRawStack::GetSparse(int iFrame, int* piNumPairs)
+{
+	piNumPairs[0] = 0;
+	if(iFrame < 0 || iFrame >= m_iNumExtras) return 0L;
+	piNumPairs[0] = m_piNumPairs[iFrame];
+	return m_ppiSparse[iFrame];
+}
+
+unsigned char* CRawStack::GetDense(int iFrame)
+{
+	if(iFrame < 0 || iFrame >= m_iNumExtras) return 0L;
+	return m_ppucDense[iFrame];
+}
+
+void CRawStack::mCleanExtras(void)
+{
+	for(int i=0; i<m_iNumExtras; i++)
+	{	if(m_ppiSparse[i] != 0L) delete[] m_ppiSparse[i];
+		if(m_ppucDense[i] != 0L) delete[] m_ppucDense[i];
+	}
+	if(m_ppiSparse != 0L) delete[] m_ppiSparse;
+	if(m_piNumPairs != 0L) delete[] m_piNumPairs;
+	if(m_ppucDense != 0L) delete[] m_ppucDense;
+	m_ppiSparse = 0L;
+	m_piNumPairs = 0L;
+	m_ppucDense = 0L;
+	m_iNumExtras = 0;
+}
@@ -40,6 +40,7 @@ CReadMdoc::CReadMdoc(void)
 	m_iNthGpu = 0;
 	m_iBufSize = 1024;
 	m_iNumTilts = 0;
+	m_lOffset = 0;
 	//-----------------
 	m_ppcFrmPath = new char*[m_iBufSize];
 	m_piAcqIdxs = new int[m_iBufSize];
@@ -95,60 +96,82 @@ float CReadMdoc::GetDose(int iTilt)
 
 bool CReadMdoc::DoIt(const char* pcMdocFile)
 {
-	mClean();
-	FILE* pFile = fopen(pcMdocFile, "rt");
-	if(pFile == 0L) return false;
+	bool bOpen = this->Open(pcMdocFile);
+	if(!bOpen) return false;
 	//-----------------
+	if(m_iNumTilts >= 7) return true;
+	else return false;
+}
+
+//--------------------------------------------------------------------
+// 1. Reads the tilts already listed in pcMdocFile. ReadNew picks up
+//    those appended later.
+//--------------------------------------------------------------------
+bool CReadMdoc::Open(const char* pcMdocFile)
+{
+	mClean();
 	memset(m_acMdocFile, 0, sizeof(m_acMdocFile));
 	strcpy(m_acMdocFile, pcMdocFile);
+	m_lOffset = 0;
 	//-----------------
-	m_iNumTilts = 0;
+	int iNumNew = this->ReadNew();
+	if(iNumNew < 0) return false;
+	else return true;
+}
+
+//--------------------------------------------------------------------
+// 1. Parses the [ZValue] sections after m_lOffset, which is moved
+//    past the last complete section. A section is complete once
+//    its SubFramePath line has been written in full.
+// 2. Returns the number of new tilts, or -1 if the mdoc file
+//    cannot be opened.
+//--------------------------------------------------------------------
+int CReadMdoc::ReadNew(void)
+{
+	FILE* pFile = fopen(m_acMdocFile, "rt");
+	if(pFile == 0L) return -1;
+	if(fseek(pFile, m_lOffset, SEEK_SET) != 0)
+	{	fclose(pFile);
+		return 0;
+	}
+	//-----------------
+	int iNumNew = 0;
+	int iValZ = -1, iStage = 0;
+	float fTilt = 0.0f, fDose = 0.0f;
 	char acBuf[256] = {'\0'};
-	bool bTiltLoaded, bDoseLoaded, bFmLoaded;
 	//-----------------
-	while(!feof(pFile))
+	while(m_iNumTilts < m_iBufSize)
 	{	memset(acBuf, 0, sizeof(char) * 256);
 		char* pcRet = fgets(acBuf, 256, pFile);
-		if(pcRet == 0L) continue;
-		//----------------
-		int iValZ = mExtractValZ(acBuf);
-		if(iValZ < 0) continue;
-		m_piAcqIdxs[m_iNumTilts] = iValZ;
+		if(pcRet == 0L) break;
+		if(strchr(acBuf, '\n') == 0L && feof(pFile)) break;
 		//----------------
-		bTiltLoaded = false;
-		bDoseLoaded = false;
-		bFmLoaded = false;
-		//----------------
-		while(!feof(pFile))
-		{	memset(acBuf, 0, sizeof(char) * 256);
-			char* pcRet = fgets(acBuf, 256, pFile);
-			if(pcRet == 0L) continue;
+		if(iStage == 0)
+		{	iValZ = mExtractValZ(acBuf);
+			if(iValZ >= 0) iStage = 1;
+		}
+		else if(iStage == 1)
+		{	if(mExtractTilt(acBuf, &fTilt)) iStage = 2;
+		}
+		else if(iStage == 2)
+		{	if(mExtractDose(acBuf, &fDose)) iStage = 3;
+		}
+		else
+		{	char* pcFramePath = mExtractFramePath(acBuf);
+			if(pcFramePath == 0L) continue;
 			//---------------
-			if(!bTiltLoaded)
-			{	bTiltLoaded = mExtractTilt(acBuf, 
-				   &m_pfTilts[m_iNumTilts]);
-			}
-			else if(!bDoseLoaded)
-			{	bDoseLoaded = mExtractDose(acBuf, 
-				   &m_pfDoses[m_iNumTilts]);
-                        }
-			else if(!bFmLoaded)
-			{	char* pcFramePath = mExtractFramePath(acBuf);
-				if(pcFramePath != 0L)
-				{	m_ppcFrmPath[m_iNumTilts] = pcFramePath;
-					bFmLoaded = true;
-				}
-			}
-			else
-			{	m_iNumTilts += 1;
-				break;
-			}
+			m_piAcqIdxs[m_iNumTilts] = iValZ;
+			m_pfTilts[m_iNumTilts] = fTilt;
+			m_pfDoses[m_iNumTilts] = fDose;
+			m_ppcFrmPath[m_iNumTilts] = pcFramePath;
+			m_iNumTilts += 1;
+			iNumNew += 1;
+			iStage = 0;
+			m_lOffset = ftell(pFile);
 		}
 	}
 	fclose(pFile);
-	//-----------------
-	if(m_iNumTilts >= 7) return true;
-	else return false;
+	return iNumNew;
 }
 
 int CReadMdoc::mExtractValZ(char* pcLine)
@@ -211,4 +234,5 @@ void CReadMdoc::mClean(void)
 		m_ppcFrmPath[i] = 0L;
 	}
 	m_iNumTilts = 0;
+	m_lOffset = 0;
 }
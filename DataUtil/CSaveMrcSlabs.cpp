@@ -0,0 +1,262 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo::DataUtil;
+
+static const int s_iTileRows = 16;
+static const int s_iTileX = 512;
+
+CSaveMrcSlabs::CSaveMrcSlabs(void)
+{
+	m_iFile = -1;
+	m_pfStage = 0L;
+	m_tStageFloats = 0;
+	m_tHeaderBytes = 0;
+	m_tFileBytes = 0;
+	m_iFlipVol = 0;
+	m_fPixSize = 0.0f;
+	memset(m_aiVolSize, 0, sizeof(m_aiVolSize));
+}
+
+CSaveMrcSlabs::~CSaveMrcSlabs(void)
+{
+	mClean();
+}
+
+//-------------------------------------------------------------------
+// 1. The header is written first without statistics so that the
+//    slabs can be written at their final offsets.
+//-------------------------------------------------------------------
+bool CSaveMrcSlabs::Open
+(	const char* pcMrcFile,
+	int* piVolSize,
+	int iFlipVol,
+	float fPixSize
+)
+{	mClean();
+	memcpy(m_aiVolSize, piVolSize, sizeof(m_aiVolSize));
+	m_iFlipVol = iFlipVol;
+	m_fPixSize = fPixSize;
+	m_afMinMax[0] = (float)1e30;
+	m_afMinMax[1] = (float)-1e30;
+	m_dSum = 0.0;
+	m_tPixels = 0;
+	m_tFileBytes = 0;
+	//-----------------
+	int iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+	mode_t aMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+	m_iFile = open(pcMrcFile, iFlags, aMode);
+	if(m_iFile == -1)
+	{	fprintf(stderr, "Error: unable to open %s\n"
+		   "   %s\n\n", pcMrcFile, strerror(errno));
+		return false;
+	}
+	bool bStats = true;
+	return mWriteHeader(!bStats);
+}
+
+bool CSaveMrcSlabs::DoIt(CTiltSeries* pSlab, int iStartY)
+{
+	if(m_iFile == -1) return false;
+	bool bWritten = false;
+	if(m_iFlipVol == 0) bWritten = mWriteXZY(pSlab, iStartY);
+	else bWritten = mWriteXYZ(pSlab, iStartY);
+	if(!bWritten)
+	{	fprintf(stderr, "Error: unable to write slab at y %d\n"
+		   "   %s\n\n", iStartY, strerror(errno));
+		return false;
+	}
+	//-----------------------------------------------
+	// 1) Start write-back of what has been written
+	// so that dirty pages do not pile up over the
+	// slabs.
+	//-----------------------------------------------
+	sync_file_range(m_iFile, 0, 0, SYNC_FILE_RANGE_WRITE);
+	return true;
+}
+
+bool CSaveMrcSlabs::Close(void)
+{
+	if(m_iFile == -1) return false;
+	bool bStats = true;
+	bool bClosed = mWriteHeader(bStats);
+	if(close(m_iFile) != 0) bClosed = false;
+	m_iFile = -1;
+	//-----------------
+	if(m_pfStage != 0L) delete[] m_pfStage;
+	m_pfStage = 0L;
+	m_tStageFloats = 0;
+	return bClosed;
+}
+
+//-------------------------------------------------------------------
+// 1. Bytes of the staging buffer for a slab of iNumRows y-slices.
+//    It is needed only when the volume is saved in xyz.
+//-------------------------------------------------------------------
+size_t CSaveMrcSlabs::GetStageBytes(int iNumRows)
+{
+	if(m_iFlipVol == 0) return 0;
+	return sizeof(float) * m_aiVolSize[0] * m_aiVolSize[1] * iNumRows;
+}
+
+//-------------------------------------------------------------------
+// 1. Each xz slice is a section of the output file.
+//-------------------------------------------------------------------
+bool CSaveMrcSlabs::mWriteXZY(CTiltSeries* pSlab, int iStartY)
+{
+	size_t tPixels = (size_t)m_aiVolSize[0] * m_aiVolSize[1];
+	size_t tBytes = tPixels * sizeof(float);
+	for(int i=0; i<pSlab->m_aiStkSize[2]; i++)
+	{	float* pfFrm = (float*)pSlab->GetFrame(i);
+		double dSum = 0.0;
+		for(size_t p=0; p<tPixels; p++)
+		{	if(pfFrm[p] < m_afMinMax[0]) m_afMinMax[0] = pfFrm[p];
+			if(pfFrm[p] > m_afMinMax[1]) m_afMinMax[1] = pfFrm[p];
+			dSum += pfFrm[p];
+		}
+		m_dSum += dSum;
+		m_tPixels += tPixels;
+		//----------------
+		size_t tOffset = m_tHeaderBytes + (iStartY + i) * tBytes;
+		if(!mWriteAll(pfFrm, tBytes, tOffset)) return false;
+		m_tFileBytes += tBytes;
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. After the transpose the rows of the slab for xy section z are
+//    contiguous in the staging buffer and go to the file in one
+//    write each.
+//-------------------------------------------------------------------
+bool CSaveMrcSlabs::mWriteXYZ(CTiltSeries* pSlab, int iStartY)
+{
+	mTranspose(pSlab);
+	//-----------------
+	int iNumRows = pSlab->m_aiStkSize[2];
+	int iLastZ = m_aiVolSize[1] - 1;
+	size_t tRowBytes = sizeof(float) * m_aiVolSize[0];
+	size_t tSecBytes = tRowBytes * m_aiVolSize[2];
+	size_t tBytes = tRowBytes * iNumRows;
+	for(int z=0; z<=iLastZ; z++)
+	{	int iSec = (m_iFlipVol == 1) ? (iLastZ - z) : z;
+		float* pfSrc = m_pfStage + (size_t)z * iNumRows
+		   * m_aiVolSize[0];
+		size_t tOffset = m_tHeaderBytes + iSec * tSecBytes
+		   + iStartY * tRowBytes;
+		if(!mWriteAll(pfSrc, tBytes, tOffset)) return false;
+		m_tFileBytes += tBytes;
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Swaps the y and z axes of the slab. It walks tiles of 16 z
+//    rows by 16 y slices and 512 x so that the rows read from the
+//    slab and those written to the staging buffer stay in cache.
+// 2. Min, max, and mean are collected on the way.
+//-------------------------------------------------------------------
+void CSaveMrcSlabs::mTranspose(CTiltSeries* pSlab)
+{
+	int iSizeX = m_aiVolSize[0];
+	int iSizeZ = m_aiVolSize[1];
+	int iNumRows = pSlab->m_aiStkSize[2];
+	size_t tFloats = (size_t)iSizeX * iSizeZ * iNumRows;
+	if(tFloats > m_tStageFloats)
+	{	if(m_pfStage != 0L) delete[] m_pfStage;
+		m_pfStage = new float[tFloats];
+		m_tStageFloats = tFloats;
+	}
+	//-----------------
+	float fMin = m_afMinMax[0], fMax = m_afMinMax[1];
+	double dSum = 0.0;
+	for(int z0=0; z0<iSizeZ; z0+=s_iTileRows)
+	{	int z1 = z0 + s_iTileRows;
+		if(z1 > iSizeZ) z1 = iSizeZ;
+		for(int y0=0; y0<iNumRows; y0+=s_iTileRows)
+		{	int y1 = y0 + s_iTileRows;
+			if(y1 > iNumRows) y1 = iNumRows;
+			for(int x0=0; x0<iSizeX; x0+=s_iTileX)
+			{	int iCount = iSizeX - x0;
+				if(iCount > s_iTileX) iCount = s_iTileX;
+				for(int y=y0; y<y1; y++)
+				{	float* pfFrm = (float*)pSlab->GetFrame(y);
+					for(int z=z0; z<z1; z++)
+					{	float* pfSrc = pfFrm + z * iSizeX + x0;
+						float* pfDst = m_pfStage + ((size_t)z
+						   * iNumRows + y) * iSizeX + x0;
+						float fSum = 0.0f;
+						for(int x=0; x<iCount; x++)
+						{	float fVal = pfSrc[x];
+							pfDst[x] = fVal;
+							fMin = (fVal < fMin) ? fVal : fMin;
+							fMax = (fVal > fMax) ? fVal : fMax;
+							fSum += fVal;
+						}
+						dSum += fSum;
+					}
+				}
+			}
+		}
+	}
+	m_afMinMax[0] = fMin;
+	m_afMinMax[1] = fMax;
+	m_dSum += dSum;
+	m_tPixels += tFloats;
+}
+
+bool CSaveMrcSlabs::mWriteHeader(bool bStats)
+{
+	int aiImgSize[2] = {m_aiVolSize[0], m_aiVolSize[1]};
+	int iNumSecs = m_aiVolSize[2];
+	if(m_iFlipVol != 0)
+	{	aiImgSize[1] = m_aiVolSize[2];
+		iNumSecs = m_aiVolSize[1];
+	}
+	//-----------------
+	Mrc::CSaveMainHeader aSaveMain;
+	aSaveMain.SetMode(Mrc::eMrcFloat);
+	aSaveMain.SetImgSize(aiImgSize, iNumSecs, 1, m_fPixSize);
+	if(bStats && m_tPixels > 0)
+	{	float fMean = (float)(m_dSum / m_tPixels);
+		aSaveMain.SetMinMaxMean(m_afMinMax[0], m_afMinMax[1], fMean);
+	}
+	//-----------------
+	m_tHeaderBytes = sizeof(aSaveMain.m_aHeader);
+	bool bWritten = mWriteAll(&aSaveMain.m_aHeader, m_tHeaderBytes, 0);
+	if(!bWritten)
+	{	fprintf(stderr, "Error: unable to write MRC header\n"
+		   "   %s\n\n", strerror(errno));
+	}
+	return bWritten;
+}
+
+bool CSaveMrcSlabs::mWriteAll(void* pvBuf, size_t tBytes, size_t tOffset)
+{
+	char* pcBuf = (char*)pvBuf;
+	while(tBytes > 0)
+	{	ssize_t tWritten = pwrite(m_iFile, pcBuf, tBytes, tOffset);
+		if(tWritten < 0 && errno == EINTR) continue;
+		if(tWritten <= 0) return false;
+		pcBuf += tWritten;
+		tBytes -= tWritten;
+		tOffset += tWritten;
+	}
+	return true;
+}
+
+void CSaveMrcSlabs::mClean(void)
+{
+	if(m_iFile != -1) close(m_iFile);
+	if(m_pfStage != 0L) delete[] m_pfStage;
+	m_iFile = -1;
+	m_pfStage = 0L;
+	m_tStageFloats = 0;
+}
@@ -0,0 +1,316 @@
+#include "CDataUtilInc.h"
+#include <Util/Util_Time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <vector>
+
+using namespace McAreTomo::DataUtil;
+
+static const size_t s_tAlign = 4096;
+
+CSaveMrcStack::CSaveMrcStack(void)
+{
+	m_pMrcStack = 0L;
+	m_pcHeader = 0L;
+	m_tHeaderBytes = 0;
+	m_iNumInts = 0;
+	m_iNumFloats = 0;
+	m_iFile = -1;
+	m_fPixSize = 0.0f;
+	m_bStats = false;
+	memset(m_afStats, 0, sizeof(m_afStats));
+	//-----------------
+	m_tBatchBytes = 256 * 1024 * 1024;
+	m_tStageBytes = 64 * 1024 * 1024;
+	m_tFileBytes = 0;
+	m_fSeconds = 0.0f;
+	m_bDirect = false;
+	m_bSync = false;
+}
+
+CSaveMrcStack::~CSaveMrcStack(void)
+{
+	mClean();
+}
+
+void CSaveMrcStack::SetExtHeader(int iNumInts, int iNumFloats)
+{
+	m_iNumInts = (iNumInts > 0) ? iNumInts : 0;
+	m_iNumFloats = (iNumFloats > 0) ? iNumFloats : 0;
+}
+
+//-------------------------------------------------------------------
+// 1. Overrides the pixel size of the stack when fPixSize > 0.
+//-------------------------------------------------------------------
+void CSaveMrcStack::SetPixSize(float fPixSize)
+{
+	m_fPixSize = fPixSize;
+}
+
+void CSaveMrcStack::SetMinMaxMean(float fMin, float fMax, float fMean)
+{
+	m_afStats[0] = fMin;
+	m_afStats[1] = fMax;
+	m_afStats[2] = fMean;
+	m_bStats = true;
+}
+
+bool CSaveMrcStack::DoIt
+(	const char* pcMrcFile,
+	CMrcStack* pMrcStack,
+	float* pfTilts,
+	bool bDirect
+)
+{	mClean();
+	m_pMrcStack = pMrcStack;
+	m_tFileBytes = 0;
+	m_fSeconds = 0.0f;
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	mBuildHeader(pfTilts);
+	//-----------------
+	int iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+	mode_t aMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+	m_bDirect = false;
+	if(bDirect)
+	{	m_iFile = open(pcMrcFile, iFlags | O_DIRECT, aMode);
+		m_bDirect = (m_iFile != -1);
+	}
+	if(m_iFile == -1) m_iFile = open(pcMrcFile, iFlags, aMode);
+	if(m_iFile == -1)
+	{	fprintf(stderr, "Error: unable to open %s\n"
+		   "   %s\n\n", pcMrcFile, strerror(errno));
+		return false;
+	}
+	//-----------------------------------------------
+	// 1) Some file systems accept O_DIRECT in open
+	// but reject the writes. Rewrite the file with
+	// buffered writes in that case.
+	//-----------------------------------------------
+	bool bSaved = false;
+	if(m_bDirect) bSaved = mWriteDirect();
+	if(!bSaved && m_bDirect)
+	{	mSetDirect(false);
+		m_bDirect = false;
+	}
+	if(!m_bDirect) bSaved = mWriteVectored();
+	if(bSaved && m_bSync && fdatasync(m_iFile) != 0) bSaved = false;
+	//-----------------
+	if(close(m_iFile) != 0) bSaved = false;
+	m_iFile = -1;
+	m_fSeconds = aTimer.GetElapsedSeconds();
+	//-----------------
+	if(!bSaved)
+	{	fprintf(stderr, "Error: unable to save %s\n"
+		   "   %s\n\n", pcMrcFile, strerror(errno));
+	}
+	return bSaved;
+}
+
+void CSaveMrcStack::mBuildHeader(float* pfTilts)
+{
+	int* piStkSize = m_pMrcStack->m_aiStkSize;
+	float fPixSize = (m_fPixSize > 0) ? m_fPixSize :
+	   m_pMrcStack->m_fPixSize;
+	int iEntryBytes = (m_iNumInts + m_iNumFloats) * sizeof(float);
+	int iExtBytes = iEntryBytes * piStkSize[2];
+	//-----------------
+	Mrc::CSaveMainHeader aSaveMain;
+	aSaveMain.SetMode(m_pMrcStack->m_iMode);
+	aSaveMain.SetImgSize(piStkSize, piStkSize[2], 1, fPixSize);
+	aSaveMain.SetNumInts(m_iNumInts);
+	aSaveMain.SetNumFloats(m_iNumFloats);
+	aSaveMain.SetSymbt(iExtBytes);
+	if(m_bStats)
+	{	aSaveMain.SetMinMaxMean(m_afStats[0],
+		   m_afStats[1], m_afStats[2]);
+	}
+	//-----------------
+	int iMainBytes = sizeof(aSaveMain.m_aHeader);
+	m_tHeaderBytes = iMainBytes + iExtBytes;
+	m_pcHeader = new char[m_tHeaderBytes];
+	memset(m_pcHeader, 0, m_tHeaderBytes);
+	memcpy(m_pcHeader, &aSaveMain.m_aHeader, iMainBytes);
+	//-----------------
+	if(pfTilts == 0L || m_iNumFloats <= 0) return;
+	char* pcExt = m_pcHeader + iMainBytes + m_iNumInts * sizeof(int);
+	for(int i=0; i<piStkSize[2]; i++)
+	{	memcpy(pcExt + i * iEntryBytes, pfTilts + i, sizeof(float));
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Contiguous frames are merged into one iovec. Each iovec is
+//    capped at m_tBatchBytes so that a batch never gets larger
+//    than that.
+// 2. Write-back of each batch is started right after it has been
+//    written so that the page cache drains while the next batch
+//    is copied.
+//-------------------------------------------------------------------
+bool CSaveMrcStack::mWriteVectored(void)
+{
+	std::vector<struct iovec> aIovs;
+	int iNumFrames = m_pMrcStack->m_aiStkSize[2];
+	for(int i=-1; i<iNumFrames; i++)
+	{	char* pcSrc = (i < 0) ? m_pcHeader :
+		   (char*)m_pMrcStack->GetFrame(i);
+		size_t tBytes = (i < 0) ? m_tHeaderBytes :
+		   m_pMrcStack->m_tFmBytes;
+		if(!aIovs.empty())
+		{	struct iovec* pLast = &aIovs.back();
+			char* pcEnd = (char*)pLast->iov_base + pLast->iov_len;
+			size_t tRoom = m_tBatchBytes - pLast->iov_len;
+			if(pcEnd == pcSrc && tRoom > 0)
+			{	size_t tAdd = (tBytes < tRoom) ? tBytes : tRoom;
+				pLast->iov_len += tAdd;
+				pcSrc += tAdd;
+				tBytes -= tAdd;
+			}
+		}
+		while(tBytes > 0)
+		{	struct iovec aIov;
+			aIov.iov_base = pcSrc;
+			aIov.iov_len = (tBytes < m_tBatchBytes) ?
+			   tBytes : m_tBatchBytes;
+			aIovs.push_back(aIov);
+			pcSrc += aIov.iov_len;
+			tBytes -= aIov.iov_len;
+		}
+	}
+	//-----------------
+	int iMaxIovs = (int)sysconf(_SC_IOV_MAX);
+	if(iMaxIovs <= 0) iMaxIovs = 1024;
+	int iNumIovs = (int)aIovs.size();
+	size_t tOffset = 0;
+	int iStart = 0;
+	while(iStart < iNumIovs)
+	{	int iCount = 0;
+		size_t tBatch = 0;
+		while(iStart + iCount < iNumIovs && iCount < iMaxIovs)
+		{	size_t tLen = aIovs[iStart + iCount].iov_len;
+			if(iCount > 0 && tBatch + tLen > m_tBatchBytes) break;
+			tBatch += tLen;
+			iCount += 1;
+		}
+		//----------------
+		struct iovec* pIovs = &aIovs[iStart];
+		int iLeft = iCount;
+		size_t tPos = tOffset;
+		while(iLeft > 0)
+		{	ssize_t tWritten = pwritev(m_iFile, pIovs, iLeft, tPos);
+			if(tWritten < 0 && errno == EINTR) continue;
+			if(tWritten <= 0) return false;
+			tPos += tWritten;
+			while(iLeft > 0 && (size_t)tWritten >= pIovs->iov_len)
+			{	tWritten -= pIovs->iov_len;
+				pIovs += 1;
+				iLeft -= 1;
+			}
+			if(iLeft == 0) break;
+			pIovs->iov_base = (char*)pIovs->iov_base + tWritten;
+			pIovs->iov_len -= tWritten;
+		}
+		sync_file_range(m_iFile, tOffset, tBatch,
+		   SYNC_FILE_RANGE_WRITE);
+		//----------------
+		tOffset += tBatch;
+		iStart += iCount;
+	}
+	m_tFileBytes = tOffset;
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. O_DIRECT requires aligned buffers, sizes and offsets. The
+//    headers and frames are packed into an aligned staging buffer
+//    that is written whenever it is full.
+// 2. The unaligned tail is written after O_DIRECT is cleared.
+//-------------------------------------------------------------------
+bool CSaveMrcStack::mWriteDirect(void)
+{
+	size_t tStage = m_tStageBytes / s_tAlign * s_tAlign;
+	if(tStage < s_tAlign) tStage = s_tAlign;
+	void* pvStage = 0L;
+	if(posix_memalign(&pvStage, s_tAlign, tStage) != 0) return false;
+	char* pcStage = (char*)pvStage;
+	//-----------------
+	size_t tFill = 0, tOffset = 0;
+	bool bWritten = true;
+	int iNumFrames = m_pMrcStack->m_aiStkSize[2];
+	for(int i=-1; i<iNumFrames; i++)
+	{	char* pcSrc = (i < 0) ? m_pcHeader :
+		   (char*)m_pMrcStack->GetFrame(i);
+		size_t tBytes = (i < 0) ? m_tHeaderBytes :
+		   m_pMrcStack->m_tFmBytes;
+		while(tBytes > 0 && bWritten)
+		{	size_t tCopy = tStage - tFill;
+			if(tCopy > tBytes) tCopy = tBytes;
+			memcpy(pcStage + tFill, pcSrc, tCopy);
+			tFill += tCopy;
+			pcSrc += tCopy;
+			tBytes -= tCopy;
+			if(tFill < tStage) continue;
+			//---------------
+			bWritten = mWriteAll(pcStage, tStage, tOffset);
+			tOffset += tStage;
+			tFill = 0;
+		}
+		if(!bWritten) break;
+	}
+	//-----------------
+	size_t tAligned = tFill / s_tAlign * s_tAlign;
+	if(bWritten && tAligned > 0)
+	{	bWritten = mWriteAll(pcStage, tAligned, tOffset);
+		tOffset += tAligned;
+	}
+	if(bWritten && tFill > tAligned)
+	{	mSetDirect(false);
+		bWritten = mWriteAll(pcStage + tAligned,
+		   tFill - tAligned, tOffset);
+		tOffset += (tFill - tAligned);
+	}
+	free(pvStage);
+	//-----------------
+	if(bWritten) m_tFileBytes = tOffset;
+	return bWritten;
+}
+
+bool CSaveMrcStack::mWriteAll(void* pvBuf, size_t tBytes, size_t tOffset)
+{
+	char* pcBuf = (char*)pvBuf;
+	while(tBytes > 0)
+	{	ssize_t tWritten = pwrite(m_iFile, pcBuf, tBytes, tOffset);
+		if(tWritten < 0 && errno == EINTR) continue;
+		if(tWritten <= 0) return false;
+		pcBuf += tWritten;
+		tBytes -= tWritten;
+		tOffset += tWritten;
+	}
+	return true;
+}
+
+void CSaveMrcStack::mSetDirect(bool bDirect)
+{
+	int iFlags = fcntl(m_iFile, F_GETFL);
+	if(iFlags == -1) return;
+	if(bDirect) iFlags |= O_DIRECT;
+	else iFlags &= ~O_DIRECT;
+	fcntl(m_iFile, F_SETFL, iFlags);
+}
+
+void CSaveMrcStack::mClean(void)
+{
+	if(m_iFile != -1) close(m_iFile);
+	if(m_pcHeader != 0L) delete[] m_pcHeader;
+	m_iFile = -1;
+	m_pcHeader = 0L;
+	m_tHeaderBytes = 0;
+}
@@ -0,0 +1,136 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <new>
+
+using namespace McAreTomo::DataUtil;
+
+static const size_t s_tHugePage = 2 * 1024 * 1024;
+
+CStackArena* CStackArena::m_pInstance = 0L;
+
+CStackArena* CStackArena::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CStackArena;
+	return m_pInstance;
+}
+
+void CStackArena::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+//-------------------------------------------------------------------
+// 1. By default up to 1/8 of the physical memory is kept in freed
+//    blocks for later Alloc calls.
+//-------------------------------------------------------------------
+CStackArena::CStackArena(void)
+{
+	pthread_mutex_init(&m_aMutex, 0L);
+	memset(m_apvBlocks, 0, sizeof(m_apvBlocks));
+	memset(m_atBlockBytes, 0, sizeof(m_atBlockBytes));
+	m_iNumBlocks = 0;
+	m_tCachedBytes = 0;
+	m_bHugePages = true;
+	//-----------------
+	size_t tPages = (size_t)sysconf(_SC_PHYS_PAGES);
+	size_t tPageSize = (size_t)sysconf(_SC_PAGESIZE);
+	m_tMaxCachedBytes = tPages * tPageSize / 8;
+}
+
+CStackArena::~CStackArena(void)
+{
+	this->Trim();
+	pthread_mutex_destroy(&m_aMutex);
+}
+
+//-------------------------------------------------------------------
+// 1. Returns a page-aligned block of at least tBytes. Its actual
+//    size is returned in ptBlockBytes and must be passed to Free.
+// 2. A cached block is reused when it is no more than twice as
+//    large as requested so that small stacks do not hold on to
+//    large blocks.
+//-------------------------------------------------------------------
+void* CStackArena::Alloc(size_t tBytes, size_t* ptBlockBytes)
+{
+	size_t tRound = (size_t)sysconf(_SC_PAGESIZE);
+	if(m_bHugePages && tBytes >= s_tHugePage) tRound = s_tHugePage;
+	size_t tBlockBytes = (tBytes + tRound - 1) / tRound * tRound;
+	//-----------------
+	void* pvBlock = 0L;
+	pthread_mutex_lock(&m_aMutex);
+	int iBest = -1;
+	for(int i=0; i<m_iNumBlocks; i++)
+	{	if(m_atBlockBytes[i] < tBlockBytes) continue;
+		if(m_atBlockBytes[i] > 2 * tBlockBytes) continue;
+		if(iBest >= 0 && m_atBlockBytes[i] >= m_atBlockBytes[iBest])
+		{	continue;
+		}
+		iBest = i;
+	}
+	if(iBest >= 0)
+	{	pvBlock = m_apvBlocks[iBest];
+		tBlockBytes = m_atBlockBytes[iBest];
+		m_tCachedBytes -= tBlockBytes;
+		m_iNumBlocks -= 1;
+		m_apvBlocks[iBest] = m_apvBlocks[m_iNumBlocks];
+		m_atBlockBytes[iBest] = m_atBlockBytes[m_iNumBlocks];
+	}
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	if(pvBlock == 0L) pvBlock = mMap(tBlockBytes);
+	if(pvBlock == 0L) throw std::bad_alloc();
+	*ptBlockBytes = tBlockBytes;
+	return pvBlock;
+}
+
+void CStackArena::Free(void* pvBlock, size_t tBlockBytes)
+{
+	if(pvBlock == 0L) return;
+	pthread_mutex_lock(&m_aMutex);
+	bool bCache = (m_iNumBlocks < s_iMaxBlocks) &&
+	   (m_tCachedBytes + tBlockBytes <= m_tMaxCachedBytes);
+	if(bCache)
+	{	m_apvBlocks[m_iNumBlocks] = pvBlock;
+		m_atBlockBytes[m_iNumBlocks] = tBlockBytes;
+		m_iNumBlocks += 1;
+		m_tCachedBytes += tBlockBytes;
+	}
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	if(!bCache) munmap(pvBlock, tBlockBytes);
+}
+
+void CStackArena::Trim(void)
+{
+	pthread_mutex_lock(&m_aMutex);
+	for(int i=0; i<m_iNumBlocks; i++)
+	{	munmap(m_apvBlocks[i], m_atBlockBytes[i]);
+		m_apvBlocks[i] = 0L;
+	}
+	m_iNumBlocks = 0;
+	m_tCachedBytes = 0;
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+void* CStackArena::mMap(size_t tBlockBytes)
+{
+	void* pvBlock = mmap(0L, tBlockBytes, PROT_READ | PROT_WRITE,
+	   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(pvBlock == MAP_FAILED)
+	{	fprintf(stderr, "CStackArena: failed to map %.1f MB.\n\n",
+		   tBlockBytes / 1048576.0);
+		return 0L;
+	}
+	//-----------------
+	if(m_bHugePages && tBlockBytes >= s_tHugePage)
+	{	madvise(pvBlock, tBlockBytes, MADV_HUGEPAGE);
+	}
+	return pvBlock;
+}
@@ -6,6 +6,9 @@
 #include <memory.h>
 #include <sys/types.h>
 #include <sys/inotify.h>
+#include <sys/statfs.h>
+#include <poll.h>
+#include <time.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -13,6 +16,92 @@
 
 using namespace McAreTomo::DataUtil;
 
+CWatchedFile::CWatchedFile(void)
+{
+	m_llSize = -1;
+	m_dMtime = 0.0;
+	m_dChanged = 0.0;
+}
+
+static double sGetMtime(struct stat* pStat)
+{
+	return pStat->st_mtim.tv_sec + pStat->st_mtim.tv_nsec * 1e-9;
+}
+
+static double sGetWallSecs(void)
+{
+	struct timespec aTime;
+	clock_gettime(CLOCK_REALTIME, &aTime);
+	return aTime.tv_sec + aTime.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+// 1. A file whose mtime is already older than the stable time when
+//    it is set up counts as unchanged since its mtime.
+//------------------------------------------------------------------------------
+bool CWatchedFile::Setup(const char* pcFile)
+{
+	struct stat aStat;
+	if(stat(pcFile, &aStat) != 0) return false;
+	if(!S_ISREG(aStat.st_mode)) return false;
+	//-----------------
+	m_llSize = (long long)aStat.st_size;
+	m_dMtime = sGetMtime(&aStat);
+	double dAge = sGetWallSecs() - m_dMtime;
+	if(dAge < 0) dAge = 0.0;
+	m_dChanged = CTsScheduler::GetSeconds() - dAge;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// 1. Returns -1 when pcFile is gone, 1 when neither its size nor
+//    its mtime has changed for fStableSecs, 0 otherwise.
+//------------------------------------------------------------------------------
+int CWatchedFile::Check(const char* pcFile, float fStableSecs)
+{
+	struct stat aStat;
+	if(stat(pcFile, &aStat) != 0) return -1;
+	//-----------------
+	double dNow = CTsScheduler::GetSeconds();
+	long long llSize = (long long)aStat.st_size;
+	double dMtime = sGetMtime(&aStat);
+	if(llSize != m_llSize || dMtime != m_dMtime)
+	{	m_llSize = llSize;
+		m_dMtime = dMtime;
+		m_dChanged = dNow;
+		return 0;
+	}
+	if((dNow - m_dChanged) < fStableSecs) return 0;
+	else return 1;
+}
+
+//------------------------------------------------------------------------------
+// 1. inotify only reports changes made through the local kernel. On
+//    these file systems files written by other hosts raise no events.
+//------------------------------------------------------------------------------
+static bool sIsNetworkFs(const char* pcDirName)
+{
+	struct statfs aStatFs;
+	if(statfs(pcDirName, &aStatFs) != 0) return true;
+	unsigned int uiType = (unsigned int)aStatFs.f_type;
+	unsigned int auiTypes[] = 
+	{  0x6969,       // NFS
+	   0x0BD00BD0,   // Lustre
+	   0x47504653,   // GPFS
+	   0x19830326,   // BeeGFS
+	   0x00C36400,   // Ceph
+	   0x517B,       // SMB
+	   0xFF534D42,   // CIFS
+	   0xFE534D42,   // SMB2
+	   0x65735546    // FUSE
+	};
+	int iNumTypes = sizeof(auiTypes) / sizeof(unsigned int);
+	for(int i=0; i<iNumTypes; i++)
+	{	if(uiType == auiTypes[i]) return true;
+	}
+	return false;
+}
+
 CStackFolder* CStackFolder::m_pInstance = 0L;
 
 CStackFolder* CStackFolder::GetInstance(void)
@@ -35,6 +124,11 @@ void CStackFolder::DeleteInstance(void)
 CStackFolder::CStackFolder(void)
 {
 	m_iNumChars = 256;
+	m_fStableSecs = 5.0f;
+	m_fPollSecs = 5.0f;
+	m_iNotify = -1;
+	m_dDirMtime = 0.0;
+	m_dLastScan = 0.0;
 }
 
 //------------------------------------------------------------------------------
@@ -45,41 +139,19 @@ CStackFolder::~CStackFolder(void)
 	this->mClean();
 }
 
+//------------------------------------------------------------------------------
+// 1. Files are queued in CTsScheduler, from which the processing
+//    threads take them.
+//------------------------------------------------------------------------------
 void CStackFolder::PushFile(char* pcInFile)
 {
 	if(pcInFile == 0L) return;
-	char* pcBuf = new char[m_iNumChars];
-	strcpy(pcBuf, pcInFile);
-	//-----------------
-	pthread_mutex_lock(&m_aMutex);
-	m_aFileQueue.push(pcBuf);
-	pthread_mutex_unlock(&m_aMutex);
-}
-
-char* CStackFolder::GetFile(bool bPop)
-{
-	char* pcInFile = 0L;
-	pthread_mutex_lock(&m_aMutex);
-	if(!m_aFileQueue.empty())
-	{	pcInFile = m_aFileQueue.front();
-		if(bPop) m_aFileQueue.pop();
-	}
-	pthread_mutex_unlock(&m_aMutex);
-	return pcInFile;
-}
-
-void CStackFolder::DeleteFront(void)
-{
-	char* pcInFile = this->GetFile(true);
-	if(pcInFile != 0L) delete[] pcInFile;
+	CTsScheduler::GetInstance()->PushFile(pcInFile);
 }
 
 int CStackFolder::GetQueueSize(void)
 {
-	pthread_mutex_lock(&m_aMutex);
-	int iSize = m_aFileQueue.size();
-	pthread_mutex_unlock(&m_aMutex);
-	return iSize;
+	return CTsScheduler::GetInstance()->GetQueueSize();
 }
 
 bool CStackFolder::ReadFiles(void)
@@ -105,7 +177,7 @@ bool CStackFolder::ReadFiles(void)
 	// batch processing.
 	//-------------------------------------------------
 	if(pInput->m_iSerial == 1) 
-	{	int iNumRead = mReadFolder();
+	{	int iNumRead = mReadFolder(false);
 		if(iNumRead > 0) return true;
 		else return false;
 	}
@@ -133,8 +205,10 @@ bool CStackFolder::mReadSingle(void)
 //    search for a series stack files containing serial numbers.
 // 2. The template file contains the full path that is used to
 //    determine the folder containing the series stack files
+// 3. bWatch: the matched files are watched until they are stable
+//    instead of being queued right away.
 //--------------------------------------------------------------------
-int CStackFolder::mReadFolder(void)
+int CStackFolder::mReadFolder(bool bWatch)
 {
 	DIR* pDir = opendir(m_acDirName);
 	if(pDir == 0L)
@@ -142,69 +216,120 @@ int CStackFolder::mReadFolder(void)
 		   "in CStackFolder::mReadFolder.\n\n", m_acDirName);
 		return -1;
 	}
+	m_dLastScan = CTsScheduler::GetSeconds();
 	//-----------------
 	int iNumRead = 0;
-	int iPrefix = strlen(m_acPrefix);
-	int iSuffix = strlen(m_acSuffix);
-	int iSkips = strlen(m_acSkips);
 	struct dirent* pDirent;
-	char *pcPrefix = 0L, *pcSuffix = 0L;
-	//-----------------
-	struct stat statBuf;
-	char acFullFile[m_iNumChars] = {'\0'};
-	strcpy(acFullFile, m_acDirName);
-	char* pcMainFile = acFullFile + strlen(m_acDirName);
-	//-----------------
-	CReadMdocDone* pReadMdocDone = CReadMdocDone::GetInstance();
-	//-----------------
 	while(true)
 	{	pDirent = readdir(pDir);
 		if(pDirent == 0L) break;
-		if(pDirent->d_name[0] == '.') continue;
-		//----------------
-		if(iPrefix > 0)
-		{	pcPrefix = strstr(pDirent->d_name, m_acPrefix);
-			if(pcPrefix == 0L) continue;
-		}
-		//----------------
-		if(iSuffix > 0)
-		{	pcSuffix = strcasestr(pDirent->d_name 
-			   + iPrefix, m_acSuffix);
-			if(pcSuffix == 0L) continue;
-			if(strlen(pcSuffix) > (iSuffix + 3)) continue;
-		}
-		//----------------
-		if(iSkips > 0)
-		{	bool bSkip = mCheckSkips(pDirent->d_name);
-			if(bSkip) continue;
-		}
-		//--------------------------------------------------------
-		// 1) Note: CReadMdocDone has already considered the
-		// -Cmd = 0 and -Resume 1 combination. When it is given
-		// in the command line, CReadMdocDone checklist is empty.
-		//--------------------------------------------------------
-		if(pReadMdocDone->bExist(pDirent->d_name)) continue;
-		//----------------
-		if(m_aReadFiles.find(pDirent->d_name) ==
-		   m_aReadFiles.end())
-		{	int iNumFiles = m_aReadFiles.size();
-                	m_aReadFiles[pDirent->d_name] = iNumFiles;
-		}
-		else continue;
+		if(!mMatch(pDirent->d_name)) continue;
 		//----------------
-		strcpy(pcMainFile, pDirent->d_name);
-		this->PushFile(acFullFile);
-		//----------------
-		printf("added: %s\n", acFullFile);
+		if(bWatch) mWatchFile(pDirent->d_name);
+		else mQueueFile(pDirent->d_name);
 		iNumRead += 1;
 	}
 	closedir(pDir);
-	if(iNumRead <= 0) return 0;
+	if(iNumRead <= 0 || bWatch) return iNumRead;
 	//-----------------
 	printf("%d files have been found in %s\n\n", iNumRead, m_acDirName);
 	return iNumRead;
 }
 
+//--------------------------------------------------------------------
+// 1. Note: CReadMdocDone has already considered the -Cmd = 0 and
+//    -Resume 1 combination. When it is given in the command line,
+//    CReadMdocDone checklist is empty.
+// 2. Files already queued or being watched do not match again.
+//--------------------------------------------------------------------
+bool CStackFolder::mMatch(const char* pcName)
+{
+	if(pcName[0] == '.') return false;
+	//-----------------
+	int iPrefix = strlen(m_acPrefix);
+	int iSuffix = strlen(m_acSuffix);
+	if(iPrefix > 0)
+	{	const char* pcPrefix = strstr(pcName, m_acPrefix);
+		if(pcPrefix == 0L) return false;
+	}
+	//-----------------
+	if(iSuffix > 0)
+	{	if((int)strlen(pcName) < iPrefix) return false;
+		const char* pcSuffix = strcasestr(pcName 
+		   + iPrefix, m_acSuffix);
+		if(pcSuffix == 0L) return false;
+		if(strlen(pcSuffix) > (iSuffix + 3)) return false;
+	}
+	//-----------------
+	if(strlen(m_acSkips) > 0)
+	{	bool bSkip = mCheckSkips(pcName);
+		if(bSkip) return false;
+	}
+	//-----------------
+	if(m_aReadFiles.find(pcName) != m_aReadFiles.end()) return false;
+	if(m_aWatched.find(pcName) != m_aWatched.end()) return false;
+	//-----------------
+	CReadMdocDone* pReadMdocDone = CReadMdocDone::GetInstance();
+	if(pReadMdocDone->bExist(pcName)) return false;
+	return true;
+}
+
+void CStackFolder::mQueueFile(const char* pcName)
+{
+	int iNumFiles = m_aReadFiles.size();
+	m_aReadFiles[pcName] = iNumFiles;
+	//-----------------
+	char acFullFile[m_iNumChars] = {'\0'};
+	strcpy(acFullFile, m_acDirName);
+	strcat(acFullFile, pcName);
+	this->PushFile(acFullFile);
+	printf("added: %s\n", acFullFile);
+}
+
+void CStackFolder::mWatchFile(const char* pcName)
+{
+	char acFullFile[m_iNumChars] = {'\0'};
+	strcpy(acFullFile, m_acDirName);
+	strcat(acFullFile, pcName);
+	//-----------------
+	CWatchedFile aFile;
+	if(!aFile.Setup(acFullFile)) return;
+	m_aWatched[pcName] = aFile;
+}
+
+//--------------------------------------------------------------------
+// 1. Only the watched files are stat'ed, not the whole folder.
+// 2. A file is queued once it has been stable for m_fStableSecs.
+//    Files that are gone are dropped.
+//--------------------------------------------------------------------
+int CStackFolder::mCheckWatched(void)
+{
+	char acFullFile[m_iNumChars] = {'\0'};
+	strcpy(acFullFile, m_acDirName);
+	char* pcMainFile = acFullFile + strlen(m_acDirName);
+	//-----------------
+	int iNumQueued = 0;
+	std::unordered_map<std::string, CWatchedFile>::iterator it;
+	it = m_aWatched.begin();
+	while(it != m_aWatched.end())
+	{	strcpy(pcMainFile, it->first.c_str());
+		int iStable = it->second.Check(acFullFile, m_fStableSecs);
+		if(iStable < 0)
+		{	it = m_aWatched.erase(it);
+			continue;
+		}
+		else if(iStable == 0)
+		{	it++;
+			continue;
+		}
+		//----------------
+		mQueueFile(it->first.c_str());
+		it = m_aWatched.erase(it);
+		iNumQueued += 1;
+	}
+	return iNumQueued;
+}
+
 bool CStackFolder::mGetDirName(void)
 {
 	CInput* pInput = CInput::GetInstance();
@@ -240,47 +365,151 @@ bool CStackFolder::mCheckSkips(const char* pcString)
 
 void CStackFolder::mClean(void)
 {
-	while(!m_aFileQueue.empty())
-	{	char* pcFile = m_aFileQueue.front();
-		m_aFileQueue.pop();
-		if(pcFile != 0L) delete[] pcFile;
-	}
 	m_aReadFiles.clear();
+	m_aWatched.clear();
+	mCloseWatch();
 }
 
+//--------------------------------------------------------------------
+// 1. The watch is opened before the folder is read so that no file
+//    saved in between is missed.
+//--------------------------------------------------------------------
 bool CStackFolder::mAsyncReadFolder(void)
 {
-	mReadFolder();
+	bool bWatch = mOpenWatch();
+	if(bWatch) printf("Watch folder with inotify.\n\n");
+	else printf("Poll folder every %.1f seconds.\n\n", m_fPollSecs);
+	//-----------------
+	mDirChanged();
+	mReadFolder(true);
+	mCheckWatched();
 	this->Start();
 	return true;
 }
 
+bool CStackFolder::mOpenWatch(void)
+{
+	mCloseWatch();
+	if(sIsNetworkFs(m_acDirName)) return false;
+	//-----------------
+	m_iNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(m_iNotify < 0) return false;
+	//-----------------
+	uint32_t uiMask = IN_CLOSE_WRITE | IN_MOVED_TO 
+	   | IN_DELETE | IN_MOVED_FROM;
+	int iWatch = inotify_add_watch(m_iNotify, m_acDirName, uiMask);
+	if(iWatch >= 0) return true;
+	//-----------------
+	fprintf(stderr, "Warning: cannot watch %s, %s.\n"
+	   "   Poll it instead.\n\n", m_acDirName, strerror(errno));
+	mCloseWatch();
+	return false;
+}
+
+void CStackFolder::mCloseWatch(void)
+{
+	if(m_iNotify < 0) return;
+	close(m_iNotify);
+	m_iNotify = -1;
+}
+
+//--------------------------------------------------------------------
+// 1. Waits up to fSeconds for events. Closed or moved-in files are
+//    watched until stable. Deleted or moved-out files are forgotten
+//    so that a file saved again under the same name is read again.
+// 2. On queue overflow events were lost. The folder is read again.
+//--------------------------------------------------------------------
+void CStackFolder::mReadEvents(float fSeconds)
+{
+	struct pollfd aPollFd;
+	aPollFd.fd = m_iNotify;
+	aPollFd.events = POLLIN;
+	aPollFd.revents = 0;
+	int iRet = poll(&aPollFd, 1, (int)(fSeconds * 1000));
+	if(iRet <= 0) return;
+	//-----------------
+	char acBuf[4096] __attribute__((aligned(
+	   __alignof__(struct inotify_event))));
+	bool bOverflow = false;
+	while(true)
+	{	ssize_t tBytes = read(m_iNotify, acBuf, sizeof(acBuf));
+		if(tBytes <= 0) break;
+		//----------------
+		char* pcEvent = acBuf;
+		while(pcEvent < acBuf + tBytes)
+		{	struct inotify_event* pEvent = 
+			   (struct inotify_event*)pcEvent;
+			pcEvent += sizeof(struct inotify_event) + pEvent->len;
+			//---------------
+			if(pEvent->mask & IN_Q_OVERFLOW) bOverflow = true;
+			if(pEvent->len == 0) continue;
+			const char* pcName = pEvent->name;
+			//---------------
+			if(pEvent->mask & (IN_DELETE | IN_MOVED_FROM))
+			{	m_aReadFiles.erase(pcName);
+				m_aWatched.erase(pcName);
+			}
+			else if(mMatch(pcName)) mWatchFile(pcName);
+		}
+	}
+	if(bOverflow) mReadFolder(true);
+}
+
+//--------------------------------------------------------------------
+// 1. A folder's mtime changes when files are created, renamed or
+//    deleted in it. Only then does the polling fallback read it.
+//--------------------------------------------------------------------
+bool CStackFolder::mDirChanged(void)
+{
+	struct stat aStat;
+	if(stat(m_acDirName, &aStat) != 0) return true;
+	double dMtime = sGetMtime(&aStat);
+	if(dMtime == m_dDirMtime) return false;
+	m_dDirMtime = dMtime;
+	return true;
+}
+
+//--------------------------------------------------------------------
+// 1. Stops when no new file has been found for -Serial seconds
+//    while the scheduler queue is empty.
+// 2. The polling fallback also reads the folder every minute in
+//    case its mtime is cached by the network file system.
+//--------------------------------------------------------------------
 void CStackFolder::ThreadMain(void)
 {
 	CInput* pInput = CInput::GetInstance();
-	int iCount = 0;
+	double dLastFound = CTsScheduler::GetSeconds();
+	double dLastPrint = dLastFound;
 	//-----------------
 	while(true)
-	{	int iQueueSize = GetQueueSize();
-		if(iQueueSize > 0)
-		{	this->mWait(iQueueSize * 5.0f);
-			continue;
+	{	float fWait = m_aWatched.empty() ? 10.0f : 1.0f;
+		if(m_iNotify >= 0) mReadEvents(fWait);
+		else
+		{	this->mWait(m_aWatched.empty() ? m_fPollSecs : 1.0f);
+			double dSinceScan = CTsScheduler::GetSeconds()
+			   - m_dLastScan;
+			if(mDirChanged() || dSinceScan >= 60.0)
+			{	mReadFolder(true);
+			}
 		}
 		//----------------
-		int iNumFiles = mReadFolder();
-		if(iNumFiles > 0) 
-		{	iCount = 0;
+		int iNumQueued = mCheckWatched();
+		double dNow = CTsScheduler::GetSeconds();
+		if(iNumQueued > 0 || !m_aWatched.empty() 
+		   || GetQueueSize() > 0)
+		{	dLastFound = dNow;
+			dLastPrint = dNow;
 			continue;
 		}
 		//----------------
-		this->mWait(10.0f);
-		iCount += 10.0f;
-		int iLeftSec = pInput->m_iSerial - iCount;
-		if(iLeftSec > 0)
+		int iLeftSec = (int)(pInput->m_iSerial 
+		   - (dNow - dLastFound));
+		if(iLeftSec <= 0) break;
+		if((dNow - dLastPrint) >= 10.0)
 		{	printf("No mdoc files have been found, "
 		   	   "wait %d seconds.\n\n", iLeftSec);
+			dLastPrint = dNow;
 		}
-		if(iLeftSec <= 0) break;
-		else continue;
 	}
+	mCloseWatch();
 }
@@ -0,0 +1,95 @@
+#include "CDataUtilInc.h"
+#include "../CMcAreTomoInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo;
+using namespace McAreTomo::DataUtil;
+
+CStageCache* CStageCache::m_pInstance = 0L;
+
+CStageCache* CStageCache::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CStageCache;
+	return m_pInstance;
+}
+
+void CStageCache::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+CStageCache::CStageCache(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	m_iLevel = pInput->m_iStageCache;
+	strcpy(m_acCacheDir, pInput->m_acOutDir);
+	strcat(m_acCacheDir, "StageCache/");
+	if(m_iLevel <= 0) return;
+	//-----------------
+	struct stat st;
+	memset(&st, 0, sizeof(st));
+	if(stat(m_acCacheDir, &st) == -1)
+	{	mkdir(m_acCacheDir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+	}
+}
+
+CStageCache::~CStageCache(void)
+{
+}
+
+bool CStageCache::bEnabled(int iLevel)
+{
+	if(m_iLevel <= 0) return false;
+	return (m_iLevel >= iLevel);
+}
+
+bool CStageCache::bExists(const char* pcStage, CStageKey* pKey)
+{
+	char acPath[256] = {'\0'};
+	mGenPath(pcStage, pKey, acPath);
+	struct stat aStat;
+	return (stat(acPath, &aStat) == 0);
+}
+
+bool CStageCache::Load
+(	const char* pcStage,
+	CStageKey* pKey,
+	CStageEntry* pEntry
+)
+{	char acPath[256] = {'\0'};
+	mGenPath(pcStage, pKey, acPath);
+	return pEntry->Load(acPath, pKey->m_ullHash);
+}
+
+//-------------------------------------------------------------------
+// 1. pEntry must be created with new. It belongs to CAsyncWriter
+//    afterwards and must not be touched.
+//-------------------------------------------------------------------
+void CStageCache::Save
+(	const char* pcStage,
+	CStageKey* pKey,
+	CStageEntry* pEntry,
+	int iNthGpu
+)
+{	mGenPath(pcStage, pKey, pEntry->m_acFile);
+	pEntry->m_ullKey = pKey->m_ullHash;
+	pEntry->m_iNthGpu = iNthGpu;
+	pEntry->m_tBytes = pEntry->m_tSize;
+	CAsyncWriter::GetInstance()->Submit(pEntry);
+}
+
+void CStageCache::mGenPath
+(	const char* pcStage,
+	CStageKey* pKey,
+	char* pcPath
+)
+{	char acHex[32] = {'\0'};
+	pKey->GetHex(acHex);
+	sprintf(pcPath, "%s%s_%s.bin", m_acCacheDir, pcStage, acHex);
+}
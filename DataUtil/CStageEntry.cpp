@@ -0,0 +1,171 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#include <unistd.h>
+
+using namespace McAreTomo::DataUtil;
+
+typedef unsigned long long ull;
+
+static const ull s_ullMagic = 0x4547415453334154ULL; // AT3STAGE
+static const ull s_ullVersion = 1;
+static const int s_iHeaderSize = 5;
+
+static ull sGetSum(const char* pcData, size_t tSize)
+{
+	CStageKey aSum;
+	aSum.Add(pcData, tSize);
+	return aSum.m_ullHash;
+}
+
+CStageEntry::CStageEntry(void)
+{
+	m_pcData = 0L;
+	m_tSize = 0;
+	m_tCapacity = 0;
+	m_tReadPos = 0;
+	m_ullKey = 0;
+	m_bFailed = false;
+}
+
+CStageEntry::~CStageEntry(void)
+{
+	this->Clean();
+}
+
+void CStageEntry::Clean(void)
+{
+	if(m_pcData != 0L) free(m_pcData);
+	m_pcData = 0L;
+	m_tSize = 0;
+	m_tCapacity = 0;
+	m_tReadPos = 0;
+	m_bFailed = false;
+}
+
+void CStageEntry::Write(const void* pvData, size_t tBytes)
+{
+	if(m_tSize + tBytes > m_tCapacity)
+	{	size_t tCapacity = 2 * m_tCapacity;
+		if(tCapacity < m_tSize + tBytes) tCapacity = m_tSize + tBytes;
+		if(tCapacity < 4096) tCapacity = 4096;
+		m_pcData = (char*)realloc(m_pcData, tCapacity);
+		m_tCapacity = tCapacity;
+	}
+	memcpy(m_pcData + m_tSize, pvData, tBytes);
+	m_tSize += tBytes;
+}
+
+void CStageEntry::WriteInt(int iVal)
+{
+	this->Write(&iVal, sizeof(int));
+}
+
+void CStageEntry::WriteFloat(float fVal)
+{
+	this->Write(&fVal, sizeof(float));
+}
+
+bool CStageEntry::Read(void* pvData, size_t tBytes)
+{
+	if(m_bFailed || m_tReadPos + tBytes > m_tSize)
+	{	memset(pvData, 0, tBytes);
+		m_bFailed = true;
+		return false;
+	}
+	memcpy(pvData, m_pcData + m_tReadPos, tBytes);
+	m_tReadPos += tBytes;
+	return true;
+}
+
+int CStageEntry::ReadInt(void)
+{
+	int iVal = 0;
+	this->Read(&iVal, sizeof(int));
+	return iVal;
+}
+
+float CStageEntry::ReadFloat(void)
+{
+	float fVal = 0.0f;
+	this->Read(&fVal, sizeof(float));
+	return fVal;
+}
+
+//-------------------------------------------------------------------
+// 1. The entry is written to a temporary file that is renamed when
+//    complete. A crash never leaves a truncated entry behind.
+//-------------------------------------------------------------------
+bool CStageEntry::DoIt(void)
+{
+	char acTmpFile[256] = {'\0'};
+	snprintf(acTmpFile, sizeof(acTmpFile), "%s.%d.tmp",
+	   m_acFile, (int)getpid());
+	ull aullHeader[s_iHeaderSize] = {s_ullMagic, s_ullVersion,
+	   m_ullKey, (ull)m_tSize, sGetSum(m_pcData, m_tSize)};
+	//-----------------
+	bool bWritten = false;
+	FILE* pFile = fopen(acTmpFile, "wb");
+	if(pFile != 0L)
+	{	size_t tHdrBytes = sizeof(aullHeader);
+		bWritten = (fwrite(aullHeader, 1, tHdrBytes, pFile)
+		   == tHdrBytes);
+		if(bWritten && m_tSize > 0) bWritten =
+		   (fwrite(m_pcData, 1, m_tSize, pFile) == m_tSize);
+		if(fflush(pFile) != 0) bWritten = false;
+		if(bWritten && fdatasync(fileno(pFile)) != 0) bWritten = false;
+		if(fclose(pFile) != 0) bWritten = false;
+	}
+	if(bWritten) bWritten = (rename(acTmpFile, m_acFile) == 0);
+	if(bWritten) return true;
+	//-----------------
+	fprintf(stderr, "Warning (GPU %d): unable to write stage cache "
+	   "%s\n   %s\n\n", m_iNthGpu, m_acFile, strerror(errno));
+	unlink(acTmpFile);
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// 1. Returns false when the file is missing or its header does not
+//    match ullKey, the size or the hash of the payload. The entry
+//    is then left empty.
+//-------------------------------------------------------------------
+bool CStageEntry::Load(const char* pcFile, unsigned long long ullKey)
+{
+	this->Clean();
+	strcpy(m_acFile, pcFile);
+	FILE* pFile = fopen(m_acFile, "rb");
+	if(pFile == 0L) return false;
+	//-----------------
+	ull aullHeader[s_iHeaderSize] = {0};
+	size_t tRead = fread(aullHeader, 1, sizeof(aullHeader), pFile);
+	bool bValid = (tRead == sizeof(aullHeader));
+	if(bValid) bValid = (aullHeader[0] == s_ullMagic &&
+	   aullHeader[1] == s_ullVersion && aullHeader[2] == ullKey);
+	//-----------------
+	if(bValid && aullHeader[3] > 0)
+	{	size_t tSize = (size_t)aullHeader[3];
+		m_pcData = (char*)malloc(tSize);
+		bValid = (m_pcData != 0L);
+		if(bValid)
+		{	tRead = fread(m_pcData, 1, tSize, pFile);
+			bValid = (tRead == tSize);
+			m_tSize = tSize;
+			m_tCapacity = tSize;
+		}
+	}
+	fclose(pFile);
+	//-----------------
+	if(bValid) bValid = (aullHeader[4] == sGetSum(m_pcData, m_tSize));
+	if(bValid)
+	{	m_ullKey = ullKey;
+		return true;
+	}
+	printf("Warning: invalid stage cache %s, ignored.\n\n", m_acFile);
+	this->Clean();
+	return false;
+}
@@ -0,0 +1,149 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo::DataUtil;
+
+typedef unsigned long long ull;
+
+static const ull s_ullP1 = 11400714785074694791ULL;
+static const ull s_ullP2 = 14029467366897019727ULL;
+static const ull s_ullP3 = 1609587929392839161ULL;
+static const ull s_ullP4 = 9650029242287828579ULL;
+static const ull s_ullP5 = 2870177450012600261ULL;
+static inline ull sRotl(ull ullVal, int iBits)
+{
+	return (ullVal << iBits) | (ullVal >> (64 - iBits));
+}
+
+static inline ull sRound(ull ullAcc, ull ullInput)
+{
+	ullAcc += ullInput * s_ullP2;
+	ullAcc = sRotl(ullAcc, 31);
+	return ullAcc * s_ullP1;
+}
+
+static inline ull sMerge(ull ullAcc, ull ullVal)
+{
+	ullAcc ^= sRound(0, ullVal);
+	return ullAcc * s_ullP1 + s_ullP4;
+}
+
+//-------------------------------------------------------------------
+// 1. xxHash64 of pvData seeded with ullSeed. Four independent lanes
+//    consume 32 bytes per step.
+//-------------------------------------------------------------------
+static ull sHash64(const void* pvData, size_t tBytes, ull ullSeed)
+{
+	const unsigned char* pucData = (const unsigned char*)pvData;
+	const unsigned char* pucEnd = pucData + tBytes;
+	ull ullHash = 0, ullVal = 0;
+	//-----------------
+	if(tBytes >= 32)
+	{	const unsigned char* pucLimit = pucEnd - 32;
+		ull aullLanes[4] = {ullSeed + s_ullP1 + s_ullP2,
+		   ullSeed + s_ullP2, ullSeed, ullSeed - s_ullP1};
+		do
+		{	for(int i=0; i<4; i++)
+			{	memcpy(&ullVal, pucData + i * 8, 8);
+				aullLanes[i] = sRound(aullLanes[i], ullVal);
+			}
+			pucData += 32;
+		} while(pucData <= pucLimit);
+		//----------------
+		ullHash = sRotl(aullLanes[0], 1) + sRotl(aullLanes[1], 7)
+		   + sRotl(aullLanes[2], 12) + sRotl(aullLanes[3], 18);
+		for(int i=0; i<4; i++)
+		{	ullHash = sMerge(ullHash, aullLanes[i]);
+		}
+	}
+	else ullHash = ullSeed + s_ullP5;
+	ullHash += (ull)tBytes;
+	//-----------------
+	while(pucData + 8 <= pucEnd)
+	{	memcpy(&ullVal, pucData, 8);
+		ullHash ^= sRound(0, ullVal);
+		ullHash = sRotl(ullHash, 27) * s_ullP1 + s_ullP4;
+		pucData += 8;
+	}
+	if(pucData + 4 <= pucEnd)
+	{	unsigned int uiVal = 0;
+		memcpy(&uiVal, pucData, 4);
+		ullHash ^= (ull)uiVal * s_ullP1;
+		ullHash = sRotl(ullHash, 23) * s_ullP2 + s_ullP3;
+		pucData += 4;
+	}
+	while(pucData < pucEnd)
+	{	ullHash ^= (*pucData) * s_ullP5;
+		ullHash = sRotl(ullHash, 11) * s_ullP1;
+		pucData += 1;
+	}
+	//-----------------
+	ullHash ^= ullHash >> 33;
+	ullHash *= s_ullP2;
+	ullHash ^= ullHash >> 29;
+	ullHash *= s_ullP3;
+	ullHash ^= ullHash >> 32;
+	return ullHash;
+}
+
+CStageKey::CStageKey(void)
+{
+	m_ullHash = 0;
+}
+
+CStageKey::~CStageKey(void)
+{
+}
+
+void CStageKey::Add(const void* pvData, size_t tBytes)
+{
+	m_ullHash = sHash64(pvData, tBytes, m_ullHash);
+}
+
+void CStageKey::AddInt(int iVal)
+{
+	this->Add(&iVal, sizeof(int));
+}
+
+void CStageKey::AddFloat(float fVal)
+{
+	this->Add(&fVal, sizeof(float));
+}
+
+void CStageKey::AddStr(const char* pcStr)
+{
+	if(pcStr == 0L) pcStr = "";
+	this->Add(pcStr, strlen(pcStr) + 1);
+}
+
+//-------------------------------------------------------------------
+// 1. A file that does not exist adds only its path. This keeps
+//    entries made without a gain reference apart from those made
+//    with one.
+//-------------------------------------------------------------------
+void CStageKey::AddFile(const char* pcFile)
+{
+	this->AddStr(pcFile);
+	if(pcFile == 0L || pcFile[0] == '\0') return;
+	//-----------------
+	struct stat aStat;
+	if(stat(pcFile, &aStat) != 0) return;
+	long long aullStat[3] = {(long long)aStat.st_size,
+	   (long long)aStat.st_mtim.tv_sec,
+	   (long long)aStat.st_mtim.tv_nsec};
+	this->Add(aullStat, sizeof(aullStat));
+}
+
+void CStageKey::AddKey(CStageKey* pKey)
+{
+	this->Add(&pKey->m_ullHash, sizeof(ull));
+}
+
+void CStageKey::GetHex(char* pcHex)
+{
+	sprintf(pcHex, "%016llx", m_ullHash);
+}
+
@@ -147,6 +147,19 @@ void CTiltSeries::SetImage(int iTilt, void* pvImage)
 	memcpy(pfImg, pvImage, m_tFmBytes);
 }
 
+//-------------------------------------------------------------------
+// 1. Must be called right after Create, before the images are
+//    sorted or removed.
+//-------------------------------------------------------------------
+bool CTiltSeries::MapFrames(CMapMrc* pMapMrc)
+{
+	if(!CMrcStack::MapFrames(pMapMrc)) return false;
+	for(int i=0; i<m_aiStkSize[2]; i++)
+	{	m_ppfImages[i] = (float*)m_ppvFrames[i];
+	}
+	return true;
+}
+
 void CTiltSeries::SetCenter(int iTilt, float* pfCent)
 {
 	float* pfDstCent = m_ppfCenters[iTilt];	
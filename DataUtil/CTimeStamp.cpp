@@ -94,7 +94,11 @@ void CTimeStamp::Record(const char* pcAction)
 	sprintf(pcLine, "%s, %d, %s, %.1f\n", pTsPackage->m_acMrcMain,
 	   iGpuID, pcAction, fSeconds);
 	//---------------------------
+	// CAsyncWriter records from its own threads.
+	//---------------------------
+	pthread_mutex_lock(m_pMutex);
 	m_aTimeStampQ.push(pcLine);
+	pthread_mutex_unlock(m_pMutex);
 }
 
 void CTimeStamp::Save(void)
@@ -0,0 +1,46 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+
+using namespace McAreTomo::DataUtil;
+
+CTraceBuffer::CTraceBuffer(int iSize, int iThread)
+{
+	m_iSize = (iSize > 0) ? iSize : 1;
+	m_pEvents = new CTraceEvent[m_iSize];
+	m_llAdded = 0;
+	m_iThread = iThread;
+	m_iLane = -1;
+	m_iDepth = 0;
+	sprintf(m_acName, "Thread %d", iThread);
+}
+
+CTraceBuffer::~CTraceBuffer(void)
+{
+	if(m_pEvents != 0L) delete[] m_pEvents;
+}
+
+void CTraceBuffer::Add(CTraceEvent* pEvent)
+{
+	int i = (int)(m_llAdded % m_iSize);
+	m_pEvents[i] = *pEvent;
+	m_llAdded += 1;
+}
+
+int CTraceBuffer::GetCount(void)
+{
+	if(m_llAdded < m_iSize) return (int)m_llAdded;
+	return m_iSize;
+}
+
+CTraceEvent* CTraceBuffer::GetEvent(int i)
+{
+	long long llFirst = m_llAdded - this->GetCount();
+	return &m_pEvents[(llFirst + i) % m_iSize];
+}
+
+long long CTraceBuffer::GetDropped(void)
+{
+	return m_llAdded - this->GetCount();
+}
@@ -0,0 +1,47 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+
+using namespace McAreTomo::DataUtil;
+
+CTraceSpan::CTraceSpan(const char* pcName, int iNthGpu)
+{
+	m_pBuffer = 0L;
+	if(!CTracer::m_bEnabled) return;
+	//-----------------
+	CTracer* pTracer = CTracer::GetInstance();
+	m_pBuffer = pTracer->GetBuffer();
+	m_iOldLane = m_pBuffer->m_iLane;
+	if(iNthGpu >= 0) m_pBuffer->m_iLane = iNthGpu;
+	//-----------------
+	m_aEvent.m_pcName = pcName;
+	m_aEvent.m_tBytes = 0;
+	m_aEvent.m_iItems = 0;
+	m_aEvent.m_iLane = m_pBuffer->m_iLane;
+	m_aEvent.m_iDepth = m_pBuffer->m_iDepth;
+	m_pBuffer->m_iDepth += 1;
+	m_aEvent.m_llStart = pTracer->GetNanoSecs();
+}
+
+CTraceSpan::~CTraceSpan(void)
+{
+	if(m_pBuffer == 0L) return;
+	CTracer* pTracer = CTracer::GetInstance();
+	m_aEvent.m_llDur = pTracer->GetNanoSecs() - m_aEvent.m_llStart;
+	m_pBuffer->m_iDepth -= 1;
+	m_pBuffer->m_iLane = m_iOldLane;
+	m_pBuffer->Add(&m_aEvent);
+}
+
+void CTraceSpan::AddBytes(size_t tBytes)
+{
+	if(m_pBuffer == 0L) return;
+	m_aEvent.m_tBytes += tBytes;
+}
+
+void CTraceSpan::AddItems(int iItems)
+{
+	if(m_pBuffer == 0L) return;
+	m_aEvent.m_iItems += iItems;
+}
@@ -0,0 +1,191 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <time.h>
+#include <set>
+
+using namespace McAreTomo::DataUtil;
+
+static thread_local CTraceBuffer* s_pBuffer = 0L;
+
+CTracer* CTracer::m_pInstance = 0L;
+bool CTracer::m_bEnabled = false;
+
+CTracer* CTracer::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CTracer;
+	return m_pInstance;
+}
+
+//-------------------------------------------------------------------
+// 1. The trace file is saved here. All threads recording spans
+//    must have exited.
+//-------------------------------------------------------------------
+void CTracer::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	if(m_bEnabled) m_pInstance->Save();
+	m_bEnabled = false;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+CTracer::CTracer(void)
+{
+	m_iBufSize = 65536;
+	m_iNumGpus = 0;
+	m_iNumEntries = 0;
+	m_llStart = 0;
+	memset(m_acTraceFile, 0, sizeof(m_acTraceFile));
+	pthread_mutex_init(&m_aMutex, 0L);
+}
+
+CTracer::~CTracer(void)
+{
+	while(!m_aBuffers.empty())
+	{	delete m_aBuffers.front();
+		m_aBuffers.pop_front();
+	}
+	pthread_mutex_destroy(&m_aMutex);
+}
+
+void CTracer::Start(const char* pcTraceFile, int iNumGpus)
+{
+	strcpy(m_acTraceFile, pcTraceFile);
+	m_iNumGpus = iNumGpus;
+	m_llStart = 0;
+	m_llStart = this->GetNanoSecs();
+	m_bEnabled = true;
+}
+
+//-------------------------------------------------------------------
+// 1. Names the track of the calling thread in the trace.
+//-------------------------------------------------------------------
+void CTracer::NameThread(const char* pcName)
+{
+	if(!m_bEnabled) return;
+	CTraceBuffer* pBuffer = this->GetBuffer();
+	strncpy(pBuffer->m_acName, pcName, sizeof(pBuffer->m_acName) - 1);
+}
+
+//-------------------------------------------------------------------
+// 1. The buffer of the calling thread, created at its first span.
+//    The buffers are kept after their threads exit.
+//-------------------------------------------------------------------
+CTraceBuffer* CTracer::GetBuffer(void)
+{
+	if(s_pBuffer != 0L) return s_pBuffer;
+	pthread_mutex_lock(&m_aMutex);
+	int iThread = (int)m_aBuffers.size();
+	s_pBuffer = new CTraceBuffer(m_iBufSize, iThread);
+	m_aBuffers.push_back(s_pBuffer);
+	pthread_mutex_unlock(&m_aMutex);
+	return s_pBuffer;
+}
+
+long long CTracer::GetNanoSecs(void)
+{
+	struct timespec aTime;
+	clock_gettime(CLOCK_MONOTONIC, &aTime);
+	long long llNs = aTime.tv_sec * 1000000000LL + aTime.tv_nsec;
+	return llNs - m_llStart;
+}
+
+bool CTracer::Save(void)
+{
+	FILE* pFile = fopen(m_acTraceFile, "wt");
+	if(pFile == 0L)
+	{	fprintf(stderr, "Warning: unable to save trace %s\n\n",
+		   m_acTraceFile);
+		return false;
+	}
+	//-----------------
+	pthread_mutex_lock(&m_aMutex);
+	fprintf(pFile, "{\"displayTimeUnit\": \"ms\",\n");
+	fprintf(pFile, "\"traceEvents\": [");
+	m_iNumEntries = 0;
+	mSaveLanes(pFile);
+	long long llDropped = 0;
+	for(int i=0; i<(int)m_aBuffers.size(); i++)
+	{	mSaveEvents(pFile, m_aBuffers[i]);
+		llDropped += m_aBuffers[i]->GetDropped();
+	}
+	fprintf(pFile, "\n],\n\"otherData\": {\"dropped\": %lld}}\n",
+	   llDropped);
+	pthread_mutex_unlock(&m_aMutex);
+	fclose(pFile);
+	//-----------------
+	printf("Trace saved: %s\n", m_acTraceFile);
+	if(llDropped > 0)
+	{	printf("   %lld oldest spans dropped.\n", llDropped);
+	}
+	printf("\n");
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. The host is process 0 and GPU i process i+1. Lanes beyond
+//    the GPUs are prefetch slots.
+// 2. A thread gets a track in every lane it has spans in.
+//-------------------------------------------------------------------
+void CTracer::mSaveLanes(FILE* pFile)
+{
+	std::set<int> aLanes;
+	for(int i=0; i<(int)m_aBuffers.size(); i++)
+	{	CTraceBuffer* pBuffer = m_aBuffers[i];
+		std::set<int> aThreadLanes;
+		for(int e=0; e<pBuffer->GetCount(); e++)
+		{	aThreadLanes.insert(pBuffer->GetEvent(e)->m_iLane + 1);
+		}
+		std::set<int>::iterator itr;
+		for(itr=aThreadLanes.begin(); itr!=aThreadLanes.end(); itr++)
+		{	mNewEntry(pFile);
+			fprintf(pFile, "{\"name\": \"thread_name\", \"ph\": \"M\", "
+			   "\"pid\": %d, \"tid\": %d, "
+			   "\"args\": {\"name\": \"%s\"}}",
+			   *itr, pBuffer->m_iThread, pBuffer->m_acName);
+			aLanes.insert(*itr);
+		}
+	}
+	//-----------------
+	std::set<int>::iterator itr;
+	for(itr=aLanes.begin(); itr!=aLanes.end(); itr++)
+	{	char acName[64] = {'\0'};
+		int iLane = *itr;
+		if(iLane == 0) strcpy(acName, "Host");
+		else if(iLane <= m_iNumGpus) sprintf(acName, "GPU %d", iLane - 1);
+		else sprintf(acName, "Slot %d", iLane - 1);
+		mNewEntry(pFile);
+		fprintf(pFile, "{\"name\": \"process_name\", \"ph\": \"M\", "
+		   "\"pid\": %d, \"args\": {\"name\": \"%s\"}}",
+		   iLane, acName);
+		mNewEntry(pFile);
+		fprintf(pFile, "{\"name\": \"process_sort_index\", "
+		   "\"ph\": \"M\", \"pid\": %d, "
+		   "\"args\": {\"sort_index\": %d}}", iLane, iLane);
+	}
+}
+
+void CTracer::mSaveEvents(FILE* pFile, CTraceBuffer* pBuffer)
+{
+	for(int i=0; i<pBuffer->GetCount(); i++)
+	{	CTraceEvent* pEvent = pBuffer->GetEvent(i);
+		mNewEntry(pFile);
+		fprintf(pFile, "{\"name\": \"%s\", \"ph\": \"X\", "
+		   "\"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+		   "\"args\": {\"bytes\": %zu, \"items\": %d, "
+		   "\"depth\": %d}}", pEvent->m_pcName,
+		   pEvent->m_iLane + 1, pBuffer->m_iThread,
+		   pEvent->m_llStart * 1e-3, pEvent->m_llDur * 1e-3,
+		   pEvent->m_tBytes, pEvent->m_iItems, pEvent->m_iDepth);
+	}
+}
+
+void CTracer::mNewEntry(FILE* pFile)
+{
+	if(m_iNumEntries > 0) fprintf(pFile, ",");
+	fprintf(pFile, "\n");
+	m_iNumEntries += 1;
+}
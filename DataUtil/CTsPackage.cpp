@@ -42,6 +42,7 @@ CTsPackage::CTsPackage(void)
 	{	m_ppTsStacks[i] = new CTiltSeries;
 		m_ppVolStacks[i] = 0L;
 	}
+	m_iCpuRecon = 0;
 }
 
 CTsPackage::~CTsPackage(void)
@@ -80,6 +81,51 @@ void CTsPackage::CreateTiltSeries(void)
 	   pReadMdoc->m_iNumTilts, pAlnSums->m_fPixSize);
 }
 
+//--------------------------------------------------------------------
+// 1. -Stream: makes room for iNumTilts tilts while the tilt series
+//    is being assembled, keeping the tilts already set.
+// 2. The room at least doubles so that each tilt is copied only a
+//    few times. TrimTiltSeries drops the unused room at the end.
+//--------------------------------------------------------------------
+void CTsPackage::GrowTiltSeries(int iNumTilts)
+{
+	int iOldTilts = m_ppTsStacks[0]->m_aiStkSize[2];
+	if(iNumTilts <= iOldTilts) return;
+	//-----------------
+	CReadMdoc* pReadMdoc = CReadMdoc::GetInstance(m_iNthGpu);
+	int iNewTilts = 2 * iOldTilts;
+	if(iNewTilts < iNumTilts) iNewTilts = iNumTilts;
+	if(iNewTilts < pReadMdoc->m_iNumTilts) 
+	{	iNewTilts = pReadMdoc->m_iNumTilts;
+	}
+	//-----------------
+	for(int i=0; i<CAlnSums::m_iNumSums; i++)
+	{	CTiltSeries* pOld = m_ppTsStacks[i];
+		CTiltSeries* pNew = new CTiltSeries;
+		pNew->Create(pOld->m_aiStkSize, iNewTilts);
+		pNew->m_fPixSize = pOld->m_fPixSize;
+		for(int j=0; j<iOldTilts; j++)
+		{	pNew->SetImage(j, pOld->GetFrame(j));
+			pNew->m_pfTilts[j] = pOld->m_pfTilts[j];
+			pNew->m_pfDoses[j] = pOld->m_pfDoses[j];
+			pNew->m_piAcqIndices[j] = pOld->m_piAcqIndices[j];
+			pNew->m_piSecIndices[j] = pOld->m_piSecIndices[j];
+		}
+		delete pOld;
+		m_ppTsStacks[i] = pNew;
+	}
+}
+
+void CTsPackage::TrimTiltSeries(int iNumTilts)
+{
+	for(int i=0; i<CAlnSums::m_iNumSums; i++)
+	{	CTiltSeries* pSeries = m_ppTsStacks[i];
+		while(pSeries->m_aiStkSize[2] > iNumTilts)
+		{	pSeries->RemoveFrame(pSeries->m_aiStkSize[2] - 1);
+		}
+	}
+}
+
 void CTsPackage::SetLoaded(bool bLoaded)
 {
 	for(int i=0; i<MD::CAlnSums::m_iNumSums; i++)
@@ -89,6 +135,7 @@ void CTsPackage::SetLoaded(bool bLoaded)
 
 bool CTsPackage::LoadTiltSeries(void)
 {
+	CTraceSpan aSpan("CTsPackage::LoadTiltSeries", m_iNthGpu);
 	char* pcExt = strrchr(m_acInFile, '.');
 	if(pcExt == 0L) return false;	
 	//-----------------------------------------------
@@ -98,7 +145,8 @@ bool CTsPackage::LoadTiltSeries(void)
 	// from the input directory.
 	//-----------------------------------------------
 	char acMrcFile[256] = {'0'};
-	if(strstr(pcExt, ".mdoc") != 0L) mGenOutPath(".mrc", acMrcFile);
+	bool bMdoc = (strstr(pcExt, ".mdoc") != 0L);
+	if(bMdoc) mGenOutPath(".mrc", acMrcFile);
 	else strcpy(acMrcFile, m_acInFile);
         //-----------------
         Mrc::CLoadMrc loadMrc;
@@ -120,22 +168,30 @@ bool CTsPackage::LoadTiltSeries(void)
 	//--------------------------------------------------
 	loadMrc.CloseFile();
 	mCreateTiltSeries(aiStkSize, aiStkSize[2], fPixSize);
-	//-----------------
+	//-----------------------------------------------
+	// 1) The tilt series of a mdoc input has been
+	// saved by SaveTiltSeries with .mrc extension.
+	//-----------------------------------------------
+	const char* pcMrcExt = bMdoc ? ".mrc" : pcExt;
 	char acExt[32] = {'\0'};
-	strcpy(acExt, pcExt);
+	strcpy(acExt, pcMrcExt);
         bLoaded = mLoadMrc(acExt, m_ppTsStacks[0]);
 	if(!bLoaded) return false;
 	//-----------------
 	strcpy(acExt, "_EVN");
-	strcat(acExt, pcExt);
+	strcat(acExt, pcMrcExt);
 	mLoadMrc(acExt, m_ppTsStacks[1]);
 	//-----------------
 	strcpy(acExt, "_ODD");
-	strcat(acExt, pcExt);
+	strcat(acExt, pcMrcExt);
         mLoadMrc(acExt, m_ppTsStacks[2]);
 	//-----------------
 	bLoaded = mLoadTiltFile();
 	if(!bLoaded) return false;
+	//-----------------
+	CTiltSeries* pSeries = this->GetSeries(0);
+	aSpan.AddBytes(pSeries->m_tFmBytes * pSeries->m_aiStkSize[2]);
+	aSpan.AddItems(pSeries->m_aiStkSize[2]);
 	return true;
 }
 
@@ -248,26 +304,17 @@ void CTsPackage::mSaveMrc
 (	const char* pcExt, 
 	CTiltSeries* pTiltSeries
 )
-{	char acMrcFile[256] = {'0'};
-	mGenOutPath(pcExt, acMrcFile);
-	//-----------------
-	Mrc::CSaveMrc saveMrc;
-	saveMrc.OpenFile(acMrcFile);
-	saveMrc.SetMode(Mrc::eMrcFloat);
-	saveMrc.SetExtHeader(0, 32, 0);
-	saveMrc.SetImgSize(pTiltSeries->m_aiStkSize,
-	   pTiltSeries->m_aiStkSize[2], 1,
-	   pTiltSeries->m_fPixSize);
-	saveMrc.m_pSaveMain->DoIt();
-	//-----------------
-	float** ppfImages = pTiltSeries->GetImages();
-	for(int i=0; i<pTiltSeries->m_aiStkSize[2]; i++)
-	{	float fTilt = pTiltSeries->m_pfTilts[i];
-		saveMrc.m_pSaveExt->SetTilt(i, &fTilt, 1);
-		saveMrc.m_pSaveExt->DoIt();
-		saveMrc.m_pSaveImg->DoIt(i, ppfImages[i]);
-	}
-	saveMrc.CloseFile();
+{	CWriteStack* pWriteStack = new CWriteStack;
+	mGenOutPath(pcExt, pWriteStack->m_acFile);
+	pWriteStack->m_iNthGpu = m_iNthGpu;
+	//-----------------------------------------------
+	// 1) The tilt series is processed further. It
+	// is borrowed and copied when queued.
+	//-----------------------------------------------
+	bool bOwn = true;
+	pWriteStack->SetStack(pTiltSeries, !bOwn);
+	pWriteStack->SetTilts(pTiltSeries->m_pfTilts);
+	CAsyncWriter::GetInstance()->Submit(pWriteStack);
 }
 
 void CTsPackage::mSaveTiltFile(CTiltSeries* pTiltSeries)
@@ -275,10 +322,12 @@ void CTsPackage::mSaveTiltFile(CTiltSeries* pTiltSeries)
 	char acTiltFile[256] = {'0'};
 	mGenOutPath("_TLT.txt", acTiltFile);
 	//-----------------
-	FILE* pFile = fopen(acTiltFile, "wt");
+	CWriteText* pWriteText = new CWriteText;
+	FILE* pFile = pWriteText->Open(acTiltFile, m_iNthGpu);
 	if(pFile == 0L)
 	{	printf("GPU %d warning: Unable to save tilt angles\n\n",
 		   m_iNthGpu, acTiltFile);
+		delete pWriteText;
 		return;
 	}
 	//-----------------------------------------------
@@ -301,7 +350,7 @@ void CTsPackage::mSaveTiltFile(CTiltSeries* pTiltSeries)
 		fprintf(pFile, "%8.2f  %4d  %8.2f\n", 
 		   fTilt, iAcqIdx, fDose);
 	}
-	fclose(pFile);
+	pWriteText->Submit();
 }
 
 bool CTsPackage::mLoadMrc
@@ -312,6 +361,12 @@ bool CTsPackage::mLoadMrc
 	mGenInPath(pcExt, acMrcFile);
 	//-----------------
 	pTiltSeries->m_bLoaded = false;
+	CInput* pInput = CInput::GetInstance();
+	if(pInput->m_iMmapLoad != 0 && mMapMrc(acMrcFile, pTiltSeries))
+	{	pTiltSeries->m_bLoaded = true;
+		return true;
+	}
+	//-----------------
 	Mrc::CLoadMrc loadMrc;
 	bool bLoaded = loadMrc.OpenFile(acMrcFile);
 	if(!bLoaded) return false;
@@ -355,6 +410,41 @@ bool CTsPackage::mLoadMrc
 	return false;
 }
 
+//-------------------------------------------------------------------
+// 1. With -MmapLoad 2 float sections in native byte order are used
+//    in place. Otherwise they are converted to float in one pass.
+// 2. Returns false when the file cannot be mapped or does not match
+//    the tilt series. mLoadMrc then falls back to Mrc::CLoadMrc.
+//-------------------------------------------------------------------
+bool CTsPackage::mMapMrc
+(	const char* pcMrcFile,
+	CTiltSeries* pTiltSeries
+)
+{	CMapMrc* pMapMrc = new CMapMrc;
+	bool bMapped = pMapMrc->OpenFile(pcMrcFile);
+	int* piStkSize = pTiltSeries->m_aiStkSize;
+	if(pMapMrc->m_aiSize[0] != piStkSize[0]) bMapped = false;
+	else if(pMapMrc->m_aiSize[1] != piStkSize[1]) bMapped = false;
+	else if(pMapMrc->m_aiSize[2] < piStkSize[2]) bMapped = false;
+	if(!bMapped)
+	{	delete pMapMrc;
+		return false;
+	}
+	//-----------------
+	CInput* pInput = CInput::GetInstance();
+	if(pInput->m_iMmapLoad == 2 && pTiltSeries->MapFrames(pMapMrc))
+	{	return true;
+	}
+	//-----------------
+	for(int i=0; i<piStkSize[2]; i++)
+	{	float* pfImg = (float*)pTiltSeries->GetFrame(i);
+		bMapped = pMapMrc->ReadFloat(i, pfImg);
+		if(!bMapped) break;
+	}
+	delete pMapMrc;
+	return bMapped;
+}
+
 bool CTsPackage::mLoadTiltFile(void)
 {
 	char acTlt[256] = {'\0'}, acRawTlt[256] = {'\0'};
@@ -0,0 +1,350 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo::DataUtil;
+
+CTsJob::CTsJob(void)
+{
+	memset(m_acInFile, 0, sizeof(m_acInFile));
+	m_iAttempts = 0;
+	m_dQueued = 0.0;
+	m_dNotBefore = 0.0;
+}
+
+CTsScheduler* CTsScheduler::m_pInstance = 0L;
+
+CTsScheduler* CTsScheduler::GetInstance(void)
+{
+	if(m_pInstance != 0L) return m_pInstance;
+	m_pInstance = new CTsScheduler;
+	return m_pInstance;
+}
+
+void CTsScheduler::DeleteInstance(void)
+{
+	if(m_pInstance == 0L) return;
+	delete m_pInstance;
+	m_pInstance = 0L;
+}
+
+double CTsScheduler::GetSeconds(void)
+{
+	struct timespec aTime;
+	clock_gettime(CLOCK_MONOTONIC, &aTime);
+	return aTime.tv_sec + aTime.tv_nsec * 1e-9;
+}
+
+//-------------------------------------------------------------------
+// 1. By default 1/8 of the physical memory must be available to
+//    start another tilt series while one is running.
+//-------------------------------------------------------------------
+CTsScheduler::CTsScheduler(void)
+{
+	m_ppRunning = 0L;
+	m_pdBusySecs = 0L;
+	m_pdStarts = 0L;
+	m_piNumJobs = 0L;
+	m_iNumWorkers = 0;
+	//-----------------
+	m_fSettleSecs = 30.0f;
+	m_fRetrySecs = 5.0f;
+	m_iMaxRetries = 10;
+	size_t tPages = (size_t)sysconf(_SC_PHYS_PAGES);
+	size_t tPageSize = (size_t)sysconf(_SC_PAGESIZE);
+	m_tMinAvailBytes = tPages * tPageSize / 8;
+	//-----------------
+	pthread_mutex_init(&m_aMutex, 0L);
+	pthread_cond_init(&m_aCond, 0L);
+	this->Setup(0);
+}
+
+CTsScheduler::~CTsScheduler(void)
+{
+	mClean();
+	pthread_cond_destroy(&m_aCond);
+	pthread_mutex_destroy(&m_aMutex);
+}
+
+void CTsScheduler::Setup(int iNumWorkers)
+{
+	mClean();
+	m_iNumWorkers = iNumWorkers;
+	if(m_iNumWorkers > 0)
+	{	m_ppRunning = new CTsJob*[m_iNumWorkers];
+		m_pdBusySecs = new double[m_iNumWorkers];
+		m_pdStarts = new double[m_iNumWorkers];
+		m_piNumJobs = new int[m_iNumWorkers];
+		memset(m_ppRunning, 0, sizeof(CTsJob*) * m_iNumWorkers);
+		memset(m_pdBusySecs, 0, sizeof(double) * m_iNumWorkers);
+		memset(m_pdStarts, 0, sizeof(double) * m_iNumWorkers);
+		memset(m_piNumJobs, 0, sizeof(int) * m_iNumWorkers);
+	}
+	//-----------------
+	m_iNumBusy = 0;
+	m_bClosed = false;
+	m_bHolding = false;
+	m_dStart = CTsScheduler::GetSeconds();
+	m_dWaitSecs = 0.0;
+	m_dMaxWait = 0.0;
+	m_iDispatched = 0;
+	m_iDeferred = 0;
+	m_iDropped = 0;
+	m_iMaxDepth = 0;
+}
+
+void CTsScheduler::PushFile(const char* pcInFile)
+{
+	if(pcInFile == 0L) return;
+	CTsJob* pJob = new CTsJob;
+	strncpy(pJob->m_acInFile, pcInFile, sizeof(pJob->m_acInFile) - 1);
+	pJob->m_dQueued = CTsScheduler::GetSeconds();
+	//-----------------
+	pthread_mutex_lock(&m_aMutex);
+	m_aJobs.push_back(pJob);
+	int iDepth = (int)m_aJobs.size();
+	if(iDepth > m_iMaxDepth) m_iMaxDepth = iDepth;
+	pthread_cond_broadcast(&m_aCond);
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+//-------------------------------------------------------------------
+// 1. No more files will be pushed. WaitJob returns false once the
+//    queue is empty and no worker can defer a job back into it.
+//-------------------------------------------------------------------
+void CTsScheduler::Close(void)
+{
+	pthread_mutex_lock(&m_aMutex);
+	m_bClosed = true;
+	pthread_cond_broadcast(&m_aCond);
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+bool CTsScheduler::WaitJob(int iWorker, char* pcInFile)
+{
+	pthread_mutex_lock(&m_aMutex);
+	CTsJob* pJob = 0L;
+	while(true)
+	{	if(m_bClosed && m_aJobs.empty() && m_iNumBusy == 0) break;
+		//----------------
+		double dNow = CTsScheduler::GetSeconds();
+		double dWakeUp = dNow + 1.0;
+		int iJob = mPickJob(dNow, &dWakeUp);
+		if(iJob >= 0 && m_iNumBusy > 0 && !mCheckMemory()) iJob = -1;
+		if(iJob >= 0)
+		{	pJob = m_aJobs[iJob];
+			m_aJobs.erase(m_aJobs.begin() + iJob);
+			break;
+		}
+		//----------------
+		double dWait = dWakeUp - dNow;
+		if(dWait < 0.01) dWait = 0.01;
+		struct timespec aTime;
+		clock_gettime(CLOCK_REALTIME, &aTime);
+		double dNsec = aTime.tv_nsec + dWait * 1e9;
+		aTime.tv_sec += (time_t)(dNsec * 1e-9);
+		aTime.tv_nsec = (long)(dNsec - (double)(time_t)(dNsec * 1e-9) * 1e9);
+		pthread_cond_timedwait(&m_aCond, &m_aMutex, &aTime);
+	}
+	//-----------------
+	if(pJob == 0L)
+	{	pthread_cond_broadcast(&m_aCond);
+		pthread_mutex_unlock(&m_aMutex);
+		return false;
+	}
+	//-----------------
+	double dNow = CTsScheduler::GetSeconds();
+	double dWait = dNow - pJob->m_dQueued;
+	m_dWaitSecs += dWait;
+	if(dWait > m_dMaxWait) m_dMaxWait = dWait;
+	m_iDispatched += 1;
+	m_iNumBusy += 1;
+	m_ppRunning[iWorker] = pJob;
+	m_pdStarts[iWorker] = dNow;
+	m_piNumJobs[iWorker] += 1;
+	int iDepth = (int)m_aJobs.size();
+	strcpy(pcInFile, pJob->m_acInFile);
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	printf("Scheduler: worker %d takes %s\n"
+	   "   waited %.1f s, %d left in queue\n\n",
+	   iWorker, pcInFile, dWait, iDepth);
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Returns the running job of iWorker to the queue. JobDone must
+//    still be called.
+//-------------------------------------------------------------------
+void CTsScheduler::Defer(int iWorker)
+{
+	pthread_mutex_lock(&m_aMutex);
+	CTsJob* pJob = m_ppRunning[iWorker];
+	m_ppRunning[iWorker] = 0L;
+	bool bDrop = true;
+	if(pJob != 0L && pJob->m_iAttempts < m_iMaxRetries)
+	{	double dNow = CTsScheduler::GetSeconds();
+		pJob->m_iAttempts += 1;
+		pJob->m_dNotBefore = dNow + m_fRetrySecs;
+		m_aJobs.push_back(pJob);
+		m_iDeferred += 1;
+		bDrop = false;
+		pthread_cond_broadcast(&m_aCond);
+	}
+	else if(pJob != 0L) m_iDropped += 1;
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	if(!bDrop || pJob == 0L) return;
+	printf("Warning: failed to read mdoc file.\n");
+	printf("   mdoc file: %s\n\n", pJob->m_acInFile);
+	delete pJob;
+}
+
+void CTsScheduler::JobDone(int iWorker)
+{
+	pthread_mutex_lock(&m_aMutex);
+	CTsJob* pJob = m_ppRunning[iWorker];
+	m_ppRunning[iWorker] = 0L;
+	m_pdBusySecs[iWorker] += CTsScheduler::GetSeconds()
+	   - m_pdStarts[iWorker];
+	m_iNumBusy -= 1;
+	pthread_cond_broadcast(&m_aCond);
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	if(pJob != 0L) delete pJob;
+}
+
+int CTsScheduler::GetQueueSize(void)
+{
+	pthread_mutex_lock(&m_aMutex);
+	int iSize = (int)m_aJobs.size();
+	pthread_mutex_unlock(&m_aMutex);
+	return iSize;
+}
+
+void CTsScheduler::PrintStats(void)
+{
+	pthread_mutex_lock(&m_aMutex);
+	double dWall = CTsScheduler::GetSeconds() - m_dStart;
+	double dMeanWait = (m_iDispatched > 0) ?
+	   m_dWaitSecs / m_iDispatched : 0.0;
+	printf("Scheduler: %d dispatched, %d deferred, %d dropped\n",
+	   m_iDispatched, m_iDeferred, m_iDropped);
+	printf("   max queue depth %d, wait mean %.1f s max %.1f s\n",
+	   m_iMaxDepth, dMeanWait, m_dMaxWait);
+	for(int i=0; i<m_iNumWorkers; i++)
+	{	double dUtil = (dWall > 0) ? m_pdBusySecs[i] / dWall : 0.0;
+		printf("   worker %d: %d jobs, busy %.1f s, %.1f%%\n",
+		   i, m_piNumJobs[i], m_pdBusySecs[i], dUtil * 100.0);
+	}
+	printf("\n");
+	pthread_mutex_unlock(&m_aMutex);
+}
+
+//-------------------------------------------------------------------
+// 1. Must be called with m_aMutex locked.
+// 2. Jobs that are complete (mIsComplete) are picked first, oldest
+//    first. pdWakeUp is lowered to when a deferred job becomes
+//    ready or a growing mdoc settles.
+// 3. Returns the index of the job in m_aJobs, or -1. The job stays
+//    queued until WaitJob has also passed the memory check.
+//-------------------------------------------------------------------
+int CTsScheduler::mPickJob(double dNow, double* pdWakeUp)
+{
+	int iBest = -1;
+	bool bBestComplete = false;
+	for(int i=0; i<(int)m_aJobs.size(); i++)
+	{	CTsJob* pJob = m_aJobs[i];
+		if(pJob->m_dNotBefore > dNow)
+		{	if(pJob->m_dNotBefore < *pdWakeUp)
+			{	*pdWakeUp = pJob->m_dNotBefore;
+			}
+			continue;
+		}
+		bool bComplete = mIsComplete(pJob, dNow);
+		if(!bComplete)
+		{	double dSettle = dNow + m_fSettleSecs;
+			if(dSettle < *pdWakeUp) *pdWakeUp = dSettle;
+		}
+		if(iBest >= 0 && (bBestComplete || !bComplete)) continue;
+		iBest = i;
+		bBestComplete = bComplete;
+	}
+	return iBest;
+}
+
+//-------------------------------------------------------------------
+// 1. MemAvailable from /proc/meminfo includes reclaimable page
+//    cache, unlike _SC_AVPHYS_PAGES.
+// 2. Prints once each time the scheduler starts holding jobs.
+//-------------------------------------------------------------------
+bool CTsScheduler::mCheckMemory(void)
+{
+	if(m_tMinAvailBytes == 0) return true;
+	FILE* pFile = fopen("/proc/meminfo", "rt");
+	if(pFile == 0L) return true;
+	//-----------------
+	size_t tAvailKB = 0;
+	char acLine[256] = {'\0'};
+	bool bFound = false;
+	while(fgets(acLine, sizeof(acLine), pFile) != 0L)
+	{	if(strncmp(acLine, "MemAvailable:", 13) != 0) continue;
+		tAvailKB = strtoull(acLine + 13, 0L, 10);
+		bFound = true;
+		break;
+	}
+	fclose(pFile);
+	if(!bFound) return true;
+	//-----------------
+	bool bEnough = (tAvailKB * 1024) >= m_tMinAvailBytes;
+	if(!bEnough && !m_bHolding)
+	{	printf("Scheduler: %.1f GB available, less than %.1f GB, "
+		   "waiting for a running job to finish.\n\n",
+		   tAvailKB / 1048576.0, m_tMinAvailBytes / 1073741824.0);
+	}
+	m_bHolding = !bEnough;
+	return bEnough;
+}
+
+//-------------------------------------------------------------------
+// 1. Anything but an mdoc is complete. An mdoc is complete when it
+//    has not been modified for m_fSettleSecs.
+//-------------------------------------------------------------------
+bool CTsScheduler::mIsComplete(CTsJob* pJob, double dNow)
+{
+	const char* pcExt = strrchr(pJob->m_acInFile, '.');
+	if(pcExt == 0L || strcasestr(pcExt, ".mdoc") == 0L) return true;
+	//-----------------
+	struct stat aStat;
+	if(stat(pJob->m_acInFile, &aStat) != 0) return false;
+	struct timespec aTime;
+	clock_gettime(CLOCK_REALTIME, &aTime);
+	double dAge = difftime(aTime.tv_sec, aStat.st_mtime);
+	return dAge >= m_fSettleSecs;
+}
+
+void CTsScheduler::mClean(void)
+{
+	while(!m_aJobs.empty())
+	{	delete m_aJobs.front();
+		m_aJobs.pop_front();
+	}
+	for(int i=0; i<m_iNumWorkers; i++)
+	{	if(m_ppRunning[i] != 0L) delete m_ppRunning[i];
+	}
+	if(m_ppRunning != 0L) delete[] m_ppRunning;
+	if(m_pdBusySecs != 0L) delete[] m_pdBusySecs;
+	if(m_pdStarts != 0L) delete[] m_pdStarts;
+	if(m_piNumJobs != 0L) delete[] m_piNumJobs;
+	m_ppRunning = 0L;
+	m_pdBusySecs = 0L;
+	m_pdStarts = 0L;
+	m_piNumJobs = 0L;
+	m_iNumWorkers = 0;
+}
@@ -0,0 +1,23 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+
+using namespace McAreTomo::DataUtil;
+
+CWriteJob::CWriteJob(void)
+{
+	memset(m_acFile, 0, sizeof(m_acFile));
+	memset(m_acStamp, 0, sizeof(m_acStamp));
+	m_tBytes = 0;
+	m_iNthGpu = 0;
+	m_bReport = false;
+}
+
+CWriteJob::~CWriteJob(void)
+{
+}
+
+void CWriteJob::Detach(void)
+{
+}
@@ -0,0 +1,98 @@
+#include "CDataUtilInc.h"
+#include "../CMcAreTomoInc.h"
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+
+using namespace McAreTomo::DataUtil;
+
+CWriteStack::CWriteStack(void)
+{
+	m_pMrcStack = 0L;
+	m_pfTilts = 0L;
+	memset(m_aiExtHeader, 0, sizeof(m_aiExtHeader));
+	memset(m_afStats, 0, sizeof(m_afStats));
+	m_fPixSize = 0.0f;
+	m_bOwn = false;
+	m_bStats = false;
+}
+
+CWriteStack::~CWriteStack(void)
+{
+	if(m_bOwn && m_pMrcStack != 0L) delete m_pMrcStack;
+	if(m_pfTilts != 0L) delete[] m_pfTilts;
+}
+
+void CWriteStack::SetStack(CMrcStack* pMrcStack, bool bOwn)
+{
+	m_pMrcStack = pMrcStack;
+	m_bOwn = bOwn;
+	m_tBytes = pMrcStack->m_tFmBytes * pMrcStack->m_aiStkSize[2];
+}
+
+//-------------------------------------------------------------------
+// 1. Tilts are copied since they go into the extended header
+//    after the caller has moved on.
+//-------------------------------------------------------------------
+void CWriteStack::SetTilts(float* pfTilts)
+{
+	if(m_pfTilts != 0L) delete[] m_pfTilts;
+	m_pfTilts = 0L;
+	if(pfTilts == 0L || m_pMrcStack == 0L) return;
+	int iNumTilts = m_pMrcStack->m_aiStkSize[2];
+	m_pfTilts = new float[iNumTilts];
+	memcpy(m_pfTilts, pfTilts, sizeof(float) * iNumTilts);
+}
+
+void CWriteStack::SetExtHeader(int iNumInts, int iNumFloats)
+{
+	m_aiExtHeader[0] = iNumInts;
+	m_aiExtHeader[1] = iNumFloats;
+}
+
+void CWriteStack::SetPixSize(float fPixSize)
+{
+	m_fPixSize = fPixSize;
+}
+
+void CWriteStack::SetMinMaxMean(float fMin, float fMax, float fMean)
+{
+	m_afStats[0] = fMin;
+	m_afStats[1] = fMax;
+	m_afStats[2] = fMean;
+	m_bStats = true;
+}
+
+bool CWriteStack::DoIt(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	CSaveMrcStack aSaveStack;
+	aSaveStack.SetExtHeader(m_aiExtHeader[0], m_aiExtHeader[1]);
+	aSaveStack.SetPixSize(m_fPixSize);
+	if(m_bStats)
+	{	aSaveStack.SetMinMaxMean(m_afStats[0],
+		   m_afStats[1], m_afStats[2]);
+	}
+	aSaveStack.m_bSync = true;
+	return aSaveStack.DoIt(m_acFile, m_pMrcStack, m_pfTilts,
+	   pInput->m_iDirectIO != 0);
+}
+
+//-------------------------------------------------------------------
+// 1. A borrowed stack is copied into a stack of the job's own so
+//    that the caller can reuse it as soon as Submit returns.
+//-------------------------------------------------------------------
+void CWriteStack::Detach(void)
+{
+	if(m_bOwn || m_pMrcStack == 0L) return;
+	CMrcStack* pCopy = new CMrcStack;
+	pCopy->Create(m_pMrcStack->m_iMode, m_pMrcStack->m_aiStkSize);
+	pCopy->m_fPixSize = m_pMrcStack->m_fPixSize;
+	pCopy->m_fStkDose = m_pMrcStack->m_fStkDose;
+	for(int i=0; i<m_pMrcStack->m_aiStkSize[2]; i++)
+	{	memcpy(pCopy->GetFrame(i), m_pMrcStack->GetFrame(i),
+		   m_pMrcStack->m_tFmBytes);
+	}
+	m_pMrcStack = pCopy;
+	m_bOwn = true;
+}
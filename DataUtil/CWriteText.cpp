@@ -0,0 +1,69 @@
+#include "CDataUtilInc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace McAreTomo::DataUtil;
+
+CWriteText::CWriteText(void)
+{
+	m_pStream = 0L;
+	m_pcText = 0L;
+	m_tSize = 0;
+}
+
+CWriteText::~CWriteText(void)
+{
+	if(m_pStream != 0L) fclose(m_pStream);
+	if(m_pcText != 0L) free(m_pcText);
+}
+
+FILE* CWriteText::Open(const char* pcFile, int iNthGpu)
+{
+	strcpy(m_acFile, pcFile);
+	m_iNthGpu = iNthGpu;
+	m_pStream = open_memstream(&m_pcText, &m_tSize);
+	return m_pStream;
+}
+
+//-------------------------------------------------------------------
+// 1. The text is final once the stream is closed. The job belongs
+//    to CAsyncWriter afterwards.
+//-------------------------------------------------------------------
+void CWriteText::Submit(void)
+{
+	if(m_pStream != 0L) fclose(m_pStream);
+	m_pStream = 0L;
+	m_tBytes = m_tSize;
+	CAsyncWriter::GetInstance()->Submit(this);
+}
+
+bool CWriteText::DoIt(void)
+{
+	int iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+	mode_t aMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+	int iFile = open(m_acFile, iFlags, aMode);
+	if(iFile == -1) return false;
+	//-----------------
+	char* pcBuf = m_pcText;
+	size_t tBytes = m_tSize;
+	bool bWritten = true;
+	while(tBytes > 0)
+	{	ssize_t tWritten = write(iFile, pcBuf, tBytes);
+		if(tWritten < 0 && errno == EINTR) continue;
+		if(tWritten <= 0)
+		{	bWritten = false;
+			break;
+		}
+		pcBuf += tWritten;
+		tBytes -= tWritten;
+	}
+	if(bWritten && fdatasync(iFile) != 0) bWritten = false;
+	if(close(iFile) != 0) bWritten = false;
+	return bWritten;
+}
@@ -0,0 +1,66 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+CAddFrames::CAddFrames(void)
+{
+}
+
+CAddFrames::~CAddFrames(void)
+{
+}
+
+void CAddFrames::DoIt
+(	unsigned char* pucFrm1,
+	unsigned char* pucFrm2,
+	unsigned char* pucSum,
+	int* piFrmSize
+)
+{	size_t tPixels = (size_t)piFrmSize[0] * piFrmSize[1];
+	mAddWords(pucFrm1, pucFrm2, pucSum, tPixels, 
+	   0x8080808080808080UL);
+	//-----------------
+	size_t tStart = tPixels / sizeof(unsigned long) 
+	   * sizeof(unsigned long);
+	for(size_t i=tStart; i<tPixels; i++)
+	{	pucSum[i] = pucFrm1[i] + pucFrm2[i];
+	}
+}
+
+void CAddFrames::DoIt
+(	unsigned short* pusFrm1,
+	unsigned short* pusFrm2,
+	unsigned short* pusSum,
+	int* piFrmSize
+)
+{	size_t tPixels = (size_t)piFrmSize[0] * piFrmSize[1];
+	mAddWords((unsigned char*)pusFrm1, (unsigned char*)pusFrm2,
+	   (unsigned char*)pusSum, tPixels * sizeof(short), 
+	   0x8000800080008000UL);
+	//-----------------
+	size_t tStart = tPixels * sizeof(short) / sizeof(unsigned long) 
+	   * sizeof(unsigned long) / sizeof(short);
+	for(size_t i=tStart; i<tPixels; i++)
+	{	pusSum[i] = pusFrm1[i] + pusFrm2[i];
+	}
+}
+
+void CAddFrames::mAddWords
+(	unsigned char* pucFrm1,
+	unsigned char* pucFrm2,
+	unsigned char* pucSum,
+	size_t tBytes,
+	unsigned long ulHigh
+)
+{	unsigned long ulLow = ~ulHigh;
+	size_t tWords = tBytes / sizeof(unsigned long);
+	unsigned long* pulFrm1 = (unsigned long*)pucFrm1;
+	unsigned long* pulFrm2 = (unsigned long*)pucFrm2;
+	unsigned long* pulSum = (unsigned long*)pucSum;
+	for(size_t i=0; i<tWords; i++)
+	{	unsigned long a = pulFrm1[i], b = pulFrm2[i];
+		pulSum[i] = ((a & ulLow) + (b & ulLow)) ^ ((a ^ b) & ulHigh);
+	}
+}
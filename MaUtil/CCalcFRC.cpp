@@ -0,0 +1,79 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::MaUtil;
+
+CCalcFRC::CCalcFRC(void)
+{
+}
+
+CCalcFRC::~CCalcFRC(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. Gives the rings of mGCalcFRC. A pixel is in the ring [iLow,
+//    iHigh) when the integer part of its radius is, so the sums
+//    are binned by that part once and each ring adds its bins.
+// 2. The sums are in double instead of float.
+//-------------------------------------------------------------------
+void CCalcFRC::DoIt
+(	cufftComplex* pCmp1,
+	cufftComplex* pCmp2,
+	float* pfFRC,
+	int iRingWidth,
+	int* piCmpSize
+)
+{	int iCmpX = piCmpSize[0];
+	int iCmpY = piCmpSize[1];
+	double* pdBins = new double[iCmpX * 4];
+	memset(pdBins, 0, sizeof(double) * iCmpX * 4);
+	double* pdCC = pdBins;
+	double* pdP1 = pdBins + iCmpX;
+	double* pdP2 = pdBins + iCmpX * 2;
+	double* pdCount = pdBins + iCmpX * 3;
+	//-----------------
+	float fHalfY = 0.5f * iCmpY;
+	for(int y=0; y<iCmpY; y++)
+	{	float fY = (y < fHalfY) ? y : y - iCmpY;
+		if(fabsf(fY) >= iCmpX) continue;
+		for(int x=0; x<iCmpX; x++)
+		{	float fR = sqrtf(x * x + fY * fY);
+			if(fR >= iCmpX) break;
+			int r = (int)fR;
+			cufftComplex c1 = pCmp1[y * iCmpX + x];
+			cufftComplex c2 = pCmp2[y * iCmpX + x];
+			pdCC[r] += (c1.x * c2.x + c1.y * c2.y);
+			pdP1[r] += (c1.x * c1.x + c1.y * c1.y);
+			pdP2[r] += (c2.x * c2.x + c2.y * c2.y);
+			pdCount[r] += 1.0;
+		}
+	}
+	//-----------------
+	for(int b=0; b<iCmpX; b++)
+	{	int iLow = b - iRingWidth / 2;
+		int iHigh = iLow + iRingWidth;
+		if(iLow < 0)
+		{	iLow = 0;
+			iHigh = iRingWidth;
+		}
+		else if(iHigh >= iCmpX)
+		{	iHigh = iCmpX - 1;
+			iLow = iHigh - iRingWidth;
+		}
+		//----------------
+		double dCC = 0.0, dP1 = 0.0, dP2 = 0.0, dCount = 0.0;
+		if(iLow < 0) iLow = 0;
+		for(int r=iLow; r<iHigh; r++)
+		{	dCC += pdCC[r];
+			dP1 += pdP1[r];
+			dP2 += pdP2[r];
+			dCount += pdCount[r];
+		}
+		if(dCount == 0) pfFRC[b] = 0.0f;
+		else pfFRC[b] = (float)(dCC / sqrt(dP1 * dP2));
+	}
+	delete[] pdBins;
+}
@@ -0,0 +1,60 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+template <int Exp>
+static float sSumRow(float* pfRow, int iSizeX)
+{
+	float fSum = 0.0f;
+	for(int x=0; x<iSizeX; x++)
+	{	float fVal = pfRow[x];
+		float fExpVal = fVal;
+		for(int i=1; i<Exp; i++) fExpVal *= fVal;
+		fSum += (fVal < (float)-1e10) ? 0.0f : fExpVal;
+	}
+	return fSum;
+}
+
+static float sSumRow(float* pfRow, int iSizeX, int iExp)
+{
+	float fSum = 0.0f;
+	for(int x=0; x<iSizeX; x++)
+	{	float fVal = pfRow[x];
+		if(fVal < (float)-1e10) continue;
+		float fExpVal = fVal;
+		for(int i=1; i<iExp; i++) fExpVal *= fVal;
+		fSum += fExpVal;
+	}
+	return fSum;
+}
+
+CCalcMoment2D::CCalcMoment2D(void)
+{
+}
+
+CCalcMoment2D::~CCalcMoment2D(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. Exponents 1 and 2 have unrolled row sums that vectorize.
+//-------------------------------------------------------------------
+float CCalcMoment2D::DoIt
+(	float* pfImg,
+	int* piImgSize,
+	bool bPadded,
+	int iExponent
+)
+{	int iPadX = piImgSize[0];
+	int iSizeX = bPadded ? (iPadX / 2 - 1) * 2 : iPadX;
+	double dSum = 0.0;
+	for(int y=0; y<piImgSize[1]; y++)
+	{	float* pfRow = pfImg + (size_t)y * iPadX;
+		if(iExponent <= 1) dSum += sSumRow<1>(pfRow, iSizeX);
+		else if(iExponent == 2) dSum += sSumRow<2>(pfRow, iSizeX);
+		else dSum += sSumRow(pfRow, iSizeX, iExponent);
+	}
+	return (float)(dSum / ((double)iSizeX * piImgSize[1]));
+}
@@ -1,5 +1,6 @@
 #include "CMaUtilInc.h"
 #include <stdio.h>
+#include <memory.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <Util/Util_Time.h>
@@ -13,6 +14,7 @@ CCufft2D::CCufft2D(void)
 	m_iFFTx = 0;
 	m_iFFTy = 0;
 	m_aType = CUFFT_R2C;
+	m_pHostFFT = 0L;
 }
 
 CCufft2D::~CCufft2D(void)
@@ -23,13 +25,19 @@ CCufft2D::~CCufft2D(void)
 void CCufft2D::CreateForwardPlan(int* piSize, bool bPad)
 {
 	int iFFTx = bPad? (piSize[0] / 2 - 1) * 2 : piSize[0];
+	bool bHost = (GetBackend() == hostBackend);
 	if(iFFTx == m_iFFTx && piSize[1] == m_iFFTy &&
-	   m_aType == CUFFT_R2C) return;
+	   m_aType == CUFFT_R2C && bHost == (m_pHostFFT != 0L)) return;
 	//-----------------
 	this->DestroyPlan();
 	m_iFFTx = iFFTx;
 	m_iFFTy = piSize[1];
 	m_aType = CUFFT_R2C;
+	if(bHost)
+	{	m_pHostFFT = new CFFT2D;
+		m_pHostFFT->CreatePlan(m_iFFTx, m_iFFTy, GetHostThreads());
+		return;
+	}
      	cufftResult res = cufftPlan2d(&m_aPlan, m_iFFTy, m_iFFTx, m_aType);
 	//-----------------
 	const char* pcFormat = "CCufft2D::CreateForwardPlan: %s\n";
@@ -39,13 +47,19 @@ void CCufft2D::CreateForwardPlan(int* piSize, bool bPad)
 void CCufft2D::CreateInversePlan(int* piSize, bool bCmp)
 {
 	int iFFTx = bCmp? (piSize[0] - 1) * 2 : piSize[0];
+	bool bHost = (GetBackend() == hostBackend);
 	if(iFFTx == m_iFFTx && piSize[1] == m_iFFTy &&
-	   m_aType == CUFFT_C2R) return;
+	   m_aType == CUFFT_C2R && bHost == (m_pHostFFT != 0L)) return;
 	//-----------------
 	this->DestroyPlan();
 	m_iFFTx = iFFTx;
 	m_iFFTy = piSize[1];
 	m_aType = CUFFT_C2R;
+	if(bHost)
+	{	m_pHostFFT = new CFFT2D;
+		m_pHostFFT->CreatePlan(m_iFFTx, m_iFFTy, GetHostThreads());
+		return;
+	}
 	cufftResult res = cufftPlan2d(&m_aPlan, m_iFFTy, m_iFFTx, m_aType);
 	//-----------------------------------------------------------------
 	const char* pcFormat = "CCufft2D::CreateInversePlan: %s\n";
@@ -54,6 +68,12 @@ void CCufft2D::CreateInversePlan(int* piSize, bool bCmp)
 
 void CCufft2D::DestroyPlan(void)
 {
+	if(m_pHostFFT != 0L)
+	{	delete m_pHostFFT;
+		m_pHostFFT = 0L;
+		m_iFFTx = 0;
+		m_iFFTy = 0;
+	}
 	if(m_aPlan == 0) return;
 	cufftResult res = cufftDestroy(m_aPlan);
 	m_aPlan = 0;
@@ -65,6 +85,16 @@ void CCufft2D::DestroyPlan(void)
 bool CCufft2D::Forward(float* gfPadImg, cufftComplex* gCmpImg,
 	bool bNorm, cudaStream_t stream)
 {
+	if(m_pHostFFT != 0L)
+	{	size_t tBytes = sizeof(cufftComplex) * (m_iFFTx / 2 + 1)
+		   * m_iFFTy;
+		if((void*)gCmpImg != (void*)gfPadImg)
+		{	memcpy(gCmpImg, gfPadImg, tBytes);
+		}
+		m_pHostFFT->Forward((float*)gCmpImg, bNorm);
+		return true;
+	}
+	//-----------------
 	const char* pcFormat = "CCufft2D::Forward: %s\n\n";
 	cufftSetStream (m_aPlan, stream);
 	cufftResult res = cufftExecR2C(m_aPlan, 
@@ -108,6 +138,14 @@ cufftComplex* CCufft2D::ForwardH2G
 bool CCufft2D::Inverse(cufftComplex* gCmp, float* gfPadImg, 
 	cudaStream_t stream)
 {
+	if(m_pHostFFT != 0L)
+	{	size_t tBytes = sizeof(cufftComplex) * (m_iFFTx / 2 + 1)
+		   * m_iFFTy;
+		if((void*)gCmp != (void*)gfPadImg) memcpy(gfPadImg, gCmp, tBytes);
+		m_pHostFFT->Inverse((cufftComplex*)gfPadImg);
+		return true;
+	}
+	//-----------------
 	const char* pcFormat = "CCufft2D::Inverse: %s\n";
 	//-----------------------------------------------
         cufftSetStream (m_aPlan, stream);
@@ -138,7 +176,8 @@ float* CCufft2D::InverseG2H(cufftComplex* gCmp)
 
 void CCufft2D::SubtractMean(cufftComplex* gComplex)
 {
-	cudaMemset(gComplex, 0, sizeof(cufftComplex));
+	if(GetBackend() == hostBackend) memset(gComplex, 0, sizeof(cufftComplex));
+	else cudaMemset(gComplex, 0, sizeof(cufftComplex));
 }
 
 bool CCufft2D::mCheckError(cufftResult* pResult, const char* pcFormat)
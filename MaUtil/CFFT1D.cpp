@@ -0,0 +1,374 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::MaUtil;
+
+static const double s_dTwoPi = 6.283185307179586;
+
+static inline cufftComplex sMul(cufftComplex a, cufftComplex b)
+{
+	cufftComplex c;
+	c.x = a.x * b.x - a.y * b.y;
+	c.y = a.x * b.y + a.y * b.x;
+	return c;
+}
+
+static inline cufftComplex sConj(cufftComplex a)
+{
+	a.y = -a.y;
+	return a;
+}
+
+static inline cufftComplex sExpI(double dAngle)
+{
+	cufftComplex c;
+	c.x = (float)cos(dAngle);
+	c.y = (float)sin(dAngle);
+	return c;
+}
+
+CCmpFFT1D::CCmpFFT1D(void)
+{
+	m_iFFTSize = 0;
+	m_iNumRadices = 0;
+	m_pTwiddles = 0L;
+	m_pBuf = 0L;
+	m_pChirp = 0L;
+	m_pKernel = 0L;
+	m_pPow2FFT = 0L;
+}
+
+CCmpFFT1D::~CCmpFFT1D(void)
+{
+	this->DestroyPlan();
+}
+
+void CCmpFFT1D::DestroyPlan(void)
+{
+	if(m_pTwiddles != 0L) delete[] m_pTwiddles;
+	if(m_pBuf != 0L) delete[] m_pBuf;
+	if(m_pChirp != 0L) delete[] m_pChirp;
+	if(m_pKernel != 0L) delete[] m_pKernel;
+	if(m_pPow2FFT != 0L) delete m_pPow2FFT;
+	m_pTwiddles = 0L;
+	m_pBuf = 0L;
+	m_pChirp = 0L;
+	m_pKernel = 0L;
+	m_pPow2FFT = 0L;
+	m_iFFTSize = 0;
+	m_iNumRadices = 0;
+}
+
+//-------------------------------------------------------------------
+// 1. Radix 4 is taken first since its butterfly needs no
+//    multiplication.
+// 2. Stage s has a sub-transform size iNs, the product of the
+//    radices before it. Its twiddles exp(-2 pi i r k / (iNs p))
+//    are stored for k in [0, iNs) and r in [1, p).
+//-------------------------------------------------------------------
+void CCmpFFT1D::CreatePlan(int iFFTSize)
+{
+	if(iFFTSize == m_iFFTSize) return;
+	this->DestroyPlan();
+	if(iFFTSize <= 0) return;
+	m_iFFTSize = iFFTSize;
+	//-----------------
+	for(int p=2; p<=13; p++)
+	{	for(int m=0; m<p; m++)
+		{	m_aRoots[p][m] = sExpI(-s_dTwoPi * m / p);
+		}
+	}
+	//-----------------
+	int iLeft = m_iFFTSize;
+	const int aiRadices[] = {4, 2, 3, 5, 7, 11, 13};
+	for(int i=0; i<7; i++)
+	{	while(iLeft % aiRadices[i] == 0 && m_iNumRadices < 32)
+		{	m_aiRadices[m_iNumRadices] = aiRadices[i];
+			m_iNumRadices += 1;
+			iLeft /= aiRadices[i];
+		}
+	}
+	//-----------------
+	if(iLeft > 1)
+	{	m_iNumRadices = 0;
+		int iPow2 = 1;
+		while(iPow2 < 2 * m_iFFTSize - 1) iPow2 *= 2;
+		m_pPow2FFT = new CCmpFFT1D;
+		m_pPow2FFT->CreatePlan(iPow2);
+		//----------------
+		m_pChirp = new cufftComplex[m_iFFTSize];
+		long long llTwoN = 2LL * m_iFFTSize;
+		for(long long n=0; n<m_iFFTSize; n++)
+		{	long long llPhase = (n * n) % llTwoN;
+			m_pChirp[n] = sExpI(-s_dTwoPi * 0.5 * llPhase
+			   / m_iFFTSize);
+		}
+		//----------------
+		m_pKernel = new cufftComplex[iPow2];
+		memset(m_pKernel, 0, sizeof(cufftComplex) * iPow2);
+		m_pKernel[0] = sConj(m_pChirp[0]);
+		for(int n=1; n<m_iFFTSize; n++)
+		{	m_pKernel[n] = sConj(m_pChirp[n]);
+			m_pKernel[iPow2 - n] = m_pKernel[n];
+		}
+		m_pPow2FFT->DoIt(m_pKernel, true);
+		float fScale = 1.0f / iPow2;
+		for(int i=0; i<iPow2; i++)
+		{	m_pKernel[i].x *= fScale;
+			m_pKernel[i].y *= fScale;
+		}
+		m_pBuf = new cufftComplex[iPow2];
+		return;
+	}
+	//-----------------
+	int iNumTwiddles = 0, iNs = 1;
+	for(int s=0; s<m_iNumRadices; s++)
+	{	iNumTwiddles += iNs * (m_aiRadices[s] - 1);
+		iNs *= m_aiRadices[s];
+	}
+	m_pTwiddles = new cufftComplex[iNumTwiddles + 1];
+	m_pBuf = new cufftComplex[m_iFFTSize];
+	//-----------------
+	cufftComplex* pTwiddles = m_pTwiddles;
+	iNs = 1;
+	for(int s=0; s<m_iNumRadices; s++)
+	{	int p = m_aiRadices[s];
+		for(int k=0; k<iNs; k++)
+		{	for(int r=1; r<p; r++)
+			{	pTwiddles[r-1] = sExpI(-s_dTwoPi * r * k
+				   / (iNs * p));
+			}
+			pTwiddles += (p - 1);
+		}
+		iNs *= p;
+	}
+}
+
+void CCmpFFT1D::DoIt(cufftComplex* pCmpLine, bool bForward)
+{
+	if(m_iFFTSize <= 1) return;
+	if(m_pPow2FFT != 0L) mBluestein(pCmpLine, bForward);
+	else mStockham(pCmpLine, bForward);
+}
+
+//-------------------------------------------------------------------
+// 1. Each pass reads p strided inputs, twiddles and transforms
+//    them, and writes them to their sorted positions in the other
+//    buffer, so that no bit reversal is needed.
+//-------------------------------------------------------------------
+void CCmpFFT1D::mStockham(cufftComplex* pCmpLine, bool bForward)
+{
+	cufftComplex* pSrc = pCmpLine;
+	cufftComplex* pDst = m_pBuf;
+	cufftComplex* pTwiddles = m_pTwiddles;
+	cufftComplex aVals[13];
+	int iNs = 1;
+	//-----------------
+	for(int s=0; s<m_iNumRadices; s++)
+	{	int p = m_aiRadices[s];
+		int iStride = m_iFFTSize / p;
+		for(int j=0; j<iStride; j++)
+		{	int k = j % iNs;
+			cufftComplex* pW = pTwiddles + k * (p - 1);
+			aVals[0] = pSrc[j];
+			for(int r=1; r<p; r++)
+			{	cufftComplex aW = bForward ? pW[r-1] : sConj(pW[r-1]);
+				aVals[r] = sMul(pSrc[j + r * iStride], aW);
+			}
+			mButterfly(aVals, p, bForward);
+			//---------------
+			int iDst = (j / iNs) * iNs * p + k;
+			for(int r=0; r<p; r++)
+			{	pDst[iDst + r * iNs] = aVals[r];
+			}
+		}
+		pTwiddles += iNs * (p - 1);
+		iNs *= p;
+		cufftComplex* pTemp = pSrc;
+		pSrc = pDst;
+		pDst = pTemp;
+	}
+	if(pSrc != pCmpLine)
+	{	memcpy(pCmpLine, pSrc, sizeof(cufftComplex) * m_iFFTSize);
+	}
+}
+
+void CCmpFFT1D::mButterfly(cufftComplex* pVals, int iRadix, bool bForward)
+{
+	if(iRadix == 2)
+	{	cufftComplex a = pVals[0], b = pVals[1];
+		pVals[0].x = a.x + b.x; pVals[0].y = a.y + b.y;
+		pVals[1].x = a.x - b.x; pVals[1].y = a.y - b.y;
+		return;
+	}
+	//-----------------
+	if(iRadix == 4)
+	{	cufftComplex a0 = pVals[0], a1 = pVals[1];
+		cufftComplex a2 = pVals[2], a3 = pVals[3];
+		float t0x = a0.x + a2.x, t0y = a0.y + a2.y;
+		float t1x = a0.x - a2.x, t1y = a0.y - a2.y;
+		float t2x = a1.x + a3.x, t2y = a1.y + a3.y;
+		float t3x = a1.x - a3.x, t3y = a1.y - a3.y;
+		//----------------
+		// -i * t3 forward, +i * t3 inverse
+		//----------------
+		float fSign = bForward ? 1.0f : -1.0f;
+		pVals[0].x = t0x + t2x; pVals[0].y = t0y + t2y;
+		pVals[2].x = t0x - t2x; pVals[2].y = t0y - t2y;
+		pVals[1].x = t1x + fSign * t3y; pVals[1].y = t1y - fSign * t3x;
+		pVals[3].x = t1x - fSign * t3y; pVals[3].y = t1y + fSign * t3x;
+		return;
+	}
+	//-----------------
+	cufftComplex aIn[13];
+	memcpy(aIn, pVals, sizeof(cufftComplex) * iRadix);
+	for(int q=0; q<iRadix; q++)
+	{	cufftComplex aSum = aIn[0];
+		for(int r=1; r<iRadix; r++)
+		{	cufftComplex aW = m_aRoots[iRadix][(q * r) % iRadix];
+			if(!bForward) aW = sConj(aW);
+			cufftComplex aProd = sMul(aIn[r], aW);
+			aSum.x += aProd.x;
+			aSum.y += aProd.y;
+		}
+		pVals[q] = aSum;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. X[k] = w[k] * sum_n (x[n] w[n]) conj(w[k-n]), w[n] =
+//    exp(-pi i n^2 / N), a circular convolution done with power
+//    of 2 FFTs. m_pKernel holds the scaled FFT of conj(w).
+// 2. The inverse is conj(DFT(conj(x))).
+//-------------------------------------------------------------------
+void CCmpFFT1D::mBluestein(cufftComplex* pCmpLine, bool bForward)
+{
+	int iPow2 = m_pPow2FFT->m_iFFTSize;
+	memset(m_pBuf, 0, sizeof(cufftComplex) * iPow2);
+	for(int n=0; n<m_iFFTSize; n++)
+	{	cufftComplex aVal = bForward ? pCmpLine[n] : sConj(pCmpLine[n]);
+		m_pBuf[n] = sMul(aVal, m_pChirp[n]);
+	}
+	m_pPow2FFT->DoIt(m_pBuf, true);
+	for(int i=0; i<iPow2; i++)
+	{	m_pBuf[i] = sMul(m_pBuf[i], m_pKernel[i]);
+	}
+	m_pPow2FFT->DoIt(m_pBuf, false);
+	//-----------------
+	for(int k=0; k<m_iFFTSize; k++)
+	{	cufftComplex aVal = sMul(m_pBuf[k], m_pChirp[k]);
+		pCmpLine[k] = bForward ? aVal : sConj(aVal);
+	}
+}
+
+CFFT1D::CFFT1D(void)
+{
+	m_iFFTSize = 0;
+	m_pTwiddles = 0L;
+}
+
+CFFT1D::~CFFT1D(void)
+{
+	this->DestroyPlan();
+}
+
+void CFFT1D::DestroyPlan(void)
+{
+	m_aCmpFFT.DestroyPlan();
+	if(m_pTwiddles != 0L) delete[] m_pTwiddles;
+	m_pTwiddles = 0L;
+	m_iFFTSize = 0;
+}
+
+//-------------------------------------------------------------------
+// 1. iFFTSize must be even. m_pTwiddles[k] = exp(-2 pi i k / N)
+//    for k in [0, N/2].
+//-------------------------------------------------------------------
+void CFFT1D::CreatePlan(int iFFTSize)
+{
+	if(iFFTSize == m_iFFTSize) return;
+	this->DestroyPlan();
+	if(iFFTSize <= 0 || iFFTSize % 2 != 0) return;
+	m_iFFTSize = iFFTSize;
+	//-----------------
+	int iHalf = m_iFFTSize / 2;
+	m_aCmpFFT.CreatePlan(iHalf);
+	m_pTwiddles = new cufftComplex[iHalf + 1];
+	for(int k=0; k<=iHalf; k++)
+	{	m_pTwiddles[k] = sExpI(-s_dTwoPi * k / m_iFFTSize);
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Even and odd samples are the real and imaginary parts of a
+//    half size complex line Z. With E and O the transforms of the
+//    even and odd samples, X[k] = E[k] + W^k O[k] where
+//    E[k] = (Z[k] + conj(Z[M-k])) / 2 and
+//    O[k] = (Z[k] - conj(Z[M-k])) / 2i.
+//-------------------------------------------------------------------
+void CFFT1D::Forward(float* pfPadLine, bool bNorm)
+{
+	int iHalf = m_iFFTSize / 2;
+	cufftComplex* pCmp = (cufftComplex*)pfPadLine;
+	m_aCmpFFT.DoIt(pCmp, true);
+	//-----------------
+	pCmp[iHalf] = pCmp[0];
+	for(int k=0; k<=iHalf/2; k++)
+	{	int k2 = iHalf - k;
+		cufftComplex a = pCmp[k], b = pCmp[k2];
+		//----------------
+		cufftComplex aE, aO;
+		aE.x = 0.5f * (a.x + b.x); aE.y = 0.5f * (a.y - b.y);
+		aO.x = 0.5f * (a.y + b.y); aO.y = -0.5f * (a.x - b.x);
+		aO = sMul(aO, m_pTwiddles[k]);
+		pCmp[k].x = aE.x + aO.x;
+		pCmp[k].y = aE.y + aO.y;
+		//----------------
+		cufftComplex aE2, aO2;
+		aE2.x = 0.5f * (b.x + a.x); aE2.y = 0.5f * (b.y - a.y);
+		aO2.x = 0.5f * (b.y + a.y); aO2.y = -0.5f * (b.x - a.x);
+		aO2 = sMul(aO2, m_pTwiddles[k2]);
+		pCmp[k2].x = aE2.x + aO2.x;
+		pCmp[k2].y = aE2.y + aO2.y;
+	}
+	if(!bNorm) return;
+	//-----------------
+	float fFactor = 1.0f / m_iFFTSize;
+	for(int i=0; i<=iHalf; i++)
+	{	pCmp[i].x *= fFactor;
+		pCmp[i].y *= fFactor;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Unnormalized like cufftExecC2R. The imaginary parts of X[0]
+//    and X[N/2] are ignored.
+// 2. Z[k] = (X[k] + conj(X[M-k])) + i W^-k (X[k] - conj(X[M-k]))
+//    is inverse transformed at half size, giving the even and odd
+//    samples as its real and imaginary parts.
+//-------------------------------------------------------------------
+void CFFT1D::Inverse(cufftComplex* pCmpLine)
+{
+	int iHalf = m_iFFTSize / 2;
+	pCmpLine[0].y = 0.0f;
+	pCmpLine[iHalf].y = 0.0f;
+	for(int k=0; k<=iHalf/2; k++)
+	{	int k2 = iHalf - k;
+		cufftComplex a = pCmpLine[k], b = pCmpLine[k2];
+		//----------------
+		cufftComplex aD;
+		aD.x = a.x - b.x; aD.y = a.y + b.y;
+		aD = sMul(aD, sConj(m_pTwiddles[k]));
+		pCmpLine[k].x = (a.x + b.x) - aD.y;
+		pCmpLine[k].y = (a.y - b.y) + aD.x;
+		//----------------
+		cufftComplex aD2;
+		aD2.x = b.x - a.x; aD2.y = b.y + a.y;
+		aD2 = sMul(aD2, sConj(m_pTwiddles[k2]));
+		pCmpLine[k2].x = (b.x + a.x) - aD2.y;
+		pCmpLine[k2].y = (b.y - a.y) + aD2.x;
+	}
+	m_aCmpFFT.DoIt(pCmpLine, false);
+}
@@ -0,0 +1,187 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+static const int s_iColBlock = 8;
+
+CFFT2DThread::CFFT2DThread(void)
+{
+	m_pFFT2D = 0L;
+	m_iThread = 0;
+	m_iPass = 0;
+}
+
+CFFT2DThread::~CFFT2DThread(void)
+{
+}
+
+void CFFT2DThread::Run(CFFT2D* pFFT2D, int iThread, int iPass)
+{
+	m_pFFT2D = pFFT2D;
+	m_iThread = iThread;
+	m_iPass = iPass;
+	this->Start();
+}
+
+void CFFT2DThread::ThreadMain(void)
+{
+	m_pFFT2D->DoPass(m_iThread, m_iPass);
+}
+
+CFFT2D::CFFT2D(void)
+{
+	m_iFFTx = 0;
+	m_iFFTy = 0;
+	m_iNumThreads = 0;
+	m_pRowFFTs = 0L;
+	m_pColFFTs = 0L;
+	m_pColBufs = 0L;
+	m_pThreads = 0L;
+	m_pCmpImg = 0L;
+	m_fNorm = 1.0f;
+}
+
+CFFT2D::~CFFT2D(void)
+{
+	this->DestroyPlan();
+}
+
+void CFFT2D::DestroyPlan(void)
+{
+	if(m_pRowFFTs != 0L) delete[] m_pRowFFTs;
+	if(m_pColFFTs != 0L) delete[] m_pColFFTs;
+	if(m_pColBufs != 0L) delete[] m_pColBufs;
+	if(m_pThreads != 0L) delete[] m_pThreads;
+	m_pRowFFTs = 0L;
+	m_pColFFTs = 0L;
+	m_pColBufs = 0L;
+	m_pThreads = 0L;
+	m_iFFTx = 0;
+	m_iFFTy = 0;
+	m_iNumThreads = 0;
+}
+
+//-------------------------------------------------------------------
+// 1. No more threads than blocks of 8 rows, so that small images
+//    are not slowed down by thread starts.
+//-------------------------------------------------------------------
+void CFFT2D::CreatePlan(int iFFTx, int iFFTy, int iNumThreads)
+{
+	int iMaxThreads = iFFTy / s_iColBlock;
+	if(iNumThreads > iMaxThreads) iNumThreads = iMaxThreads;
+	if(iNumThreads < 1) iNumThreads = 1;
+	if(iFFTx == m_iFFTx && iFFTy == m_iFFTy &&
+	   iNumThreads == m_iNumThreads) return;
+	//-----------------
+	this->DestroyPlan();
+	m_iFFTx = iFFTx;
+	m_iFFTy = iFFTy;
+	m_iNumThreads = iNumThreads;
+	//-----------------
+	m_pRowFFTs = new CFFT1D[m_iNumThreads];
+	m_pColFFTs = new CCmpFFT1D[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	m_pRowFFTs[i].CreatePlan(m_iFFTx);
+		m_pColFFTs[i].CreatePlan(m_iFFTy);
+	}
+	size_t tBufSize = (size_t)m_iNumThreads * s_iColBlock * m_iFFTy;
+	m_pColBufs = new cufftComplex[tBufSize];
+	m_pThreads = new CFFT2DThread[m_iNumThreads];
+}
+
+void CFFT2D::Forward(float* pfPadImg, bool bNorm)
+{
+	m_pCmpImg = (cufftComplex*)pfPadImg;
+	m_fNorm = 1.0f;
+	if(bNorm) m_fNorm = (float)(1.0 / m_iFFTx / m_iFFTy);
+	mRunPass(0);
+	mRunPass(1);
+}
+
+void CFFT2D::Inverse(cufftComplex* pCmpImg)
+{
+	m_pCmpImg = pCmpImg;
+	m_fNorm = 1.0f;
+	mRunPass(2);
+	mRunPass(3);
+}
+
+//-------------------------------------------------------------------
+// 1. Pass 0 and 1 are the forward row and column passes, 2 and 3
+//    the inverse column and row passes.
+//-------------------------------------------------------------------
+void CFFT2D::DoPass(int iThread, int iPass)
+{
+	if(iPass == 0) mDoRows(iThread, true);
+	else if(iPass == 1) mDoCols(iThread, true);
+	else if(iPass == 2) mDoCols(iThread, false);
+	else mDoRows(iThread, false);
+}
+
+//-------------------------------------------------------------------
+// 1. The calling thread does the first part itself.
+//-------------------------------------------------------------------
+void CFFT2D::mRunPass(int iPass)
+{
+	for(int i=1; i<m_iNumThreads; i++)
+	{	m_pThreads[i].Run(this, i, iPass);
+	}
+	this->DoPass(0, iPass);
+	for(int i=1; i<m_iNumThreads; i++)
+	{	m_pThreads[i].WaitForExit(-1.0f);
+	}
+}
+
+void CFFT2D::mDoRows(int iThread, bool bForward)
+{
+	int iPadX = (m_iFFTx / 2 + 1) * 2;
+	int iStartY = iThread * m_iFFTy / m_iNumThreads;
+	int iEndY = (iThread + 1) * m_iFFTy / m_iNumThreads;
+	float* pfPadImg = (float*)m_pCmpImg;
+	CFFT1D* pRowFFT = &m_pRowFFTs[iThread];
+	//-----------------
+	for(int y=iStartY; y<iEndY; y++)
+	{	float* pfLine = pfPadImg + (size_t)y * iPadX;
+		if(bForward) pRowFFT->Forward(pfLine, false);
+		else pRowFFT->Inverse((cufftComplex*)pfLine);
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. 8 columns are gathered at a time so that each row access reads
+//    one 64-byte cache line. The forward scaling is applied when
+//    they are scattered back.
+//-------------------------------------------------------------------
+void CFFT2D::mDoCols(int iThread, bool bForward)
+{
+	int iCmpX = m_iFFTx / 2 + 1;
+	int iNumBlocks = (iCmpX + s_iColBlock - 1) / s_iColBlock;
+	int iStartBlock = iThread * iNumBlocks / m_iNumThreads;
+	int iEndBlock = (iThread + 1) * iNumBlocks / m_iNumThreads;
+	cufftComplex* pBuf = m_pColBufs + (size_t)iThread
+	   * s_iColBlock * m_iFFTy;
+	CCmpFFT1D* pColFFT = &m_pColFFTs[iThread];
+	//-----------------
+	for(int b=iStartBlock; b<iEndBlock; b++)
+	{	int iStartX = b * s_iColBlock;
+		int iCols = iCmpX - iStartX;
+		if(iCols > s_iColBlock) iCols = s_iColBlock;
+		//----------------
+		for(int y=0; y<m_iFFTy; y++)
+		{	cufftComplex* pRow = m_pCmpImg + (size_t)y * iCmpX + iStartX;
+			for(int c=0; c<iCols; c++) pBuf[c * m_iFFTy + y] = pRow[c];
+		}
+		for(int c=0; c<iCols; c++)
+		{	pColFFT->DoIt(pBuf + c * m_iFFTy, bForward);
+		}
+		for(int y=0; y<m_iFFTy; y++)
+		{	cufftComplex* pRow = m_pCmpImg + (size_t)y * iCmpX + iStartX;
+			for(int c=0; c<iCols; c++)
+			{	pRow[c].x = pBuf[c * m_iFFTy + y].x * m_fNorm;
+				pRow[c].y = pBuf[c * m_iFFTy + y].y * m_fNorm;
+			}
+		}
+	}
+}
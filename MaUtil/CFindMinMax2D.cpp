@@ -0,0 +1,38 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::MaUtil;
+
+CFindMinMax2D::CFindMinMax2D(void)
+{
+}
+
+CFindMinMax2D::~CFindMinMax2D(void)
+{
+}
+
+float CFindMinMax2D::DoMin(float* pfImg, int* piImgSize, bool bPadded)
+{
+	int iPadX = piImgSize[0];
+	int iSizeX = bPadded ? (iPadX / 2 - 1) * 2 : iPadX;
+	float fMin = (float)1e20;
+	for(int y=0; y<piImgSize[1]; y++)
+	{	float* pfRow = pfImg + (size_t)y * iPadX;
+		for(int x=0; x<iSizeX; x++) fMin = fminf(fMin, pfRow[x]);
+	}
+	return fMin;
+}
+
+float CFindMinMax2D::DoMax(float* pfImg, int* piImgSize, bool bPadded)
+{
+	int iPadX = piImgSize[0];
+	int iSizeX = bPadded ? (iPadX / 2 - 1) * 2 : iPadX;
+	float fMax = (float)-1e20;
+	for(int y=0; y<piImgSize[1]; y++)
+	{	float* pfRow = pfImg + (size_t)y * iPadX;
+		for(int x=0; x<iSizeX; x++) fMax = fmaxf(fMax, pfRow[x]);
+	}
+	return fMax;
+}
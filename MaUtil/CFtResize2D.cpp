@@ -0,0 +1,88 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+CFtResize2D::CFtResize2D(void)
+{
+}
+
+CFtResize2D::~CFtResize2D(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. Same as mGResize. Output pixels outside the input are left
+//    untouched.
+//-------------------------------------------------------------------
+void CFtResize2D::Resize
+(	cufftComplex* pCmpIn,
+	int* piSizeIn,
+	cufftComplex* pCmpOut,
+	int* piSizeOut,
+	bool bSum
+)
+{	int iSizeX = (piSizeIn[0] < piSizeOut[0]) ? piSizeIn[0] : piSizeOut[0];
+	for(int y=0; y<piSizeOut[1]; y++)
+	{	int iY = y;
+		if(iY > (piSizeOut[1] / 2))
+		{	iY -= piSizeOut[1];
+			if(iY <= (-piSizeIn[1] / 2)) continue;
+			iY += piSizeIn[1];
+		}
+		else if(iY > (piSizeIn[1] / 2)) continue;
+		//----------------
+		float* pfIn = (float*)(pCmpIn + (size_t)iY * piSizeIn[0]);
+		float* pfOut = (float*)(pCmpOut + (size_t)y * piSizeOut[0]);
+		if(!bSum)
+		{	memcpy(pfOut, pfIn, sizeof(cufftComplex) * iSizeX);
+			continue;
+		}
+		for(int x=0; x<iSizeX*2; x++) pfOut[x] += pfIn[x];
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same as mGTruncate.
+//-------------------------------------------------------------------
+void CFtResize2D::DownSample
+(	cufftComplex* pCmpIn,
+	int* piSizeIn,
+	cufftComplex* pCmpOut,
+	int* piSizeOut,
+	bool bSum
+)
+{	for(int y=0; y<piSizeOut[1]; y++)
+	{	int iY = y;
+		if(iY > (piSizeOut[1] / 2)) iY = iY - piSizeOut[1] + piSizeIn[1];
+		//----------------
+		float* pfIn = (float*)(pCmpIn + (size_t)iY * piSizeIn[0]);
+		float* pfOut = (float*)(pCmpOut + (size_t)y * piSizeOut[0]);
+		if(!bSum)
+		{	memcpy(pfOut, pfIn, sizeof(cufftComplex) * piSizeOut[0]);
+			continue;
+		}
+		for(int x=0; x<piSizeOut[0]*2; x++) pfOut[x] += pfIn[x];
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Same as mGExpand after zeroing the output.
+//-------------------------------------------------------------------
+void CFtResize2D::UpSample
+(	cufftComplex* pCmpIn,
+	int* piSizeIn,
+	cufftComplex* pCmpOut,
+	int* piSizeOut
+)
+{	size_t tBytes = sizeof(cufftComplex) * piSizeOut[0] * piSizeOut[1];
+	memset(pCmpOut, 0, tBytes);
+	for(int y=0; y<piSizeIn[1]; y++)
+	{	int iY = y;
+		if(iY > (piSizeIn[1] / 2)) iY = iY - piSizeIn[1] + piSizeOut[1];
+		memcpy(pCmpOut + (size_t)iY * piSizeOut[0],
+		   pCmpIn + (size_t)y * piSizeIn[0],
+		   sizeof(cufftComplex) * piSizeIn[0]);
+	}
+}
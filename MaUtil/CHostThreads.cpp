@@ -0,0 +1,79 @@
+#include "CMaUtilInc.h"
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+CHostThread::CHostThread(void)
+{
+	m_pHostThreads = 0L;
+	m_iThread = 0;
+}
+
+CHostThread::~CHostThread(void)
+{
+}
+
+void CHostThread::Run(CHostThreads* pHostThreads, int iThread)
+{
+	m_pHostThreads = pHostThreads;
+	m_iThread = iThread;
+	this->Start();
+}
+
+void CHostThread::ThreadMain(void)
+{
+	m_pHostThreads->DoPart(m_iThread);
+}
+
+CHostThreads::CHostThreads(void)
+{
+	m_pJob = 0L;
+	m_iNumItems = 0;
+	m_iBlockSize = 1;
+	m_iNumThreads = 1;
+}
+
+CHostThreads::~CHostThreads(void)
+{
+}
+
+void CHostThreads::DoIt
+(	CHostJob* pJob,
+	int iNumItems,
+	int iBlockSize,
+	int iNumThreads
+)
+{	if(iNumItems <= 0) return;
+	m_pJob = pJob;
+	m_iNumItems = iNumItems;
+	m_iBlockSize = (iBlockSize > 0) ? iBlockSize : 1;
+	//-----------------
+	int iNumBlocks = (m_iNumItems + m_iBlockSize - 1) / m_iBlockSize;
+	m_iNumThreads = iNumThreads;
+	if(m_iNumThreads > iNumBlocks) m_iNumThreads = iNumBlocks;
+	if(m_iNumThreads <= 1)
+	{	m_iNumThreads = 1;
+		this->DoPart(0);
+		return;
+	}
+	//-----------------
+	CHostThread* pThreads = new CHostThread[m_iNumThreads];
+	for(int i=1; i<m_iNumThreads; i++)
+	{	pThreads[i].Run(this, i);
+	}
+	this->DoPart(0);
+	for(int i=1; i<m_iNumThreads; i++)
+	{	pThreads[i].WaitForExit(-1.0f);
+	}
+	delete[] pThreads;
+}
+
+void CHostThreads::DoPart(int iThread)
+{
+	int iStride = m_iNumThreads * m_iBlockSize;
+	for(int i=iThread*m_iBlockSize; i<m_iNumItems; i+=iStride)
+	{	int iCount = m_iNumItems - i;
+		if(iCount > m_iBlockSize) iCount = m_iBlockSize;
+		m_pJob->DoBlock(i, iCount, iThread);
+	}
+}
@@ -14,6 +14,19 @@ namespace McAreTomo::MaUtil
 	class CCufft2D;
 	class CPad2D;
 	class CPeak2D;
+	class CCmpFFT1D;
+	class CFFT1D;
+	class CFFT2D;
+	class CFFT2DThread;
+	class CHostJob;
+	class CHostThreads;
+	class CHostThread;
+	class CCalcMoment2D;
+	class CNormalize2D;
+	class CFtResize2D;
+	class CFindMinMax2D;
+	class CPhaseShift2D;
+	class CCalcFRC;
 	class GAddFrames;
 	class GCalcMoment2D;
 	class GCorrLinearInterp;
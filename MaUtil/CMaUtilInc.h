@@ -1,8 +1,27 @@
 #pragma once
+#include <Util/Util_Thread.h>
 #include <cufft.h>
 
 namespace McAreTomo::MaUtil
 {
+//-------------------------------------------------------------------
+// 1. Compute backend of the calling thread. With hostBackend the
+//    primitives CCufft2D, GFFT1D, GPad2D, GFourierResize2D,
+//    GFtResize2D, GNormalize2D, GCalcMoment2D, GFindMinMax2D,
+//    GPhaseShift2D, and GCalcFRC take host buffers and run on the
+//    CPU. Their streams are ignored.
+// 2. With scoreBackend the primitives stay on the GPU and only the
+//    candidate scoring of CFindDefocus1D, CFindDefocus2D and
+//    GLineScore runs on host threads. -HostScore selects it for
+//    the processing threads.
+// 3. The default is gpuBackend. iHostThreads <= 0 uses all cores
+//    for the host FFTs and scoring.
+//-------------------------------------------------------------------
+enum EBackend {gpuBackend, hostBackend, scoreBackend};
+void SetBackend(EBackend eBackend, int iHostThreads = 0);
+EBackend GetBackend(void);
+int GetHostThreads(void);
+//------------------
 size_t GetGpuMemory(int iGpuId);
 void PrintGpuMemoryUsage(const char* pcInfo);
 float GetGpuMemoryUsage(void);
@@ -14,6 +33,11 @@ const char* GetHomeDir(void); // do not free
 bool GetCurrDir(char* pcRet, int iSize);
 void UseFullPath(char* pcPath);
 
+class CFFT1D;
+class CCmpFFT1D;
+class CFFT2D;
+class CFFT2DThread;
+class CHostThreads;
 
 class CParseArgs
 {
@@ -69,6 +93,7 @@ private:
 	cufftType m_aType;
 	int m_iFFTx;
 	int m_iFFTy;
+	CFFT2D* m_pHostFFT;  // when planned under hostBackend
 };
 
 class CFileName
@@ -87,6 +112,10 @@ public:
 	char m_acFileExt[32];
 };
 
+//-------------------------------------------------------------------
+// 1. Copies rows between host and GPU buffers. Under hostBackend
+//    both buffers are on the host and are copied without CUDA.
+//-------------------------------------------------------------------
 class CPad2D
 {
 public:
@@ -137,6 +166,39 @@ private:
         char m_acMrcFile[256];
 };	//CSaveTempMrc
 
+//-------------------------------------------------------------------
+// 1. Host counterpart of GAddFrames for integer frames. Each pixel
+//    wraps around on overflow like in the GPU kernels.
+// 2. Adds 8 bytes per step in 64-bit words. The top bit of each
+//    pixel is added separately so that no carry crosses pixels.
+//-------------------------------------------------------------------
+class CAddFrames
+{
+public:
+	CAddFrames(void);
+	~CAddFrames(void);
+	void DoIt
+	( unsigned char* pucFrm1,
+	  unsigned char* pucFrm2,
+	  unsigned char* pucSum,
+	  int* piFrmSize
+	);
+	void DoIt
+	( unsigned short* pusFrm1,
+	  unsigned short* pusFrm2,
+	  unsigned short* pusSum,
+	  int* piFrmSize
+	);
+private:
+	void mAddWords
+	( unsigned char* pucFrm1,
+	  unsigned char* pucFrm2,
+	  unsigned char* pucSum,
+	  size_t tBytes,
+	  unsigned long ulHigh
+	);
+};
+
 class GAddFrames
 {
 public:
@@ -183,6 +245,23 @@ private:
 	//-----------------
 	int m_aiImgSize[2];
 	int m_iPadX;
+	bool m_bHost;
+	float m_fHostRes;
+};
+
+//-------------------------------------------------------------------
+// 1. Host counterpart of GCalcMoment2D. Each row is summed in float
+//    in a loop that vectorizes, and the rows are summed in double.
+//-------------------------------------------------------------------
+class CCalcMoment2D
+{
+public:
+	CCalcMoment2D(void);
+	~CCalcMoment2D(void);
+	float DoIt
+	( float* pfImg, int* piImgSize, bool bPadded,
+	  int iExponent
+	);
 };
 
 class GCorrLinearInterp
@@ -219,6 +298,159 @@ private:
 	int m_iNumLines;
 	cufftType m_cufftType;
 	cufftHandle m_cufftPlan;
+	CFFT1D* m_pHostFFT;  // when planned under hostBackend
+};
+
+//-------------------------------------------------------------------
+// 1. CPU complex FFT of any size, unnormalized like cuFFT. Sizes
+//    made of 2, 3, 5, 7, 11, and 13 use mixed-radix Stockham
+//    passes. Other sizes use Bluestein's algorithm on a power of 2.
+// 2. One instance must not be used by two threads at once.
+//-------------------------------------------------------------------
+class CCmpFFT1D
+{
+public:
+	CCmpFFT1D(void);
+	~CCmpFFT1D(void);
+	void DestroyPlan(void);
+	void CreatePlan(int iFFTSize);
+	void DoIt(cufftComplex* pCmpLine, bool bForward);
+	int m_iFFTSize;
+private:
+	void mStockham(cufftComplex* pCmpLine, bool bForward);
+	void mButterfly(cufftComplex* pVals, int iRadix, bool bForward);
+	void mBluestein(cufftComplex* pCmpLine, bool bForward);
+	//-----------------
+	int m_aiRadices[32];
+	int m_iNumRadices;
+	cufftComplex m_aRoots[14][13];  // exp(-2 pi i m / radix)
+	cufftComplex* m_pTwiddles;
+	cufftComplex* m_pBuf;
+	//-----------------
+	cufftComplex* m_pChirp;
+	cufftComplex* m_pKernel;
+	CCmpFFT1D* m_pPow2FFT;
+};
+
+//-------------------------------------------------------------------
+// 1. CPU counterpart of GFFT1D for one line at a time. The real
+//    line of even size iFFTSize is padded to (iFFTSize/2+1)*2
+//    floats and transformed in place, the same layout as cuFFT.
+// 2. The real transform is done with a complex FFT of half size.
+//-------------------------------------------------------------------
+class CFFT1D
+{
+public:
+	CFFT1D(void);
+	~CFFT1D(void);
+	void DestroyPlan(void);
+	void CreatePlan(int iFFTSize);
+	void Forward(float* pfPadLine, bool bNorm);
+	void Inverse(cufftComplex* pCmpLine);
+private:
+	int m_iFFTSize;
+	CCmpFFT1D m_aCmpFFT;
+	cufftComplex* m_pTwiddles;
+};
+
+//-------------------------------------------------------------------
+// 1. Host counterpart of the 2D cuFFT plans of CCufft2D, with the
+//    same padded in-place layout and the same scaling. The x size
+//    must be even.
+// 2. The rows are transformed with CFFT1D and the columns, 8 at a
+//    time, with CCmpFFT1D. Both passes are split among the threads.
+//    Each thread keeps its 1D plans until the size changes.
+//-------------------------------------------------------------------
+class CFFT2D
+{
+public:
+	CFFT2D(void);
+	~CFFT2D(void);
+	void DestroyPlan(void);
+	void CreatePlan(int iFFTx, int iFFTy, int iNumThreads);
+	void Forward(float* pfPadImg, bool bNorm);
+	void Inverse(cufftComplex* pCmpImg);
+	void DoPass(int iThread, int iPass);
+	int m_iFFTx;
+	int m_iFFTy;
+	int m_iNumThreads;
+private:
+	void mRunPass(int iPass);
+	void mDoRows(int iThread, bool bForward);
+	void mDoCols(int iThread, bool bForward);
+	//-----------------
+	CFFT1D* m_pRowFFTs;
+	CCmpFFT1D* m_pColFFTs;
+	cufftComplex* m_pColBufs;
+	CFFT2DThread* m_pThreads;
+	cufftComplex* m_pCmpImg;
+	float m_fNorm;
+};
+
+//-------------------------------------------------------------------
+// 1. Runs one pass of CFFT2D on the part given by its index.
+//-------------------------------------------------------------------
+class CFFT2DThread : public Util_Thread
+{
+public:
+	CFFT2DThread(void);
+	~CFFT2DThread(void);
+	void Run(CFFT2D* pFFT2D, int iThread, int iPass);
+	void ThreadMain(void);
+private:
+	CFFT2D* m_pFFT2D;
+	int m_iThread;
+	int m_iPass;
+};
+
+//-------------------------------------------------------------------
+// 1. The work of one call split into items, e.g. the candidates to
+//    score. DoBlock does the items iFirst to iFirst + iCount - 1 on
+//    host thread iThread, which may index per-thread buffers.
+// 2. A job holds the arguments of its call, so that several calls
+//    can run on one engine at the same time.
+//-------------------------------------------------------------------
+class CHostJob
+{
+public:
+	virtual ~CHostJob(void) {}
+	virtual void DoBlock(int iFirst, int iCount, int iThread) = 0;
+};
+
+//-------------------------------------------------------------------
+// 1. Runs a CHostJob on up to iNumThreads host threads. The items
+//    are cut into blocks of iBlockSize and thread t does the blocks
+//    t, t + n, t + 2n, ... No more threads than blocks are used.
+// 2. The calling thread is thread 0. DoIt returns when all threads
+//    are done.
+//-------------------------------------------------------------------
+class CHostThreads
+{
+public:
+	CHostThreads(void);
+	~CHostThreads(void);
+	void DoIt
+	( CHostJob* pJob, int iNumItems,
+	  int iBlockSize, int iNumThreads
+	);
+	void DoPart(int iThread);
+private:
+	CHostJob* m_pJob;
+	int m_iNumItems;
+	int m_iBlockSize;
+	int m_iNumThreads;
+};
+
+class CHostThread : public Util_Thread
+{
+public:
+	CHostThread(void);
+	~CHostThread(void);
+	void Run(CHostThreads* pHostThreads, int iThread);
+	void ThreadMain(void);
+private:
+	CHostThreads* m_pHostThreads;
+	int m_iThread;
 };
 
 class GPad2D
@@ -274,6 +506,20 @@ public:
 	);
 };
 
+//-------------------------------------------------------------------
+// 1. Host counterpart of GNormalize2D.
+//-------------------------------------------------------------------
+class CNormalize2D
+{
+public:
+	CNormalize2D(void);
+	~CNormalize2D(void);
+	void DoIt
+	( float* pfImg, int* piSize, bool bPadded,
+	  float fMean, float fStd
+	);
+};
+
 class GThreshold2D
 {
 public:
@@ -370,6 +616,31 @@ public:
         );
 };
 
+//-------------------------------------------------------------------
+// 1. Host counterparts of GFourierResize2D::DoIt (Resize) and of
+//    GFtResize2D (DownSample, UpSample) on complex images.
+//-------------------------------------------------------------------
+class CFtResize2D
+{
+public:
+	CFtResize2D(void);
+	~CFtResize2D(void);
+	void Resize
+	( cufftComplex* pCmpIn, int* piSizeIn,
+	  cufftComplex* pCmpOut, int* piSizeOut,
+	  bool bSum
+	);
+	void DownSample
+	( cufftComplex* pCmpIn, int* piSizeIn,
+	  cufftComplex* pCmpOut, int* piSizeOut,
+	  bool bSum
+	);
+	void UpSample
+	( cufftComplex* pCmpIn, int* piSizeIn,
+	  cufftComplex* pCmpOut, int* piSizeOut
+	);
+};
+
 class GPositivity2D
 {
 public:
@@ -434,6 +705,20 @@ private:
 	dim3 m_aBlockDim;
 	dim3 m_aGridDim;
 	float* m_gfBuf;
+	bool m_bHost;
+	float m_fHostRes;
+};
+
+//-------------------------------------------------------------------
+// 1. Host counterpart of GFindMinMax2D.
+//-------------------------------------------------------------------
+class CFindMinMax2D
+{
+public:
+	CFindMinMax2D(void);
+	~CFindMinMax2D(void);
+	float DoMin(float* pfImg, int* piImgSize, bool bPadded);
+	float DoMax(float* pfImg, int* piImgSize, bool bPadded);
 };
 
 class GPartialCopy
@@ -478,6 +763,23 @@ public:
 	);
 };
 
+//-------------------------------------------------------------------
+// 1. Host counterpart of GPhaseShift2D::DoIt with bSum.
+//-------------------------------------------------------------------
+class CPhaseShift2D
+{
+public:
+	CPhaseShift2D(void);
+	~CPhaseShift2D(void);
+	void DoIt
+	( cufftComplex* pInCmp,
+	  int* piCmpSize,
+	  float* pfShift,
+	  bool bSum,
+	  cufftComplex* pOutCmp
+	);
+};
+
 class GGriddingCorrect
 {
 public:
@@ -513,6 +815,22 @@ private:
 	void mCalcFFT(float* gfPadImg1, float* gfPadImg2);
 	int m_aiCmpSize[2];
 };
+
+//-------------------------------------------------------------------
+// 1. Host counterpart of GCalcFRC::DoIt on complex images.
+//-------------------------------------------------------------------
+class CCalcFRC
+{
+public:
+	CCalcFRC(void);
+	~CCalcFRC(void);
+	void DoIt
+	( cufftComplex* pCmp1,
+	  cufftComplex* pCmp2,
+	  float* pfFRC, int iRingWidth,
+	  int* piCmpSize
+	);
+};
 }
 
 namespace MU = McAreTomo::MaUtil;
@@ -0,0 +1,37 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MaUtil;
+
+CNormalize2D::CNormalize2D(void)
+{
+}
+
+CNormalize2D::~CNormalize2D(void)
+{
+}
+
+//-------------------------------------------------------------------
+// 1. Pixels below -1e10 are flagged and kept as they are. The test
+//    is a select so that the loop vectorizes.
+//-------------------------------------------------------------------
+void CNormalize2D::DoIt
+(	float* pfImg,
+	int* piSize,
+	bool bPadded,
+	float fMean,
+	float fStd
+)
+{	int iSizeX = bPadded ? (piSize[0] / 2 - 1) * 2 : piSize[0];
+	if(fStd == 0) fStd = 1.0f;
+	//-----------------
+	for(int y=0; y<piSize[1]; y++)
+	{	float* pfRow = pfImg + (size_t)y * piSize[0];
+		for(int x=0; x<iSizeX; x++)
+		{	float fInt = pfRow[x];
+			float fNorm = (fInt - fMean) / fStd;
+			pfRow[x] = (fInt < (float)-1e10) ? fInt : fNorm;
+		}
+	}
+}
@@ -18,11 +18,13 @@ void CPad2D::Pad(float* pfImg, int* piImgSize, float* pfPad)
 {
 	int iBytes = piImgSize[0] * sizeof(float);
 	int iPadX = (piImgSize[0] / 2 + 1) * 2;
+	bool bHost = (GetBackend() == hostBackend);
 	//-------------------------------------
 	for(int y=0; y<piImgSize[1]; y++)
 	{	float* pfSrc = pfImg + y * piImgSize[0];
 		float* pfDst = pfPad + y * iPadX;
-		cudaMemcpy(pfDst, pfSrc, iBytes, cudaMemcpyDefault);
+		if(bHost) memcpy(pfDst, pfSrc, iBytes);
+		else cudaMemcpy(pfDst, pfSrc, iBytes, cudaMemcpyDefault);
 	}
 }
 
@@ -30,11 +32,13 @@ void CPad2D::Unpad(float* pfPad, int* piPadSize, float* pfImg)
 {
 	int iImageX = (piPadSize[0] / 2 - 1) * 2;
 	int iBytes = iImageX * sizeof(float);
+	bool bHost = (GetBackend() == hostBackend);
 	//-----------------------------------
 	for(int y=0; y<piPadSize[1]; y++)
 	{	float* pfSrc = pfPad + y * piPadSize[0];
 		float* pfDst = pfImg + y * iImageX;
-		cudaMemcpy(pfDst, pfSrc, iBytes, cudaMemcpyDefault);
+		if(bHost) memcpy(pfDst, pfSrc, iBytes);
+		else cudaMemcpy(pfDst, pfSrc, iBytes, cudaMemcpyDefault);
 	}
 }
 
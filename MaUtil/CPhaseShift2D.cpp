@@ -0,0 +1,46 @@
+#include "CMaUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace McAreTomo::MaUtil;
+
+CPhaseShift2D::CPhaseShift2D(void)
+{
+}
+
+CPhaseShift2D::~CPhaseShift2D(void)
+{
+}
+
+void CPhaseShift2D::DoIt
+(	cufftComplex* pInCmp,
+	int* piCmpSize,
+	float* pfShift,
+	bool bSum,
+	cufftComplex* pOutCmp
+)
+{	float f2PI = (float)(8 * atan(1.0));
+	int iNx = (piCmpSize[0] - 1) * 2;
+	float fShiftX = pfShift[0] * (f2PI / iNx);
+	float fShiftY = pfShift[1] * (f2PI / piCmpSize[1]);
+	//-----------------
+	for(int y=0; y<piCmpSize[1]; y++)
+	{	int iY = (y > piCmpSize[1] / 2) ? y - piCmpSize[1] : y;
+		int i = y * piCmpSize[0];
+		for(int x=0; x<piCmpSize[0]; x++)
+		{	float fPhaseShift = x * fShiftX + iY * fShiftY;
+			float fCos = cosf(fPhaseShift);
+			float fSin = sinf(fPhaseShift);
+			cufftComplex aIn = pInCmp[i + x];
+			cufftComplex aRes;
+			aRes.x = fCos * aIn.x - fSin * aIn.y;
+			aRes.y = fCos * aIn.y + fSin * aIn.x;
+			if(bSum)
+			{	pOutCmp[i + x].x += aRes.x;
+				pOutCmp[i + x].y += aRes.y;
+			}
+			else pOutCmp[i + x] = aRes;
+		}
+	}
+}
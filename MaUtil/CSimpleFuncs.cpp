@@ -9,6 +9,7 @@
 #include <pwd.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/sysinfo.h>
 #include <sys/types.h>
 
 
@@ -69,6 +70,26 @@ void* MU::GetGpuBuf(size_t tBytes, bool bZero)
 	return gvBuf;
 }
 
+static thread_local MU::EBackend s_eBackend = MU::gpuBackend;
+static thread_local int s_iHostThreads = 0;
+
+void MU::SetBackend(MU::EBackend eBackend, int iHostThreads)
+{
+	s_eBackend = eBackend;
+	s_iHostThreads = iHostThreads;
+}
+
+MU::EBackend MU::GetBackend(void)
+{
+	return s_eBackend;
+}
+
+int MU::GetHostThreads(void)
+{
+	if(s_iHostThreads > 0) return s_iHostThreads;
+	return get_nprocs();
+}
+
 const char* MU::GetHomeDir(void)
 {
 	const char* pcHomeDir = getenv("HOME");
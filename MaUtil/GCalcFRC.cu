@@ -120,7 +120,13 @@ void GCalcFRC::DoIt
 	int* piCmpSize,
         cudaStream_t stream
 )
-{	dim3 aBlockDim(1, 512);
+{	if(GetBackend() == hostBackend)
+	{	CCalcFRC aCalcFRC;
+		aCalcFRC.DoIt(gCmp1, gCmp2, gfFRC, iRingWidth, piCmpSize);
+		return;
+	}
+	//-----------------
+	dim3 aBlockDim(1, 512);
 	dim3 aGridDim(piCmpSize[0], 1);
 	aGridDim.y = (piCmpSize[1] + aBlockDim.y - 1) / aBlockDim.y;
 	//-----------------
@@ -66,6 +66,8 @@ GCalcMoment2D::GCalcMoment2D(void)
 	m_aGridDim.x = 512;
 	m_aGridDim.y = 1;
 	m_gfBuf = 0L;
+	m_bHost = false;
+	m_fHostRes = 0.0f;
 }
 
 GCalcMoment2D::~GCalcMoment2D(void)
@@ -86,6 +88,8 @@ void GCalcMoment2D::SetSize(int* piImgSize, bool bPadded)
 	m_iPadX = piImgSize[0];
 	m_aiImgSize[1] = piImgSize[1];
 	m_aiImgSize[0] = bPadded ? (m_iPadX/2 - 1) * 2 : m_iPadX;
+	m_bHost = (GetBackend() == hostBackend);
+	if(m_bHost) return;
 	//-------------------------------------------------------
 	int iPixels = m_aiImgSize[0] * m_aiImgSize[1];
 	int iNumBlocks = (iPixels + m_aBlockDim.x - 1) / m_aBlockDim.x;
@@ -103,7 +107,16 @@ float GCalcMoment2D::DoIt
 	bool bSync,
 	cudaStream_t stream
 )
-{	int iShmBytes = sizeof(float) * m_aBlockDim.x;
+{	if(m_bHost)
+	{	CCalcMoment2D aCalcMoment2D;
+		int aiSize[] = {m_iPadX, m_aiImgSize[1]};
+		bool bPadded = (m_aiImgSize[0] != m_iPadX);
+		m_fHostRes = aCalcMoment2D.DoIt(gfImg, aiSize,
+		   bPadded, iExponent);
+		return m_fHostRes;
+	}
+	//-----------------
+	int iShmBytes = sizeof(float) * m_aBlockDim.x;
 	mGSum2D<<<m_aGridDim, m_aBlockDim, iShmBytes, stream>>>(gfImg, 
 	   m_aiImgSize[0], m_aiImgSize[1], m_iPadX, iExponent, m_gfBuf);
         mGSum1D<<<1, m_aGridDim, iShmBytes, stream>>>(m_gfBuf);
@@ -117,6 +130,7 @@ float GCalcMoment2D::DoIt
 
 float GCalcMoment2D::GetResult(void)
 {
+	if(m_bHost) return m_fHostRes;
 	float fRes = 0.0f;
 	cudaMemcpy(&fRes, m_gfBuf, sizeof(float), cudaMemcpyDefault);
 	return fRes;
@@ -26,6 +26,7 @@ GFFT1D::GFFT1D(void)
 	m_iFFTSize = 0;
 	m_iNumLines = 0;
 	m_cufftType = CUFFT_R2C;
+	m_pHostFFT = 0L;
 }
 
 GFFT1D::~GFFT1D(void)
@@ -35,6 +36,12 @@ GFFT1D::~GFFT1D(void)
 
 void GFFT1D::DestroyPlan(void)
 {
+	if(m_pHostFFT != 0L)
+	{	delete m_pHostFFT;
+		m_pHostFFT = 0L;
+		m_iFFTSize = 0;
+		m_iNumLines = 0;
+	}
 	if(m_cufftPlan == 0) return;
 	cufftDestroy(m_cufftPlan);
 	m_cufftPlan = 0;
@@ -45,14 +52,21 @@ void GFFT1D::DestroyPlan(void)
 void GFFT1D::CreatePlan(int iFFTSize, int iNumLines, bool bForward)
 {
 	cufftType fftType = bForward ? CUFFT_R2C : CUFFT_C2R;
+	bool bHost = (GetBackend() == hostBackend);
 	if(fftType != m_cufftType) this->DestroyPlan();
 	else if(m_iFFTSize != iFFTSize) this->DestroyPlan();
 	else if(m_iNumLines != iNumLines) this->DestroyPlan();
-	if(m_cufftPlan != 0) return;
+	else if(bHost != (m_pHostFFT != 0L)) this->DestroyPlan();
+	if(m_cufftPlan != 0 || m_pHostFFT != 0L) return;
 	//--------------------------
 	m_cufftType = fftType;
 	m_iFFTSize = iFFTSize;
 	m_iNumLines = iNumLines;
+	if(bHost)
+	{	m_pHostFFT = new CFFT1D;
+		m_pHostFFT->CreatePlan(m_iFFTSize);
+		return;
+	}
 	//----------------------
 	cufftResult res = cufftPlan1d
 	( &m_cufftPlan, m_iFFTSize, m_cufftType, m_iNumLines
@@ -63,7 +77,15 @@ void GFFT1D::Forward
 (	float* gfPadLines,
 	bool bNorm
 )
-{	cufftResult res = cufftExecR2C
+{	if(m_pHostFFT != 0L)
+	{	int iPadSize = (m_iFFTSize / 2 + 1) * 2;
+		for(int i=0; i<m_iNumLines; i++)
+		{	m_pHostFFT->Forward(gfPadLines + i * iPadSize, bNorm);
+		}
+		return;
+	}
+	//-----------------
+	cufftResult res = cufftExecR2C
 	( m_cufftPlan, (cufftReal*)gfPadLines,
 	  (cufftComplex*)gfPadLines
 	);
@@ -82,6 +104,13 @@ void GFFT1D::Forward
 
 void GFFT1D::Inverse(cufftComplex* gCmpLines)
 {	
+	if(m_pHostFFT != 0L)
+	{	int iCmpSize = m_iFFTSize / 2 + 1;
+		for(int i=0; i<m_iNumLines; i++)
+		{	m_pHostFFT->Inverse(gCmpLines + i * iCmpSize);
+		}
+		return;
+	}
 	cufftResult res = cufftExecC2R
 	( m_cufftPlan, gCmpLines, (cufftReal*)gCmpLines
 	);
@@ -104,6 +104,8 @@ GFindMinMax2D::GFindMinMax2D(void)
 	m_aGridDim.x = 512;
 	m_aGridDim.y = 1;
 	m_gfBuf = 0L;
+	m_bHost = false;
+	m_fHostRes = 0.0f;
 }
 
 GFindMinMax2D::~GFindMinMax2D(void)
@@ -125,6 +127,8 @@ void GFindMinMax2D::SetSize(int* piImgSize, bool bPadded)
 	m_iPadX = piImgSize[0];
 	m_aiImgSize[1] = piImgSize[1];
 	m_aiImgSize[0] = bPadded ? (m_iPadX/2 - 1) * 2 : m_iPadX;
+	m_bHost = (GetBackend() == hostBackend);
+	if(m_bHost) return;
 	//-------------------------------------------------------
 	int iPixels = m_aiImgSize[0] * m_aiImgSize[1];
 	int iNumBlocks = (iPixels + m_aBlockDim.x - 1) / m_aBlockDim.x;
@@ -141,7 +145,15 @@ float GFindMinMax2D::DoMin
 	bool bSync, 
 	cudaStream_t stream
 )
-{	int iShmBytes = sizeof(float) * m_aBlockDim.x;
+{	if(m_bHost)
+	{	CFindMinMax2D aFindMinMax2D;
+		int aiSize[] = {m_iPadX, m_aiImgSize[1]};
+		bool bPadded = (m_aiImgSize[0] != m_iPadX);
+		m_fHostRes = aFindMinMax2D.DoMin(gfImg, aiSize, bPadded);
+		return m_fHostRes;
+	}
+	//-----------------
+	int iShmBytes = sizeof(float) * m_aBlockDim.x;
 	mGFindMin2D<<<m_aGridDim, m_aBlockDim, iShmBytes, stream>>>(gfImg,
 	   m_aiImgSize[0], m_aiImgSize[1], m_iPadX, m_gfBuf);
         mGFindMin1D<<<1, m_aGridDim, iShmBytes, stream>>>(m_gfBuf);
@@ -158,7 +170,15 @@ float GFindMinMax2D::DoMax
         bool bSync,
         cudaStream_t stream
 )
-{       int iShmBytes = sizeof(float) * m_aBlockDim.x;
+{	if(m_bHost)
+	{	CFindMinMax2D aFindMinMax2D;
+		int aiSize[] = {m_iPadX, m_aiImgSize[1]};
+		bool bPadded = (m_aiImgSize[0] != m_iPadX);
+		m_fHostRes = aFindMinMax2D.DoMax(gfImg, aiSize, bPadded);
+		return m_fHostRes;
+	}
+	//-----------------
+	int iShmBytes = sizeof(float) * m_aBlockDim.x;
         mGFindMax2D<<<m_aGridDim, m_aBlockDim, iShmBytes, stream>>>(gfImg,
            m_aiImgSize[0], m_aiImgSize[1], m_iPadX, m_gfBuf);
         mGFindMax1D<<<1, m_aGridDim, iShmBytes, stream>>>(m_gfBuf);
@@ -172,6 +192,7 @@ float GFindMinMax2D::DoMax
 
 float GFindMinMax2D::GetResult(void)
 {
+	if(m_bHost) return m_fHostRes;
 	float fRes = 0.0f;
 	cudaMemcpy(&fRes, m_gfBuf, sizeof(float), cudaMemcpyDefault);
 	return fRes;
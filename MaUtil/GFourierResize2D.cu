@@ -122,7 +122,13 @@ void GFourierResize2D::DoIt
 	bool bSum,
 	cudaStream_t stream
 )
-{	dim3 aBlockDim(1, 64);
+{	if(GetBackend() == hostBackend)
+	{	CFtResize2D aFtResize2D;
+		aFtResize2D.Resize(gCmpIn, piSizeIn, gCmpOut, piSizeOut, bSum);
+		return;
+	}
+	//-----------------
+	dim3 aBlockDim(1, 64);
 	dim3 aGridDim(piSizeOut[0], 1);
 	aGridDim.y = (piSizeOut[1] + aBlockDim.y - 1) / aBlockDim.y;
 	//-----------------
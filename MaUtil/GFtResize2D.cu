@@ -128,7 +128,14 @@ void GFtResize2D::DownSample
 	bool bSum,
 	cudaStream_t stream
 )
-{	int iNumBlocks = piSizeOut[1] / 32;
+{	if(GetBackend() == hostBackend)
+	{	CFtResize2D aFtResize2D;
+		aFtResize2D.DownSample(gCmpIn, piSizeIn, gCmpOut,
+		   piSizeOut, bSum);
+		return;
+	}
+	//-----------------
+	int iNumBlocks = piSizeOut[1] / 32;
 	if(iNumBlocks < 1) iNumBlocks = 1;
 	else if(iNumBlocks > 16) iNumBlocks = 16;
 	int iBlockSizeY = iNumBlocks * 32;
@@ -148,7 +155,13 @@ void GFtResize2D::UpSample
 	int* piSizeOut,
 	cudaStream_t stream
 )
-{	size_t tBytes = piSizeOut[0] * piSizeOut[1];
+{	if(GetBackend() == hostBackend)
+	{	CFtResize2D aFtResize2D;
+		aFtResize2D.UpSample(gCmpIn, piSizeIn, gCmpOut, piSizeOut);
+		return;
+	}
+	//-----------------
+	size_t tBytes = piSizeOut[0] * piSizeOut[1];
 	tBytes *= sizeof(cufftComplex);
 	cudaMemsetAsync(gCmpOut, 0, tBytes, stream);
 	//---------------------------
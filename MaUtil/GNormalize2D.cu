@@ -38,7 +38,13 @@ void GNormalize2D::DoIt
 	float fStd,
 	cudaStream_t stream
 )
-{	int iSizeX = bPadded ? (piSize[0] / 2 - 1) * 2 : piSize[0];
+{	if(GetBackend() == hostBackend)
+	{	CNormalize2D aNormalize2D;
+		aNormalize2D.DoIt(gfImg, piSize, bPadded, fMean, fStd);
+		return;
+	}
+	//-----------------
+	int iSizeX = bPadded ? (piSize[0] / 2 - 1) * 2 : piSize[0];
 	int iSizeY = piSize[1];
 	dim3 aBlockDim(1, 512);
 	dim3 aGridDim(iSizeX, 1);
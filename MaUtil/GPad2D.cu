@@ -32,7 +32,13 @@ void GPad2D::Pad
 	float* gfPadImg,
 	cudaStream_t stream
 )
-{	dim3 aBlockDim (64, 1, 1);
+{	if(GetBackend() == hostBackend)
+	{	CPad2D aPad2D;
+		aPad2D.Pad(gfImg, piImgSize, gfPadImg);
+		return;
+	}
+	//-----------------
+	dim3 aBlockDim (64, 1, 1);
         dim3 aGridDim (piImgSize[0] / aBlockDim.x + 1, piImgSize[1]);
         mGPad<<<aGridDim,aBlockDim, 0, stream>>>(gfImg, 
 		piImgSize[0], gfPadImg);
@@ -44,7 +50,13 @@ void GPad2D::Unpad
 	float* gfImg,
 	cudaStream_t stream
 )
-{	int iImgSizeX = (piPadSize[0] / 2 - 1) * 2;
+{	if(GetBackend() == hostBackend)
+	{	CPad2D aPad2D;
+		aPad2D.Unpad(gfPadImg, piPadSize, gfImg);
+		return;
+	}
+	//-----------------
+	int iImgSizeX = (piPadSize[0] / 2 - 1) * 2;
 	dim3 aBlockDim(64, 1, 1);
 	dim3 aGridDim(iImgSizeX / aBlockDim.x + 1, piPadSize[1]);
 	mGUnpad<<<aGridDim, aBlockDim, 0, stream>>>(gfPadImg, 
@@ -52,7 +52,13 @@ void GPhaseShift2D::DoIt
 	cufftComplex* gOutCmp,
         cudaStream_t stream
 )
-{	float f2PI = (float)(8 * atan(1.0));
+{	if(GetBackend() == hostBackend)
+	{	CPhaseShift2D aPhaseShift2D;
+		aPhaseShift2D.DoIt(gInCmp, piCmpSize, pfShift, bSum, gOutCmp);
+		return;
+	}
+	//-----------------
+	float f2PI = (float)(8 * atan(1.0));
 	int iNx = (piCmpSize[0] - 1) * 2;
 	float fShiftX = pfShift[0] * (f2PI / iNx);
 	float fShiftY = pfShift[1] * (f2PI / piCmpSize[1]);
@@ -127,7 +127,9 @@ void CLoadRefs::mLoadGainMrc(char* pcMrcFile)
 	//-----------------
 	int iPixels = iSizeX * iSizeY;
 	cudaMallocHost(&m_pfGain, sizeof(float) * iPixels);
-	aLoadMrc.m_pLoadImg->DoIt(0, m_pfGain);
+	if(!mMapRef(pcMrcFile, m_pfGain))
+	{	aLoadMrc.m_pLoadImg->DoIt(0, m_pfGain);
+	}
 	m_aiRefSize[0] = iSizeX;
 	m_aiRefSize[1] = iSizeY;
 	//----------------------
@@ -181,15 +183,18 @@ bool CLoadRefs::LoadDark(char* pcMrcFile)
 	m_aiDarkSize[1] = aLoadMrc.m_pLoadMain->GetSizeY();
 	int iMode = aLoadMrc.m_pLoadMain->GetMode();
 	//------------------------------------------
-	if(iMode == Mrc::eMrcFloat)
-	{	int iPixels = m_aiDarkSize[0] * m_aiDarkSize[1];
-		int iBytes = sizeof(float) * iPixels;
-		cudaMallocHost(&m_pfDark, iBytes);
-		memset(m_pfDark, 0, iBytes);
+	int iPixels = m_aiDarkSize[0] * m_aiDarkSize[1];
+	int iBytes = sizeof(float) * iPixels;
+	cudaMallocHost(&m_pfDark, iBytes);
+	bool bMapped = mMapRef(pcMrcFile, m_pfDark);
+	if(bMapped) {}
+	else if(iMode == Mrc::eMrcFloat)
+	{	memset(m_pfDark, 0, iBytes);
 		aLoadMrc.m_pLoadImg->DoIt(0, m_pfDark);
 	} 
 	else
-	{	void* pvDark = aLoadMrc.m_pLoadImg->DoIt(0);
+	{	mClearDark();
+		void* pvDark = aLoadMrc.m_pLoadImg->DoIt(0);
 		if(pvDark == 0L) return false;
 		m_pfDark = mToFloat(pvDark, iMode, m_aiDarkSize);
 		delete[] (char*)pvDark;
@@ -355,6 +360,22 @@ float* CLoadRefs::mToFloat(void* pvRef, int iMode, int* piSize)
 	return 0L;
 }
 
+//-------------------------------------------------------------------
+// 1. Loads the first section through MD::CMapMrc, converted to
+//    float, when -MmapLoad is not 0. Returns false when the file
+//    cannot be mapped or its mode is not supported, in which case
+//    Mrc::CLoadMrc is used instead.
+//-------------------------------------------------------------------
+bool CLoadRefs::mMapRef(char* pcMrcFile, float* pfRef)
+{
+	CInput* pInput = CInput::GetInstance();
+	if(pInput->m_iMmapLoad == 0) return false;
+	//-----------------
+	MD::CMapMrc aMapMrc;
+	if(!aMapMrc.OpenFile(pcMrcFile)) return false;
+	return aMapMrc.ReadFloat(0, pfRef);
+}
+
 void CLoadRefs::mCheckDarkRef(void)
 {
 	if(m_pfDark == 0L) return;
@@ -32,6 +32,7 @@ private:
 	void mFlip(float* gfRef, int* piRefSize, int iFlip);
 	void mInverse(float* gfRef, int* piRefSize, int iInverse);
 	float* mToFloat(void* pvRef, int iMode, int* piSize);
+	bool mMapRef(char* pcMrcFile, float* pfRef);
 	void mCheckDarkRef(void);
 	float* mAugmentRef(float* pfRef, int iFact);
 	CLoadRefs(void);
@@ -98,6 +99,8 @@ public:
 	CMotionCorMain(void);
 	~CMotionCorMain(void);
 	bool DoIt(int iNthGpu);
+	bool LoadStack(int iNthGpu);
+	bool Correct(int iNthGpu);
 	//-----------------
 private:
 	bool mLoadStack(void);
@@ -111,4 +114,26 @@ private:
 	int m_iNthGpu;
 };
 
+//-------------------------------------------------------------------
+// 1. Loads the next movie of a tilt series into the prefetch slot
+//    of MD::CMcPackage, CFmIntParam, and CFmGroupParam while the
+//    current movie is being motion corrected.
+// 2. Wait swaps the prefetched movie into the slot of iNthGpu.
+//-------------------------------------------------------------------
+class CPrefetchMovie : public Util_Thread
+{
+public:
+	static int GetSlot(int iNthGpu);
+	CPrefetchMovie(void);
+	~CPrefetchMovie(void);
+	void Run(int iTilt, int iNthGpu);
+	bool bPrefetched(int iTilt);
+	bool Wait(void);
+	void ThreadMain(void);
+private:
+	int m_iTilt;
+	int m_iNthGpu;
+	bool m_bLoaded;
+};
+
 }
@@ -38,9 +38,31 @@ void CMotionCorMain::LoadRefs(void)
 }
 
 bool CMotionCorMain::DoIt(int iNthGpu)
+{
+	if(!this->LoadStack(iNthGpu)) return false;
+	return this->Correct(iNthGpu);
+}
+
+//-------------------------------------------------------------------
+// 1. iNthGpu can also be a prefetch slot (CPrefetchMovie::GetSlot).
+//-------------------------------------------------------------------
+bool CMotionCorMain::LoadStack(int iNthGpu)
+{
+	m_iNthGpu = iNthGpu;
+	MD::CTraceSpan aSpan("CMotionCorMain::LoadStack", m_iNthGpu);
+	bool bLoaded = mLoadStack();
+	//-----------------
+	MD::CMrcStack* pRawStack = 
+	   MD::CMcPackage::GetInstance(m_iNthGpu)->m_pRawStack;
+	aSpan.AddBytes(pRawStack->m_tFmBytes * pRawStack->m_aiStkSize[2]);
+	aSpan.AddItems(pRawStack->m_aiStkSize[2]);
+	return bLoaded;
+}
+
+bool CMotionCorMain::Correct(int iNthGpu)
 {
 	m_iNthGpu = iNthGpu;
-	if(!mLoadStack()) return false;
+	MD::CTraceSpan aSpan("CMotionCorMain::Correct", m_iNthGpu);
 	if(!mCheckGain()) return false;
 	mCreateBuffer();
 	//-----------------
@@ -0,0 +1,77 @@
+#include "CMotionCorInc.h"
+#include "DataUtil/CDataUtilInc.h"
+#include <stdio.h>
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+using namespace McAreTomo;
+using namespace McAreTomo::MotionCor;
+
+int CPrefetchMovie::GetSlot(int iNthGpu)
+{
+	CInput* pInput = CInput::GetInstance();
+	return iNthGpu + pInput->m_iNumGpus;
+}
+
+CPrefetchMovie::CPrefetchMovie(void)
+{
+	m_iTilt = -1;
+	m_iNthGpu = 0;
+	m_bLoaded = false;
+}
+
+CPrefetchMovie::~CPrefetchMovie(void)
+{
+	if(this->IsCreated()) this->WaitForExit(-1.0f);
+}
+
+//-------------------------------------------------------------------
+// 1. The caller must have set up the movie name and its mdoc
+//    entries in MD::CMcPackage::GetInstance(GetSlot(iNthGpu)).
+//-------------------------------------------------------------------
+void CPrefetchMovie::Run(int iTilt, int iNthGpu)
+{
+	m_iTilt = iTilt;
+	m_iNthGpu = iNthGpu;
+	m_bLoaded = false;
+	this->Start();
+}
+
+bool CPrefetchMovie::bPrefetched(int iTilt)
+{
+	if(m_iTilt < 0) return false;
+	return (m_iTilt == iTilt);
+}
+
+bool CPrefetchMovie::Wait(void)
+{
+	if(m_iTilt < 0) return false;
+	this->WaitForExit(-1.0f);
+	m_iTilt = -1;
+	//-----------------
+	int iSlot = CPrefetchMovie::GetSlot(m_iNthGpu);
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	pPackage->Swap(MD::CMcPackage::GetInstance(iSlot));
+	//-----------------
+	MMD::CFmIntParam* pFmIntParam =
+	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
+	pFmIntParam->Swap(MMD::CFmIntParam::GetInstance(iSlot));
+	//-----------------
+	for(int i=0; i<2; i++)
+	{	bool bLocal = (i == 1);
+		MMD::CFmGroupParam* pFmGroupParam =
+		   MMD::CFmGroupParam::GetInstance(m_iNthGpu, bLocal);
+		pFmGroupParam->Swap(
+		   MMD::CFmGroupParam::GetInstance(iSlot, bLocal));
+	}
+	return m_bLoaded;
+}
+
+void CPrefetchMovie::ThreadMain(void)
+{
+	CInput* pInput = CInput::GetInstance();
+	cudaSetDevice(pInput->m_piGpuIDs[m_iNthGpu]);
+	//-----------------
+	CMotionCorMain aMcMain;
+	m_bLoaded = aMcMain.LoadStack(CPrefetchMovie::GetSlot(m_iNthGpu));
+}
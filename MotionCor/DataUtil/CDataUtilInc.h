@@ -22,6 +22,7 @@ public:
 	~CFmIntParam(void);
 	bool bIntegrate(void);
 	bool bHasDose(void);
+	void Swap(CFmIntParam* pFmIntParam);
         //-----------------
 	void Setup
 	( int iNumRawFms,   // frames of raw movie
@@ -66,6 +67,7 @@ public:
         //-----------------
         ~CFmGroupParam(void);
         void Setup(int iGroupSize);
+        void Swap(CFmGroupParam* pFmGroupParam);
         int* GetGroupIdxs(int iGroup); // do not free
         //-----------------
         int m_iNumGroups;
@@ -3,20 +3,25 @@
 #include <string.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <utility>
 
 using namespace McAreTomo::MotionCor::DataUtil;
 
 CFmGroupParam* CFmGroupParam::m_pInstances = 0L;
 int CFmGroupParam::m_iNumGpus = 0;
 
+//-------------------------------------------------------------------
+// 1. Each GPU has a global and a local instance. The second half
+//    are the prefetch slots paired with those of CFmIntParam.
+//-------------------------------------------------------------------
 void CFmGroupParam::CreateInstances(int iNumGpus)
 {
 	if(m_iNumGpus == iNumGpus) return;
 	if(m_pInstances != 0L) delete[] m_pInstances;
-	int iSize = 2 * iNumGpus;
+	int iSize = 4 * iNumGpus;
 	m_pInstances = new CFmGroupParam[iSize];
 	//-----------------
-	for(int i=0; i<iNumGpus; i++)
+	for(int i=0; i<2*iNumGpus; i++)
 	{	int k = 2 * i;
 		m_pInstances[k].m_iNthGpu = i;
 		m_pInstances[k+1].m_iNthGpu = i;
@@ -53,6 +58,14 @@ CFmGroupParam::~CFmGroupParam(void)
 	this->mClean();
 }
 
+void CFmGroupParam::Swap(CFmGroupParam* pFmGroupParam)
+{
+	std::swap(m_iNumGroups, pFmGroupParam->m_iNumGroups);
+	std::swap(m_iNumIntFms, pFmGroupParam->m_iNumIntFms);
+	std::swap(m_iGroupSize, pFmGroupParam->m_iGroupSize);
+	std::swap(m_ppiGroupIdxs, pFmGroupParam->m_ppiGroupIdxs);
+}
+
 void CFmGroupParam::mClean(void)
 {
 	if(m_ppiGroupIdxs != 0L)
@@ -5,19 +5,25 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <sys/types.h>
+#include <utility>
 
 using namespace McAreTomo::MotionCor::DataUtil;
 
 CFmIntParam* CFmIntParam::m_pInstances = 0L;
 int CFmIntParam::m_iNumGpus = 0;
 
+//-------------------------------------------------------------------
+// 1. The second half are the prefetch slots paired with those of
+//    MD::CMcPackage.
+//-------------------------------------------------------------------
 void CFmIntParam::CreateInstances(int iNumGpus)
 {
 	if(m_iNumGpus == iNumGpus) return;
 	if(m_pInstances != 0L) delete[] m_pInstances;
-	m_pInstances = new CFmIntParam[iNumGpus];
+	int iSize = 2 * iNumGpus;
+	m_pInstances = new CFmIntParam[iSize];
 	//-----------------
-	for(int i=0; i<iNumGpus; i++)
+	for(int i=0; i<iSize; i++)
 	{	m_pInstances[i].m_iNthGpu = i;
 	}
 	m_iNumGpus = iNumGpus;
@@ -65,6 +71,18 @@ void CFmIntParam::Setup(int iNumRawFms, int iMrcMode, float fMdocDose)
 	mCalcIntFms(); 
 }
 
+void CFmIntParam::Swap(CFmIntParam* pFmIntParam)
+{
+	std::swap(m_iNumIntFms, pFmIntParam->m_iNumIntFms);
+	std::swap(m_fTotalDose, pFmIntParam->m_fTotalDose);
+	std::swap(m_pfIntFmDoses, pFmIntParam->m_pfIntFmDoses);
+	std::swap(m_pfAccFmDoses, pFmIntParam->m_pfAccFmDoses);
+	std::swap(m_piIntFmStarts, pFmIntParam->m_piIntFmStarts);
+	std::swap(m_piIntFmSizes, pFmIntParam->m_piIntFmSizes);
+	std::swap(m_iNumRawFms, pFmIntParam->m_iNumRawFms);
+	std::swap(m_iMrcMode, pFmIntParam->m_iMrcMode);
+}
+
 int CFmIntParam::GetIntFmStart(int iIntFrame)
 {
 	return m_piIntFmStarts[iIntFrame];
@@ -21,25 +21,13 @@ void CDecodeEerFrame::Setup(int* piCamSize, int iEerUpSampling)
 	m_uiCamPixels = piCamSize[0] * piCamSize[1];
 	m_iUpSampling = iEerUpSampling;
 	//-----------------------------
-	int iFact = 1;
-	if(m_iUpSampling == 2) 
-	{	iFact = 2;
-		m_aiSuperResAnd[0] = 2;
-		m_aiSuperResAnd[1] = 8;
-		m_aiSuperResShift[0] = 1;
-		m_aiSuperResShift[1] = 1;
-		m_aiSuperResShift[2] = 3;
-	}
-	else if(m_iUpSampling == 3) 
-	{	iFact = 4;
-		m_aiSuperResAnd[0] = 3;
-		m_aiSuperResAnd[1] = 12;
-		m_aiSuperResShift[0] = 2;
-		m_aiSuperResShift[1] = 0;
-		m_aiSuperResShift[2] = 2;
-	}
-	m_aiFrmSize[0] = piCamSize[0] * iFact;
-	m_aiFrmSize[1] = piCamSize[1] * iFact;
+	m_iSuperResShift = 0;
+	if(m_iUpSampling == 2) m_iSuperResShift = 1;
+	else if(m_iUpSampling == 3) m_iSuperResShift = 2;
+	//-----------------
+	m_aiFrmSize[0] = piCamSize[0] << m_iSuperResShift;
+	m_aiFrmSize[1] = piCamSize[1] << m_iSuperResShift;
+	mSetupSubPixLut();
 }
 
 void CDecodeEerFrame::Do7Bits
@@ -68,148 +56,185 @@ void CDecodeEerFrame::Do8Bits
 	else mDo8BitsSuperRes();
 }
 
+//-------------------------------------------------------------------
+// 1. A 7-bit code is a run of empty pixels. A run of 127 is not
+//    followed by an electron. Otherwise a 4-bit sub-pixel code
+//    follows and the electron lands at the end of the run.
+// 2. One 64-bit load holds at least 57 valid bits, i.e. up to five
+//    codes are decoded before the next load.
+//-------------------------------------------------------------------
 void CDecodeEerFrame::mDo7BitsCounted(void)
 {
-	m_uiNumPixels = 0;
+	unsigned int uiNumPixels = 0;
 	unsigned int uiBitPos = 0;
-	unsigned char p;
-	unsigned int uiChunk = 0;
-	//-----------------------
-	while(true)
-	{	unsigned int uiFirstByte = uiBitPos >> 3;
-		unsigned int uiBitOffset = uiBitPos & 7;  // % 8
-		uiChunk = (*(unsigned int*)(m_pucEerFrame + uiFirstByte))
-		   >> uiBitOffset;
+	unsigned int uiEndBit = m_iEerFrameSize * 8;
+	//-----------------
+	while(uiBitPos + 11 <= uiEndBit)
+	{	unsigned int uiBitOffset = uiBitPos & 7;
+		unsigned long ulChunk = mLoadWord(uiBitPos >> 3) >> uiBitOffset;
+		unsigned int uiBits = 64 - uiBitOffset;
+		if(uiBits > uiEndBit - uiBitPos) uiBits = uiEndBit - uiBitPos;
 		//----------------
-		p = (unsigned char)(uiChunk & 127);
-		uiBitPos += 7;
-		m_uiNumPixels += p;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		else if(p == 127) continue;
-		//-------------------------
-		uiBitPos += 4;
-		m_uiX = m_uiNumPixels % m_aiFrmSize[0];
-		m_uiY = m_uiNumPixels / m_aiFrmSize[0];
-		m_pucRawFrame[m_uiY * m_aiFrmSize[0] + m_uiX] += 1;
-		m_uiNumPixels += 1;
-		//-----------------
-		p = (unsigned char)((uiChunk >> 11) & 127);
-		uiBitPos += 7;
-		m_uiNumPixels += p;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		else if(p == 127) continue;
-		//-------------------------
-		uiBitPos += 4;
-		m_uiX = m_uiNumPixels % m_aiFrmSize[0];
-		m_uiY = m_uiNumPixels / m_aiFrmSize[0];
-		m_pucRawFrame[m_uiY * m_aiFrmSize[0] + m_uiX] += 1;
-		m_uiNumPixels += 1;
+		while(uiBits >= 11)
+		{	unsigned int p = (unsigned int)(ulChunk & 127);
+			ulChunk >>= 7;
+			uiBits -= 7;
+			uiBitPos += 7;
+			uiNumPixels += p;
+			if(uiNumPixels >= m_uiCamPixels) return;
+			else if(p == 127) continue;
+			//---------------
+			ulChunk >>= 4;
+			uiBits -= 4;
+			uiBitPos += 4;
+			m_pucRawFrame[uiNumPixels] += 1;
+			uiNumPixels += 1;
+		}
 	}
 }
 
 void CDecodeEerFrame::mDo7BitsSuperRes(void)
 {
-	m_uiNumPixels = 0;
+	unsigned int uiNumPixels = 0;
 	unsigned int uiBitPos = 0;
-	unsigned char p;
-	unsigned int uiChunk = 0;
-	//-----------------------
-	while(true)
-	{	unsigned int uiFirstByte = uiBitPos >> 3;
-		unsigned int uiBitOffset = uiBitPos & 7; // % 8
-		uiChunk = (*(unsigned int*)(m_pucEerFrame + uiFirstByte))
-		   >> uiBitOffset;
+	unsigned int uiEndBit = m_iEerFrameSize * 8;
+	//-----------------
+	while(uiBitPos + 11 <= uiEndBit)
+	{	unsigned int uiBitOffset = uiBitPos & 7;
+		unsigned long ulChunk = mLoadWord(uiBitPos >> 3) >> uiBitOffset;
+		unsigned int uiBits = 64 - uiBitOffset;
+		if(uiBits > uiEndBit - uiBitPos) uiBits = uiEndBit - uiBitPos;
 		//----------------
-		p = (unsigned char)(uiChunk & 127);
-		uiBitPos += 7;
-		m_uiNumPixels += p;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		else if(p == 127) continue;
-		//-------------------------
-		m_ucS = (unsigned char)((uiChunk >> 7) & 15) ^ 0x0A;
-		uiBitPos += 4;
-		//------------
-		mFindElectron();
-		m_uiNumPixels += 1;
-		//-----------------
-		p = (unsigned char)((uiChunk >> 11) & 127);
-		uiBitPos += 7;
-		m_uiNumPixels += p;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		else if(p == 127) continue;
-		//-------------------------
-		m_ucS = (unsigned char)((uiChunk >> 18) & 15) ^ 0x0A;
-		uiBitPos += 4;
-		mFindElectron();
-		m_uiNumPixels += 1;
+		while(uiBits >= 11)
+		{	unsigned int p = (unsigned int)(ulChunk & 127);
+			ulChunk >>= 7;
+			uiBits -= 7;
+			uiBitPos += 7;
+			uiNumPixels += p;
+			if(uiNumPixels >= m_uiCamPixels) return;
+			else if(p == 127) continue;
+			//---------------
+			unsigned int s = (unsigned int)(ulChunk & 15);
+			ulChunk >>= 4;
+			uiBits -= 4;
+			uiBitPos += 4;
+			unsigned int i = mFindElectron(uiNumPixels);
+			m_pucRawFrame[i + m_auiSubPixLut[s]] += 1;
+			uiNumPixels += 1;
+		}
 	}
 }
 
+//-------------------------------------------------------------------
+// 1. An 8-bit code is 12 bits wide, an 8-bit run followed by the
+//    4-bit sub-pixel code. A run of 255 is not followed by an
+//    electron.
+// 2. Every 6 bytes hold exactly 4 codes that are decoded from one
+//    64-bit load.
+//-------------------------------------------------------------------
 void CDecodeEerFrame::mDo8BitsCounted(void)
 {
-	m_uiNumPixels = 0;
+	unsigned int uiNumPixels = 0;
+	int iNumCodes = (m_iEerFrameSize * 2) / 3;
 	unsigned int uiPos = 0;
-	unsigned char p1, p2;
-	while(uiPos < m_iEerFrameSize)
-	{	p1 = m_pucEerFrame[uiPos];
-		m_uiNumPixels += p1;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		//-------------------------------------
-		if(p1 < 255)
-		{	m_uiX = m_uiNumPixels % m_aiFrmSize[0];
-			m_uiY = m_uiNumPixels / m_aiFrmSize[0];
-			m_pucRawFrame[m_uiY * m_aiFrmSize[0] + m_uiX] += 1;
-			m_uiNumPixels += 1;
-		}
-		//-------------------------
-		p2 = (m_pucEerFrame[uiPos + 1] >> 4) 
-		   | (m_pucEerFrame[uiPos + 2] << 4); 
-		m_uiNumPixels += p2;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		//-------------------------------------
-		if(p2 < 255)
-		{	m_uiX = m_uiNumPixels % m_aiFrmSize[0];
-			m_uiY = m_uiNumPixels / m_aiFrmSize[0];
-			m_pucRawFrame[m_uiY * m_aiFrmSize[0] + m_uiX] += 1;
-			m_uiNumPixels += 1;
+	//-----------------
+	while(iNumCodes > 0)
+	{	unsigned long ulChunk = mLoadWord(uiPos);
+		int iCodes = (iNumCodes < 4) ? iNumCodes : 4;
+		iNumCodes -= iCodes;
+		uiPos += 6;
+		//----------------
+		for(int i=0; i<iCodes; i++)
+		{	unsigned int p = (unsigned int)(ulChunk & 255);
+			ulChunk >>= 12;
+			uiNumPixels += p;
+			if(uiNumPixels >= m_uiCamPixels) return;
+			else if(p == 255) continue;
+			//---------------
+			m_pucRawFrame[uiNumPixels] += 1;
+			uiNumPixels += 1;
 		}
-		uiPos += 3;
 	}	
 }
 
 void CDecodeEerFrame::mDo8BitsSuperRes(void)
 {
-	m_uiNumPixels = 0;
-	unsigned int uiPos = 0, uiPos1 = 0, uiPos2 = 0;
-	unsigned char p1, p2;
-	while(uiPos < m_iEerFrameSize)
-	{	uiPos1 = uiPos + 1;
-		p1 = m_pucEerFrame[uiPos];
-		m_ucS = m_pucEerFrame[uiPos1] & 0x0A;
-		m_uiNumPixels += p1;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		if(p1 < 255)
-		{	mFindElectron();
-			m_uiNumPixels++;
+	unsigned int uiNumPixels = 0;
+	int iNumCodes = (m_iEerFrameSize * 2) / 3;
+	unsigned int uiPos = 0;
+	//-----------------
+	while(iNumCodes > 0)
+	{	unsigned long ulChunk = mLoadWord(uiPos);
+		int iCodes = (iNumCodes < 4) ? iNumCodes : 4;
+		iNumCodes -= iCodes;
+		uiPos += 6;
+		//----------------
+		for(int i=0; i<iCodes; i++)
+		{	unsigned int p = (unsigned int)(ulChunk & 255);
+			unsigned int s = (unsigned int)((ulChunk >> 8) & 15);
+			ulChunk >>= 12;
+			uiNumPixels += p;
+			if(uiNumPixels >= m_uiCamPixels) return;
+			else if(p == 255) continue;
+			//---------------
+			unsigned int j = mFindElectron(uiNumPixels);
+			m_pucRawFrame[j + m_auiSubPixLut[s]] += 1;
+			uiNumPixels += 1;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. The sub-pixel code is stored with bits 1 and 3 inverted. Bits
+//    0-1 are the x and bits 2-3 the y sub-pixel position.
+// 2. The table maps the stored code directly to the pixel offset
+//    relative to the upper-left super-res pixel of the camera
+//    pixel.
+//-------------------------------------------------------------------
+void CDecodeEerFrame::mSetupSubPixLut(void)
+{
+	memset(m_auiSubPixLut, 0, sizeof(m_auiSubPixLut));
+	if(m_iSuperResShift == 0) return;
+	//-----------------
+	for(int i=0; i<16; i++)
+	{	int s = i ^ 0x0A;
+		int iX = 0, iY = 0;
+		if(m_iSuperResShift == 1)
+		{	iX = (s & 2) >> 1;
+			iY = (s & 8) >> 3;
 		}
-		//----------------------
-		p2 = (m_pucEerFrame[uiPos1] >> 4) | (m_pucEerFrame[uiPos2]);
-		m_ucS = (m_pucEerFrame[uiPos2] >> 4) ^ 0x0A;
-		m_uiNumPixels += p2;
-		if(m_uiNumPixels >= m_uiCamPixels) break;
-		if(p2 < 255)
-		{	mFindElectron();
-			m_uiNumPixels++;
+		else
+		{	iX = s & 3;
+			iY = (s & 12) >> 2;
 		}
-		uiPos += 3;
+		m_auiSubPixLut[i] = iY * m_aiFrmSize[0] + iX;
+	}
+}
+
+//-------------------------------------------------------------------
+// 1. Little-endian load of 8 bytes starting at uiByte. Bytes past
+//    the end of the EER frame are read as zero.
+//-------------------------------------------------------------------
+unsigned long CDecodeEerFrame::mLoadWord(unsigned int uiByte)
+{
+	unsigned long ulWord = 0;
+	if(uiByte + 8 <= (unsigned int)m_iEerFrameSize)
+	{	memcpy(&ulWord, m_pucEerFrame + uiByte, 8);
+	}
+	else if(uiByte < (unsigned int)m_iEerFrameSize)
+	{	memcpy(&ulWord, m_pucEerFrame + uiByte,
+		   m_iEerFrameSize - uiByte);
 	}
+	return ulWord;
 }
 
-void  CDecodeEerFrame::mFindElectron(void)
+//-------------------------------------------------------------------
+// Returns the index of the upper-left super-res pixel of the
+// camera pixel uiNumPixels.
+//-------------------------------------------------------------------
+unsigned int CDecodeEerFrame::mFindElectron(unsigned int uiNumPixels)
 {
-	m_uiX = ((m_uiNumPixels & 4095) << m_aiSuperResShift[0])
-	   | ((m_ucS & m_aiSuperResAnd[0]) >> m_aiSuperResShift[1]);
-	m_uiY = ((m_uiNumPixels >> 12) << m_aiSuperResShift[0])
-	   | ((m_ucS & m_aiSuperResAnd[1]) >> m_aiSuperResShift[2]);
-	m_pucRawFrame[m_uiY * m_aiFrmSize[0] + m_uiX] += 1;
+	unsigned int uiX = uiNumPixels % m_aiCamSize[0];
+	unsigned int uiY = uiNumPixels / m_aiCamSize[0];
+	return ((uiY * m_aiFrmSize[0] + uiX) << m_iSuperResShift);
 }
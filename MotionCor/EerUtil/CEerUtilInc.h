@@ -1,6 +1,9 @@
 #pragma once
 #include "../CMotionCorInc.h"
 #include "../DataUtil/CDataUtilInc.h"
+#include "../Util/CUtilInc.h"
+#include "../TiffUtil/CTiffUtilInc.h"
+#include <Util/Util_Thread.h>
 #include <tiffio.h>
 #include <stdio.h>
 #include <cuda.h>
@@ -42,25 +45,59 @@ private:
 	TIFF* m_pTiff;
 };
 
-class CLoadEerFrames
+//-------------------------------------------------------------------
+// 1. DoIt reads all frames into memory before rendering.
+// 2. Stream keeps only iRingFrames frames in memory. A reader thread
+//    preads the strips of the next frame into a ring slot once the
+//    frame previously held by the slot has been released. Frames
+//    must therefore be requested roughly in increasing order and
+//    each of them released by ReleaseFrame after decoding.
+// 3. GetEerFrame blocks in streaming mode until the frame has been
+//    read and returns null if reading has failed.
+//-------------------------------------------------------------------
+class CLoadEerFrames : public Util_Thread
 {
 public:
         CLoadEerFrames(void);
         ~CLoadEerFrames(void);
 	void Clean(void);
-	bool DoIt(int iFile, int iNumFrames);
+	bool DoIt
+	( int iFile, int iNumFrames, 
+	  const char* pcCacheFile = 0L
+	);
+	bool Stream
+	( int iFile, int iNumFrames, int iRingFrames,
+	  const char* pcCacheFile = 0L
+	);
+	bool EndStream(void);
 	unsigned char* GetEerFrame(int iFrame);     // do not free
+	void ReleaseFrame(int iFrame);
 	int GetEerFrameSize(int iFrame);
+	void ThreadMain(void);
 	int m_iNumFrames;
+	size_t m_tMemBytes;
 private:
+	bool mIndex(int iFile, int iNumFrames, const char* pcCacheFile);
 	void mReadFrame(int iFrame);
-	TIFF* m_pTiff;
+	MMT::CTiffDirIndex m_aDirIndex;
 	unsigned char* m_pucFrames;
-	int* m_piFrmStarts;
-	int* m_piFrmSizes;
-	int m_iBytesRead;
+	size_t* m_ptFrmStarts;
+	int m_iFile;
+	bool m_bStream;
+	bool m_bReadError;
+	//---------------------------
+	int m_iRingFrames;
+	int m_iSlotBytes;
+	int* m_piSlotFrames;     // frame held by each slot, -1 if free
 };
 
+//-------------------------------------------------------------------
+// 1. Decodes one EER frame and adds the electrons to pucRawFrame.
+// 2. Runs are unpacked from 64-bit words, several codes per load,
+//    and the 4-bit sub-pixel codes are mapped to pixel offsets
+//    through a lookup table built in Setup.
+// 3. Not thread safe. Each decoding thread needs its own object.
+//-------------------------------------------------------------------
 class CDecodeEerFrame
 {
 public:
@@ -83,22 +120,81 @@ private:
 	void mDo7BitsSuperRes(void);
 	void mDo8BitsCounted(void);
 	void mDo8BitsSuperRes(void);
-	void mFindElectron(void);
+	void mSetupSubPixLut(void);
+	unsigned long mLoadWord(unsigned int uiByte);
+	unsigned int mFindElectron(unsigned int uiNumPixels);
 	//-----------------------
 	unsigned int m_uiCamPixels;
 	unsigned char* m_pucEerFrame;
 	unsigned char* m_pucRawFrame;
-	unsigned int m_uiNumPixels;
-	unsigned char m_ucS;
-	unsigned int m_uiX;
-	unsigned int m_uiY;
 	int m_iUpSampling;
 	int m_iEerFrameSize;
 	int m_aiCamSize[2];
-	int m_aiSuperResAnd[2];
-	int m_aiSuperResShift[3];
+	int m_iSuperResShift;
+	unsigned int m_auiSubPixLut[16];
 };
 
+//-------------------------------------------------------------------
+// 1. Worker of CRenderMrcStack. Each thread pulls jobs from the
+//    shared CNextItem. A job decodes EER frames, every stride-th
+//    one starting from the first, that belong to one rendered
+//    frame. Each EER frame is released after decoding.
+// 2. When a rendered frame is split into several jobs, the job
+//    is decoded into the thread's own buffer that is then added
+//    to the rendered frame under the shared mutex.
+// 3. A packed stack is rendered through 8-bit frames: a whole
+//    job in the thread's buffer that is then packed into the
+//    stack, split jobs are added to pucSums.
+//-------------------------------------------------------------------
+class CRenderEerThread : public Util_Thread
+{
+public:
+	CRenderEerThread(void);
+	~CRenderEerThread(void);
+	void Run
+	( CLoadEerFrames* pLoadFrames,
+	  int iEerBits,
+	  int* piCamSize,
+	  int iEerSampling,
+	  MD::CRawStack* pRawStack,
+	  unsigned char* pucSums,
+	  int* piJobs,
+	  MMU::CNextItem* pNextJob,
+	  pthread_mutex_t* pMutex
+	);
+	void ThreadMain(void);
+	int m_iNumDecoded;
+private:
+	void mDoJob(int iJob);
+	void mDecodeFrames
+	( int iEerStart,
+	  int iNumEerFms,
+	  int iEerStride,
+	  unsigned char* pucFrm
+	);
+	void mAddBuf(unsigned char* pucFrm);
+	//-----------------
+	CDecodeEerFrame m_aDecodeEerFrame;
+	CLoadEerFrames* m_pLoadFrames;
+	MD::CRawStack* m_pRawStack;
+	unsigned char* m_pucSums;
+	MMU::CNextItem* m_pNextJob;
+	pthread_mutex_t* m_pMutex;
+	int* m_piJobs;
+	int m_iEerBits;
+	unsigned char* m_pucBuf;
+	size_t m_tBufBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Renders the EER frames into the integrated frames defined by
+//    CFmIntParam using a pool of CRenderEerThread.
+// 2. m_iNumThreads <= 0 lets DoIt split the CPU cores evenly among
+//    the GPU threads.
+// 3. Rendering into a packed stack needs an 8-bit buffer in each
+//    thread. The number of threads is then limited by the buffer
+//    memory.
+//-------------------------------------------------------------------
 class CRenderMrcStack 
 {
 public:
@@ -109,21 +205,27 @@ public:
 	  CLoadEerFrames* pLoadFrames,
 	  int iNthGpu 
 	);
+	int m_iNumThreads;
+	float m_fRenderTime;
 private:
-	void mLoadHeader(void);
-	void mLoadStack(int iNumFrames);
+	void mSetupThreads(void);
+	void mCreateJobs(void);
 	void mRender(void);
-	void mRenderInt(void);
-	void mRenderFrame(int iIntFrm);
-	void mDecodeFrame(int iEerFrame, unsigned char* pucDecodedFrm);
+	void mPackSums(void);
+	void mClean(void);
 	//-----------------
-	CDecodeEerFrame m_aDecodeEerFrame;
 	CLoadEerHeader* m_pLoadHeader;
 	CLoadEerFrames* m_pLoadFrames;
 	//-----------------
-	MD::CMrcStack* m_pRawStack;
+	MD::CRawStack* m_pRawStack;
+	unsigned char* m_pucSums; // 8-bit split frames of packed stack
 	MMD::CFmIntParam* m_pFmIntParam;
-
+	//-----------------
+	int* m_piJobs;   // int frame, EER start, EER count, stride
+	int m_iNumJobs;
+	int m_iNumParts;
+	MMU::CNextItem m_aNextJob;
+	pthread_mutex_t m_aMutex;
 	int m_iNthGpu;
 };
 
@@ -5,16 +5,23 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <stdio.h>
 
 using namespace McAreTomo::MotionCor::EerUtil;
 using namespace McAreTomo::MotionCor;
 
 CLoadEerFrames::CLoadEerFrames(void)
 {
-	m_pTiff = 0L;
 	m_pucFrames = 0L;
-	m_piFrmStarts = 0L;
-	m_piFrmSizes = 0L;
+	m_ptFrmStarts = 0L;
+	m_piSlotFrames = 0L;
+	m_iNumFrames = 0;
+	m_tMemBytes = 0;
+	m_iFile = -1;
+	m_bStream = false;
+	m_bReadError = false;
+	m_iRingFrames = 0;
+	m_iSlotBytes = 0;
 }
 
 CLoadEerFrames::~CLoadEerFrames(void)
@@ -24,87 +31,183 @@ CLoadEerFrames::~CLoadEerFrames(void)
 
 void CLoadEerFrames::Clean(void)
 {
+	if(this->IsCreated())
+	{	pthread_mutex_lock(&m_aMutex);
+		m_bStop = true;
+		pthread_cond_broadcast(&m_aCond);
+		pthread_mutex_unlock(&m_aMutex);
+		this->WaitForExit(-1.0f);
+	}
+	//-----------------
 	if(m_pucFrames != 0L) delete[] m_pucFrames;
-	if(m_piFrmStarts != 0L) delete[] m_piFrmStarts;
-	if(m_piFrmSizes != 0L) delete[] m_piFrmSizes;
+	if(m_ptFrmStarts != 0L) delete[] m_ptFrmStarts;
+	if(m_piSlotFrames != 0L) delete[] m_piSlotFrames;
 	m_pucFrames = 0L;
-	m_piFrmStarts = 0L;
-	m_piFrmSizes = 0L;
-	//-----------------
-	if(m_pTiff == 0L) return;
-	TIFFCleanup(m_pTiff);
-	m_pTiff = 0L;
+	m_ptFrmStarts = 0L;
+	m_piSlotFrames = 0L;
+	m_tMemBytes = 0;
+	m_bStream = false;
+	m_aDirIndex.Clean();
 }
 
 bool CLoadEerFrames::DoIt
 (	int iFile,
-	int iNumFrames
+	int iNumFrames,
+	const char* pcCacheFile
 )
 {	this->Clean();
-	m_iNumFrames = iNumFrames;
-	//-----------------
-	lseek64(iFile, 0, SEEK_SET);
-        m_pTiff = TIFFFdOpen(iFile, "\0", "r");
-	if(m_pTiff == 0L) return false;
+	if(!mIndex(iFile, iNumFrames, pcCacheFile)) return false;
 	//-----------------
-	struct stat buf;
-	fstat(iFile, &buf);
-	unsigned int uiSize = buf.st_size;
-	m_pucFrames = new unsigned char[uiSize];
-	memset(m_pucFrames, 0, sizeof(char) * uiSize);
-	//-----------------
-	int iBytes = sizeof(int) * m_iNumFrames;
-	m_piFrmStarts = new int[m_iNumFrames];
-	m_piFrmSizes = new int[m_iNumFrames];
-	memset(m_piFrmStarts, 0, iBytes);
-	memset(m_piFrmSizes, 0, iBytes);
+	m_ptFrmStarts = new size_t[m_iNumFrames];
+	m_tMemBytes = 0;
+	for(int i=0; i<m_iNumFrames; i++)
+	{	m_ptFrmStarts[i] = m_tMemBytes;
+		m_tMemBytes += m_aDirIndex.GetDirBytes(i);
+	}
+	m_pucFrames = new unsigned char[m_tMemBytes];
 	//-----------------
-	m_iBytesRead = 0;
 	CMcInput* pInput = CMcInput::GetInstance();
 	if(pInput->m_iTiffOrder >= 0)
-	{	for(int i=0; i<m_iNumFrames; i++) 
+	{	for(int i=0; i<m_iNumFrames; i++)
 		{	mReadFrame(i);
 		}
 	}
 	else
 	{	int iLastFrm = m_iNumFrames - 1;
-		for(int i=iLastFrm; i>=0; i--) 
+		for(int i=iLastFrm; i>=0; i--)
 		{	mReadFrame(i);
 		}
 	}
+	return !m_bReadError;
+}
+
+//-------------------------------------------------------------------
+// 1. Starts the reader thread and returns immediately. Rendering
+//    overlaps with reading the file. EndStream must be called when
+//    all frames have been consumed.
+//-------------------------------------------------------------------
+bool CLoadEerFrames::Stream
+(	int iFile,
+	int iNumFrames,
+	int iRingFrames,
+	const char* pcCacheFile
+)
+{	this->Clean();
+	if(!mIndex(iFile, iNumFrames, pcCacheFile)) return false;
+	//-----------------
+	m_iRingFrames = (iRingFrames < m_iNumFrames) ?
+	   iRingFrames : m_iNumFrames;
+	if(m_iRingFrames < 1) m_iRingFrames = 1;
+	m_iSlotBytes = m_aDirIndex.GetMaxDirBytes();
+	m_tMemBytes = (size_t)m_iSlotBytes * m_iRingFrames;
+	m_pucFrames = new unsigned char[m_tMemBytes];
+	m_piSlotFrames = new int[m_iRingFrames];
+	for(int i=0; i<m_iRingFrames; i++) m_piSlotFrames[i] = -1;
 	//-----------------
-	TIFFCleanup(m_pTiff);
-        m_pTiff = 0L;
+	m_bStream = true;
+	m_bStop = false;
+	this->Start();
 	return true;
 }
 
+bool CLoadEerFrames::EndStream(void)
+{
+	if(!m_bStream) return !m_bReadError;
+	pthread_mutex_lock(&m_aMutex);
+	m_bStop = true;
+	pthread_cond_broadcast(&m_aCond);
+	pthread_mutex_unlock(&m_aMutex);
+	this->WaitForExit(-1.0f);
+	return !m_bReadError;
+}
+
+void CLoadEerFrames::ThreadMain(void)
+{
+	for(int i=0; i<m_iNumFrames; i++)
+	{	int iSlot = i % m_iRingFrames;
+		pthread_mutex_lock(&m_aMutex);
+		while(m_piSlotFrames[iSlot] >= 0 && !m_bStop)
+		{	pthread_cond_wait(&m_aCond, &m_aMutex);
+		}
+		bool bStop = m_bStop;
+		pthread_mutex_unlock(&m_aMutex);
+		if(bStop) return;
+		//----------------
+		unsigned char* pucSlot = m_pucFrames +
+		   (size_t)iSlot * m_iSlotBytes;
+		bool bRead = m_aDirIndex.ReadDir(m_iFile, i, pucSlot);
+		//----------------
+		pthread_mutex_lock(&m_aMutex);
+		if(bRead) m_piSlotFrames[iSlot] = i;
+		else m_bReadError = true;
+		pthread_cond_broadcast(&m_aCond);
+		pthread_mutex_unlock(&m_aMutex);
+		if(!bRead) return;
+	}
+}
+
 unsigned char* CLoadEerFrames::GetEerFrame(int iFrame)
 {
 	if(m_pucFrames == 0L) return 0L;
-	return m_pucFrames + m_piFrmStarts[iFrame];
+	if(!m_bStream) return m_pucFrames + m_ptFrmStarts[iFrame];
+	//-----------------
+	int iSlot = iFrame % m_iRingFrames;
+	pthread_mutex_lock(&m_aMutex);
+	while(m_piSlotFrames[iSlot] != iFrame && !m_bReadError && !m_bStop)
+	{	pthread_cond_wait(&m_aCond, &m_aMutex);
+	}
+	bool bReady = (m_piSlotFrames[iSlot] == iFrame);
+	pthread_mutex_unlock(&m_aMutex);
+	//-----------------
+	if(!bReady) return 0L;
+	return m_pucFrames + (size_t)iSlot * m_iSlotBytes;
 }
 
-int CLoadEerFrames::GetEerFrameSize(int iFrame)
+void CLoadEerFrames::ReleaseFrame(int iFrame)
 {
-	if(m_piFrmSizes == 0L) return 0;
-	return m_piFrmSizes[iFrame];
+	if(!m_bStream) return;
+	int iSlot = iFrame % m_iRingFrames;
+	pthread_mutex_lock(&m_aMutex);
+	if(m_piSlotFrames[iSlot] == iFrame)
+	{	m_piSlotFrames[iSlot] = -1;
+		pthread_cond_broadcast(&m_aCond);
+	}
+	pthread_mutex_unlock(&m_aMutex);
 }
 
-void CLoadEerFrames::mReadFrame(int iFrame)
+int CLoadEerFrames::GetEerFrameSize(int iFrame)
 {
-	m_piFrmStarts[iFrame] = m_iBytesRead;
-	unsigned char* pcEerFrm = m_pucFrames + m_iBytesRead;
-	//---------------------------------------------------
-	TIFFSetDirectory(m_pTiff, iFrame);
-	int iNumStrips = TIFFNumberOfStrips(m_pTiff);
-	int iFrmBytes = 0;
-	//----------------
-	for(int i=0; i<iNumStrips; i++)
-	{	int iStripBytes = TIFFRawStripSize(m_pTiff, i);
-		TIFFReadRawStrip(m_pTiff, i, pcEerFrm + iFrmBytes, iStripBytes);
-		iFrmBytes += iStripBytes;
+	if(m_aDirIndex.m_iNumDirs <= iFrame) return 0;
+	return m_aDirIndex.GetDirBytes(iFrame);
+}
+
+//-------------------------------------------------------------------
+// 1. The strip offsets of all frames are collected once so that
+//    frames can be read with pread instead of TIFFSetDirectory,
+//    which walks the directory chain from the start every time.
+// 2. The index is loaded from pcCacheFile when it is still valid.
+//-------------------------------------------------------------------
+bool CLoadEerFrames::mIndex
+(	int iFile, 
+	int iNumFrames,
+	const char* pcCacheFile
+)
+{	m_iFile = iFile;
+	m_iNumFrames = iNumFrames;
+	m_bReadError = false;
+	if(!m_aDirIndex.DoIt(m_iFile, pcCacheFile)) return false;
+	//-----------------
+	if(m_aDirIndex.m_iNumDirs < m_iNumFrames)
+	{	fprintf(stderr, "Error: EER file has %d frames, "
+		   "%d expected.\n\n", m_aDirIndex.m_iNumDirs, m_iNumFrames);
+		return false;
 	}
-	m_piFrmSizes[iFrame] = iFrmBytes;
-	m_iBytesRead += iFrmBytes;
+	return true;
 }
 
+void CLoadEerFrames::mReadFrame(int iFrame)
+{
+	unsigned char* pucFrm = m_pucFrames + m_ptFrmStarts[iFrame];
+	if(m_aDirIndex.ReadDir(m_iFile, iFrame, pucFrm)) return;
+	m_bReadError = true;
+}
@@ -66,11 +66,13 @@ void CLoadEerMain::mLoadHeader(void)
 	pFmGroupParam = MMD::CFmGroupParam::GetInstance(m_iNthGpu, true);
 	pFmGroupParam->Setup(pInput->m_aiGroup[1]);
 	//-------------------------------------------------
-	// Create a MRC stack to store the rendered frames
+	// Create a MRC stack to store the rendered frames.
+	// They are 4-bit packed since most pixels count
+	// less than 16 electrons.
 	//-------------------------------------------------
 	memcpy(m_aiStkSize, m_pLoadHeader->m_aiFrmSize, sizeof(int) * 2);
 	m_aiStkSize[2] = pFmIntParam->m_iNumIntFms;
-	pPackage->m_pRawStack->Create(Mrc::eMrcUChar, m_aiStkSize);
+	pPackage->m_pRawStack->Create(Mrc::eMrc4Bits, m_aiStkSize);
 	//-----------------
 	int* piCamSize = m_pLoadHeader->m_aiCamSize;
 	printf("EER stack: %d  %d  %d\nRendered stack: %d  %d  %d\n\n", 
@@ -83,13 +85,29 @@ void CLoadEerMain::mLoadStack(void)
 {
 	if(!m_bLoaded) return;
 	//-----------------
-	m_bLoaded = m_pLoadFrames->DoIt(m_iFile, 
-	   m_pLoadHeader->m_iNumFrames);
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	char acCacheFile[512] = {'\0'};
+	bool bCache = MMT::CTiffDirIndex::GetCacheFile(
+	   pPackage->m_acMoviePath, acCacheFile);
+	const char* pcCacheFile = bCache ? acCacheFile : 0L;
+	//-----------------
+	CMcInput* pInput = CMcInput::GetInstance();
+	int iNumFrames = m_pLoadHeader->m_iNumFrames;
+	if(pInput->m_iEerStream > 0)
+	{	m_bLoaded = m_pLoadFrames->Stream(m_iFile, iNumFrames,
+		   pInput->m_iEerStream, pcCacheFile);
+	}
+	else
+	{	m_bLoaded = m_pLoadFrames->DoIt(m_iFile, iNumFrames,
+		   pcCacheFile);
+	}
 	if(!m_bLoaded) return;
 	//-----------------
 	CRenderMrcStack aRenderMrcStack;
 	aRenderMrcStack.DoIt(m_pLoadHeader, m_pLoadFrames, m_iNthGpu);
-	m_bLoaded = true;
+	m_bLoaded = m_pLoadFrames->EndStream();
+	if(m_bLoaded) return;
+	fprintf(stderr, "Error: failed to read EER frames, skip.\n\n");
 }
 
 void CLoadEerMain::mClean(void)
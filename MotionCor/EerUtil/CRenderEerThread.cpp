@@ -0,0 +1,112 @@
+#include "CEerUtilInc.h"
+#include <memory.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MotionCor::EerUtil;
+
+CRenderEerThread::CRenderEerThread(void)
+{
+	m_pucBuf = 0L;
+	m_tBufBytes = 0;
+	m_iNumDecoded = 0;
+}
+
+CRenderEerThread::~CRenderEerThread(void)
+{
+	if(m_pucBuf != 0L) delete[] m_pucBuf;
+}
+
+void CRenderEerThread::Run
+(	CLoadEerFrames* pLoadFrames,
+	int iEerBits,
+	int* piCamSize,
+	int iEerSampling,
+	MD::CRawStack* pRawStack,
+	unsigned char* pucSums,
+	int* piJobs,
+	MMU::CNextItem* pNextJob,
+	pthread_mutex_t* pMutex
+)
+{	m_pLoadFrames = pLoadFrames;
+	m_iEerBits = iEerBits;
+	m_pRawStack = pRawStack;
+	m_pucSums = pucSums;
+	m_piJobs = piJobs;
+	m_pNextJob = pNextJob;
+	m_pMutex = pMutex;
+	m_iNumDecoded = 0;
+	//-----------------
+	m_aDecodeEerFrame.Setup(piCamSize, iEerSampling);
+	this->Start();
+}
+
+void CRenderEerThread::ThreadMain(void)
+{
+	while(true)
+	{	int iJob = m_pNextJob->GetNext();
+		if(iJob < 0) break;
+		mDoJob(iJob);
+	}
+}
+
+void CRenderEerThread::mDoJob(int iJob)
+{
+	int* piJob = m_piJobs + iJob * 4;
+	bool bPacked = m_pRawStack->bPacked();
+	unsigned char* pucFrm = (unsigned char*)
+	   m_pRawStack->GetFrame(piJob[0]);
+	//-----------------
+	if(piJob[3] == 1 && !bPacked)
+	{	mDecodeFrames(piJob[1], piJob[2], 1, pucFrm);
+		return;
+	}
+	//-----------------
+	size_t tBufBytes = m_pRawStack->GetPixels();
+	if(m_tBufBytes != tBufBytes)
+	{	if(m_pucBuf != 0L) delete[] m_pucBuf;
+		m_tBufBytes = tBufBytes;
+		m_pucBuf = new unsigned char[m_tBufBytes];
+	}
+	memset(m_pucBuf, 0, m_tBufBytes);
+	mDecodeFrames(piJob[1], piJob[2], piJob[3], m_pucBuf);
+	//-----------------
+	if(piJob[3] == 1)
+	{	m_pRawStack->SetFrame(piJob[0], m_pucBuf);
+		return;
+	}
+	if(bPacked) pucFrm = m_pucSums + piJob[0] * m_tBufBytes;
+	//-----------------
+	pthread_mutex_lock(m_pMutex);
+	mAddBuf(pucFrm);
+	pthread_mutex_unlock(m_pMutex);
+}
+
+void CRenderEerThread::mDecodeFrames
+(	int iEerStart,
+	int iNumEerFms,
+	int iEerStride,
+	unsigned char* pucFrm
+)
+{	for(int i=0; i<iNumEerFms; i++)
+	{	int iEerFrame = iEerStart + i * iEerStride;
+		unsigned char* pucEerFrm = m_pLoadFrames->GetEerFrame(iEerFrame);
+		if(pucEerFrm == 0L) continue;
+		int iEerFmBytes = m_pLoadFrames->GetEerFrameSize(iEerFrame);
+		if(m_iEerBits == 7)
+		{	m_aDecodeEerFrame.Do7Bits(pucEerFrm, 
+			   iEerFmBytes, pucFrm);
+		}
+		else
+		{	m_aDecodeEerFrame.Do8Bits(pucEerFrm, 
+			   iEerFmBytes, pucFrm);
+		}
+		m_pLoadFrames->ReleaseFrame(iEerFrame);
+	}
+	m_iNumDecoded += iNumEerFms;
+}
+
+void CRenderEerThread::mAddBuf(unsigned char* pucFrm)
+{
+	MU::CAddFrames aAddFrames;
+	aAddFrames.DoIt(pucFrm, m_pucBuf, pucFrm, m_pRawStack->m_aiStkSize);
+}
@@ -1,18 +1,31 @@
 #include "CEerUtilInc.h"
 #include "../Util/CUtilInc.h"
+#include <Util/Util_Time.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
+#include <sys/sysinfo.h>
 #include <memory.h>
 #include <stdio.h>
 
 using namespace McAreTomo::MotionCor::EerUtil;
 
+static size_t s_tMaxBufBytes = (size_t)2 * 1024 * 1024 * 1024;
+
 CRenderMrcStack::CRenderMrcStack(void)
 {
+	m_iNumThreads = 0;
+	m_fRenderTime = 0.0f;
+	m_piJobs = 0L;
+	m_iNumJobs = 0;
+	m_iNumParts = 1;
+	m_pucSums = 0L;
+	pthread_mutex_init(&m_aMutex, 0L);
 }
 
 CRenderMrcStack::~CRenderMrcStack(void)
 {
+	mClean();
+	pthread_mutex_destroy(&m_aMutex);
 }
 
 void CRenderMrcStack::DoIt
@@ -24,71 +37,139 @@ void CRenderMrcStack::DoIt
 	m_pLoadFrames = pLoadFrames;
 	m_iNthGpu = iNthGpu;
 	//-----------------
-	m_aDecodeEerFrame.Setup(m_pLoadHeader->m_aiCamSize, 
-	   m_pLoadHeader->m_iEerSampling);
-	//-----------------
 	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
 	m_pRawStack = pPackage->m_pRawStack;
-	//-----------------
 	m_pFmIntParam = MMD::CFmIntParam::GetInstance(m_iNthGpu);
-	if(m_pFmIntParam->bIntegrate()) mRenderInt();
-	else mRender();
+	//-----------------
+	Util_Time aTimer;
+	aTimer.Measure();
+	mSetupThreads();
+	mCreateJobs();
+	mRender();
+	mClean();
+	m_fRenderTime = aTimer.GetElapsedSeconds();
+	//-----------------
+	int iNumEerFms = m_pLoadHeader->m_iNumFrames;
+	printf("EER rendered: %d frames, %d threads, %.2f sec, "
+	   "%.1f frames/s\n\n", iNumEerFms, m_iNumThreads, m_fRenderTime,
+	   iNumEerFms / (m_fRenderTime + 1e-6f));
 }
 
-void CRenderMrcStack::mRender(void)
+//-------------------------------------------------------------------
+// 1. By default the cores are shared evenly among the GPU threads
+//    since each of them may render its own movie concurrently.
+//-------------------------------------------------------------------
+void CRenderMrcStack::mSetupThreads(void)
 {
-	unsigned char* pucMrcFrm = 0L;
-	for(int i=0; i<m_pRawStack->m_aiStkSize[2]; i++)
-	{	pucMrcFrm = (unsigned char*)m_pRawStack->GetFrame(i);
-		memset(pucMrcFrm, 0, m_pRawStack->m_tFmBytes);
-		int iEerFrm = m_pFmIntParam->GetIntFmStart(i);
-		mDecodeFrame(iEerFrm, pucMrcFrm);
-	}
+	if(m_iNumThreads > 0) return;
+	CInput* pInput = CInput::GetInstance();
+	int iNumGpus = (pInput->m_iNumGpus > 0) ? pInput->m_iNumGpus : 1;
+	m_iNumThreads = get_nprocs() / iNumGpus;
+	if(m_iNumThreads < 1) m_iNumThreads = 1;
 }
 
-void CRenderMrcStack::mRenderInt(void)
+//-------------------------------------------------------------------
+// 1. Each rendered frame is one job when there are enough rendered
+//    frames to keep all threads busy. The threads then decode into
+//    the rendered frames directly.
+// 2. Otherwise each rendered frame is split into several jobs that
+//    are decoded into per-thread buffers and reduced afterwards.
+//    The number of threads is limited by the buffer memory.
+// 3. A job is {rendered frame, first EER frame, number of EER
+//    frames, stride}. Split jobs take every iParts-th EER frame so
+//    that the threads progress through the file together, which
+//    keeps the streamed EER frames within a small window.
+//-------------------------------------------------------------------
+void CRenderMrcStack::mCreateJobs(void)
 {
-	for(int i=0; i<m_pRawStack->m_aiStkSize[2]; i++)
-	{	int iFmSize = m_pFmIntParam->GetIntFmSize(i);
-		if(iFmSize == 1) 
-		{	void* pvMrcFrm = m_pRawStack->GetFrame(i);
-			memset(pvMrcFrm, 0, m_pRawStack->m_tFmBytes);
-			int iFmStart = m_pFmIntParam->GetIntFmStart(i);
-			mDecodeFrame(iFmStart, (unsigned char*)pvMrcFrm);
+	int iNumIntFms = m_pRawStack->m_aiStkSize[2];
+	bool bIntegrate = m_pFmIntParam->bIntegrate();
+	bool bSplit = bIntegrate && iNumIntFms < m_iNumThreads;
+	//-----------------
+	if(bSplit || m_pRawStack->bPacked())
+	{	size_t tBufBytes = m_pRawStack->GetPixels();
+		int iMaxBufs = (int)(s_tMaxBufBytes / tBufBytes);
+		if(m_iNumThreads > iMaxBufs) m_iNumThreads = iMaxBufs;
+		if(m_iNumThreads < 1) m_iNumThreads = 1;
+	}
+	//-----------------
+	int iNumParts = 1;
+	if(bIntegrate && iNumIntFms < m_iNumThreads)
+	{	iNumParts = (m_iNumThreads + iNumIntFms - 1) / iNumIntFms;
+	}
+	m_iNumParts = iNumParts;
+	//-----------------
+	m_piJobs = new int[iNumIntFms * iNumParts * 4];
+	m_iNumJobs = 0;
+	for(int i=0; i<iNumIntFms; i++)
+	{	int iFmStart = m_pFmIntParam->GetIntFmStart(i);
+		int iFmSize = bIntegrate ? m_pFmIntParam->GetIntFmSize(i) : 1;
+		int iParts = (iNumParts < iFmSize) ? iNumParts : iFmSize;
+		//----------------
+		for(int p=0; p<iParts; p++)
+		{	int* piJob = m_piJobs + m_iNumJobs * 4;
+			piJob[0] = i;
+			piJob[1] = iFmStart + p;
+			piJob[2] = (iFmSize - p + iParts - 1) / iParts;
+			piJob[3] = iParts;
+			m_iNumJobs += 1;
 		}
-		else mRenderFrame(i);
 	}
+	if(m_iNumThreads > m_iNumJobs) m_iNumThreads = m_iNumJobs;
 }
 
-void CRenderMrcStack::mRenderFrame(int iIntFrm)
+void CRenderMrcStack::mRender(void)
 {
-	int iIntFmStart = m_pFmIntParam->GetIntFmStart(iIntFrm);
-	int iIntFmSize = m_pFmIntParam->GetIntFmSize(iIntFrm);
+	int iNumIntFms = m_pRawStack->m_aiStkSize[2];
+	size_t tPixels = m_pRawStack->GetPixels();
+	if(!m_pRawStack->bPacked())
+	{	for(int i=0; i<iNumIntFms; i++)
+		{	void* pvFrm = m_pRawStack->GetFrame(i);
+			memset(pvFrm, 0, m_pRawStack->m_tFmBytes);
+		}
+	}
+	else if(m_iNumParts > 1)
+	{	m_pucSums = new unsigned char[tPixels * iNumIntFms];
+		memset(m_pucSums, 0, tPixels * iNumIntFms);
+	}
 	//-----------------
-	unsigned char* pucFrm = 0L;
-	pucFrm = (unsigned char*)m_pRawStack->GetFrame(iIntFrm);
-	memset(pucFrm, 0, m_pRawStack->m_tFmBytes);
+	m_aNextJob.Create(m_iNumJobs);
+	CRenderEerThread* pThreads = new CRenderEerThread[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].Run(m_pLoadFrames, m_pLoadHeader->m_iNumBits,
+		   m_pLoadHeader->m_aiCamSize, m_pLoadHeader->m_iEerSampling,
+		   m_pRawStack, m_pucSums, m_piJobs, &m_aNextJob, &m_aMutex);
+	}
 	//-----------------
-	for(int i=0; i<iIntFmSize; i++)
-	{	int iEerFrame = iIntFmStart + i;
-		mDecodeFrame(iEerFrame, pucFrm);
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].WaitForExit(-1.0f);
 	}
-}	
+	delete[] pThreads;
+	mPackSums();
+}
 
-void CRenderMrcStack::mDecodeFrame
-(	int iEerFrame,
-	unsigned char* pucDecodedFrm
-)
-{	int iEerFmBytes = m_pLoadFrames->GetEerFrameSize(iEerFrame);
-	int iEerBits = m_pLoadHeader->m_iNumBits;
-	unsigned char* pEerFrm = m_pLoadFrames->GetEerFrame(iEerFrame);
-	if(iEerBits == 7)
-	{	m_aDecodeEerFrame.Do7Bits(pEerFrm, 
-		   iEerFmBytes, pucDecodedFrm);
-	}
-	else
-	{	m_aDecodeEerFrame.Do8Bits(pEerFrm, 
-		   iEerFmBytes, pucDecodedFrm);
+//-------------------------------------------------------------------
+// 1. Packs the rendered frames that have been split into several
+//    jobs. The jobs of a rendered frame are consecutive.
+//-------------------------------------------------------------------
+void CRenderMrcStack::mPackSums(void)
+{
+	if(m_pucSums == 0L) return;
+	size_t tPixels = m_pRawStack->GetPixels();
+	for(int j=0; j<m_iNumJobs; j++)
+	{	int* piJob = m_piJobs + j * 4;
+		if(piJob[3] == 1) continue;
+		if(j > 0 && piJob[-4] == piJob[0]) continue;
+		unsigned char* pucSum = m_pucSums + piJob[0] * tPixels;
+		m_pRawStack->SetFrame(piJob[0], pucSum);
 	}
 }
 
+void CRenderMrcStack::mClean(void)
+{
+	if(m_piJobs != 0L) delete[] m_piJobs;
+	if(m_pucSums != 0L) delete[] m_pucSums;
+	m_piJobs = 0L;
+	m_pucSums = 0L;
+	m_iNumJobs = 0;
+}
@@ -148,18 +148,52 @@ void CApplyRefs::mApplyRefs(cufftComplex* gCmpFrm, int iStream)
 {	
 	void* pvRawFrm = m_pRawStack->GetFrame(m_iFrame);
 	float* gfPadFrm = reinterpret_cast<float*>(gCmpFrm);
+	size_t tFmBytes = m_pRawStack->m_tFmBytes;
+	int iMode = m_pRawStack->m_iMode;
+	//----------------------------------------------------
+	// A packed frame with too many pixels over 15 is
+	// kept as 8-bit by CRawStack.
+	//----------------------------------------------------
+	unsigned char* pucDense = m_pRawStack->GetDense(m_iFrame);
+	if(pucDense != 0L)
+	{	pvRawFrm = pucDense;
+		tFmBytes = m_pRawStack->GetPixels();
+		iMode = Mrc::eMrcUChar;
+	}
 	//----------------------------------------------------
 	// Synchornize to make sure m_pvMrcFrames[iStream] is
 	// done with the previous operation.
 	//----------------------------------------------------
 	cudaStreamSynchronize(m_streams[iStream]);
-	memcpy(m_pvMrcFrames[iStream], pvRawFrm, m_pRawStack->m_tFmBytes);
-	//----------------
-	int* piCmpSize = ((MD::CStackBuffer*)m_pFrmBuffer)->m_aiCmpSize;
-	int aiPadSize[] = {piCmpSize[0] * 2, piCmpSize[1]};
-	int iMode = m_pRawStack->m_iMode;
+	memcpy(m_pvMrcFrames[iStream], pvRawFrm, tFmBytes);
 	//-----------------
 	m_aGAppRefsToFrame.DoIt(m_pvMrcFrames[iStream], iMode,
 	   gfPadFrm, m_streams[iStream]);
+	if(iMode == Mrc::eMrc4Bits) mApplySparse(gfPadFrm, tFmBytes, iStream);
+}
+
+//-------------------------------------------------------------------
+// 1. The sparse pairs of a packed frame are copied behind it in
+//    the pinned buffer, in several rounds if they do not fit.
+//-------------------------------------------------------------------
+void CApplyRefs::mApplySparse(float* gfPadFrm, size_t tOffset, int iStream)
+{
+	int iNumPairs = 0;
+	int* piPairs = m_pRawStack->GetSparse(m_iFrame, &iNumPairs);
+	if(iNumPairs <= 0) return;
+	//-----------------
+	size_t tStart = (tOffset + 7) / 8 * 8;
+	size_t tPairBytes = sizeof(int) * 2;
+	int iMaxPairs = (int)((m_pTmpBuffer->m_tFmBytes - tStart) / tPairBytes);
+	int* piPinned = (int*)((char*)m_pvMrcFrames[iStream] + tStart);
+	//-----------------
+	for(int i=0; i<iNumPairs; i+=iMaxPairs)
+	{	int iPairs = iNumPairs - i;
+		if(iPairs > iMaxPairs) iPairs = iMaxPairs;
+		if(i > 0) cudaStreamSynchronize(m_streams[iStream]);
+		memcpy(piPinned, piPairs + 2 * i, tPairBytes * iPairs);
+		m_aGAppRefsToFrame.DoSparse(piPinned, iPairs, 
+		   gfPadFrm, m_streams[iStream]);
+	}
 }
 
@@ -85,6 +85,12 @@ public:
 	  float* gfFrame,
 	  cudaStream_t stream=0
 	);
+	void DoSparse
+	( int* giPairs,  // {pixel index, count} in the MRC frame
+	  int iNumPairs,
+	  float* gfFrame,
+	  cudaStream_t stream=0
+	);
 	void DoShort
 	( short* gsFrm, 
 	  float* gfFrame,
@@ -120,13 +126,14 @@ private:
 	void mCorrectGpuFrames(void);
 	void mCorrectCpuFrames(void); 
 	void mApplyRefs(cufftComplex* gCmpFrm, int iStream);
+	void mApplySparse(float* gfPadFrm, size_t tOffset, int iStream);
 	//-----------------
 	int m_iNthGpu;
 	//-----------------
 	MD::CStackBuffer* m_pFrmBuffer;
 	MD::CStackBuffer* m_pTmpBuffer;
 	MD::CStackBuffer* m_pSumBuffer;
-	MD::CMrcStack* m_pRawStack;
+	MD::CRawStack* m_pRawStack;
 	float* m_gfGain;
 	float* m_gfDark;
 	int m_iFrame;
@@ -52,6 +52,35 @@ static __global__ void mGDoPkd
 	gfFrame[blockIdx.y * iPadX + x] = fVal;
 }
 
+//-------------------------------------------------------------------
+// 1. Overwrites the pixels of a packed frame that count more than
+//    15. Pixels cropped out of the frame are skipped.
+//-------------------------------------------------------------------
+static __global__ void mGDoSparse
+(	int* giPairs,
+	int iNumPairs,
+	float* gfGain,
+	float* gfDark,
+	float* gfFrame,
+	int iSizeX,
+	int iSizeY,
+	int iPadX
+)
+{	int i = blockIdx.x * blockDim.x + threadIdx.x;
+	if(i >= iNumPairs) return;
+	//---------------------
+	int iPixel = giPairs[2 * i];
+	int x = iPixel % giMrcSize[0] - (giMrcSize[0] - iSizeX) / 2;
+	int y = iPixel / giMrcSize[0] - (giMrcSize[1] - iSizeY) / 2;
+	if(x < 0 || x >= iSizeX || y < 0 || y >= iSizeY) return;
+	//---------------------
+	float fVal = (float)giPairs[2 * i + 1];
+	i = y * iPadX + x;
+	if(gfDark != 0L) fVal -= gfDark[i];
+	if(gfGain != 0L) fVal *= gfGain[i];
+	gfFrame[i] = fVal;
+}
+
 template <typename T>
 static __global__ void mGDoRaw
 (	T* gtFrame,
@@ -177,6 +206,20 @@ void GApplyRefsToFrame::DoPkd
 	  m_aiFrmSize[0], m_iPadSizeX );
 }
 
+void GApplyRefsToFrame::DoSparse
+(	int* giPairs,
+	int iNumPairs,
+	float* gfFrame,
+	cudaStream_t stream
+)
+{	if(iNumPairs <= 0) return;
+	dim3 aBlockDim(256, 1);
+	dim3 aGridDim((iNumPairs + aBlockDim.x - 1) / aBlockDim.x, 1);
+	mGDoSparse<<<aGridDim, aBlockDim, 0, stream>>>
+	( giPairs, iNumPairs, m_gfGain, m_gfDark, gfFrame,
+	  m_aiFrmSize[0], m_aiFrmSize[1], m_iPadSizeX );
+}
+
 void GApplyRefsToFrame::DoShort
 (	short* gsFrm,
 	float* gfFrame,
@@ -13,7 +13,7 @@ CLoadTiffHeader::CLoadTiffHeader(void)
 CLoadTiffHeader::~CLoadTiffHeader(void)
 {
 	if(m_pTiff == 0L) return;
-	TIFFCleanup(m_pTiff);
+	TIFFClose(m_pTiff);
 	m_pTiff = 0L;	
 }
 
@@ -23,8 +23,7 @@ bool CLoadTiffHeader::DoIt(int iFile)
 	m_fPixelSize = 0.0f;
 	memset(m_aiImgSize, 0, sizeof(m_aiImgSize));
 	//------------------------------------------
-	lseek64(iFile, 0, SEEK_SET);
-	m_pTiff = TIFFFdOpen(iFile, "\0", "r");
+	m_pTiff = COpenTiff::DoIt(iFile);
 	if(m_pTiff == 0L) return false;
 	//-----------------------------
 	m_bReadImgSize = mReadImageSize();
@@ -35,7 +34,7 @@ bool CLoadTiffHeader::DoIt(int iFile)
         //----------------------------
         mReadPixelSize();
    	//---------------
-	TIFFCleanup(m_pTiff);
+	TIFFClose(m_pTiff);
 	m_pTiff = 0L;
 	//-----------
 	if(!m_bReadImgSize) return false;
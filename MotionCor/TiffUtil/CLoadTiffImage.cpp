@@ -10,37 +10,73 @@ CLoadTiffImage::CLoadTiffImage(void)
 {
 	m_pTiff = 0L;
 	m_iImgBytes = 0;
+	m_iFile = -1;
+	m_pcBuf = 0L;
+	m_iBufBytes = 0;
     	memset(m_aiSize, 0, sizeof(m_aiSize));
 }
 
 CLoadTiffImage::~CLoadTiffImage(void)
 {
+	if(m_pcBuf != 0L) delete[] m_pcBuf;
+	m_pcBuf = 0L;
+	//-----------------
 	if(m_pTiff == 0L) return;
-	TIFFCleanup(m_pTiff);
+	TIFFClose(m_pTiff);
         m_pTiff = 0L;
 }
 
-bool CLoadTiffImage::SetFile(int iFile)
+//-------------------------------------------------------------------
+// 1. The directory offsets are indexed once here so that DoIt can
+//    jump to any directory with TIFFSetSubDirectory. Without the
+//    index TIFFSetDirectory walks the chain from the first IFD for
+//    every image, which is quadratic in the number of frames.
+//-------------------------------------------------------------------
+bool CLoadTiffImage::SetFile(int iFile, const char* pcCacheFile)
 {
 	bool bLoadHeader = m_aLoadHeader.DoIt(iFile);
 	if(!bLoadHeader) return false;
-	//----------------------------
-	m_iMode = m_aLoadHeader.GetMode();
-	if(m_iMode == Mrc::eMrcUChar) m_iPixelBytes = 1;
-	else if(m_iMode == Mrc::eMrcUCharEM) m_iPixelBytes = 1;
-	else if(m_iMode == Mrc::eMrcShort) m_iPixelBytes = 2;
-	else if(m_iMode == Mrc::eMrcUShort) m_iPixelBytes= 2;
-	else if(m_iMode == Mrc::eMrcFloat) m_iPixelBytes = 4;
-	else return false;
-	//----------------
-    	m_aLoadHeader.GetSize(m_aiSize, 3);
-    	m_iImgBytes = m_aiSize[0] * m_aiSize[1] * m_iPixelBytes;
-	//------------------------------------------------------
-    	lseek64(iFile, 0, SEEK_SET);
-    	m_pTiff = TIFFFdOpen(iFile, "\0", "r");
+	if(!mSetMode()) return false;
+	//-----------------
+	m_iFile = iFile;
+    	m_pTiff = COpenTiff::DoIt(iFile);
+	if(m_pTiff == 0L) return false;
+	//-----------------
+	m_aDirIndex.DoIt(m_pTiff, iFile, pcCacheFile);
 	return true;
 }
 
+//-------------------------------------------------------------------
+// 1. Takes the header and the directory index of pLoadTiffImage
+//    that has been set up on the same movie, so that each loading
+//    thread opens its own TIFF handle without scanning the file.
+// 2. iFile can be the descriptor of pLoadTiffImage or its dup.
+//-------------------------------------------------------------------
+bool CLoadTiffImage::SetFile(int iFile, CLoadTiffImage* pLoadTiffImage)
+{
+	m_aLoadHeader = pLoadTiffImage->m_aLoadHeader;
+	if(!mSetMode()) return false;
+	//-----------------
+	m_iFile = iFile;
+	m_pTiff = COpenTiff::DoIt(iFile);
+	if(m_pTiff == 0L) return false;
+	//-----------------
+	m_aDirIndex.Copy(&pLoadTiffImage->m_aDirIndex);
+	return true;
+}
+
+void CLoadTiffImage::Prefetch(int iNthImage, int iNumImages)
+{
+	if(m_iFile == -1) return;
+	m_aDirIndex.Prefetch(m_iFile, iNthImage, iNumImages);
+}
+
+int CLoadTiffImage::GetFileBytes(int iNthImage)
+{
+	if(iNthImage >= m_aDirIndex.m_iNumDirs) return 0;
+	return m_aDirIndex.GetDirBytes(iNthImage);
+}
+
 void* CLoadTiffImage::DoIt(int iNthImage)
 {
 	if(m_pTiff == 0L) return 0L;
@@ -68,17 +104,50 @@ bool CLoadTiffImage::DoIt(int iNthImage, void* pvImage)
 	return bSuccess;
 }
 
+bool CLoadTiffImage::mSetMode(void)
+{
+	m_iMode = m_aLoadHeader.GetMode();
+	if(m_iMode == Mrc::eMrcUChar) m_iPixelBytes = 1;
+	else if(m_iMode == Mrc::eMrcUCharEM) m_iPixelBytes = 1;
+	else if(m_iMode == Mrc::eMrcShort) m_iPixelBytes = 2;
+	else if(m_iMode == Mrc::eMrcUShort) m_iPixelBytes= 2;
+	else if(m_iMode == Mrc::eMrcFloat) m_iPixelBytes = 4;
+	else return false;
+	//----------------
+    	m_aLoadHeader.GetSize(m_aiSize, 3);
+    	m_iImgBytes = m_aiSize[0] * m_aiSize[1] * m_iPixelBytes;
+	return true;
+}
+
+char* CLoadTiffImage::mGetBuf(int iBytes)
+{
+	if(iBytes <= m_iBufBytes) return m_pcBuf;
+	if(m_pcBuf != 0L) delete[] m_pcBuf;
+	m_pcBuf = new char[iBytes];
+	m_iBufBytes = iBytes;
+	return m_pcBuf;
+}
+
+bool CLoadTiffImage::mSetDirectory(int iNthImage)
+{
+	if(iNthImage < m_aDirIndex.m_iNumDirs)
+	{	uint64_t ulOffset = m_aDirIndex.GetDirOffset(iNthImage);
+		if(TIFFSetSubDirectory(m_pTiff, ulOffset)) return true;
+	}
+	return TIFFSetDirectory(m_pTiff, iNthImage) != 0;
+}
+
 bool CLoadTiffImage::mReadByStrip
 (	int iNthImage, 
 	void* pvImage
 ) 
-{	TIFFSetDirectory(m_pTiff, iNthImage);
+{	if(!mSetDirectory(iNthImage)) return false;
 	//-----------------------------------
 	int iRowBytes = m_aiSize[0] * m_iPixelBytes;
 	int iRowsPerStrip = m_aLoadHeader.GetTileSizeY();
 	int iNumStrips = m_aLoadHeader.GetNumTilesY();
 	int iStripBytes = iRowsPerStrip * iRowBytes;
-	char* pcBuf = new char[iStripBytes];
+	char* pcBuf = mGetBuf(iStripBytes);
 	char* pcImg = (char*)pvImage;
 	//---------------------------
 	bool bSuccess = true;
@@ -105,7 +174,6 @@ bool CLoadTiffImage::mReadByStrip
 			memcpy(pcDst, pcSrc, iRowBytes);
 		}
 	}
-	if(pcBuf != 0L) delete[] pcBuf;
 	return bSuccess;
 }
 
@@ -113,14 +181,14 @@ bool CLoadTiffImage::mReadByTile
 (	int iNthImage,
 	void* pvImage
 )
-{	TIFFSetDirectory(m_pTiff, iNthImage);
+{	if(!mSetDirectory(iNthImage)) return false;
 	//-----------------------------------
 	int iNumTilesX = m_aLoadHeader.GetNumTilesX();
 	int iNumTilesY = m_aLoadHeader.GetNumTilesY();
 	int iTileSizeX = m_aLoadHeader.GetTileSizeX();
 	int iTileSizeY = m_aLoadHeader.GetTileSizeY();
 	int iTileBytes = iTileSizeX * iTileSizeY * m_iPixelBytes;
-	char* pcBuf = new char[iTileBytes];
+	char* pcBuf = mGetBuf(iTileBytes);
 	char* pcImg = (char*)pvImage;
 	//---------------------------
 	for(int iTileY=0; iTileY<iNumTilesY; iTileY++)
@@ -148,14 +216,14 @@ bool CLoadTiffImage::mReadByTile
 				* m_iPixelBytes;
 			for(int y=iStartY; y<=iEndY; y++)
 			{	char* pcSrc = pcBuf + (iEndY - y)
-					* iTileSizeX;
-				char* pcDst = pcImg + y * m_aiSize[0]
-					+ iStartX;
+					* iTileSizeX * m_iPixelBytes;
+				char* pcDst = pcImg + ((size_t)y 
+					* m_aiSize[0] + iStartX)
+					* m_iPixelBytes;
 				memcpy(pcDst, pcSrc, iLineBytes);
 			}
 		}
 	}
-	if(pcBuf != 0L) delete[] pcBuf;
 	return true;
 }
 
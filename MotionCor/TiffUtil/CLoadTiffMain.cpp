@@ -75,71 +75,129 @@ void CLoadTiffMain::mLoadHeader(void)
 	//-----------------------------------------------------------
 	int iIntMode = m_iMode;
 	if(pFmIntParam->bIntegrate()) iIntMode = Mrc::eMrcUChar;
+	//-----------------------------------------------
+	// 8-bit frames are counts and are 4-bit packed.
+	//-----------------------------------------------
+	if(m_iMode == Mrc::eMrcUChar || m_iMode == Mrc::eMrcUCharEM)
+	{	iIntMode = Mrc::eMrc4Bits;
+	}
 	pPackage->m_pRawStack->Create(iIntMode, m_aiStkSize);
 	//-----------------
 	printf("Rendered size & mode:  %d  %d  %d  %d\n", 
 	   m_aiStkSize[0], m_aiStkSize[1], m_aiStkSize[2], m_iMode);
 }
 
+//-------------------------------------------------------------------
+// 1. Frames are decoded by a pool of CLoadTiffThread unless 8-bit
+//    frames are to be integrated on GPU (-CpuFmInt 0) or non-8-bit
+//    frames are to be integrated.
+//-------------------------------------------------------------------
 void CLoadTiffMain::mLoadStack(void)
 {
 	Util_Time aTimer;
 	aTimer.Measure();
 	nvtxRangePushA("CLoadTiffMain");
 	//-----------------
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	char acCacheFile[512] = {'\0'};
+	bool bCache = CTiffDirIndex::GetCacheFile(pPackage->m_acMoviePath,
+	   acCacheFile);
+	//-----------------
 	m_pLoadTiffImage = new CLoadTiffImage;
-	m_pLoadTiffImage->SetFile(m_iFile);
+	m_pLoadTiffImage->SetFile(m_iFile, bCache ? acCacheFile : 0L);
+	m_iNumRawFms = m_pLoadTiffImage->m_aiSize[2];
+	m_tFileBytes = 0;
+	for(int i=0; i<m_iNumRawFms; i++)
+	{	m_tFileBytes += m_pLoadTiffImage->GetFileBytes(i);
+	}
 	//-----------------
+	CMcInput* pMcInput = CMcInput::GetInstance();
+	bool bByte = (m_iMode == Mrc::eMrcUChar || 
+	   m_iMode == Mrc::eMrcUCharEM);
 	MMD::CFmIntParam* pFmIntParam = 
 	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
-	if(pFmIntParam->bIntegrate()) mLoadInt();
-	else mLoadSingle();
+	m_iNumThreads = 1;
+	if(!pFmIntParam->bIntegrate()) mLoadThreads();
+	else if(pMcInput->m_iCpuFmInt != 0 && bByte) mLoadThreads();
+	else mLoadInt();
 	//-----------------
 	delete m_pLoadTiffImage;
 	m_pLoadTiffImage = 0L;
 	//-----------------
 	nvtxRangePop();
 	m_fLoadTime = aTimer.GetElapsedSeconds();
+	float fSecs = m_fLoadTime + 1e-6f;
+	printf("TIFF loaded: %d frames, %d threads, %.2f sec, "
+	   "%.1f frames/s, %.1f MB/s\n\n", m_iNumRawFms, m_iNumThreads, 
+	   m_fLoadTime, m_iNumRawFms / fSecs, m_tFileBytes / fSecs / 1.0e6);
 }
 
-void CLoadTiffMain::mLoadSingle(void)
+//-------------------------------------------------------------------
+// 1. The cores are shared evenly among the GPU threads since each
+//    of them may load its own movie.
+//-------------------------------------------------------------------
+void CLoadTiffMain::mLoadThreads(void)
 {
 	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
-	MMD::CFmIntParam* pFmIntParam = 
-	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
 	MD::CMrcStack* pRawStack = pPackage->m_pRawStack;
 	//-----------------
-	for(int i=0; i<pRawStack->m_aiStkSize[2]; i++)
-	{	int iIntFmStart = pFmIntParam->GetIntFmStart(i);
-		void* pvFrame = pPackage->m_pRawStack->GetFrame(i);
-		m_bLoaded = m_pLoadTiffImage->DoIt(iIntFmStart, 
-		   (char*)pvFrame);
-		if(!m_bLoaded) break;
+	CInput* pInput = CInput::GetInstance();
+	int iNumGpus = (pInput->m_iNumGpus > 0) ? pInput->m_iNumGpus : 1;
+	m_iNumThreads = get_nprocs() / iNumGpus;
+	if(m_iNumThreads > pRawStack->m_aiStkSize[2]) 
+	{	m_iNumThreads = pRawStack->m_aiStkSize[2];
+	}
+	if(m_iNumThreads < 1) m_iNumThreads = 1;
+	//-----------------
+	posix_fadvise(m_iFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+	MMU::CNextItem aNextFrame;
+	aNextFrame.Create(pRawStack->m_aiStkSize[2]);
+	CLoadTiffThread* pThreads = new CLoadTiffThread[m_iNumThreads];
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].Run(m_pLoadTiffImage, m_iFile, 
+		   &aNextFrame, m_iNthGpu);
+	}
+	//-----------------
+	for(int i=0; i<m_iNumThreads; i++)
+	{	pThreads[i].WaitForExit(-1.0f);
+		if(!pThreads[i].m_bLoaded) m_bLoaded = false;
 	}
+	delete[] pThreads;
 }
 
 void CLoadTiffMain::mLoadInt(void)
 {
 	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
-	MD::CMrcStack* pRawStack = pPackage->m_pRawStack;
+	MD::CRawStack* pRawStack = pPackage->m_pRawStack;
 	MMD::CFmIntParam* pFmIntParam = 
 	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
-	//-----------------
+	//-----------------------------------------------
+	// A packed stack is rendered through an 8-bit
+	// frame that is then packed into the stack.
+	//-----------------------------------------------
+	bool bPacked = pRawStack->bPacked();
 	size_t tFmBytes = pRawStack->m_tFmBytes;
+	unsigned char* pucFrm = 0L;
+	if(bPacked)
+	{	tFmBytes = pRawStack->GetPixels();
+		pucFrm = new unsigned char[tFmBytes];
+	}
 	unsigned char *gucRaw = 0L, *gucSum = 0L;
 	cudaMalloc(&gucSum, tFmBytes);
 	cudaMalloc(&gucRaw, tFmBytes);
 	//-----------------
 	for(int i=0; i<pRawStack->m_aiStkSize[2]; i++)
 	{	void* pvIntFm = pRawStack->GetFrame(i);
+		if(bPacked) pvIntFm = pucFrm;
 		//----------------
 		int iIntFmStart = pFmIntParam->GetIntFmStart(i);
 		int iIntFmSize = pFmIntParam->GetIntFmSize(i);
 		m_bLoaded = m_pLoadTiffImage->DoIt(iIntFmStart, pvIntFm);
 		//----------------
 		if(iIntFmSize == 1)
-		{	if(m_bLoaded) continue;
-			else break;
+		{	if(!m_bLoaded) break;
+			if(bPacked) pRawStack->SetFrame(i, pucFrm);
+			continue;
 		}
 		//----------------
 		cudaMemcpy(gucSum, pvIntFm, tFmBytes, cudaMemcpyDefault);
@@ -157,7 +215,9 @@ void CLoadTiffMain::mLoadInt(void)
 		}
 		if(!m_bLoaded) break;
 		cudaMemcpy(pvIntFm, gucSum, tFmBytes, cudaMemcpyDefault);
+		if(bPacked) pRawStack->SetFrame(i, pucFrm);
 	}
+	if(pucFrm != 0L) delete[] pucFrm;
 	cudaFree(gucRaw);
 	cudaFree(gucSum);
 }
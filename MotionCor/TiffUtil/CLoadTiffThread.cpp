@@ -0,0 +1,113 @@
+#include "CTiffUtilInc.h"
+#include "../DataUtil/CDataUtilInc.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MotionCor::TiffUtil;
+namespace MMD = McAreTomo::MotionCor::DataUtil;
+
+CLoadTiffThread::CLoadTiffThread(void)
+{
+	m_pLoadTiffImage = 0L;
+	m_pucBuf = 0L;
+	m_pucFrm = 0L;
+	m_iFile = -1;
+	m_bLoaded = false;
+}
+
+CLoadTiffThread::~CLoadTiffThread(void)
+{
+	if(m_pLoadTiffImage != 0L) delete m_pLoadTiffImage;
+	if(m_pucBuf != 0L) delete[] m_pucBuf;
+	if(m_pucFrm != 0L) delete[] m_pucFrm;
+	if(m_iFile != -1) close(m_iFile);
+}
+
+void CLoadTiffThread::Run
+(	CLoadTiffImage* pLoadTiffImage,
+	int iFile,
+	MMU::CNextItem* pNextFrame,
+	int iNthGpu
+)
+{	m_pSrcImage = pLoadTiffImage;
+	m_iFile = dup(iFile);
+	m_pNextFrame = pNextFrame;
+	m_iNthGpu = iNthGpu;
+	m_bLoaded = true;
+	this->Start();
+}
+
+void CLoadTiffThread::ThreadMain(void)
+{
+	m_pLoadTiffImage = new CLoadTiffImage;
+	if(m_iFile == -1 || !m_pLoadTiffImage->SetFile(m_iFile, m_pSrcImage))
+	{	m_bLoaded = false;
+		return;
+	}
+	//-----------------
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	MMD::CFmIntParam* pFmIntParam = 
+	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
+	MD::CRawStack* pRawStack = pPackage->m_pRawStack;
+	if(pFmIntParam->bIntegrate())
+	{	m_pucBuf = new unsigned char[pRawStack->GetPixels()];
+	}
+	//-----------------------------------------------
+	// 4-bit TIFF frames are loaded packed as they are.
+	//-----------------------------------------------
+	if(pRawStack->bPacked() && 
+	   m_pLoadTiffImage->m_iMode != Mrc::eMrc4Bits)
+	{	m_pucFrm = new unsigned char[pRawStack->GetPixels()];
+	}
+	//-----------------
+	int iFrame = m_pNextFrame->GetNext();
+	while(iFrame >= 0)
+	{	int iNextFrame = m_pNextFrame->GetNext();
+		mPrefetch(iNextFrame);
+		if(!mLoadFrame(iFrame))
+		{	m_bLoaded = false;
+			break;
+		}
+		iFrame = iNextFrame;
+	}
+}
+
+bool CLoadTiffThread::mLoadFrame(int iFrame)
+{
+	MD::CMcPackage* pPackage = MD::CMcPackage::GetInstance(m_iNthGpu);
+	MD::CRawStack* pRawStack = pPackage->m_pRawStack;
+	MMD::CFmIntParam* pFmIntParam = 
+	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
+	//-----------------
+	int iIntFmStart = pFmIntParam->GetIntFmStart(iFrame);
+	int iIntFmSize = pFmIntParam->bIntegrate() ?
+	   pFmIntParam->GetIntFmSize(iFrame) : 1;
+	void* pvFrame = pRawStack->GetFrame(iFrame);
+	if(m_pucFrm != 0L) pvFrame = m_pucFrm;
+	if(!m_pLoadTiffImage->DoIt(iIntFmStart, pvFrame)) return false;
+	//-----------------
+	MU::CAddFrames aAddFrames;
+	for(int i=1; i<iIntFmSize; i++)
+	{	if(!m_pLoadTiffImage->DoIt(iIntFmStart + i, m_pucBuf)) 
+		{	return false;
+		}
+		aAddFrames.DoIt((unsigned char*)pvFrame, m_pucBuf, 
+		   (unsigned char*)pvFrame, pRawStack->m_aiStkSize);
+	}
+	if(m_pucFrm != 0L) pRawStack->SetFrame(iFrame, m_pucFrm);
+	return true;
+}
+
+void CLoadTiffThread::mPrefetch(int iFrame)
+{
+	if(iFrame < 0) return;
+	MMD::CFmIntParam* pFmIntParam = 
+	   MMD::CFmIntParam::GetInstance(m_iNthGpu);
+	int iIntFmStart = pFmIntParam->GetIntFmStart(iFrame);
+	int iIntFmSize = pFmIntParam->bIntegrate() ?
+	   pFmIntParam->GetIntFmSize(iFrame) : 1;
+	m_pLoadTiffImage->Prefetch(iIntFmStart, iIntFmSize);
+}
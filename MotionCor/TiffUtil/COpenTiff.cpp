@@ -0,0 +1,94 @@
+#include "CTiffUtilInc.h"
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MotionCor::TiffUtil;
+
+typedef struct
+{	int iFile;
+	toff_t tOffset;
+} CTiffHandle;
+
+TIFF* COpenTiff::DoIt(int iFile)
+{
+	CTiffHandle* pHandle = new CTiffHandle;
+	pHandle->iFile = iFile;
+	pHandle->tOffset = 0;
+	//-----------------
+	TIFF* pTiff = TIFFClientOpen("TiffFile", "r", (thandle_t)pHandle,
+	   mRead, mWrite, mSeek, mClose, mSize, mMap, mUnmap);
+	if(pTiff == 0L) delete pHandle;
+	return pTiff;
+}
+
+tmsize_t COpenTiff::mRead
+(	thandle_t pHandle, 
+	void* pvBuf, 
+	tmsize_t tSize
+)
+{	CTiffHandle* pTiffHandle = (CTiffHandle*)pHandle;
+	char* pcBuf = (char*)pvBuf;
+	tmsize_t tRead = 0;
+	while(tRead < tSize)
+	{	ssize_t tBytes = pread(pTiffHandle->iFile, pcBuf + tRead,
+		   tSize - tRead, (off_t)pTiffHandle->tOffset);
+		if(tBytes <= 0) break;
+		tRead += tBytes;
+		pTiffHandle->tOffset += tBytes;
+	}
+	return tRead;
+}
+
+tmsize_t COpenTiff::mWrite
+(	thandle_t pHandle, 
+	void* pvBuf, 
+	tmsize_t tSize
+)
+{	return 0;
+}
+
+toff_t COpenTiff::mSeek
+(	thandle_t pHandle, 
+	toff_t tOffset, 
+	int iWhence
+)
+{	CTiffHandle* pTiffHandle = (CTiffHandle*)pHandle;
+	if(iWhence == SEEK_SET) pTiffHandle->tOffset = tOffset;
+	else if(iWhence == SEEK_CUR) pTiffHandle->tOffset += tOffset;
+	else if(iWhence == SEEK_END) 
+	{	pTiffHandle->tOffset = mSize(pHandle) + tOffset;
+	}
+	return pTiffHandle->tOffset;
+}
+
+int COpenTiff::mClose(thandle_t pHandle)
+{
+	delete (CTiffHandle*)pHandle;
+	return 0;
+}
+
+toff_t COpenTiff::mSize(thandle_t pHandle)
+{
+	CTiffHandle* pTiffHandle = (CTiffHandle*)pHandle;
+	struct stat aStat;
+	if(fstat(pTiffHandle->iFile, &aStat) != 0) return 0;
+	return (toff_t)aStat.st_size;
+}
+
+int COpenTiff::mMap
+(	thandle_t pHandle, 
+	void** ppvBase, 
+	toff_t* ptSize
+)
+{	return 0;
+}
+
+void COpenTiff::mUnmap
+(	thandle_t pHandle, 
+	void* pvBase, 
+	toff_t tSize
+)
+{
+}
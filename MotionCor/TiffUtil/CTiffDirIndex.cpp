@@ -0,0 +1,354 @@
+#include "CTiffUtilInc.h"
+#include <memory.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdio.h>
+
+using namespace McAreTomo::MotionCor::TiffUtil;
+
+static const char* s_pcCacheMagic = "TIFFIDX1";
+
+bool CTiffDirIndex::GetCacheFile
+(	const char* pcTiffFile,
+	char* pcCacheFile
+)
+{	CInput* pInput = CInput::GetInstance();
+	if(strlen(pInput->m_acTmpDir) == 0) return false;
+	//-----------------
+	const char* pcName = strrchr(pcTiffFile, '/');
+	pcName = (pcName == 0L) ? pcTiffFile : pcName + 1;
+	strcpy(pcCacheFile, pInput->m_acTmpDir);
+	strcat(pcCacheFile, pcName);
+	strcat(pcCacheFile, ".idx");
+	return true;
+}
+
+CTiffDirIndex::CTiffDirIndex(void)
+{
+	m_ptDirOffsets = 0L;
+	m_piStripStarts = 0L;
+	m_ptStripOffsets = 0L;
+	m_piStripBytes = 0L;
+	m_iNumDirs = 0;
+	m_iNumStrips = 0;
+	m_iMaxDirs = 0;
+	m_iMaxStrips = 0;
+}
+
+CTiffDirIndex::~CTiffDirIndex(void)
+{
+	this->Clean();
+}
+
+void CTiffDirIndex::Clean(void)
+{
+	if(m_ptDirOffsets != 0L) delete[] m_ptDirOffsets;
+	if(m_piStripStarts != 0L) delete[] m_piStripStarts;
+	if(m_ptStripOffsets != 0L) delete[] m_ptStripOffsets;
+	if(m_piStripBytes != 0L) delete[] m_piStripBytes;
+	m_ptDirOffsets = 0L;
+	m_piStripStarts = 0L;
+	m_ptStripOffsets = 0L;
+	m_piStripBytes = 0L;
+	m_iNumDirs = 0;
+	m_iNumStrips = 0;
+	m_iMaxDirs = 0;
+	m_iMaxStrips = 0;
+}
+
+bool CTiffDirIndex::DoIt(int iFile, const char* pcCacheFile)
+{
+	if(pcCacheFile != 0L && this->Load(pcCacheFile, iFile)) return true;
+	//-----------------
+	TIFF* pTiff = COpenTiff::DoIt(iFile);
+	if(pTiff == 0L) return false;
+	bool bSuccess = this->DoIt(pTiff);
+	TIFFClose(pTiff);
+	//-----------------
+	if(bSuccess && pcCacheFile != 0L) this->Save(pcCacheFile, iFile);
+	return bSuccess;
+}
+
+bool CTiffDirIndex::DoIt
+(	TIFF* pTiff, 
+	int iFile, 
+	const char* pcCacheFile
+)
+{	if(pcCacheFile != 0L && this->Load(pcCacheFile, iFile)) return true;
+	bool bSuccess = this->DoIt(pTiff);
+	if(bSuccess && pcCacheFile != 0L) this->Save(pcCacheFile, iFile);
+	return bSuccess;
+}
+
+//-------------------------------------------------------------------
+// 1. Tiled images are indexed by tiles since libtiff returns the
+//    tile offsets and byte counts for the strip tags.
+//-------------------------------------------------------------------
+bool CTiffDirIndex::DoIt(TIFF* pTiff)
+{
+	this->Clean();
+	if(!TIFFSetDirectory(pTiff, 0)) return false;
+	//-----------------
+	while(true)
+	{	int iNumStrips = TIFFIsTiled(pTiff) ? 
+		   TIFFNumberOfTiles(pTiff) : TIFFNumberOfStrips(pTiff);
+		mExpand(m_iNumDirs + 1, m_iNumStrips + iNumStrips);
+		//----------------
+		toff_t* pOffsets = 0L;
+		toff_t* pBytes = 0L;
+		TIFFGetField(pTiff, TIFFTAG_STRIPOFFSETS, &pOffsets);
+		TIFFGetField(pTiff, TIFFTAG_STRIPBYTECOUNTS, &pBytes);
+		if(pOffsets == 0L || pBytes == 0L) 
+		{	this->Clean();
+			return false;
+		}
+		//----------------
+		m_ptDirOffsets[m_iNumDirs] = (size_t)TIFFCurrentDirOffset(pTiff);
+		m_piStripStarts[m_iNumDirs] = m_iNumStrips;
+		for(int i=0; i<iNumStrips; i++)
+		{	m_ptStripOffsets[m_iNumStrips + i] = (size_t)pOffsets[i];
+			m_piStripBytes[m_iNumStrips + i] = (int)pBytes[i];
+		}
+		m_iNumStrips += iNumStrips;
+		m_iNumDirs += 1;
+		m_piStripStarts[m_iNumDirs] = m_iNumStrips;
+		//----------------
+		if(!TIFFReadDirectory(pTiff)) break;
+	}
+	return true;
+}
+
+void CTiffDirIndex::Copy(CTiffDirIndex* pDirIndex)
+{
+	this->Clean();
+	if(pDirIndex->m_iNumDirs <= 0) return;
+	mExpand(pDirIndex->m_iNumDirs, pDirIndex->m_iNumStrips);
+	m_iNumDirs = pDirIndex->m_iNumDirs;
+	m_iNumStrips = pDirIndex->m_iNumStrips;
+	memcpy(m_ptDirOffsets, pDirIndex->m_ptDirOffsets, 
+	   sizeof(size_t) * m_iNumDirs);
+	memcpy(m_piStripStarts, pDirIndex->m_piStripStarts,
+	   sizeof(int) * (m_iNumDirs + 1));
+	memcpy(m_ptStripOffsets, pDirIndex->m_ptStripOffsets,
+	   sizeof(size_t) * m_iNumStrips);
+	memcpy(m_piStripBytes, pDirIndex->m_piStripBytes,
+	   sizeof(int) * m_iNumStrips);
+}
+
+//-------------------------------------------------------------------
+// 1. Asks the kernel to start reading the strips of iNumDirs
+//    directories in the background. The strips of consecutive
+//    directories are usually contiguous and requested as one range.
+//-------------------------------------------------------------------
+void CTiffDirIndex::Prefetch(int iFile, int iDir, int iNumDirs)
+{
+	if(iDir < 0 || iDir >= m_iNumDirs) return;
+	int iLastDir = iDir + iNumDirs;
+	if(iLastDir > m_iNumDirs) iLastDir = m_iNumDirs;
+	int iStart = m_piStripStarts[iDir];
+	int iEnd = m_piStripStarts[iLastDir];
+	if(iStart >= iEnd) return;
+	//-----------------
+	size_t tMin = m_ptStripOffsets[iStart];
+	size_t tMax = tMin;
+	for(int i=iStart; i<iEnd; i++)
+	{	size_t tEnd = m_ptStripOffsets[i] + m_piStripBytes[i];
+		if(m_ptStripOffsets[i] < tMin) tMin = m_ptStripOffsets[i];
+		if(tEnd > tMax) tMax = tEnd;
+	}
+	posix_fadvise(iFile, (off_t)tMin, (off_t)(tMax - tMin),
+	   POSIX_FADV_WILLNEED);
+}
+
+size_t CTiffDirIndex::GetDirOffset(int iDir)
+{
+	return m_ptDirOffsets[iDir];
+}
+
+int CTiffDirIndex::GetNumStrips(int iDir)
+{
+	return m_piStripStarts[iDir + 1] - m_piStripStarts[iDir];
+}
+
+size_t CTiffDirIndex::GetStripOffset(int iDir, int iStrip)
+{
+	return m_ptStripOffsets[m_piStripStarts[iDir] + iStrip];
+}
+
+int CTiffDirIndex::GetStripBytes(int iDir, int iStrip)
+{
+	return m_piStripBytes[m_piStripStarts[iDir] + iStrip];
+}
+
+int CTiffDirIndex::GetDirBytes(int iDir)
+{
+	int iBytes = 0;
+	for(int i=m_piStripStarts[iDir]; i<m_piStripStarts[iDir+1]; i++)
+	{	iBytes += m_piStripBytes[i];
+	}
+	return iBytes;
+}
+
+int CTiffDirIndex::GetMaxDirBytes(void)
+{
+	int iMaxBytes = 0;
+	for(int i=0; i<m_iNumDirs; i++)
+	{	int iBytes = this->GetDirBytes(i);
+		if(iBytes > iMaxBytes) iMaxBytes = iBytes;
+	}
+	return iMaxBytes;
+}
+
+//-------------------------------------------------------------------
+// 1. Reads the raw strips of a directory back to back into pucBuf
+//    that must hold GetDirBytes(iDir) bytes. pread is used so that
+//    several threads can share the file descriptor.
+//-------------------------------------------------------------------
+bool CTiffDirIndex::ReadDir
+(	int iFile, 
+	int iDir, 
+	unsigned char* pucBuf
+)
+{	int iBytesRead = 0;
+	for(int i=m_piStripStarts[iDir]; i<m_piStripStarts[iDir+1]; i++)
+	{	size_t tOffset = m_ptStripOffsets[i];
+		int iLeft = m_piStripBytes[i];
+		while(iLeft > 0)
+		{	ssize_t tRead = pread(iFile, pucBuf + iBytesRead, 
+			   iLeft, (off_t)tOffset);
+			if(tRead <= 0) return false;
+			iLeft -= (int)tRead;
+			tOffset += tRead;
+			iBytesRead += (int)tRead;
+		}
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. The cache stores the magic, the key of the TIFF file, the
+//    numbers of directories and strips followed by the arrays.
+//-------------------------------------------------------------------
+bool CTiffDirIndex::Load(const char* pcCacheFile, int iFile)
+{
+	this->Clean();
+	FILE* pFile = fopen(pcCacheFile, "rb");
+	if(pFile == 0L) return false;
+	//-----------------
+	char acMagic[8] = {0};
+	long alKey[3] = {0}, alFileKey[3] = {0};
+	int aiNums[2] = {0};
+	fread(acMagic, sizeof(char), 8, pFile);
+	fread(alKey, sizeof(long), 3, pFile);
+	size_t tRead = fread(aiNums, sizeof(int), 2, pFile);
+	mGetFileKey(iFile, alFileKey);
+	//-----------------
+	bool bValid = (tRead == 2) && (aiNums[0] > 0) && (aiNums[1] > 0);
+	if(memcmp(acMagic, s_pcCacheMagic, 8) != 0) bValid = false;
+	if(memcmp(alKey, alFileKey, sizeof(alKey)) != 0) bValid = false;
+	if(!bValid)
+	{	fclose(pFile);
+		return false;
+	}
+	//-----------------
+	mExpand(aiNums[0], aiNums[1]);
+	tRead = fread(m_ptDirOffsets, sizeof(size_t), aiNums[0], pFile);
+	tRead += fread(m_piStripStarts, sizeof(int), aiNums[0] + 1, pFile);
+	tRead += fread(m_ptStripOffsets, sizeof(size_t), aiNums[1], pFile);
+	tRead += fread(m_piStripBytes, sizeof(int), aiNums[1], pFile);
+	fclose(pFile);
+	//-----------------
+	if(tRead != (size_t)(aiNums[0] * 2 + 1 + aiNums[1] * 2))
+	{	this->Clean();
+		return false;
+	}
+	m_iNumDirs = aiNums[0];
+	m_iNumStrips = aiNums[1];
+	return true;
+}
+
+//-------------------------------------------------------------------
+// 1. Written to a temporary file first and then renamed so that
+//    a concurrent reader never sees a partial cache.
+//-------------------------------------------------------------------
+bool CTiffDirIndex::Save(const char* pcCacheFile, int iFile)
+{
+	if(m_iNumDirs <= 0) return false;
+	char acTmpFile[512] = {'\0'};
+	snprintf(acTmpFile, sizeof(acTmpFile), "%s.%d.%lx", pcCacheFile,
+	   getpid(), (unsigned long)pthread_self());
+	FILE* pFile = fopen(acTmpFile, "wb");
+	if(pFile == 0L) return false;
+	//-----------------
+	long alKey[3] = {0};
+	int aiNums[] = {m_iNumDirs, m_iNumStrips};
+	mGetFileKey(iFile, alKey);
+	size_t tWritten = fwrite(s_pcCacheMagic, sizeof(char), 8, pFile);
+	tWritten += fwrite(alKey, sizeof(long), 3, pFile);
+	tWritten += fwrite(aiNums, sizeof(int), 2, pFile);
+	tWritten += fwrite(m_ptDirOffsets, sizeof(size_t), 
+	   m_iNumDirs, pFile);
+	tWritten += fwrite(m_piStripStarts, sizeof(int), 
+	   m_iNumDirs + 1, pFile);
+	tWritten += fwrite(m_ptStripOffsets, sizeof(size_t), 
+	   m_iNumStrips, pFile);
+	tWritten += fwrite(m_piStripBytes, sizeof(int), 
+	   m_iNumStrips, pFile);
+	bool bSuccess = (fclose(pFile) == 0);
+	//-----------------
+	size_t tExpected = 13 + m_iNumDirs * 2 + 1 + m_iNumStrips * 2;
+	if(tWritten != tExpected) bSuccess = false;
+	if(bSuccess) bSuccess = (rename(acTmpFile, pcCacheFile) == 0);
+	if(!bSuccess) remove(acTmpFile);
+	return bSuccess;
+}
+
+void CTiffDirIndex::mGetFileKey(int iFile, long* plKey)
+{
+	struct stat aStat;
+	memset(plKey, 0, sizeof(long) * 3);
+	if(fstat(iFile, &aStat) != 0) return;
+	plKey[0] = (long)aStat.st_size;
+	plKey[1] = (long)aStat.st_mtim.tv_sec;
+	plKey[2] = (long)aStat.st_mtim.tv_nsec;
+}
+
+void CTiffDirIndex::mExpand(int iNumDirs, int iNumStrips)
+{
+	if(iNumDirs + 1 > m_iMaxDirs)
+	{	int iMaxDirs = (iNumDirs + 1) * 2;
+		size_t* ptDirOffsets = new size_t[iMaxDirs];
+		int* piStripStarts = new int[iMaxDirs];
+		if(m_iNumDirs > 0)
+		{	memcpy(ptDirOffsets, m_ptDirOffsets, 
+			   sizeof(size_t) * m_iNumDirs);
+			memcpy(piStripStarts, m_piStripStarts, 
+			   sizeof(int) * (m_iNumDirs + 1));
+		}
+		if(m_ptDirOffsets != 0L) delete[] m_ptDirOffsets;
+		if(m_piStripStarts != 0L) delete[] m_piStripStarts;
+		m_ptDirOffsets = ptDirOffsets;
+		m_piStripStarts = piStripStarts;
+		m_iMaxDirs = iMaxDirs;
+	}
+	//-----------------
+	if(iNumStrips > m_iMaxStrips)
+	{	int iMaxStrips = iNumStrips * 2;
+		size_t* ptStripOffsets = new size_t[iMaxStrips];
+		int* piStripBytes = new int[iMaxStrips];
+		if(m_iNumStrips > 0)
+		{	memcpy(ptStripOffsets, m_ptStripOffsets,
+			   sizeof(size_t) * m_iNumStrips);
+			memcpy(piStripBytes, m_piStripBytes,
+			   sizeof(int) * m_iNumStrips);
+		}
+		if(m_ptStripOffsets != 0L) delete[] m_ptStripOffsets;
+		if(m_piStripBytes != 0L) delete[] m_piStripBytes;
+		m_ptStripOffsets = ptStripOffsets;
+		m_piStripBytes = piStripBytes;
+		m_iMaxStrips = iMaxStrips;
+	}
+}
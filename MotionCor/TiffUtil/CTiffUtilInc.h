@@ -1,10 +1,79 @@
 #pragma once
 #include "../CMotionCorInc.h"
+#include "../Util/CUtilInc.h"
 #include <tiffio.h>
 #include <queue>
 
 namespace McAreTomo::MotionCor::TiffUtil
 {
+//-------------------------------------------------------------------
+// 1. Opens a read-only TIFF handle on a file descriptor. Unlike
+//    TIFFFdOpen, the handle keeps its own file offset and reads with
+//    pread, so that several handles, each used by one thread, can
+//    share a descriptor or its dup.
+// 2. The handle must be freed with TIFFClose. The descriptor is not
+//    closed.
+//-------------------------------------------------------------------
+class COpenTiff
+{
+public:
+	static TIFF* DoIt(int iFile);
+private:
+	static tmsize_t mRead(thandle_t pHandle, void* pvBuf, tmsize_t tSize);
+	static tmsize_t mWrite(thandle_t pHandle, void* pvBuf, tmsize_t tSize);
+	static toff_t mSeek(thandle_t pHandle, toff_t tOffset, int iWhence);
+	static int mClose(thandle_t pHandle);
+	static toff_t mSize(thandle_t pHandle);
+	static int mMap(thandle_t pHandle, void** ppvBase, toff_t* ptSize);
+	static void mUnmap(thandle_t pHandle, void* pvBase, toff_t tSize);
+};
+
+//-------------------------------------------------------------------
+// 1. Offsets of the image file directories (IFD) and of their
+//    strips collected in one forward pass over the IFD chain.
+// 2. Strips of a directory can then be read with pread without
+//    TIFFSetDirectory walking the chain from the first IFD. A
+//    directory can also be loaded with TIFFSetSubDirectory.
+// 3. When a cache file is given, the index is loaded from it if
+//    the cache matches the size and modification time of the TIFF
+//    file. Otherwise the index is built and saved into the cache.
+//    GetCacheFile places the cache files in -TmpDir and returns
+//    false if -TmpDir is not given.
+//-------------------------------------------------------------------
+class CTiffDirIndex
+{
+public:
+	static bool GetCacheFile(const char* pcTiffFile, char* pcCacheFile);
+	CTiffDirIndex(void);
+	~CTiffDirIndex(void);
+	void Clean(void);
+	bool DoIt(TIFF* pTiff);
+	bool DoIt(int iFile, const char* pcCacheFile = 0L);
+	bool DoIt(TIFF* pTiff, int iFile, const char* pcCacheFile);
+	bool Load(const char* pcCacheFile, int iFile);
+	bool Save(const char* pcCacheFile, int iFile);
+	void Copy(CTiffDirIndex* pDirIndex);
+	void Prefetch(int iFile, int iDir, int iNumDirs);
+	size_t GetDirOffset(int iDir);
+	int GetNumStrips(int iDir);
+	size_t GetStripOffset(int iDir, int iStrip);
+	int GetStripBytes(int iDir, int iStrip);
+	int GetDirBytes(int iDir);     // sum of all strips
+	int GetMaxDirBytes(void);
+	bool ReadDir(int iFile, int iDir, unsigned char* pucBuf);
+	int m_iNumDirs;
+private:
+	void mExpand(int iNumDirs, int iNumStrips);
+	void mGetFileKey(int iFile, long* plKey);
+	size_t* m_ptDirOffsets;
+	int* m_piStripStarts;     // first strip of each directory
+	size_t* m_ptStripOffsets;
+	int* m_piStripBytes;
+	int m_iNumStrips;
+	int m_iMaxDirs;
+	int m_iMaxStrips;
+};
+
 class CLoadTiffHeader
 {
 public:
@@ -46,17 +115,65 @@ class CLoadTiffImage
 public:
         CLoadTiffImage(void);
         ~CLoadTiffImage(void);
-        bool SetFile(int iFile);
+        bool SetFile(int iFile, const char* pcCacheFile = 0L);
+	bool SetFile(int iFile, CLoadTiffImage* pLoadTiffImage);
         void* DoIt(int iNthImage);
         bool DoIt(int iNthImage, void* pvImage);
+	void Prefetch(int iNthImage, int iNumImages);
+	int GetFileBytes(int iNthImage);  // compressed bytes in file
 	int m_iMode;
 	int m_aiSize[3];
 private:
+	bool mSetMode(void);
+	bool mSetDirectory(int iNthImage);
 	bool mReadByStrip(int iNthImage, void* pvImage);
 	bool mReadByTile(int iNthImage, void* pvImage);
+	char* mGetBuf(int iBytes);
         TIFF* m_pTiff;
 	CLoadTiffHeader m_aLoadHeader;
+	CTiffDirIndex m_aDirIndex;
         int m_iPixelBytes, m_iImgBytes;
+	int m_iFile;
+	char* m_pcBuf;     // strip or tile buffer reused by images
+	int m_iBufBytes;
+};
+
+//-------------------------------------------------------------------
+// 1. Worker of CLoadTiffMain. Each thread owns a CLoadTiffImage on a
+//    dup of the movie descriptor and pulls rendered frames from the
+//    shared CNextItem, so disjoint frames are decoded concurrently.
+// 2. When frames are integrated, which is done only for 8-bit
+//    movies, the first raw frame is decoded into the rendered frame
+//    and the others into the thread's buffer that is then added
+//    with MU::CAddFrames.
+// 3. The raw frames of the next rendered frame are prefetched while
+//    the current one is decoded.
+// 4. A packed stack is rendered through the thread's 8-bit frame
+//    that is then packed into the stack.
+//-------------------------------------------------------------------
+class CLoadTiffThread : public Util_Thread
+{
+public:
+	CLoadTiffThread(void);
+	~CLoadTiffThread(void);
+	void Run
+	( CLoadTiffImage* pLoadTiffImage,
+	  int iFile,
+	  MMU::CNextItem* pNextFrame,
+	  int iNthGpu
+	);
+	void ThreadMain(void);
+	bool m_bLoaded;
+private:
+	bool mLoadFrame(int iFrame);
+	void mPrefetch(int iFrame);
+	CLoadTiffImage* m_pSrcImage;
+	CLoadTiffImage* m_pLoadTiffImage;
+	MMU::CNextItem* m_pNextFrame;
+	unsigned char* m_pucBuf;
+	unsigned char* m_pucFrm;
+	int m_iNthGpu;
+	int m_iFile;
 };
 
 class CLoadTiffMain
@@ -68,7 +185,7 @@ public:
 private:
 	void mLoadHeader(void);
 	void mLoadStack(void);
-	void mLoadSingle(void);
+	void mLoadThreads(void);
 	void mLoadInt(void);
 	//-----------------
 	int m_iNthGpu;
@@ -78,7 +195,12 @@ private:
 	int m_iFile;
 	bool m_bLoaded;
 	float m_fLoadTime;
+	int m_iNumThreads;
+	int m_iNumRawFms;
+	size_t m_tFileBytes;
 };
 
 } 
 
+
+namespace MMT = McAreTomo::MotionCor::TiffUtil;